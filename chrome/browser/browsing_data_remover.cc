@@ -51,6 +51,7 @@
 #include "content/public/browser/plugin_data_remover.h"
 #include "content/public/browser/user_metrics.h"
 #include "net/base/net_errors.h"
+#include "net/base/sdch_manager.h"
 #include "net/base/server_bound_cert_service.h"
 #include "net/base/server_bound_cert_store.h"
 #include "net/base/transport_security_state.h"
@@ -106,6 +107,7 @@ BrowsingDataRemover::BrowsingDataRemover(Profile* profile,
       waiting_for_clear_cookies_count_(0),
       waiting_for_clear_history_(false),
       waiting_for_clear_networking_history_(false),
+      waiting_for_clear_sdch_dictionaries_(false),
       waiting_for_clear_server_bound_certs_(false),
       waiting_for_clear_plugin_data_(false),
       waiting_for_clear_quota_managed_data_(false),
@@ -131,6 +133,7 @@ BrowsingDataRemover::BrowsingDataRemover(Profile* profile,
       waiting_for_clear_cookies_count_(0),
       waiting_for_clear_history_(false),
       waiting_for_clear_networking_history_(false),
+      waiting_for_clear_sdch_dictionaries_(false),
       waiting_for_clear_server_bound_certs_(false),
       waiting_for_clear_plugin_data_(false),
       waiting_for_clear_quota_managed_data_(false),
@@ -384,6 +387,16 @@ void BrowsingDataRemover::RemoveImpl(int remove_mask,
     }
   }
 
+  // Saved SDCH dictionaries reveal the sites they came from, much like cache
+  // entries.  We don't know when they were fetched, so they are all deleted.
+  if (remove_mask & (REMOVE_CACHE | REMOVE_HISTORY)) {
+    waiting_for_clear_sdch_dictionaries_ = true;
+    BrowserThread::PostTask(
+        BrowserThread::IO, FROM_HERE,
+        base::Bind(&BrowsingDataRemover::ClearSdchDictionariesOnIOThread,
+                   base::Unretained(this)));
+  }
+
   // Also delete cached network related data (like TransportSecurityState,
   // HttpServerProperties data).
   profile_->ClearNetworkingHistorySince(delete_begin_);
@@ -514,6 +527,32 @@ void BrowsingDataRemover::ClearCacheOnIOThread() {
   DoClearCache(net::OK);
 }
 
+void BrowsingDataRemover::OnClearedSdchDictionaries() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  waiting_for_clear_sdch_dictionaries_ = false;
+  NotifyAndDeleteIfDone();
+}
+
+void BrowsingDataRemover::ClearSdchDictionariesOnIOThread() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  // The SdchManager is shared by all profiles, but its store only saves the
+  // dictionaries fetched for one of them.
+  net::SdchManager* sdch_manager = net::SdchManager::Global();
+  net::SdchDictionaryStore* store =
+      sdch_manager ? sdch_manager->dictionary_store() : NULL;
+  if (store && main_context_getter_ &&
+      store->CanSaveDictionariesFor(
+          main_context_getter_->GetURLRequestContext())) {
+    store->DeleteSavedDictionaries();
+  }
+
+  BrowserThread::PostTask(
+      BrowserThread::UI, FROM_HERE,
+      base::Bind(&BrowsingDataRemover::OnClearedSdchDictionaries,
+                 base::Unretained(this)));
+}
+
 // The expected state sequence is STATE_NONE --> STATE_CREATE_MAIN -->
 // STATE_DELETE_MAIN --> STATE_CREATE_MEDIA --> STATE_DELETE_MEDIA -->
 // STATE_DONE, and any errors are ignored.
@@ -204,6 +204,14 @@ class BrowsingDataRemover : public content::NotificationObserver,
   // Invoked on the IO thread to delete from the cache.
   void ClearCacheOnIOThread();
 
+  // Callback when the saved SDCH dictionaries have been deleted. Invokes
+  // NotifyAndDeleteIfDone.
+  void OnClearedSdchDictionaries();
+
+  // Invoked on the IO thread to delete the SDCH dictionaries saved for this
+  // profile.
+  void ClearSdchDictionariesOnIOThread();
+
   // Performs the actual work to delete the cache.
   void DoClearCache(int rv);
 
@@ -252,6 +260,7 @@ class BrowsingDataRemover : public content::NotificationObserver,
            !waiting_for_clear_cookies_count_&&
            !waiting_for_clear_history_ &&
            !waiting_for_clear_networking_history_ &&
+           !waiting_for_clear_sdch_dictionaries_ &&
            !waiting_for_clear_server_bound_certs_ &&
            !waiting_for_clear_plugin_data_ &&
            !waiting_for_clear_quota_managed_data_;
@@ -300,6 +309,7 @@ class BrowsingDataRemover : public content::NotificationObserver,
   int waiting_for_clear_cookies_count_;
   bool waiting_for_clear_history_;
   bool waiting_for_clear_networking_history_;
+  bool waiting_for_clear_sdch_dictionaries_;
   bool waiting_for_clear_server_bound_certs_;
   bool waiting_for_clear_plugin_data_;
   bool waiting_for_clear_quota_managed_data_;
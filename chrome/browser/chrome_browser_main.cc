@@ -250,6 +250,15 @@ void InitializeNetworkOptions(const CommandLine& parsed_command_line) {
   if (parsed_command_line.HasSwitch(switches::kEnableHttpPipelining))
     net::HttpStreamFactory::set_http_pipelining_enabled(true);
 
+  if (parsed_command_line.HasSwitch(switches::kEnableConnectionWarming))
+    net::HttpStreamFactory::set_connection_warming_enabled(true);
+
+  if (parsed_command_line.HasSwitch(
+          switches::kEnableAdaptiveSocketGroupLimits)) {
+    net::internal::ClientSocketPoolBaseHelper::
+        set_adaptive_group_limits_enabled(true);
+  }
+
   if (parsed_command_line.HasSwitch(switches::kTestingFixedHttpPort)) {
     int value;
     base::StringToInt(
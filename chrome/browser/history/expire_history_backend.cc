@@ -11,6 +11,7 @@
 #include "base/compiler_specific.h"
 #include "base/file_util.h"
 #include "base/message_loop.h"
+#include "base/metrics/histogram.h"
 #include "chrome/browser/bookmarks/bookmark_service.h"
 #include "chrome/browser/history/archived_database.h"
 #include "chrome/browser/history/history_database.h"
@@ -22,6 +23,7 @@
 
 using base::Time;
 using base::TimeDelta;
+using base::TimeTicks;
 
 namespace history {
 
@@ -123,6 +125,12 @@ bool ShouldArchiveVisit(const VisitRow& visit) {
 // Prevents us from doing too much work any given time.
 const int kNumExpirePerIteration = 32;
 
+// The number of milliseconds an iteration keeps expiring batches of
+// kNumExpirePerIteration visits for, when there are more to expire. Other
+// history requests wait for it, so this is kept well under what a user would
+// notice.
+const int kExpirationBudgetMs = 25;
+
 // The number of seconds between checking for items that should be expired when
 // we think there might be more items to expire. This timeout is used when the
 // last expiration found at least kNumExpirePerIteration and we want to check
@@ -156,6 +164,9 @@ struct ExpireHistoryBackend::DeleteDependencies {
   // The unique URL rows affected by this delete.
   std::map<URLID, URLRow> affected_urls;
 
+  // The full-text indexed pages of the deleted visits.
+  IndexedPages indexed_pages;
+
   // ----- Filled by DeleteOneURL -----
 
   // The URLs deleted during this operation.
@@ -194,6 +205,7 @@ void ExpireHistoryBackend::SetDatabases(HistoryDatabase* main_db,
   archived_db_ = archived_db;
   thumb_db_ = thumb_db;
   text_db_ = text_db;
+  CancelDeferredCleanup();
 }
 
 void ExpireHistoryBackend::DeleteURL(const GURL& url) {
@@ -232,6 +244,7 @@ void ExpireHistoryBackend::DeleteURLs(const std::vector<GURL>& urls) {
     DeleteOneURL(url_row, is_bookmarked, &dependencies);
   }
 
+  DeleteIndexedPages(&dependencies);
   DeleteFaviconsIfPossible(dependencies.affected_favicons);
 
   if (text_db_)
@@ -275,6 +288,7 @@ void ExpireHistoryBackend::ExpireVisits(const VisitVector& visits) {
 
   DeleteDependencies dependencies;
   DeleteVisitRelatedInfo(visits, &dependencies);
+  DeleteIndexedPages(&dependencies);
 
   // Delete or update the URLs affected. We want to update the visit counts
   // since this is called by the user who wants to delete their recent history,
@@ -296,9 +310,15 @@ void ExpireHistoryBackend::ArchiveHistoryBefore(Time end_time) {
   // Archive as much history as possible before the given date.
   ArchiveSomeOldHistory(end_time, GetAllVisitsReader(),
                         std::numeric_limits<size_t>::max());
+  DoDeferredCleanup();
   ParanoidExpireHistory();
 }
 
+void ExpireHistoryBackend::CancelDeferredCleanup() {
+  // A cleanup task that is already posted finds nothing to do.
+  deferred_cleanup_.reset();
+}
+
 void ExpireHistoryBackend::InitWorkQueue() {
   DCHECK(work_queue_.empty()) << "queue has to be empty prior to init";
 
@@ -350,6 +370,41 @@ void ExpireHistoryBackend::DeleteFaviconsIfPossible(
   }
 }
 
+void ExpireHistoryBackend::DeferCleanup(
+    const DeleteDependencies& dependencies) {
+  if (dependencies.affected_favicons.empty() &&
+      dependencies.indexed_pages.empty())
+    return;
+
+  if (!deferred_cleanup_.get()) {
+    deferred_cleanup_.reset(new DeleteDependencies);
+    // This runs as a task of its own, so that other history requests can get
+    // in between it and the expiration that left it.
+    MessageLoop::current()->PostTask(
+        FROM_HERE,
+        base::Bind(&ExpireHistoryBackend::DoDeferredCleanup,
+                   weak_factory_.GetWeakPtr()));
+  }
+  deferred_cleanup_->affected_favicons.insert(
+      dependencies.affected_favicons.begin(),
+      dependencies.affected_favicons.end());
+  deferred_cleanup_->indexed_pages.insert(
+      deferred_cleanup_->indexed_pages.end(),
+      dependencies.indexed_pages.begin(), dependencies.indexed_pages.end());
+}
+
+void ExpireHistoryBackend::DoDeferredCleanup() {
+  if (!deferred_cleanup_.get())
+    return;
+
+  TimeTicks start_time = TimeTicks::Now();
+  scoped_ptr<DeleteDependencies> cleanup(deferred_cleanup_.release());
+  DeleteIndexedPages(cleanup.get());
+  DeleteFaviconsIfPossible(cleanup->affected_favicons);
+  UMA_HISTOGRAM_TIMES("History.ExpireCleanupTime",
+                      TimeTicks::Now() - start_time);
+}
+
 void ExpireHistoryBackend::BroadcastDeleteNotifications(
     DeleteDependencies* dependencies, DeletionType type) {
   if (!dependencies->deleted_urls.empty()) {
@@ -369,10 +424,10 @@ void ExpireHistoryBackend::BroadcastDeleteNotifications(
 void ExpireHistoryBackend::DeleteVisitRelatedInfo(
     const VisitVector& visits,
     DeleteDependencies* dependencies) {
-  for (size_t i = 0; i < visits.size(); i++) {
-    // Delete the visit itself.
-    main_db_->DeleteVisit(visits[i]);
+  // Delete the visits themselves.
+  main_db_->DeleteVisits(visits);
 
+  for (size_t i = 0; i < visits.size(); i++) {
     // Add the URL row to the affected URL list.
     std::map<URLID, URLRow>::const_iterator found =
         dependencies->affected_urls.find(visits[i].url_id);
@@ -387,14 +442,27 @@ void ExpireHistoryBackend::DeleteVisitRelatedInfo(
       cur_row = &found->second;
     }
 
-    // Delete any associated full-text indexed data.
+    // Note any associated full-text indexed data.
     if (visits[i].is_indexed && text_db_) {
-      text_db_->DeletePageData(visits[i].visit_time, cur_row->url(),
-                               &dependencies->text_db_changes);
+      dependencies->indexed_pages.push_back(
+          std::make_pair(visits[i].visit_time, cur_row->url()));
     }
   }
 }
 
+void ExpireHistoryBackend::DeleteIndexedPages(
+    DeleteDependencies* dependencies) {
+  if (!text_db_)
+    return;
+
+  for (IndexedPages::const_iterator i = dependencies->indexed_pages.begin();
+       i != dependencies->indexed_pages.end(); ++i) {
+    text_db_->DeletePageData(i->first, i->second,
+                             &dependencies->text_db_changes);
+  }
+  dependencies->indexed_pages.clear();
+}
+
 void ExpireHistoryBackend::DeleteOneURL(
     const URLRow& url_row,
     bool is_bookmarked,
@@ -598,9 +666,22 @@ void ExpireHistoryBackend::ScheduleArchive() {
 void ExpireHistoryBackend::DoArchiveIteration() {
   DCHECK(!work_queue_.empty()) << "queue has to be non-empty";
 
+  // Keep expiring batches while there are more, as long as the iteration is
+  // within its time budget, so that a backlog of old history is worked off
+  // without holding up the history thread for long at a time.
+  TimeTicks start_time = TimeTicks::Now();
+  TimeDelta budget = TimeDelta::FromMilliseconds(kExpirationBudgetMs);
   const ExpiringVisitsReader* reader = work_queue_.front();
-  bool more_to_expire = ArchiveSomeOldHistory(GetCurrentArchiveTime(), reader,
-                                              kNumExpirePerIteration);
+  int batches = 0;
+  bool more_to_expire;
+  do {
+    more_to_expire = ArchiveSomeOldHistory(GetCurrentArchiveTime(), reader,
+                                           kNumExpirePerIteration);
+    batches++;
+  } while (more_to_expire && TimeTicks::Now() - start_time < budget);
+  UMA_HISTOGRAM_TIMES("History.ExpireIterationTime",
+                      TimeTicks::Now() - start_time);
+  UMA_HISTOGRAM_COUNTS_100("History.ExpireBatchesPerIteration", batches);
 
   work_queue_.pop();
   // If there are more items to expire, add the reader back to the queue, thus
@@ -651,16 +732,10 @@ bool ExpireHistoryBackend::ArchiveSomeOldHistory(
   ExpireURLsForVisits(deleted_visits, &deleted_dependencies);
   ExpireURLsForVisits(archived_visits, &archived_dependencies);
 
-  // Create a union of all affected favicons (we don't store favicons for
-  // archived URLs) and delete them.
-  std::set<FaviconID> affected_favicons(
-      archived_dependencies.affected_favicons);
-  for (std::set<FaviconID>::const_iterator i =
-           deleted_dependencies.affected_favicons.begin();
-       i != deleted_dependencies.affected_favicons.end(); ++i) {
-    affected_favicons.insert(*i);
-  }
-  DeleteFaviconsIfPossible(affected_favicons);
+  // Leave the affected favicons (we don't store favicons for archived URLs)
+  // and full-text index entries of both to be deleted later.
+  DeferCleanup(archived_dependencies);
+  DeferCleanup(deleted_dependencies);
 
   // Send notifications for the stuff that was deleted. These won't normally be
   // in history views since they were subframes, but they will be in the visited
@@ -8,6 +8,7 @@
 
 #include <queue>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "base/basictypes.h"
@@ -100,6 +101,15 @@ class ExpireHistoryBackend {
   // probably isn't useful for anything else.
   void ArchiveHistoryBefore(base::Time end_time);
 
+  // Drops the favicon and full-text index cleanup left over from archiving old
+  // history. Call this before replacing the data it refers to.
+  void CancelDeferredCleanup();
+
+  // Deletes the favicons and full-text index entries left over from archiving
+  // old history right away, rather than in the task posted for it. Call this
+  // before closing the databases, since that task then finds nothing to do.
+  void DoDeferredCleanup();
+
   // Returns the current time that we are archiving stuff to. This will return
   // the threshold in absolute time rather than a delta, so the caller should
   // not save it.
@@ -112,19 +122,28 @@ class ExpireHistoryBackend {
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, ArchiveSomeOldHistory);
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, ExpiringVisitsReader);
   FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, ArchiveSomeOldHistoryWithSource);
+  FRIEND_TEST_ALL_PREFIXES(ExpireHistoryTest, DeferredCleanup);
   friend class ::TestingProfile;
 
   struct DeleteDependencies;
 
+  // The visit times and URLs of full-text indexed pages.
+  typedef std::vector<std::pair<base::Time, GURL> > IndexedPages;
+
   // Deletes the visit-related stuff for all the visits in the given list, and
   // adds the rows for unique URLs affected to the affected_urls list in
   // the dependencies structure.
   //
-  // Deleted information is the visits themselves and the full-text index
-  // entries corresponding to them.
+  // Deleted information is the visits themselves. The full-text index entries
+  // corresponding to them are added to the indexed_pages list, for
+  // DeleteIndexedPages to delete.
   void DeleteVisitRelatedInfo(const VisitVector& visits,
                               DeleteDependencies* dependencies);
 
+  // Deletes the full-text index entries in the indexed_pages list of the
+  // dependencies structure, noting the changed databases in it.
+  void DeleteIndexedPages(DeleteDependencies* dependencies);
+
   // Moves the given visits from the main database to the archived one.
   void ArchiveVisits(const VisitVector& visits);
 
@@ -195,6 +214,12 @@ class ExpireHistoryBackend {
   // care about favicons so much, so don't want to stop everything if it fails).
   void DeleteFaviconsIfPossible(const std::set<FaviconID>& favicon_id);
 
+  // Adds the favicons and full-text index entries of the given dependencies to
+  // the cleanup done by DoDeferredCleanup, and schedules it if needed.
+  // Archiving old history leaves this work for later so that each iteration
+  // holds up the history thread for less time.
+  void DeferCleanup(const DeleteDependencies& dependencies);
+
   // Enum representing what type of action resulted in the history DB deletion.
   enum DeletionType {
     // User initiated the deletion from the History UI.
@@ -211,15 +236,16 @@ class ExpireHistoryBackend {
   // Schedules a call to DoArchiveIteration.
   void ScheduleArchive();
 
-  // Calls ArchiveSomeOldHistory to expire some amount of old history, according
-  // to the items in work queue, and schedules another call to happen in the
-  // future.
+  // Calls ArchiveSomeOldHistory to expire old history, according to the items
+  // in work queue, until it runs out of either history or its time budget, and
+  // schedules another call to happen in the future.
   void DoArchiveIteration();
 
   // Tries to expire the oldest |max_visits| visits from history that are older
   // than |time_threshold|. The return value indicates if we think there might
   // be more history to expire with the current time threshold (it does not
-  // indicate success or failure).
+  // indicate success or failure). The unused favicons and the full-text index
+  // entries are left to DoDeferredCleanup.
   bool ArchiveSomeOldHistory(base::Time end_time,
                              const ExpiringVisitsReader* reader,
                              int max_visits);
@@ -276,6 +302,10 @@ class ExpireHistoryBackend {
   // iterations.
   std::queue<const ExpiringVisitsReader*> work_queue_;
 
+  // The cleanup left by ArchiveSomeOldHistory for DoDeferredCleanup, NULL when
+  // there is none.
+  scoped_ptr<DeleteDependencies> deferred_cleanup_;
+
   // Readers for various types of visits.
   // TODO(dglazkov): If you are adding another one, please consider reorganizing
   // into a map.
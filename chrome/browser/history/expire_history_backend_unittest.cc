@@ -883,6 +883,35 @@ TEST_F(ExpireHistoryTest, ArchiveSomeOldHistory) {
   EXPECT_TRUE(expirer_.ArchiveSomeOldHistory(visit_times[2], reader, 1));
 }
 
+// Tests that archiving old history leaves the favicon cleanup to a task of its
+// own.
+TEST_F(ExpireHistoryTest, DeferredCleanup) {
+  URLID url_ids[3];
+  Time visit_times[4];
+  AddExampleData(url_ids, visit_times);
+  const ExpiringVisitsReader* reader = expirer_.GetAllVisitsReader();
+
+  URLRow url_row0, url_row2;
+  ASSERT_TRUE(main_db_->GetURLRow(url_ids[0], &url_row0));
+  ASSERT_TRUE(main_db_->GetURLRow(url_ids[2], &url_row2));
+  FaviconID favicon_ids[2] = {
+    GetFavicon(url_row0.url(), FAVICON),
+    GetFavicon(url_row2.url(), FAVICON),
+  };
+
+  // Expiring all the visits deletes all the URLs, but not yet their favicons.
+  EXPECT_FALSE(expirer_.ArchiveSomeOldHistory(visit_times[3], reader, 10));
+  URLRow temp_row;
+  EXPECT_FALSE(main_db_->GetURLRow(url_ids[0], &temp_row));
+  EXPECT_FALSE(main_db_->GetURLRow(url_ids[2], &temp_row));
+  EXPECT_TRUE(HasFavicon(favicon_ids[0]));
+  EXPECT_TRUE(HasFavicon(favicon_ids[1]));
+
+  message_loop_.RunAllPending();
+  EXPECT_FALSE(HasFavicon(favicon_ids[0]));
+  EXPECT_FALSE(HasFavicon(favicon_ids[1]));
+}
+
 TEST_F(ExpireHistoryTest, ExpiringVisitsReader) {
   URLID url_ids[3];
   Time visit_times[4];
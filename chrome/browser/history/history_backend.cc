@@ -226,6 +226,10 @@ HistoryBackend::~HistoryBackend() {
   android_provider_backend_.reset();
 #endif
 
+  // The expirer's pending cleanup task is dropped with it, so finish that
+  // cleanup while the databases are still open.
+  expirer_.DoDeferredCleanup();
+
   // First close the databases before optionally running the "destroy" task.
   if (db_.get()) {
     // Commit the long-running transaction.
@@ -2282,6 +2286,9 @@ void HistoryBackend::DeleteAllHistory() {
     kept_urls.push_back(row);
   }
 
+  // The IDs the expirer has yet to clean up after are about to change.
+  expirer_.CancelDeferredCleanup();
+
   // Clear thumbnail and favicon history. The favicons for the given URLs will
   // be kept.
   if (!ClearAllThumbnailHistory(&kept_urls)) {
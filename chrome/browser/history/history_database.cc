@@ -15,6 +15,7 @@
 #include "base/string_util.h"
 #include "chrome/browser/diagnostics/sqlite_diagnostics.h"
 #include "chrome/browser/history/starred_url_database.h"
+#include "chrome/common/chrome_switches.h"
 #include "sql/transaction.h"
 
 #if defined(OS_MACOSX)
@@ -85,6 +86,17 @@ sql::InitStatus HistoryDatabase::Init(const FilePath& history_name,
   // TODO(brettw) scale this value to the amount of available memory.
   db_.set_cache_size(6000);
 
+  // Commit to a write-ahead log, so the in-memory backend and other readers
+  // don't wait for writes, and syncing happens at checkpoints rather than on
+  // every commit.  Losing the last few visits in a power failure is fine.
+  db_.set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+  db_.set_synchronous(sql::Connection::SYNCHRONOUS_NORMAL);
+
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kEnableSqlStatementProfiling)) {
+    db_.EnableStatementProfiling("History");
+  }
+
   // Note that we don't set exclusive locking here. That's done by
   // BeginExclusiveMode below which is called later (we have to be in shared
   // mode to start out for the in-memory backend to read the data).
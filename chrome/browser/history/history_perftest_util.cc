@@ -0,0 +1,35 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/history/history_perftest_util.h"
+
+namespace history {
+
+std::string MakePerfTestWord(int number) {
+  static const char* const kSyllables[] = {
+    "ka", "po", "ri", "mu", "te", "no", "sa", "vi", "lo", "ge", "da", "fu",
+    "zo", "be", "hi", "ja", "ne", "qu", "wy", "xo",
+  };
+  std::string word;
+  do {
+    word += kSyllables[number % arraysize(kSyllables)];
+    number /= arraysize(kSyllables);
+  } while (number);
+  return word;
+}
+
+PerfTestRandom::PerfTestRandom() : state_(12345) {}
+
+int PerfTestRandom::NextSkewed(int range) {
+  int a = Next() % range;
+  int b = Next() % range;
+  return static_cast<int>(static_cast<int64>(a) * b / range);
+}
+
+int PerfTestRandom::Next() {
+  state_ = state_ * 1103515245 + 12345;
+  return static_cast<int>((state_ >> 8) & 0x7fffff);
+}
+
+}  // namespace history
@@ -0,0 +1,40 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_HISTORY_HISTORY_PERFTEST_UTIL_H_
+#define CHROME_BROWSER_HISTORY_HISTORY_PERFTEST_UTIL_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+
+namespace history {
+
+// Helpers for building synthetic history in the history perf tests.
+
+// Builds a pronounceable word out of syllables, one for each |number|, so
+// that the indexes see a realistic spread of terms and letters.
+std::string MakePerfTestWord(int number);
+
+// A fixed linear congruential generator, so every run builds the same
+// history.
+class PerfTestRandom {
+ public:
+  PerfTestRandom();
+
+  // Returns a number in [0, range), skewed towards 0 the way word and site
+  // popularity is.
+  int NextSkewed(int range);
+
+ private:
+  int Next();
+
+  uint32 state_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfTestRandom);
+};
+
+}  // namespace history
+
+#endif  // CHROME_BROWSER_HISTORY_HISTORY_PERFTEST_UTIL_H_
@@ -4,7 +4,7 @@
 
 #include "chrome/browser/history/in_memory_url_index.h"
 
-#include "base/file_util.h"
+#include "base/bind.h"
 #include "base/utf_string_conversions.h"
 #include "chrome/browser/history/history_notifications.h"
 #include "chrome/browser/history/url_database.h"
@@ -21,12 +21,9 @@ using in_memory_url_index::InMemoryURLIndexCacheItem;
 
 namespace history {
 
-// Called by DoSaveToCacheFile to delete any old cache file at |path| when
-// there is no private data to save. Runs on the FILE thread.
-void DeleteCacheFile(const FilePath& path) {
-  DCHECK(!content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
-  file_util::Delete(path, false);
-}
+// The journal entries after which the cache is rewritten rather than have the
+// journal grow further, since restoring replays each of them.
+const int kMaxJournalEntries = 1000;
 
 // Initializes a whitelist of URL schemes.
 void InitializeSchemeWhitelist(std::set<std::string>* whitelist) {
@@ -97,7 +94,8 @@ InMemoryURLIndex::InMemoryURLIndex(Profile* profile,
       restore_cache_observer_(NULL),
       save_cache_observer_(NULL),
       shutdown_(false),
-      needs_to_be_cached_(false) {
+      needs_to_be_cached_(false),
+      journal_entry_count_(0) {
   InitializeSchemeWhitelist(&scheme_whitelist_);
   if (profile) {
     // TODO(mrossetti): Register for language change notifications.
@@ -116,7 +114,8 @@ InMemoryURLIndex::InMemoryURLIndex()
       restore_cache_observer_(NULL),
       save_cache_observer_(NULL),
       shutdown_(false),
-      needs_to_be_cached_(false) {
+      needs_to_be_cached_(false),
+      journal_entry_count_(0) {
   InitializeSchemeWhitelist(&scheme_whitelist_);
 }
 
@@ -186,42 +185,93 @@ void InMemoryURLIndex::Observe(int notification_type,
 }
 
 void InMemoryURLIndex::OnURLVisited(const URLVisitedDetails* details) {
-  needs_to_be_cached_ |=
-      private_data_->UpdateURL(details->row, languages_, scheme_whitelist_);
+  if (private_data_->UpdateURL(details->row, languages_, scheme_whitelist_)) {
+    needs_to_be_cached_ = true;
+    std::string entries;
+    URLIndexPrivateData::AddJournalEntry(details->row, false, &entries);
+    PostWriteJournalEntriesTask(entries, 1);
+  }
 }
 
 void InMemoryURLIndex::OnURLsModified(const URLsModifiedDetails* details) {
+  std::string entries;
+  int entry_count = 0;
   for (URLRows::const_iterator row = details->changed_urls.begin();
-       row != details->changed_urls.end(); ++row)
-    needs_to_be_cached_ |=
-        private_data_->UpdateURL(*row, languages_, scheme_whitelist_);
+       row != details->changed_urls.end(); ++row) {
+    if (private_data_->UpdateURL(*row, languages_, scheme_whitelist_)) {
+      URLIndexPrivateData::AddJournalEntry(*row, false, &entries);
+      ++entry_count;
+    }
+  }
+  if (entry_count) {
+    needs_to_be_cached_ = true;
+    PostWriteJournalEntriesTask(entries, entry_count);
+  }
 }
 
 void InMemoryURLIndex::OnURLsDeleted(const URLsDeletedDetails* details) {
   if (details->all_history) {
     ClearPrivateData();
     needs_to_be_cached_ = true;
+    // Deletes the cache file and its journal, which can't record clearing.
+    PostSaveToCacheFileTask();
   } else {
+    std::string entries;
+    int entry_count = 0;
     for (URLRows::const_iterator row = details->rows.begin();
-         row != details->rows.end(); ++row)
-      needs_to_be_cached_ |= private_data_->DeleteURL(row->url());
+         row != details->rows.end(); ++row) {
+      if (private_data_->DeleteURL(row->url())) {
+        URLIndexPrivateData::AddJournalEntry(*row, true, &entries);
+        ++entry_count;
+      }
+    }
+    if (entry_count) {
+      needs_to_be_cached_ = true;
+      PostWriteJournalEntriesTask(entries, entry_count);
+    }
   }
 }
 
+void InMemoryURLIndex::PostWriteJournalEntriesTask(const std::string& entries,
+                                                   int entry_count) {
+  FilePath path;
+  if (!GetCacheFilePath(&path) || shutdown_)
+    return;
+  // The journal is written on the FILE thread, in order with the cache file.
+  content::BrowserThread::PostTask(
+      content::BrowserThread::FILE, FROM_HERE,
+      base::Bind(&URLIndexPrivateData::WriteJournalEntriesTask, path,
+                 entries));
+  journal_entry_count_ += entry_count;
+  if (journal_entry_count_ > kMaxJournalEntries)
+    PostCompactCacheFileTask();
+}
+
+void InMemoryURLIndex::PostCompactCacheFileTask() {
+  FilePath path;
+  if (!GetCacheFilePath(&path))
+    return;
+  // The cache file and its journal already hold the whole index, so they are
+  // merged on the FILE thread rather than by copying |private_data_| here.
+  content::BrowserThread::PostTask(
+      content::BrowserThread::FILE, FROM_HERE,
+      base::Bind(&URLIndexPrivateData::CompactCacheFileTask, path, languages_,
+                 scheme_whitelist_));
+  journal_entry_count_ = 0;
+}
+
 // Restoring from Cache --------------------------------------------------------
 
 void InMemoryURLIndex::PostRestoreFromCacheFileTask() {
   FilePath path;
   if (!GetCacheFilePath(&path) || shutdown_)
     return;
-  scoped_refptr<URLIndexPrivateData> restored_private_data =
-      new URLIndexPrivateData;
-  content::BrowserThread::PostTaskAndReply(
+  content::BrowserThread::PostTaskAndReplyWithResult<
+      scoped_refptr<URLIndexPrivateData> >(
       content::BrowserThread::FILE, FROM_HERE,
-      base::Bind(&URLIndexPrivateData::RestoreFromFileTask, path,
-          restored_private_data, languages_),
-      base::Bind(&InMemoryURLIndex::OnCacheLoadDone, AsWeakPtr(),
-          restored_private_data));
+      base::Bind(&URLIndexPrivateData::RestoreFromFile, path, languages_,
+                 scheme_whitelist_),
+      base::Bind(&InMemoryURLIndex::OnCacheLoadDone, AsWeakPtr()));
 }
 
 void InMemoryURLIndex::OnCacheLoadDone(
@@ -237,8 +287,9 @@ void InMemoryURLIndex::OnCacheLoadDone(
     FilePath path;
     if (!GetCacheFilePath(&path) || shutdown_)
       return;
-    content::BrowserThread::PostBlockingPoolTask(
-        FROM_HERE, base::Bind(DeleteCacheFile, path));
+    content::BrowserThread::PostTask(
+        content::BrowserThread::FILE, FROM_HERE,
+        base::Bind(&URLIndexPrivateData::DeleteCacheFilesTask, path));
     HistoryService* service = profile_->GetHistoryServiceWithoutCreating();
     if (service && service->backend_loaded()) {
       ScheduleRebuildFromHistory();
@@ -303,10 +354,11 @@ void InMemoryURLIndex::PostSaveToCacheFileTask() {
         base::Bind(&InMemoryURLIndex::OnCacheSaveDone, AsWeakPtr(), succeeded));
   } else {
     // If there is no data in our index then delete any existing cache file.
-    content::BrowserThread::PostBlockingPoolTask(
-        FROM_HERE,
-        base::Bind(DeleteCacheFile, path));
+    content::BrowserThread::PostTask(
+        content::BrowserThread::FILE, FROM_HERE,
+        base::Bind(&URLIndexPrivateData::DeleteCacheFilesTask, path));
   }
+  journal_entry_count_ = 0;
 }
 
 void InMemoryURLIndex::OnCacheSaveDone(
@@ -195,6 +195,15 @@ class InMemoryURLIndex : public content::NotificationObserver,
   // profile directory.
   void PostRestoreFromCacheFileTask();
 
+  // Appends |entries|, made by URLIndexPrivateData::AddJournalEntry(), to the
+  // journal of the cache file.  Once the journal holds many entries, it is
+  // merged into the cache file.
+  void PostWriteJournalEntriesTask(const std::string& entries,
+                                   int entry_count);
+
+  // Merges the journal into the cache file on the FILE thread.
+  void PostCompactCacheFileTask();
+
   // Schedules a history task to rebuild our private data from the history
   // database.
   void ScheduleRebuildFromHistory();
@@ -292,6 +301,10 @@ class InMemoryURLIndex : public content::NotificationObserver,
   // http://crbug.com/83659
   bool needs_to_be_cached_;
 
+  // The number of entries written to the journal since the cache was last
+  // written or compacted.
+  int journal_entry_count_;
+
   DISALLOW_COPY_AND_ASSIGN(InMemoryURLIndex);
 };
 
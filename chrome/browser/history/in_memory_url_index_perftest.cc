@@ -0,0 +1,135 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "base/utf_string_conversions.h"
+#include "chrome/browser/history/history_perftest_util.h"
+#include "chrome/browser/history/history_types.h"
+#include "chrome/browser/history/url_index_private_data.h"
+#include "googleurl/src/gurl.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace history {
+
+namespace {
+
+// The history sizes the index is measured at.
+const int kHistorySizes[] = { 100000, 1000000 };
+
+// The number of distinct hosts and path words the URLs are made of.
+const int kHostCount = 5000;
+const int kWordCount = 20000;
+
+// What the user types, as they type it.
+const char* const kQueries[] = {
+  "g", "go", "goo", "goog", "googl", "google",
+  "ka", "kapo", "kapo ri", "kapo rimu",
+  "http", "www", "com",
+};
+
+}  // namespace
+
+class InMemoryURLIndexPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    scheme_whitelist_.insert("http");
+    scheme_whitelist_.insert("https");
+  }
+
+  // Indexes |count| synthetic history items into a new index.
+  scoped_refptr<URLIndexPrivateData> BuildIndex(int count) {
+    scoped_refptr<URLIndexPrivateData> data(new URLIndexPrivateData);
+    PerfTestRandom random;
+    base::Time now = base::Time::Now();
+    for (int id = 1; id <= count; ++id) {
+      std::string host = MakePerfTestWord(random.NextSkewed(kHostCount));
+      std::string path = MakePerfTestWord(random.NextSkewed(kWordCount)) + "/" +
+          MakePerfTestWord(random.NextSkewed(kWordCount));
+      URLRow row(GURL(base::StringPrintf("http://www.%s.com/%s?id=%d",
+                                         host.c_str(), path.c_str(), id)),
+                 id);
+      std::string title_word = MakePerfTestWord(random.NextSkewed(kWordCount));
+      row.set_title(UTF8ToUTF16(title_word + " " + host));
+      row.set_visit_count(1 + random.NextSkewed(20));
+      row.set_typed_count(random.NextSkewed(3));
+      row.set_last_visit(now - base::TimeDelta::FromHours(id % 1000));
+      data->IndexRow(row, std::string(), scheme_whitelist_);
+    }
+    data->ShrinkIndex();
+    return data;
+  }
+
+  std::set<std::string> scheme_whitelist_;
+};
+
+// Measures how long the index takes to build, how much memory it takes, and
+// how long each keystroke of a few typical queries takes to look up.
+TEST_F(InMemoryURLIndexPerfTest, BuildAndQuery) {
+  for (size_t i = 0; i < arraysize(kHistorySizes); ++i) {
+    const int count = kHistorySizes[i];
+    const std::string prefix =
+        base::StringPrintf("InMemoryURLIndex_%d_", count);
+
+    PerfTimer build_timer;
+    scoped_refptr<URLIndexPrivateData> data(BuildIndex(count));
+    LogPerfResult((prefix + "Build").c_str(),
+                  build_timer.Elapsed().InMillisecondsF(), "ms");
+    LogPerfResult((prefix + "Memory").c_str(),
+                  data->EstimateIndexMemoryUsage() / 1024, "kb");
+
+    // Each keystroke builds on the search term cache left by the one before,
+    // as in the omnibox.
+    double total_ms = 0;
+    double max_ms = 0;
+    for (size_t j = 0; j < arraysize(kQueries); ++j) {
+      PerfTimer query_timer;
+      data->HistoryItemsForTerms(ASCIIToUTF16(kQueries[j]));
+      double elapsed_ms = query_timer.Elapsed().InMillisecondsF();
+      total_ms += elapsed_ms;
+      max_ms = std::max(max_ms, elapsed_ms);
+    }
+    LogPerfResult((prefix + "QueryMean").c_str(),
+                  total_ms / arraysize(kQueries), "ms");
+    LogPerfResult((prefix + "QueryMax").c_str(), max_ms, "ms");
+  }
+}
+
+// Measures how soon the first query can be answered at startup when the index
+// is restored from its cache file, rather than rebuilt as timed above.
+TEST_F(InMemoryURLIndexPerfTest, TimeToFirstResult) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath cache_path = temp_dir.path().AppendASCII("History Provider Cache");
+  for (size_t i = 0; i < arraysize(kHistorySizes); ++i) {
+    const int count = kHistorySizes[i];
+    const std::string prefix =
+        base::StringPrintf("InMemoryURLIndex_%d_", count);
+    ASSERT_TRUE(BuildIndex(count)->SaveToFile(cache_path));
+
+    PerfTimer timer;
+    scoped_refptr<URLIndexPrivateData> data(
+        URLIndexPrivateData::RestoreFromFile(cache_path, std::string(),
+                                             scheme_whitelist_));
+    ASSERT_TRUE(data.get());
+    double restore_ms = timer.Elapsed().InMillisecondsF();
+    data->HistoryItemsForTerms(ASCIIToUTF16(kQueries[0]));
+    LogPerfResult((prefix + "Restore").c_str(), restore_ms, "ms");
+    LogPerfResult((prefix + "TimeToFirstResult").c_str(),
+                  timer.Elapsed().InMillisecondsF(), "ms");
+  }
+}
+
+}  // namespace history
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <algorithm>
+#include <vector>
 
 #include "base/string16.h"
 #include "base/utf_string_conversions.h"
@@ -144,4 +145,54 @@ TEST_F(InMemoryURLIndexTypesTest, OffsetsAndTermMatches) {
     EXPECT_EQ(expected_offsets_b[i], matches_b[i].offset);
 }
 
+TEST_F(InMemoryURLIndexTypesTest, SortedIDSet) {
+  HistoryIDSet set_a;
+  EXPECT_TRUE(set_a.insert(5).second);
+  EXPECT_TRUE(set_a.insert(9).second);
+  EXPECT_TRUE(set_a.insert(1).second);
+  EXPECT_FALSE(set_a.insert(5).second);
+  const HistoryID expected_a[] = {1, 5, 9};
+  ASSERT_EQ(arraysize(expected_a), set_a.size());
+  EXPECT_TRUE(std::equal(set_a.begin(), set_a.end(), expected_a));
+  EXPECT_EQ(1U, set_a.count(9));
+  EXPECT_EQ(0U, set_a.count(4));
+  EXPECT_TRUE(set_a.find(4) == set_a.end());
+  EXPECT_EQ(1U, set_a.erase(5));
+  EXPECT_EQ(0U, set_a.erase(5));
+  EXPECT_EQ(2U, set_a.size());
+
+  const HistoryID more_ids[] = {12, 1, 7, 7};
+  set_a.insert(more_ids, more_ids + arraysize(more_ids));
+  const HistoryID expected_b[] = {1, 7, 9, 12};
+  ASSERT_EQ(arraysize(expected_b), set_a.size());
+  EXPECT_TRUE(std::equal(set_a.begin(), set_a.end(), expected_b));
+
+  // Both ways of intersecting, merging sets of about the same size and
+  // searching a much larger set, give the same result.
+  HistoryIDSet set_b;
+  for (HistoryID id = 0; id < 100; id += 3)
+    set_b.insert(id);
+  HistoryIDSet intersection(set_a);
+  intersection.IntersectWith(set_b);
+  const HistoryID expected_c[] = {9, 12};
+  ASSERT_EQ(arraysize(expected_c), intersection.size());
+  EXPECT_TRUE(std::equal(intersection.begin(), intersection.end(),
+                         expected_c));
+  HistoryIDSet small_set;
+  small_set.insert(9);
+  small_set.insert(10);
+  set_b.IntersectWith(small_set);
+  ASSERT_EQ(1U, set_b.size());
+  EXPECT_EQ(9, *set_b.begin());
+
+  std::vector<const HistoryIDSet*> sets;
+  sets.push_back(&set_a);
+  sets.push_back(&small_set);
+  HistoryIDSet union_set;
+  UnionSortedIDSets(sets.begin(), sets.end(), &union_set);
+  const HistoryID expected_d[] = {1, 7, 9, 10, 12};
+  ASSERT_EQ(arraysize(expected_d), union_set.size());
+  EXPECT_TRUE(std::equal(union_set.begin(), union_set.end(), expected_d));
+}
+
 }  // namespace history
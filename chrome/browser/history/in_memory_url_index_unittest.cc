@@ -133,6 +133,7 @@ class InMemoryURLIndexTest : public testing::Test {
   bool GetCacheFilePath(FilePath* file_path) const;
   void PostRestoreFromCacheFileTask();
   void PostSaveToCacheFileTask();
+  void PostCompactCacheFileTask();
   void Observe(int notification_type,
                const content::NotificationSource& source,
                const content::NotificationDetails& details);
@@ -193,6 +194,10 @@ void InMemoryURLIndexTest::PostSaveToCacheFileTask() {
   url_index_->PostSaveToCacheFileTask();
 }
 
+void InMemoryURLIndexTest::PostCompactCacheFileTask() {
+  url_index_->PostCompactCacheFileTask();
+}
+
 void InMemoryURLIndexTest::Observe(
     int notification_type,
     const content::NotificationSource& source,
@@ -1008,6 +1013,182 @@ TEST_F(InMemoryURLIndexTest, CacheSaveRestore) {
   ExpectPrivateDataEqual(*old_data, new_data);
 }
 
+TEST_F(InMemoryURLIndexTest, CacheJournal) {
+  ScopedTempDir temp_directory;
+  ASSERT_TRUE(temp_directory.CreateUniqueTempDir());
+  set_history_dir(temp_directory.path());
+
+  CacheFileSaverObserver save_observer(&message_loop_);
+  url_index_->set_save_cache_observer(&save_observer);
+  PostSaveToCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(save_observer.succeeded_);
+
+  // Visit a new URL and delete an old one once the cache has been written.
+  URLVisitedDetails visited_details;
+  visited_details.row = URLRow(GURL("http://www.brokeandaloneinmanitoba.com/"),
+                               87654321);
+  visited_details.row.set_last_visit(base::Time::Now());
+  Observe(chrome::NOTIFICATION_HISTORY_URL_VISITED,
+          content::Source<InMemoryURLIndexTest>(this),
+          content::Details<history::HistoryDetails>(&visited_details));
+  ScoredHistoryMatches matches =
+      url_index_->HistoryItemsForTerms(ASCIIToUTF16("DrudgeReport"));
+  ASSERT_EQ(1U, matches.size());
+  const GURL deleted_url(matches[0].url_info.url());
+  URLsDeletedDetails deleted_details;
+  deleted_details.all_history = false;
+  deleted_details.rows.push_back(matches[0].url_info);
+  Observe(chrome::NOTIFICATION_HISTORY_URLS_DELETED,
+          content::Source<InMemoryURLIndexTest>(this),
+          content::Details<history::HistoryDetails>(&deleted_details));
+  message_loop_.RunAllPending();
+
+  FilePath cache_path;
+  ASSERT_TRUE(GetCacheFilePath(&cache_path));
+  const FilePath journal_path(
+      URLIndexPrivateData::GetJournalFilePath(cache_path));
+  std::string journal;
+  ASSERT_TRUE(file_util::ReadFileToString(journal_path, &journal));
+  EXPECT_NE(std::string::npos, journal.find("brokeandaloneinmanitoba"));
+  // Deleted rows are journaled by ID alone.
+  EXPECT_EQ(std::string::npos, journal.find(deleted_url.host()));
+
+  // The restored index includes the changes recorded in the journal.
+  scoped_refptr<URLIndexPrivateData> expected_data(
+      GetPrivateData()->Duplicate());
+  ClearPrivateData();
+  CacheFileReaderObserver read_observer(&message_loop_);
+  url_index_->set_restore_cache_observer(&read_observer);
+  PostRestoreFromCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(read_observer.succeeded_);
+  ExpectPrivateDataEqual(*expected_data, *GetPrivateData());
+  EXPECT_EQ(1U, url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("brokeandalone")).size());
+  EXPECT_TRUE(url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("DrudgeReport")).empty());
+
+  // Compacting merges the journal into the cache file.
+  PostCompactCacheFileTask();
+  message_loop_.RunAllPending();
+  EXPECT_FALSE(file_util::PathExists(journal_path));
+  ClearPrivateData();
+  PostRestoreFromCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(read_observer.succeeded_);
+  ExpectPrivateDataEqual(*expected_data, *GetPrivateData());
+
+  // Writing the cache clears the journal as well.
+  visited_details.row.set_visit_count(2);
+  Observe(chrome::NOTIFICATION_HISTORY_URL_VISITED,
+          content::Source<InMemoryURLIndexTest>(this),
+          content::Details<history::HistoryDetails>(&visited_details));
+  message_loop_.RunAllPending();
+  EXPECT_TRUE(file_util::PathExists(journal_path));
+  PostSaveToCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(save_observer.succeeded_);
+  EXPECT_FALSE(file_util::PathExists(journal_path));
+
+  // Must clear the history_dir_ to satisfy the dtor's DCHECK.
+  set_history_dir(FilePath());
+}
+
+TEST_F(InMemoryURLIndexTest, TornJournalEntry) {
+  ScopedTempDir temp_directory;
+  ASSERT_TRUE(temp_directory.CreateUniqueTempDir());
+  set_history_dir(temp_directory.path());
+
+  CacheFileSaverObserver save_observer(&message_loop_);
+  url_index_->set_save_cache_observer(&save_observer);
+  PostSaveToCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(save_observer.succeeded_);
+
+  URLVisitedDetails visited_details;
+  visited_details.row = URLRow(GURL("http://www.brokeandaloneinmanitoba.com/"),
+                               87654321);
+  visited_details.row.set_last_visit(base::Time::Now());
+  Observe(chrome::NOTIFICATION_HISTORY_URL_VISITED,
+          content::Source<InMemoryURLIndexTest>(this),
+          content::Details<history::HistoryDetails>(&visited_details));
+  message_loop_.RunAllPending();
+
+  // Leave half an entry at the end of the journal, as a crash while appending
+  // would.
+  FilePath cache_path;
+  ASSERT_TRUE(GetCacheFilePath(&cache_path));
+  const FilePath journal_path(
+      URLIndexPrivateData::GetJournalFilePath(cache_path));
+  int64 journal_size = 0;
+  ASSERT_TRUE(file_util::GetFileSize(journal_path, &journal_size));
+  const char kTornEntry[] = "\x40\0\0\0\x08\x01";
+  ASSERT_EQ(static_cast<int>(sizeof(kTornEntry) - 1),
+            file_util::AppendToFile(journal_path, kTornEntry,
+                                    sizeof(kTornEntry) - 1));
+
+  // Restoring applies the complete entry and cuts off the torn one.
+  ClearPrivateData();
+  CacheFileReaderObserver read_observer(&message_loop_);
+  url_index_->set_restore_cache_observer(&read_observer);
+  PostRestoreFromCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(read_observer.succeeded_);
+  EXPECT_EQ(1U, url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("brokeandalone")).size());
+  int64 truncated_size = 0;
+  ASSERT_TRUE(file_util::GetFileSize(journal_path, &truncated_size));
+  EXPECT_EQ(journal_size, truncated_size);
+
+  // So an entry appended afterwards is found by the next restore.
+  visited_details.row = URLRow(GURL("http://www.pauvrefilleaumanitoba.com/"),
+                               87654322);
+  visited_details.row.set_last_visit(base::Time::Now());
+  Observe(chrome::NOTIFICATION_HISTORY_URL_VISITED,
+          content::Source<InMemoryURLIndexTest>(this),
+          content::Details<history::HistoryDetails>(&visited_details));
+  message_loop_.RunAllPending();
+  ClearPrivateData();
+  PostRestoreFromCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(read_observer.succeeded_);
+  EXPECT_EQ(1U, url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("brokeandalone")).size());
+  EXPECT_EQ(1U, url_index_->HistoryItemsForTerms(
+      ASCIIToUTF16("pauvrefille")).size());
+
+  // Must clear the history_dir_ to satisfy the dtor's DCHECK.
+  set_history_dir(FilePath());
+}
+
+TEST_F(InMemoryURLIndexTest, DamagedCache) {
+  ScopedTempDir temp_directory;
+  ASSERT_TRUE(temp_directory.CreateUniqueTempDir());
+  set_history_dir(temp_directory.path());
+
+  CacheFileSaverObserver save_observer(&message_loop_);
+  url_index_->set_save_cache_observer(&save_observer);
+  PostSaveToCacheFileTask();
+  message_loop_.Run();
+  EXPECT_TRUE(save_observer.succeeded_);
+
+  FilePath cache_path;
+  ASSERT_TRUE(GetCacheFilePath(&cache_path));
+  EXPECT_TRUE(URLIndexPrivateData::RestoreFromFile(
+      cache_path, "en", scheme_whitelist()).get());
+
+  // Flip a byte in the middle of the file, where the protobuf would most
+  // likely still parse.
+  std::string data;
+  ASSERT_TRUE(file_util::ReadFileToString(cache_path, &data));
+  data[data.size() / 2] ^= 0x20;
+  ASSERT_EQ(static_cast<int>(data.size()),
+            file_util::WriteFile(cache_path, data.data(), data.size()));
+  EXPECT_FALSE(URLIndexPrivateData::RestoreFromFile(
+      cache_path, "en", scheme_whitelist()).get());
+}
+
 class InMemoryURLIndexCacheTest : public testing::Test {
  public:
   InMemoryURLIndexCacheTest() {}
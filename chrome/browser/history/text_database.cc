@@ -294,7 +294,8 @@ void TextDatabase::GetTextMatches(const std::string& query,
   std::string sql = "SELECT url, title, time, offsets(pages), body FROM pages "
                     " LEFT OUTER JOIN info ON pages.rowid = info.rowid WHERE ";
   sql += options.body_only ? "body " : "pages ";
-  sql += "MATCH ? AND time >= ? AND time < ? ORDER BY time DESC LIMIT ?";
+  // There is no LIMIT, since skipped rows must not count towards it.
+  sql += "MATCH ? AND time >= ? AND time < ? ORDER BY time DESC";
   sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, sql.c_str()));
 
   // When their values indicate "unspecified", saturate the numbers to the max
@@ -309,16 +310,17 @@ void TextDatabase::GetTextMatches(const std::string& query,
   statement.BindString(0, query);
   statement.BindInt64(1, effective_begin_time);
   statement.BindInt64(2, effective_end_time);
-  statement.BindInt(3, effective_max_count);
 
-  while (statement.Step()) {
+  URLSet added_urls;
+  while (static_cast<int>(added_urls.size()) < effective_max_count &&
+         statement.Step()) {
     // TODO(brettw) allow canceling the query in the middle.
     // if (canceled_or_something)
     //   break;
 
     GURL url(statement.ColumnString(0));
-    URLSet::const_iterator found_url = found_urls->find(url);
-    if (found_url != found_urls->end())
+    if (found_urls->find(url) != found_urls->end() ||
+        !added_urls.insert(url).second)
       continue;  // Don't add this duplicate.
 
     // Fill the results into the vector (avoid copying the URL with Swap()).
@@ -349,9 +351,9 @@ void TextDatabase::GetTextMatches(const std::string& query,
   // When we have returned all the results possible (or determined that there
   // are none), then we have searched all the time requested, so we can
   // set the first_time_searched to that value.
-  if (results->empty() ||
+  if (added_urls.empty() ||
       options.max_count == 0 ||  // Special case for wanting all the results.
-      static_cast<int>(results->size()) < options.max_count) {
+      static_cast<int>(added_urls.size()) < options.max_count) {
     *first_time_searched = options.begin_time;
   } else {
     // Since we got the results in order, we know the last item is the last
@@ -126,9 +126,10 @@ class TextDatabase {
   // time considered for the output is in |first_time_searched|
   // (see QueryResults for more).
   //
-  // Any URLs found will be added to |unique_urls|. If a URL is already in the
-  // set, additional results will not be added (giving the ability to uniquify
-  // URL results).
+  // Results for URLs in |unique_urls|, or for a URL already appended by this
+  // call, are skipped, giving the ability to uniquify URL results. The set
+  // itself is left alone. |options.max_count| limits the number of results
+  // appended, not counting the skipped ones.
   //
   // Callers must run QueryParser on the user text and pass the results of the
   // QueryParser to this method as the query string.
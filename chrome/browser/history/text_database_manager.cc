@@ -4,13 +4,18 @@
 
 #include "chrome/browser/history/text_database_manager.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/compiler_specific.h"
 #include "base/file_util.h"
 #include "base/metrics/histogram.h"
 #include "base/logging.h"
 #include "base/message_loop.h"
+#include "base/memory/scoped_vector.h"
 #include "base/string_util.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/worker_pool.h"
 #include "base/utf_string_conversions.h"
 #include "chrome/browser/history/history_publisher.h"
 #include "chrome/browser/history/visit_database.h"
@@ -35,6 +40,28 @@ std::string ConvertStringForIndexer(const string16& input) {
 // haven't gotten a title and/or body.
 const int kExpirationSeconds = 20;
 
+// The results of querying one database.
+struct DBQuery {
+  DBQuery() : db(NULL) {}
+
+  TextDatabase* db;
+  std::vector<TextDatabase::Match> matches;
+  Time first_time_searched;
+};
+
+// Queries one database, possibly on a worker thread while the history thread
+// waits for |done|, which may be NULL.
+void RunDBQuery(const std::string& fts_query,
+                const QueryOptions& options,
+                DBQuery* query,
+                base::WaitableEvent* done) {
+  TextDatabase::URLSet found_urls;
+  query->db->GetTextMatches(fts_query, options, &query->matches, &found_urls,
+                            &query->first_time_searched);
+  if (done)
+    done->Signal();
+}
+
 }  // namespace
 
 // TextDatabaseManager::ChangeSet ----------------------------------------------
@@ -429,10 +456,6 @@ void TextDatabaseManager::GetTextMatches(
   query_parser_.ParseQuery(query, &fts_query16);
   std::string fts_query = UTF16ToUTF8(fts_query16);
 
-  // Need a copy of the options so we can modify the max count for each call
-  // to the individual databases.
-  QueryOptions cur_options(options);
-
   // Compute the minimum and maximum values for the identifiers that could
   // encompass the input time range.
   TextDatabase::DBIdent min_ident = options.begin_time.is_null() ?
@@ -442,48 +465,86 @@ void TextDatabaseManager::GetTextMatches(
       *present_databases_.rbegin() :
       TimeToID(options.end_time);
 
-  // Iterate over the databases from the most recent backwards.
+  // The databases in the time range, from the most recent backwards.
+  std::vector<TextDatabase::DBIdent> idents;
+  for (DBIdentSet::reverse_iterator i = present_databases_.rbegin();
+       i != present_databases_.rend() && *i >= min_ident; ++i) {
+    if (*i <= max_ident)
+      idents.push_back(*i);
+  }
+
+  TimeTicks beginning_time = TimeTicks::Now();
+
+  // Search the databases a cacheful at a time, each one on its own worker
+  // thread, since a query spanning years of history otherwise spends seconds
+  // going through the months one after the other. Each database is asked for
+  // the full number of distinct URLs, since we don't know yet how many the
+  // more recent ones will give; usually the first few fill the results and we
+  // stop there. A database that has more than that fills the results even
+  // after dropping the URLs already found, since there can't be more of those
+  // than results. The databases are only used by one thread at a time: ours
+  // waits for the workers to finish with them.
   bool checked_one = false;
+  bool done = false;
   TextDatabase::URLSet found_urls;
-  for (DBIdentSet::reverse_iterator i = present_databases_.rbegin();
-       i != present_databases_.rend();
-       ++i) {
-    // TODO(brettw) allow canceling the query in the middle.
-    // if (canceled_or_something)
-    //   break;
-
-    // This code is stupid, we just loop until we find the correct starting
-    // time range rather than search in an intelligent way. Users will have a
-    // few dozen files at most, so this should not be an issue.
-    if (*i > max_ident)
-      continue;  // Haven't gotten to the time range yet.
-    if (*i < min_ident)
-      break;  // Covered all the time range.
-
-    TextDatabase* cur_db = GetDB(*i, false);
-    if (!cur_db)
-      continue;
+  for (size_t first = 0; first < idents.size() && !done;
+       first += kCacheDBSize) {
+    size_t last = std::min(first + kCacheDBSize, idents.size());
+    ScopedVector<DBQuery> queries;
+    for (size_t i = first; i < last; i++) {
+      TextDatabase* cur_db = GetDB(idents[i], false);
+      if (!cur_db)
+        continue;
+      DBQuery* query = new DBQuery;
+      query->db = cur_db;
+      queries.push_back(query);
+    }
 
-    // Adjust the max count according to how many results we've already got.
-    if (options.max_count) {
-      cur_options.max_count = options.max_count -
-          static_cast<int>(results->size());
+    if (queries.size() == 1) {
+      RunDBQuery(fts_query, options, queries[0], NULL);
+    } else {
+      ScopedVector<base::WaitableEvent> events;
+      for (size_t i = 0; i < queries.size(); i++) {
+        events.push_back(new base::WaitableEvent(false, false));
+        base::WorkerPool::PostTask(
+            FROM_HERE,
+            base::Bind(&RunDBQuery, fts_query, options, queries[i],
+                       events[i]),
+            false);
+      }
+      for (size_t i = 0; i < events.size(); i++)
+        events[i]->Wait();
     }
 
-    // Since we are going backwards in time, it is always OK to pass the
-    // current first_time_searched, since it will always be smaller than
-    // any previous set.
-    cur_db->GetTextMatches(fts_query, cur_options,
-                           results, &found_urls, first_time_searched);
-    checked_one = true;
-
-    DCHECK(options.max_count == 0 ||
-           static_cast<int>(results->size()) <= options.max_count);
-    if (options.max_count &&
-        static_cast<int>(results->size()) >= options.max_count)
-      break;  // Got the max number of results.
+    // Merge the results, most recent database first, as if the databases had
+    // been searched one after the other.
+    for (size_t i = 0; i < queries.size() && !done; i++) {
+      const std::vector<TextDatabase::Match>& matches = queries[i]->matches;
+      checked_one = true;
+      *first_time_searched = queries[i]->first_time_searched;
+      for (size_t j = 0; j < matches.size(); j++) {
+        if (!found_urls.insert(matches[j].url).second)
+          continue;  // Found in a more recent database.
+        results->push_back(matches[j]);
+        if (options.max_count &&
+            static_cast<int>(results->size()) >= options.max_count) {
+          // Got the max number of results, so we have searched back to this
+          // one.
+          *first_time_searched = matches[j].time;
+          done = true;
+          break;
+        }
+      }
+
+      // When the database had more results than it gave us, they filled the
+      // results above.
+      DCHECK(done || *first_time_searched == options.begin_time);
+    }
   }
 
+  UMA_HISTOGRAM_TIMES("History.GetTextMatches",
+                      TimeTicks::Now() - beginning_time);
+
   // When there were no databases in the range, we need to fix up the min time.
   if (!checked_one)
     *first_time_searched = options.begin_time;
@@ -153,6 +153,9 @@ class TextDatabaseManager {
   //
   // This function will return more than one match per URL if there is more than
   // one entry for that URL in the database.
+  //
+  // Several databases are searched at once on worker threads, and this blocks
+  // until they are done.
   void GetTextMatches(const string16& query,
                       const QueryOptions& options,
                       std::vector<TextDatabase::Match>* results,
@@ -0,0 +1,128 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "base/utf_string_conversions.h"
+#include "chrome/browser/history/history_perftest_util.h"
+#include "chrome/browser/history/text_database_manager.h"
+#include "chrome/browser/history/visit_database.h"
+#include "googleurl/src/gurl.h"
+#include "sql/connection.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using base::Time;
+using base::TimeDelta;
+
+namespace history {
+
+namespace {
+
+// The synthetic history spans this many months, with this many pages each.
+const int kMonths = 36;
+const int kPagesPerMonth = 500;
+
+// The number of words in each page body, and in the vocabulary they are drawn
+// from.
+const int kWordsPerPage = 200;
+const int kVocabularySize = 20000;
+
+// Queries for a common word, an uncommon one, a prefix, and two words
+// together.
+const char* const kQueries[] = { "kapo", "xoqujawy", "vil", "kapo rimu" };
+
+// The URL and visit tables the manager keeps in sync, in memory.
+class InMemDB : public URLDatabase, public VisitDatabase {
+ public:
+  InMemDB() {
+    EXPECT_TRUE(db_.OpenInMemory());
+    CreateURLTable(false);
+    InitVisitTable();
+  }
+
+ private:
+  virtual sql::Connection& GetDB() OVERRIDE { return db_; }
+
+  sql::Connection db_;
+
+  DISALLOW_COPY_AND_ASSIGN(InMemDB);
+};
+
+}  // namespace
+
+class TextDatabaseManagerPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  // Indexes the synthetic history into |manager|, one transaction a month.
+  void AddPages(TextDatabaseManager* manager) {
+    PerfTestRandom random;
+    Time now = Time::Now();
+    int id = 1;
+    for (int month = 0; month < kMonths; month++) {
+      manager->BeginTransaction();
+      for (int page = 0; page < kPagesPerMonth; page++, id++) {
+        Time visit_time = now - TimeDelta::FromDays(month * 30) -
+            TimeDelta::FromMinutes(page);
+        std::string title =
+            MakePerfTestWord(random.NextSkewed(kVocabularySize)) + " " +
+            MakePerfTestWord(random.NextSkewed(kVocabularySize));
+        std::string body;
+        for (int word = 0; word < kWordsPerPage; word++) {
+          body += MakePerfTestWord(random.NextSkewed(kVocabularySize));
+          body += word % 15 == 14 ? ". " : " ";
+        }
+        GURL url(base::StringPrintf("http://www.%s.com/%d",
+                                    MakePerfTestWord(id % 3000).c_str(), id));
+        EXPECT_TRUE(manager->AddPageData(url, id, 0, visit_time,
+                                         UTF8ToUTF16(title),
+                                         UTF8ToUTF16(body)));
+      }
+      manager->CommitTransaction();
+    }
+  }
+
+  MessageLoop message_loop_;
+  ScopedTempDir temp_dir_;
+};
+
+// Times full-text queries over all of a multi-year history, both for a page
+// of results, as the history page asks for, and for all of them.
+TEST_F(TextDatabaseManagerPerfTest, QueryAllTime) {
+  InMemDB visit_db;
+  TextDatabaseManager manager(temp_dir_.path(), &visit_db, &visit_db);
+  ASSERT_TRUE(manager.Init(NULL));
+  AddPages(&manager);
+
+  const int kMaxCounts[] = { 100, 0 };
+  for (size_t i = 0; i < arraysize(kMaxCounts); i++) {
+    for (size_t j = 0; j < arraysize(kQueries); j++) {
+      QueryOptions options;
+      options.max_count = kMaxCounts[i];
+      std::vector<TextDatabase::Match> results;
+      Time first_time_searched;
+      PerfTimer timer;
+      manager.GetTextMatches(UTF8ToUTF16(kQueries[j]), options, &results,
+                             &first_time_searched);
+      std::string name = base::StringPrintf(
+          "TextDatabaseManager_%s_%d_", kMaxCounts[i] ? "Page" : "All",
+          static_cast<int>(j));
+      LogPerfResult((name + "Time").c_str(),
+                    timer.Elapsed().InMillisecondsF(), "ms");
+      LogPerfResult((name + "Results").c_str(), results.size(), "results");
+    }
+  }
+}
+
+}  // namespace history
@@ -5,6 +5,7 @@
 #include "base/file_path.h"
 #include "base/file_util.h"
 #include "base/message_loop.h"
+#include "base/stringprintf.h"
 #include "base/utf_string_conversions.h"
 #include "chrome/browser/history/text_database_manager.h"
 #include "chrome/browser/history/visit_database.h"
@@ -534,4 +535,109 @@ TEST_F(TextDatabaseManagerTest, QueryBackwards) {
   EXPECT_EQ(0U, results.size());
 }
 
+// Tests querying more databases than are searched at once.
+TEST_F(TextDatabaseManagerTest, QueryManyDatabases) {
+  ASSERT_TRUE(Init());
+  InMemDB visit_db;
+  TextDatabaseManager manager(dir_, &visit_db, &visit_db);
+  ASSERT_TRUE(manager.Init(NULL));
+
+  // One page a month, in more months than the manager keeps open.
+  Time::Exploded exploded;
+  memset(&exploded, 0, sizeof(Time::Exploded));
+  exploded.year = 2009;
+  exploded.day_of_month = 3;
+  std::vector<Time> times;
+  for (int month = 1; month <= 12; month++) {
+    exploded.month = month;
+    times.push_back(Time::FromUTCExploded(exploded));
+    GURL url(base::StringPrintf("http://www.google.com/%d", month));
+    ASSERT_TRUE(manager.AddPageData(url, month, 0, times.back(),
+                                    UTF8ToUTF16(kTitle1),
+                                    UTF8ToUTF16(kBody1)));
+  }
+
+  string16 foo = UTF8ToUTF16("FOO");
+  QueryOptions options;
+  options.begin_time = times[0] - TimeDelta::FromDays(100);
+  options.end_time = times.back() + TimeDelta::FromDays(100);
+  std::vector<TextDatabase::Match> results;
+  Time first_time_searched;
+  manager.GetTextMatches(foo, options, &results, &first_time_searched);
+
+  // All the pages, most recent first.
+  ASSERT_EQ(times.size(), results.size());
+  for (size_t i = 0; i < results.size(); i++)
+    EXPECT_TRUE(times[times.size() - 1 - i] == results[i].time);
+  EXPECT_TRUE(first_time_searched == options.begin_time);
+
+  // Asking for fewer stops at the last page returned, in a database after the
+  // first few searched.
+  options.max_count = 7;
+  manager.GetTextMatches(foo, options, &results, &first_time_searched);
+  ASSERT_EQ(7U, results.size());
+  EXPECT_TRUE(times[5] == first_time_searched);
+  EXPECT_TRUE(times[5] == results[6].time);
+
+  // Going back from there gets the rest.
+  options.end_time = first_time_searched;
+  manager.GetTextMatches(foo, options, &results, &first_time_searched);
+  ASSERT_EQ(5U, results.size());
+  EXPECT_TRUE(times[4] == results[0].time);
+  EXPECT_TRUE(first_time_searched == options.begin_time);
+}
+
+// Tests that a URL found in more than one month counts once towards the
+// maximum number of results.
+TEST_F(TextDatabaseManagerTest, QueryDuplicateURLsWithMaxCount) {
+  ASSERT_TRUE(Init());
+  InMemDB visit_db;
+  TextDatabaseManager manager(dir_, &visit_db, &visit_db);
+  ASSERT_TRUE(manager.Init(NULL));
+
+  Time::Exploded exploded;
+  memset(&exploded, 0, sizeof(Time::Exploded));
+  exploded.year = 2009;
+  exploded.month = 3;
+  exploded.day_of_month = 3;
+  Time march = Time::FromUTCExploded(exploded);
+  exploded.month = 2;
+  Time february = Time::FromUTCExploded(exploded);
+
+  // kURL1 is in March, and twice in February ahead of the other pages there.
+  const GURL url1(kURL1);
+  const GURL url2(kURL2);
+  const GURL url3(kURL3);
+  ASSERT_TRUE(manager.AddPageData(url1, 1, 0, march, UTF8ToUTF16(kTitle1),
+                                  UTF8ToUTF16(kBody1)));
+  ASSERT_TRUE(manager.AddPageData(url1, 1, 0,
+                                  february + TimeDelta::FromDays(3),
+                                  UTF8ToUTF16(kTitle1), UTF8ToUTF16(kBody1)));
+  ASSERT_TRUE(manager.AddPageData(url1, 1, 0,
+                                  february + TimeDelta::FromDays(2),
+                                  UTF8ToUTF16(kTitle1), UTF8ToUTF16(kBody1)));
+  ASSERT_TRUE(manager.AddPageData(url2, 2, 0,
+                                  february + TimeDelta::FromDays(1),
+                                  UTF8ToUTF16(kTitle2), UTF8ToUTF16(kBody2)));
+  ASSERT_TRUE(manager.AddPageData(url3, 3, 0, february, UTF8ToUTF16(kTitle3),
+                                  UTF8ToUTF16(kBody3)));
+
+  QueryOptions options;
+  options.begin_time = february - TimeDelta::FromDays(100);
+  options.end_time = march + TimeDelta::FromDays(100);
+  options.max_count = 3;
+  std::vector<TextDatabase::Match> results;
+  Time first_time_searched;
+  manager.GetTextMatches(UTF8ToUTF16("FOO"), options, &results,
+                         &first_time_searched);
+
+  // The most recent visit of each URL, down to the third URL found.
+  ASSERT_EQ(3U, results.size());
+  EXPECT_EQ(url1, results[0].url);
+  EXPECT_TRUE(march == results[0].time);
+  EXPECT_EQ(url2, results[1].url);
+  EXPECT_EQ(url3, results[2].url);
+  EXPECT_TRUE(february == first_time_searched);
+}
+
 }  // namespace history
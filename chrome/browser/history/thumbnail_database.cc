@@ -153,6 +153,10 @@ sql::InitStatus ThumbnailDatabase::OpenDatabase(sql::Connection* db,
   db->set_page_size(2048);
   db->set_cache_size(32);
 
+  // Favicons can be fetched again, so only sync at checkpoints.
+  db->set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+  db->set_synchronous(sql::Connection::SYNCHRONOUS_NORMAL);
+
   // Run the database in exclusive mode. Nobody else should be accessing the
   // database while we're running, and this will give somewhat improved perf.
   db->set_exclusive_locking();
@@ -4,6 +4,10 @@
 
 #include "base/file_util.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/metrics/histogram.h"
+#include "base/sha1.h"
+#include "base/string_number_conversions.h"
 #include "base/string_split.h"
 #include "base/string_util.h"
 #include "chrome/browser/diagnostics/sqlite_diagnostics.h"
@@ -16,8 +20,10 @@
 namespace history {
 
 // From the version 1 to 2, one column was added. Old versions of Chrome
-// should be able to read version 2 files just fine.
-static const int kVersionNumber = 2;
+// should be able to read version 2 files just fine. Version 3 moved the
+// thumbnails into the thumbnail_data table, shared by the pages whose
+// thumbnails are the same.
+static const int kVersionNumber = 3;
 
 TopSitesDatabase::TopSitesDatabase() : may_need_history_migration_(false) {
 }
@@ -62,7 +68,7 @@ bool TopSitesDatabase::Init(const FilePath& db_name) {
   if (!meta_table_.Init(db_.get(), kVersionNumber, kVersionNumber))
     return false;
 
-  if (!InitThumbnailTable())
+  if (!InitThumbnailTable() || !InitThumbnailDataTable())
     return false;
 
   if (meta_table_.GetVersionNumber() == 1) {
@@ -72,6 +78,13 @@ bool TopSitesDatabase::Init(const FilePath& db_name) {
     }
   }
 
+  if (meta_table_.GetVersionNumber() == 2) {
+    if (!UpgradeToVersion3()) {
+      LOG(WARNING) << "Unable to upgrade top sites database to version 3.";
+      return false;
+    }
+  }
+
   // Version check.
   if (meta_table_.GetVersionNumber() != kVersionNumber)
     return false;
@@ -95,7 +108,21 @@ bool TopSitesDatabase::InitThumbnailTable() {
                       "good_clipping INTEGER DEFAULT 0, "
                       "at_top INTEGER DEFAULT 0, "
                       "last_updated INTEGER DEFAULT 0, "
-                      "load_completed INTEGER DEFAULT 0) ")) {
+                      "load_completed INTEGER DEFAULT 0, "
+                      "thumbnail_hash LONGVARCHAR) ")) {
+      LOG(WARNING) << db_->GetErrorMessage();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TopSitesDatabase::InitThumbnailDataTable() {
+  if (!db_->DoesTableExist("thumbnail_data")) {
+    if (!db_->Execute("CREATE TABLE thumbnail_data ("
+                      "hash LONGVARCHAR PRIMARY KEY,"
+                      "ref_count INTEGER DEFAULT 0,"
+                      "data BLOB)")) {
       LOG(WARNING) << db_->GetErrorMessage();
       return false;
     }
@@ -114,13 +141,58 @@ bool TopSitesDatabase::UpgradeToVersion2() {
   return true;
 }
 
+bool TopSitesDatabase::UpgradeToVersion3() {
+  // Add 'thumbnail_hash' column.
+  if (!db_->Execute("ALTER TABLE thumbnails ADD thumbnail_hash LONGVARCHAR")) {
+    NOTREACHED();
+    return false;
+  }
+
+  // Read all the thumbnails before moving them, rather than change the table
+  // while stepping through it.
+  std::vector<std::string> urls;
+  std::vector<scoped_refptr<base::RefCountedBytes> > thumbnails;
+  sql::Statement select_statement(db_->GetUniqueStatement(
+      "SELECT url, thumbnail FROM thumbnails WHERE thumbnail IS NOT NULL"));
+  while (select_statement.Step()) {
+    std::vector<unsigned char> data;
+    select_statement.ColumnBlobAsVector(1, &data);
+    if (data.empty())
+      continue;
+    urls.push_back(select_statement.ColumnString(0));
+    thumbnails.push_back(base::RefCountedBytes::TakeVector(&data));
+  }
+  if (!select_statement.Succeeded())
+    return false;
+
+  for (size_t i = 0; i < urls.size(); i++) {
+    std::string hash = AddThumbnailData(thumbnails[i]);
+    if (hash.empty())
+      return false;
+    sql::Statement update_statement(db_->GetCachedStatement(
+        SQL_FROM_HERE,
+        "UPDATE thumbnails SET thumbnail_hash = ?, thumbnail = NULL "
+        "WHERE url = ?"));
+    update_statement.BindString(0, hash);
+    update_statement.BindString(1, urls[i]);
+    if (!update_statement.Run())
+      return false;
+  }
+
+  meta_table_.SetVersionNumber(3);
+  return true;
+}
+
 void TopSitesDatabase::GetPageThumbnails(MostVisitedURLList* urls,
                                          URLToImagesMap* thumbnails) {
   sql::Statement statement(db_->GetCachedStatement(
       SQL_FROM_HERE,
-      "SELECT url, url_rank, title, thumbnail, redirects, "
-      "boring_score, good_clipping, at_top, last_updated, load_completed "
-      "FROM thumbnails ORDER BY url_rank "));
+      "SELECT url, url_rank, title, data, redirects, "
+      "boring_score, good_clipping, at_top, last_updated, load_completed, "
+      "thumbnail_hash "
+      "FROM thumbnails LEFT OUTER JOIN thumbnail_data "
+      "ON thumbnails.thumbnail_hash = thumbnail_data.hash "
+      "ORDER BY url_rank "));
 
   if (!statement.is_valid()) {
     LOG(WARNING) << db_->GetErrorMessage();
@@ -130,6 +202,11 @@ void TopSitesDatabase::GetPageThumbnails(MostVisitedURLList* urls,
   urls->clear();
   thumbnails->clear();
 
+  // Pages with the same thumbnail share one copy of it in memory, as they do
+  // on disk.
+  std::map<std::string, scoped_refptr<base::RefCountedBytes> > data_by_hash;
+  size_t bytes_saved = 0;
+
   while (statement.Step()) {
     // Results are sorted by url_rank.
     MostVisitedURL url;
@@ -140,11 +217,20 @@ void TopSitesDatabase::GetPageThumbnails(MostVisitedURLList* urls,
     SetRedirects(redirects, &url);
     urls->push_back(url);
 
-    std::vector<unsigned char> data;
-    statement.ColumnBlobAsVector(3, &data);
     Images thumbnail;
-    if (!data.empty())
-      thumbnail.thumbnail = base::RefCountedBytes::TakeVector(&data);
+    std::string hash = statement.ColumnString(10);
+    if (!hash.empty()) {
+      scoped_refptr<base::RefCountedBytes>& shared_data = data_by_hash[hash];
+      if (shared_data.get()) {
+        bytes_saved += shared_data->size();
+      } else {
+        std::vector<unsigned char> data;
+        statement.ColumnBlobAsVector(3, &data);
+        if (!data.empty())
+          shared_data = base::RefCountedBytes::TakeVector(&data);
+      }
+      thumbnail.thumbnail = shared_data;
+    }
     thumbnail.thumbnail_score.boring_score = statement.ColumnDouble(5);
     thumbnail.thumbnail_score.good_clipping = statement.ColumnBool(6);
     thumbnail.thumbnail_score.at_top = statement.ColumnBool(7);
@@ -154,6 +240,9 @@ void TopSitesDatabase::GetPageThumbnails(MostVisitedURLList* urls,
 
     (*thumbnails)[gurl] = thumbnail;
   }
+
+  UMA_HISTOGRAM_MEMORY_KB("History.TopSitesSharedThumbnailKB",
+                          static_cast<int>(bytes_saved / 1024));
 }
 
 // static
@@ -192,18 +281,24 @@ void TopSitesDatabase::SetPageThumbnail(const MostVisitedURL& url,
 
 bool TopSitesDatabase::UpdatePageThumbnail(
     const MostVisitedURL& url, const Images& thumbnail) {
+  std::string old_hash = GetThumbnailHash(url.url);
+  std::string hash;
+  if (thumbnail.thumbnail.get() && thumbnail.thumbnail->front()) {
+    hash = AddThumbnailData(thumbnail.thumbnail);
+    if (hash.empty())
+      return false;
+  }
+
   sql::Statement statement(db_->GetCachedStatement(
       SQL_FROM_HERE,
       "UPDATE thumbnails SET "
-      "title = ?, thumbnail = ?, redirects = ?, "
+      "title = ?, thumbnail_hash = ?, redirects = ?, "
       "boring_score = ?, good_clipping = ?, at_top = ?, last_updated = ?, "
       "load_completed = ? "
       "WHERE url = ? "));
   statement.BindString16(0, url.title);
-  if (thumbnail.thumbnail.get() && thumbnail.thumbnail->front()) {
-    statement.BindBlob(1, thumbnail.thumbnail->front(),
-                       static_cast<int>(thumbnail.thumbnail->size()));
-  }
+  if (!hash.empty())
+    statement.BindString(1, hash);
   statement.BindString(2, GetRedirects(url));
   const ThumbnailScore& score = thumbnail.thumbnail_score;
   statement.BindDouble(3, score.boring_score);
@@ -213,7 +308,13 @@ bool TopSitesDatabase::UpdatePageThumbnail(
   statement.BindBool(7, score.load_completed);
   statement.BindString(8, url.url.spec());
 
-  return statement.Run();
+  if (!statement.Run())
+    return false;
+
+  // Released after adding the new reference, in case they are the same.
+  if (!old_hash.empty())
+    ReleaseThumbnailData(old_hash);
+  return true;
 }
 
 void TopSitesDatabase::AddPageThumbnail(const MostVisitedURL& url,
@@ -221,19 +322,26 @@ void TopSitesDatabase::AddPageThumbnail(const MostVisitedURL& url,
                                             const Images& thumbnail) {
   int count = GetRowCount();
 
+  // A row replaced below gives up its reference to its thumbnail data.
+  std::string old_hash = GetThumbnailHash(url.url);
+  std::string hash;
+  if (thumbnail.thumbnail.get() && thumbnail.thumbnail->front()) {
+    hash = AddThumbnailData(thumbnail.thumbnail);
+    if (hash.empty())
+      return;
+  }
+
   sql::Statement statement(db_->GetCachedStatement(
       SQL_FROM_HERE,
       "INSERT OR REPLACE INTO thumbnails "
-      "(url, url_rank, title, thumbnail, redirects, "
+      "(url, url_rank, title, thumbnail_hash, redirects, "
       "boring_score, good_clipping, at_top, last_updated, load_completed) "
       "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
   statement.BindString(0, url.url.spec());
   statement.BindInt(1, count);  // Make it the last url.
   statement.BindString16(2, url.title);
-  if (thumbnail.thumbnail.get() && thumbnail.thumbnail->front()) {
-    statement.BindBlob(3, thumbnail.thumbnail->front(),
-                       static_cast<int>(thumbnail.thumbnail->size()));
-  }
+  if (!hash.empty())
+    statement.BindString(3, hash);
   statement.BindString(4, GetRedirects(url));
   const ThumbnailScore& score = thumbnail.thumbnail_score;
   statement.BindDouble(5, score.boring_score);
@@ -244,6 +352,10 @@ void TopSitesDatabase::AddPageThumbnail(const MostVisitedURL& url,
   if (!statement.Run())
     return;
 
+  // Released after adding the new reference, in case they are the same.
+  if (!old_hash.empty())
+    ReleaseThumbnailData(old_hash);
+
   UpdatePageRankNoTransaction(url, new_rank);
 }
 
@@ -302,8 +414,9 @@ bool TopSitesDatabase::GetPageThumbnail(const GURL& url,
                                             Images* thumbnail) {
   sql::Statement statement(db_->GetCachedStatement(
       SQL_FROM_HERE,
-      "SELECT thumbnail, boring_score, good_clipping, at_top, last_updated "
-      "FROM thumbnails WHERE url=?"));
+      "SELECT data, boring_score, good_clipping, at_top, last_updated "
+      "FROM thumbnails LEFT OUTER JOIN thumbnail_data "
+      "ON thumbnails.thumbnail_hash = thumbnail_data.hash WHERE url=?"));
   statement.BindString(0, url.spec());
   if (!statement.Step())
     return false;
@@ -347,6 +460,8 @@ bool TopSitesDatabase::RemoveURL(const MostVisitedURL& url) {
   if (old_rank < 0)
     return false;
 
+  std::string hash = GetThumbnailHash(url.url);
+
   sql::Transaction transaction(db_.get());
   transaction.Begin();
   // Decrement all following ranks.
@@ -368,9 +483,62 @@ bool TopSitesDatabase::RemoveURL(const MostVisitedURL& url) {
   if (!delete_statement.Run())
     return false;
 
+  if (!hash.empty())
+    ReleaseThumbnailData(hash);
+
   return transaction.Commit();
 }
 
+std::string TopSitesDatabase::GetThumbnailHash(const GURL& url) {
+  sql::Statement statement(db_->GetCachedStatement(
+      SQL_FROM_HERE,
+      "SELECT thumbnail_hash FROM thumbnails WHERE url=?"));
+  statement.BindString(0, url.spec());
+  if (!statement.Step())
+    return std::string();
+  return statement.ColumnString(0);
+}
+
+std::string TopSitesDatabase::AddThumbnailData(
+    const base::RefCountedMemory* data) {
+  unsigned char digest[base::kSHA1Length];
+  base::SHA1HashBytes(data->front(), data->size(), digest);
+  std::string hash = base::HexEncode(digest, sizeof(digest));
+
+  sql::Statement update_statement(db_->GetCachedStatement(
+      SQL_FROM_HERE,
+      "UPDATE thumbnail_data SET ref_count = ref_count + 1 WHERE hash = ?"));
+  update_statement.BindString(0, hash);
+  if (!update_statement.Run())
+    return std::string();
+  if (db_->GetLastChangeCount())
+    return hash;  // Already stored for another page.
+
+  sql::Statement insert_statement(db_->GetCachedStatement(
+      SQL_FROM_HERE,
+      "INSERT INTO thumbnail_data (hash, ref_count, data) VALUES (?, 1, ?)"));
+  insert_statement.BindString(0, hash);
+  insert_statement.BindBlob(1, data->front(), static_cast<int>(data->size()));
+  if (!insert_statement.Run())
+    return std::string();
+  return hash;
+}
+
+void TopSitesDatabase::ReleaseThumbnailData(const std::string& hash) {
+  sql::Statement update_statement(db_->GetCachedStatement(
+      SQL_FROM_HERE,
+      "UPDATE thumbnail_data SET ref_count = ref_count - 1 WHERE hash = ?"));
+  update_statement.BindString(0, hash);
+  if (!update_statement.Run())
+    return;
+
+  sql::Statement delete_statement(db_->GetCachedStatement(
+      SQL_FROM_HERE,
+      "DELETE FROM thumbnail_data WHERE hash = ? AND ref_count <= 0"));
+  delete_statement.BindString(0, hash);
+  delete_statement.Run();
+}
+
 sql::Connection* TopSitesDatabase::CreateDB(const FilePath& db_name) {
   scoped_ptr<sql::Connection> db(new sql::Connection());
   // Settings copied from ThumbnailDatabase.
@@ -16,6 +16,10 @@
 
 class FilePath;
 
+namespace base {
+class RefCountedMemory;
+}
+
 namespace sql {
 class Connection;
 }
@@ -65,15 +69,28 @@ class TopSitesDatabase {
 
  private:
   FRIEND_TEST_ALL_PREFIXES(TopSitesDatabaseTest, UpgradeToVersion2);
+  FRIEND_TEST_ALL_PREFIXES(TopSitesDatabaseTest, UpgradeToVersion3);
+  FRIEND_TEST_ALL_PREFIXES(TopSitesDatabaseTest, SharedThumbnailData);
+  FRIEND_TEST_ALL_PREFIXES(TopSitesDatabaseTest, ReplacedThumbnailData);
 
   // Creates the thumbnail table, returning true if the table already exists
   // or was successfully created.
   bool InitThumbnailTable();
 
+  // Creates the table of thumbnail data, returning true if the table already
+  // exists or was successfully created. The thumbnails are keyed by the hash
+  // of their bytes, so pages with the same thumbnail share one copy, and are
+  // deleted when no page refers to them any more.
+  bool InitThumbnailDataTable();
+
   // Upgrades the thumbnail table to version 2, returning true if the
   // upgrade was successful.
   bool UpgradeToVersion2();
 
+  // Upgrades the thumbnail table to version 3, moving the thumbnails into
+  // the thumbnail data table. Returns true if the upgrade was successful.
+  bool UpgradeToVersion3();
+
   // Adds a new URL to the database.
   void AddPageThumbnail(const MostVisitedURL& url,
                         int new_rank,
@@ -93,6 +110,19 @@ class TopSitesDatabase {
   // Returns the number of URLs (rows) in the database.
   int GetRowCount();
 
+  // Returns the hash of the URL's thumbnail, or an empty string if it has
+  // none.
+  std::string GetThumbnailHash(const GURL& url);
+
+  // Adds a reference to |data| in the thumbnail data table, storing it if it
+  // isn't there already. Returns its hash, or an empty string on failure.
+  // Should be called within an open transaction.
+  std::string AddThumbnailData(const base::RefCountedMemory* data);
+
+  // Drops a reference to the thumbnail data with |hash|, deleting it once it
+  // is unreferenced. Should be called within an open transaction.
+  void ReleaseThumbnailData(const std::string& hash);
+
   sql::Connection* CreateDB(const FilePath& db_name);
 
   // Encodes redirects into a string.
@@ -2,14 +2,40 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <map>
+#include <vector>
+
 #include "base/file_path.h"
 #include "base/file_util.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/scoped_temp_dir.h"
+#include "base/utf_string_conversions.h"
 #include "chrome/browser/history/top_sites_database.h"
+#include "sql/connection.h"
+#include "sql/statement.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace history {
 
+namespace {
+
+// Returns thumbnail bytes made of |size| copies of |value|.
+Images MakeThumbnail(unsigned char value, size_t size) {
+  std::vector<unsigned char> data(size, value);
+  Images thumbnail;
+  thumbnail.thumbnail = base::RefCountedBytes::TakeVector(&data);
+  return thumbnail;
+}
+
+int CountThumbnailData(sql::Connection* db) {
+  sql::Statement statement(db->GetUniqueStatement(
+      "SELECT COUNT(*) FROM thumbnail_data"));
+  EXPECT_TRUE(statement.Step());
+  return statement.ColumnInt(0);
+}
+
+}  // namespace
+
 class TopSitesDatabaseTest : public testing::Test {
  protected:
   virtual void SetUp() {
@@ -53,4 +79,106 @@ TEST_F(TopSitesDatabaseTest, UpgradeToVersion2) {
   ASSERT_TRUE(db.db_->DoesColumnExist("thumbnails", "load_completed"));
 }
 
+TEST_F(TopSitesDatabaseTest, UpgradeToVersion3) {
+  TopSitesDatabase db;
+  ASSERT_TRUE(db.Init(file_name_));
+
+  // Create a version 2 table with two pages with the same thumbnail.
+  ASSERT_TRUE(db.db_->Execute("DROP TABLE IF EXISTS thumbnails"));
+  ASSERT_TRUE(db.db_->Execute("CREATE TABLE thumbnails ("
+                              "url LONGVARCHAR PRIMARY KEY,"
+                              "url_rank INTEGER ,"
+                              "title LONGVARCHAR,"
+                              "thumbnail BLOB,"
+                              "redirects LONGVARCHAR,"
+                              "boring_score DOUBLE DEFAULT 1.0, "
+                              "good_clipping INTEGER DEFAULT 0, "
+                              "at_top INTEGER DEFAULT 0, "
+                              "last_updated INTEGER DEFAULT 0, "
+                              "load_completed INTEGER DEFAULT 0)"));
+  ASSERT_TRUE(db.db_->Execute(
+      "INSERT INTO thumbnails (url, url_rank, thumbnail) VALUES "
+      "('http://www.google.com/', 0, X'0102030405')"));
+  ASSERT_TRUE(db.db_->Execute(
+      "INSERT INTO thumbnails (url, url_rank, thumbnail) VALUES "
+      "('http://www.google.com/a', 1, X'0102030405')"));
+  db.meta_table_.SetVersionNumber(2);
+
+  // Upgrade to version 3.
+  ASSERT_TRUE(db.UpgradeToVersion3());
+  ASSERT_EQ(3, db.meta_table_.GetVersionNumber());
+  ASSERT_TRUE(db.db_->DoesColumnExist("thumbnails", "thumbnail_hash"));
+
+  // The thumbnail is stored once, and still read for both pages.
+  EXPECT_EQ(1, CountThumbnailData(db.db_.get()));
+  Images thumbnail;
+  ASSERT_TRUE(db.GetPageThumbnail(GURL("http://www.google.com/a"),
+                                  &thumbnail));
+  ASSERT_EQ(5U, thumbnail.thumbnail->size());
+  EXPECT_EQ(3, thumbnail.thumbnail->front()[2]);
+}
+
+TEST_F(TopSitesDatabaseTest, SharedThumbnailData) {
+  TopSitesDatabase db;
+  ASSERT_TRUE(db.Init(file_name_));
+
+  MostVisitedURL url1(GURL("http://www.google.com/1"), ASCIIToUTF16("1"));
+  MostVisitedURL url2(GURL("http://www.google.com/2"), ASCIIToUTF16("2"));
+  db.SetPageThumbnail(url1, 0, MakeThumbnail(1, 100));
+  db.SetPageThumbnail(url2, 1, MakeThumbnail(1, 100));
+  EXPECT_EQ(1, CountThumbnailData(db.db_.get()));
+
+  // Loaded, the pages share the thumbnail in memory too.
+  MostVisitedURLList urls;
+  std::map<GURL, Images> thumbnails;
+  db.GetPageThumbnails(&urls, &thumbnails);
+  ASSERT_EQ(2U, urls.size());
+  ASSERT_TRUE(thumbnails[url1.url].thumbnail.get());
+  EXPECT_EQ(thumbnails[url1.url].thumbnail.get(),
+            thumbnails[url2.url].thumbnail.get());
+
+  // Setting the same thumbnail again doesn't lose it.
+  db.SetPageThumbnail(url1, 0, MakeThumbnail(1, 100));
+  EXPECT_EQ(1, CountThumbnailData(db.db_.get()));
+
+  // A different thumbnail is stored separately.
+  db.SetPageThumbnail(url2, 1, MakeThumbnail(2, 100));
+  EXPECT_EQ(2, CountThumbnailData(db.db_.get()));
+  Images thumbnail;
+  ASSERT_TRUE(db.GetPageThumbnail(url2.url, &thumbnail));
+  EXPECT_EQ(2, thumbnail.thumbnail->front()[0]);
+
+  // Thumbnails go away with the last page using them.
+  ASSERT_TRUE(db.RemoveURL(url1));
+  EXPECT_EQ(1, CountThumbnailData(db.db_.get()));
+  ASSERT_TRUE(db.RemoveURL(url2));
+  EXPECT_EQ(0, CountThumbnailData(db.db_.get()));
+}
+
+// Replacing a page's thumbnail deletes the data of the old one.
+TEST_F(TopSitesDatabaseTest, ReplacedThumbnailData) {
+  TopSitesDatabase db;
+  ASSERT_TRUE(db.Init(file_name_));
+
+  MostVisitedURL url(GURL("http://www.google.com/1"), ASCIIToUTF16("1"));
+  db.SetPageThumbnail(url, 0, MakeThumbnail(1, 100));
+  EXPECT_EQ(1, CountThumbnailData(db.db_.get()));
+
+  // Through an update of the existing row.
+  db.SetPageThumbnail(url, 0, MakeThumbnail(2, 100));
+  EXPECT_EQ(1, CountThumbnailData(db.db_.get()));
+  Images thumbnail;
+  ASSERT_TRUE(db.GetPageThumbnail(url.url, &thumbnail));
+  EXPECT_EQ(2, thumbnail.thumbnail->front()[0]);
+
+  // Through a replacement of the whole row.
+  db.AddPageThumbnail(url, 0, MakeThumbnail(3, 100));
+  EXPECT_EQ(1, CountThumbnailData(db.db_.get()));
+  ASSERT_TRUE(db.GetPageThumbnail(url.url, &thumbnail));
+  EXPECT_EQ(3, thumbnail.thumbnail->front()[0]);
+
+  ASSERT_TRUE(db.RemoveURL(url));
+  EXPECT_EQ(0, CountThumbnailData(db.db_.get()));
+}
+
 }  // namespace history
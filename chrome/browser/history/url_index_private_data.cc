@@ -12,7 +12,9 @@
 
 #include "base/file_util.h"
 #include "base/i18n/case_conversion.h"
+#include "base/md5.h"
 #include "base/metrics/histogram.h"
+#include "base/platform_file.h"
 #include "base/string_util.h"
 #include "base/time.h"
 #include "base/utf_string_conversions.h"
@@ -28,6 +30,7 @@
 using google::protobuf::RepeatedField;
 using google::protobuf::RepeatedPtrField;
 using in_memory_url_index::InMemoryURLIndexCacheItem;
+using in_memory_url_index::InMemoryURLIndexJournalEntry;
 
 namespace history {
 
@@ -49,6 +52,69 @@ typedef imui::InMemoryURLIndexCacheItem_WordStartsMapItem WordStartsMapItem;
 typedef imui::InMemoryURLIndexCacheItem_WordStartsMapItem_WordStartsMapEntry
     WordStartsMapEntry;
 
+namespace {
+
+// The cache file starts with this header.  |checksum| is the MD5 of the
+// |payload_size| bytes of serialized InMemoryURLIndexCacheItem that follow.
+// The file is only read back on the machine that wrote it, so the header is
+// written as it is laid out in memory.
+struct CacheFileHeader {
+  uint32 magic;
+  uint32 payload_size;
+  base::MD5Digest checksum;
+};
+
+const uint32 kCacheFileMagic = 0x494d5549;  // 'IMUI'
+
+// Checks the header of the cache file contents in |data| and the checksum of
+// the payload, and returns the payload in |payload| and |payload_size|.
+bool GetCacheFilePayload(const uint8* data,
+                         size_t length,
+                         const uint8** payload,
+                         size_t* payload_size) {
+  CacheFileHeader header;
+  if (length < sizeof(header))
+    return false;
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != kCacheFileMagic ||
+      header.payload_size != length - sizeof(header))
+    return false;
+  base::MD5Digest checksum;
+  base::MD5Sum(data + sizeof(header), header.payload_size, &checksum);
+  if (memcmp(&checksum, &header.checksum, sizeof(checksum)) != 0)
+    return false;
+  *payload = data + sizeof(header);
+  *payload_size = header.payload_size;
+  return true;
+}
+
+// Fills |id_set| with the IDs in |ids|.  They are saved from a sorted set, so
+// they can normally be taken as they are.
+template <typename T, typename RepeatedIDs>
+void RestoreIDSet(const RepeatedIDs& ids, SortedIDSet<T>* id_set) {
+  std::vector<T> sorted_ids(ids.begin(), ids.end());
+  if (std::adjacent_find(sorted_ids.begin(), sorted_ids.end(),
+                         std::greater_equal<T>()) != sorted_ids.end()) {
+    std::sort(sorted_ids.begin(), sorted_ids.end());
+    sorted_ids.erase(std::unique(sorted_ids.begin(), sorted_ids.end()),
+                     sorted_ids.end());
+  }
+  id_set->SwapSortedIDs(&sorted_ids);
+}
+
+// Cuts the file at |path| down to its first |length| bytes.
+bool TruncateFile(const FilePath& path, int64 length) {
+  base::PlatformFile file = base::CreatePlatformFile(
+      path, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_WRITE, NULL, NULL);
+  if (file == base::kInvalidPlatformFileValue)
+    return false;
+  bool truncated = base::TruncatePlatformFile(file, length);
+  base::ClosePlatformFile(file);
+  return truncated;
+}
+
+}  // namespace
+
 // The maximum score any candidate result can achieve.
 const int kMaxTotalScore = 1425;
 
@@ -145,6 +211,46 @@ bool URLIndexPrivateData::Empty() const {
   return history_info_map_.empty();
 }
 
+void URLIndexPrivateData::ShrinkIndex() {
+  for (CharWordIDMap::iterator iter = char_word_map_.begin();
+       iter != char_word_map_.end(); ++iter)
+    iter->second.ShrinkToFit();
+  for (WordIDHistoryMap::iterator iter = word_id_history_map_.begin();
+       iter != word_id_history_map_.end(); ++iter)
+    iter->second.ShrinkToFit();
+  for (HistoryIDWordMap::iterator iter = history_id_word_map_.begin();
+       iter != history_id_word_map_.end(); ++iter)
+    iter->second.ShrinkToFit();
+}
+
+size_t URLIndexPrivateData::EstimateIndexMemoryUsage() const {
+  // A red-black tree node holds three pointers and a color besides its value.
+  const size_t kMapNodeOverhead = 4 * sizeof(void*);
+
+  size_t usage = word_list_.capacity() * sizeof(string16);
+  for (String16Vector::const_iterator iter = word_list_.begin();
+       iter != word_list_.end(); ++iter)
+    usage += iter->capacity() * sizeof(char16);
+  usage += word_map_.size() *
+      (kMapNodeOverhead + sizeof(WordMap::value_type));
+  usage += char_word_map_.size() *
+      (kMapNodeOverhead + sizeof(CharWordIDMap::value_type));
+  for (CharWordIDMap::const_iterator iter = char_word_map_.begin();
+       iter != char_word_map_.end(); ++iter)
+    usage += iter->second.EstimateMemoryUsage();
+  usage += word_id_history_map_.size() *
+      (kMapNodeOverhead + sizeof(WordIDHistoryMap::value_type));
+  for (WordIDHistoryMap::const_iterator iter = word_id_history_map_.begin();
+       iter != word_id_history_map_.end(); ++iter)
+    usage += iter->second.EstimateMemoryUsage();
+  usage += history_id_word_map_.size() *
+      (kMapNodeOverhead + sizeof(HistoryIDWordMap::value_type));
+  for (HistoryIDWordMap::const_iterator iter = history_id_word_map_.begin();
+       iter != history_id_word_map_.end(); ++iter)
+    usage += iter->second.EstimateMemoryUsage();
+  return usage;
+}
+
 scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::Duplicate() const {
   scoped_refptr<URLIndexPrivateData> data_copy = new URLIndexPrivateData;
   data_copy->word_list_ = word_list_;
@@ -503,9 +609,9 @@ ScoredHistoryMatches URLIndexPrivateData::HistoryItemsForTerms(
                       history_ids.begin() + kItemsToScoreLimit,
                       history_ids.end(),
                       item_factor_functor);
-    history_id_set.clear();
-    std::copy(history_ids.begin(), history_ids.begin() + kItemsToScoreLimit,
-              std::inserter(history_id_set, history_id_set.end()));
+    history_ids.resize(kItemsToScoreLimit);
+    std::sort(history_ids.begin(), history_ids.end());
+    history_id_set.SwapSortedIDs(&history_ids);
     post_filter_item_count_ = history_id_set.size();
   }
 
@@ -774,12 +880,7 @@ HistoryIDSet URLIndexPrivateData::HistoryIDSetFromWords(
     if (iter == words.begin()) {
       history_id_set.swap(term_history_set);
     } else {
-      HistoryIDSet new_history_id_set;
-      std::set_intersection(history_id_set.begin(), history_id_set.end(),
-                            term_history_set.begin(), term_history_set.end(),
-                            std::inserter(new_history_id_set,
-                                          new_history_id_set.begin()));
-      history_id_set.swap(new_history_id_set);
+      history_id_set.IntersectWith(term_history_set);
     }
   }
   return history_id_set;
@@ -851,24 +952,20 @@ HistoryIDSet URLIndexPrivateData::HistoryIDsForTerm(
       if (prefix_chars.empty()) {
         word_id_set.swap(leftover_set);
       } else {
-        WordIDSet new_word_id_set;
-        std::set_intersection(word_id_set.begin(), word_id_set.end(),
-                              leftover_set.begin(), leftover_set.end(),
-                              std::inserter(new_word_id_set,
-                                            new_word_id_set.begin()));
-        word_id_set.swap(new_word_id_set);
+        word_id_set.IntersectWith(leftover_set);
       }
     }
 
     // We must filter the word list because the resulting word set surely
     // contains words which do not have the search term as a proper subset.
+    std::vector<WordID> matching_word_ids;
+    matching_word_ids.reserve(word_id_set.size());
     for (WordIDSet::iterator word_set_iter = word_id_set.begin();
-         word_set_iter != word_id_set.end(); ) {
-      if (word_list_[*word_set_iter].find(term) == string16::npos)
-        word_id_set.erase(word_set_iter++);
-      else
-        ++word_set_iter;
+         word_set_iter != word_id_set.end(); ++word_set_iter) {
+      if (word_list_[*word_set_iter].find(term) != string16::npos)
+        matching_word_ids.push_back(*word_set_iter);
     }
+    word_id_set.SwapSortedIDs(&matching_word_ids);
   } else {
     word_id_set = WordIDSetForTermChars(Char16SetFromString16(term));
   }
@@ -877,16 +974,17 @@ HistoryIDSet URLIndexPrivateData::HistoryIDsForTerm(
   // the sets from each word.
   HistoryIDSet history_id_set;
   if (!word_id_set.empty()) {
+    std::vector<const HistoryIDSet*> word_history_id_sets;
+    word_history_id_sets.reserve(word_id_set.size());
     for (WordIDSet::iterator word_id_iter = word_id_set.begin();
          word_id_iter != word_id_set.end(); ++word_id_iter) {
       WordID word_id = *word_id_iter;
       WordIDHistoryMap::iterator word_iter = word_id_history_map_.find(word_id);
-      if (word_iter != word_id_history_map_.end()) {
-        HistoryIDSet& word_history_id_set(word_iter->second);
-        history_id_set.insert(word_history_id_set.begin(),
-                              word_history_id_set.end());
-      }
+      if (word_iter != word_id_history_map_.end())
+        word_history_id_sets.push_back(&word_iter->second);
     }
+    UnionSortedIDSets(word_history_id_sets.begin(), word_history_id_sets.end(),
+                      &history_id_set);
   }
 
   // Record a new cache entry for this word if the term is longer than
@@ -921,12 +1019,7 @@ WordIDSet URLIndexPrivateData::WordIDSetForTermChars(
       word_id_set = char_word_id_set;
     } else {
       // Subsequent character results get intersected in.
-      WordIDSet new_word_id_set;
-      std::set_intersection(word_id_set.begin(), word_id_set.end(),
-                            char_word_id_set.begin(), char_word_id_set.end(),
-                            std::inserter(new_word_id_set,
-                                          new_word_id_set.begin()));
-      word_id_set.swap(new_word_id_set);
+      word_id_set.IntersectWith(char_word_id_set);
     }
   }
   return word_id_set;
@@ -942,21 +1035,39 @@ void URLIndexPrivateData::WritePrivateDataToCacheFileTask(
   DCHECK(private_data.get());
   DCHECK(!file_path.empty());
   succeeded->set_value(private_data->SaveToFile(file_path));
+  if (succeeded->value())
+    file_util::Delete(GetJournalFilePath(file_path), false);
 }
 
 bool URLIndexPrivateData::SaveToFile(const FilePath& file_path) {
   base::TimeTicks beginning_time = base::TimeTicks::Now();
   InMemoryURLIndexCacheItem index_cache;
   SavePrivateData(&index_cache);
-  std::string data;
-  if (!index_cache.SerializeToString(&data)) {
+  std::string data(sizeof(CacheFileHeader), '\0');
+  if (!index_cache.AppendToString(&data)) {
     LOG(WARNING) << "Failed to serialize the InMemoryURLIndex cache.";
     return false;
   }
-
+  CacheFileHeader header;
+  header.magic = kCacheFileMagic;
+  header.payload_size = data.size() - sizeof(header);
+  base::MD5Sum(data.data() + sizeof(header), header.payload_size,
+               &header.checksum);
+  memcpy(&data[0], &header, sizeof(header));
+
+  // Write a new file and move it into place, so that a failed write leaves
+  // the previous cache, which the journal still applies to.
+  FilePath temp_path;
+  if (!file_util::CreateTemporaryFileInDir(file_path.DirName(), &temp_path)) {
+    LOG(WARNING) << "Failed to create a temporary file for "
+                 << file_path.value();
+    return false;
+  }
   int size = data.size();
-  if (file_util::WriteFile(file_path, data.c_str(), size) != size) {
+  if (file_util::WriteFile(temp_path, data.data(), size) != size ||
+      !file_util::ReplaceFile(temp_path, file_path)) {
     LOG(WARNING) << "Failed to write " << file_path.value();
+    file_util::Delete(temp_path, false);
     return false;
   }
   UMA_HISTOGRAM_TIMES("History.InMemoryURLIndexSaveCacheTime",
@@ -1092,48 +1203,79 @@ void URLIndexPrivateData::SaveWordStartsMap(
 // Cache Restoring -------------------------------------------------------------
 
 // static
-void URLIndexPrivateData::RestoreFromFileTask(
+scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::RestoreFromFile(
     const FilePath& file_path,
-    scoped_refptr<URLIndexPrivateData> private_data,
-    const std::string& languages) {
-  private_data = URLIndexPrivateData::RestoreFromFile(file_path, languages);
+    const std::string& languages,
+    const std::set<std::string>& scheme_whitelist) {
+  base::TimeTicks beginning_time = base::TimeTicks::Now();
+  int64 cache_size = 0;
+  int journal_entries = 0;
+  scoped_refptr<URLIndexPrivateData> restored_data(
+      ReadFromFile(file_path, languages, scheme_whitelist, &cache_size,
+                   &journal_entries));
+  if (!restored_data.get())
+    return NULL;
+
+  UMA_HISTOGRAM_TIMES("History.InMemoryURLIndexRestoreCacheTime",
+                      base::TimeTicks::Now() - beginning_time);
+  UMA_HISTOGRAM_COUNTS("History.InMemoryURLHistoryItems",
+                       restored_data->history_id_word_map_.size());
+  UMA_HISTOGRAM_COUNTS("History.InMemoryURLCacheSize", cache_size);
+  UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLJournalEntries",
+                             journal_entries);
+  UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLWords",
+                             restored_data->word_map_.size());
+  UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLChars",
+                             restored_data->char_word_map_.size());
+  UMA_HISTOGRAM_MEMORY_KB("History.InMemoryURLIndexMemory",
+                          restored_data->EstimateIndexMemoryUsage() / 1024);
+  if (restored_data->Empty())
+    return NULL;  // 'No data' is the same as a failed reload.
+  return restored_data;
 }
 
 // static
-scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::RestoreFromFile(
+scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::ReadFromFile(
     const FilePath& file_path,
-    const std::string& languages) {
-  base::TimeTicks beginning_time = base::TimeTicks::Now();
-  if (!file_util::PathExists(file_path))
-    return NULL;
-  std::string data;
+    const std::string& languages,
+    const std::set<std::string>& scheme_whitelist,
+    int64* cache_size,
+    int* journal_entries) {
   // If there is no cache file then simply give up. This will cause us to
   // attempt to rebuild from the history database.
-  if (!file_util::ReadFileToString(file_path, &data))
+  if (!file_util::PathExists(file_path))
+    return NULL;
+  // The protobuf is parsed straight out of the mapped file, rather than out
+  // of a copy read into memory.
+  file_util::MemoryMappedFile mapped_file;
+  if (!mapped_file.Initialize(file_path))
+    return NULL;
+  const uint8* payload = NULL;
+  size_t payload_size = 0;
+  bool valid = GetCacheFilePayload(mapped_file.data(), mapped_file.length(),
+                                   &payload, &payload_size);
+  UMA_HISTOGRAM_BOOLEAN("History.InMemoryURLCacheValid", valid);
+  if (!valid) {
+    LOG(WARNING) << "Ignoring damaged URLIndexPrivateData cache file "
+                 << file_path.value();
     return NULL;
+  }
 
   scoped_refptr<URLIndexPrivateData> restored_data(new URLIndexPrivateData);
   InMemoryURLIndexCacheItem index_cache;
-  if (!index_cache.ParseFromArray(data.c_str(), data.size())) {
+  if (!index_cache.ParseFromArray(payload, payload_size)) {
     LOG(WARNING) << "Failed to parse URLIndexPrivateData cache data read from "
                  << file_path.value();
-    return restored_data;
+    return NULL;
   }
 
   if (!restored_data->RestorePrivateData(index_cache, languages))
     return NULL;
+  *journal_entries = restored_data->ReplayJournal(
+      GetJournalFilePath(file_path), languages, scheme_whitelist);
+  restored_data->ShrinkIndex();
 
-  UMA_HISTOGRAM_TIMES("History.InMemoryURLIndexRestoreCacheTime",
-                      base::TimeTicks::Now() - beginning_time);
-  UMA_HISTOGRAM_COUNTS("History.InMemoryURLHistoryItems",
-                       restored_data->history_id_word_map_.size());
-  UMA_HISTOGRAM_COUNTS("History.InMemoryURLCacheSize", data.size());
-  UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLWords",
-                             restored_data->word_map_.size());
-  UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLChars",
-                             restored_data->char_word_map_.size());
-  if (restored_data->Empty())
-    return NULL;  // 'No data' is the same as a failed reload.
+  *cache_size = mapped_file.length();
   return restored_data;
 }
 
@@ -1153,6 +1295,7 @@ scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::RebuildFromHistory(
     return NULL;
   for (URLRow row; history_enum.GetNextURL(&row); )
     rebuilt_data->IndexRow(row, languages, scheme_whitelist);
+  rebuilt_data->ShrinkIndex();
 
   UMA_HISTOGRAM_TIMES("History.InMemoryURLIndexingTime",
                       base::TimeTicks::Now() - beginning_time);
@@ -1162,6 +1305,8 @@ scoped_refptr<URLIndexPrivateData> URLIndexPrivateData::RebuildFromHistory(
                              rebuilt_data->word_map_.size());
   UMA_HISTOGRAM_COUNTS_10000("History.InMemoryURLChars",
                              rebuilt_data->char_word_map_.size());
+  UMA_HISTOGRAM_MEMORY_KB("History.InMemoryURLIndexMemory",
+                          rebuilt_data->EstimateIndexMemoryUsage() / 1024);
   return rebuilt_data;
 }
 
@@ -1225,12 +1370,7 @@ bool URLIndexPrivateData::RestoreCharWordMap(
     if (actual_item_count == 0 || actual_item_count != expected_item_count)
       return false;
     char16 uni_char = static_cast<char16>(iter->char_16());
-    WordIDSet word_id_set;
-    const RepeatedField<int32>& word_ids(iter->word_id());
-    for (RepeatedField<int32>::const_iterator jiter = word_ids.begin();
-         jiter != word_ids.end(); ++jiter)
-      word_id_set.insert(*jiter);
-    char_word_map_[uni_char] = word_id_set;
+    RestoreIDSet(iter->word_id(), &char_word_map_[uni_char]);
   }
   return true;
 }
@@ -1253,14 +1393,11 @@ bool URLIndexPrivateData::RestoreWordIDHistoryMap(
     if (actual_item_count == 0 || actual_item_count != expected_item_count)
       return false;
     WordID word_id = iter->word_id();
-    HistoryIDSet history_id_set;
-    const RepeatedField<int64>& history_ids(iter->history_id());
-    for (RepeatedField<int64>::const_iterator jiter = history_ids.begin();
-         jiter != history_ids.end(); ++jiter) {
-      history_id_set.insert(*jiter);
+    HistoryIDSet& history_id_set(word_id_history_map_[word_id]);
+    RestoreIDSet(iter->history_id(), &history_id_set);
+    for (HistoryIDSet::const_iterator jiter = history_id_set.begin();
+         jiter != history_id_set.end(); ++jiter)
       AddToHistoryIDWordMap(*jiter, word_id);
-    }
-    word_id_history_map_[word_id] = history_id_set;
   }
   return true;
 }
@@ -1344,6 +1481,130 @@ bool URLIndexPrivateData::RestoreWordStartsMap(
   return true;
 }
 
+// Cache Journal ---------------------------------------------------------------
+
+// The journal is a sequence of entries, each a 32 bit length followed by that
+// many bytes of serialized InMemoryURLIndexJournalEntry.  A crash while
+// appending can only leave the last entry incomplete.
+
+// static
+FilePath URLIndexPrivateData::GetJournalFilePath(const FilePath& cache_path) {
+  return FilePath(cache_path.value() + FILE_PATH_LITERAL(" Journal"));
+}
+
+// static
+void URLIndexPrivateData::AddJournalEntry(const URLRow& row,
+                                          bool deleted,
+                                          std::string* entries) {
+  InMemoryURLIndexJournalEntry entry;
+  entry.set_history_id(row.id());
+  if (deleted) {
+    // The ID is enough to find the row, so the URL is not kept on disk after
+    // it has been removed from history.
+    entry.set_deleted(true);
+  } else {
+    entry.set_url(row.url().spec());
+    entry.set_visit_count(row.visit_count());
+    entry.set_typed_count(row.typed_count());
+    entry.set_last_visit(row.last_visit().ToInternalValue());
+    entry.set_title(UTF16ToUTF8(row.title()));
+  }
+  std::string data;
+  if (!entry.SerializeToString(&data))
+    return;
+  uint32 size = data.size();
+  entries->append(reinterpret_cast<const char*>(&size), sizeof(size));
+  entries->append(data);
+}
+
+// static
+void URLIndexPrivateData::WriteJournalEntriesTask(const FilePath& cache_path,
+                                                  const std::string& entries) {
+  FilePath journal_path(GetJournalFilePath(cache_path));
+  int size = entries.size();
+  int written = file_util::PathExists(journal_path) ?
+      file_util::AppendToFile(journal_path, entries.data(), size) :
+      file_util::WriteFile(journal_path, entries.data(), size);
+  if (written != size)
+    LOG(WARNING) << "Failed to write " << journal_path.value();
+}
+
+// static
+void URLIndexPrivateData::DeleteCacheFilesTask(const FilePath& cache_path) {
+  file_util::Delete(cache_path, false);
+  file_util::Delete(GetJournalFilePath(cache_path), false);
+}
+
+// static
+void URLIndexPrivateData::CompactCacheFileTask(
+    const FilePath& cache_path,
+    const std::string& languages,
+    const std::set<std::string>& scheme_whitelist) {
+  int64 cache_size = 0;
+  int journal_entries = 0;
+  scoped_refptr<URLIndexPrivateData> data(
+      ReadFromFile(cache_path, languages, scheme_whitelist, &cache_size,
+                   &journal_entries));
+  if (!data.get() || !journal_entries)
+    return;
+  if (data->Empty()) {
+    DeleteCacheFilesTask(cache_path);
+    return;
+  }
+  scoped_refptr<RefCountedBool> succeeded(new RefCountedBool(false));
+  WritePrivateDataToCacheFileTask(data, cache_path, succeeded);
+}
+
+int URLIndexPrivateData::ReplayJournal(
+    const FilePath& journal_path,
+    const std::string& languages,
+    const std::set<std::string>& scheme_whitelist) {
+  std::string journal;
+  if (!file_util::ReadFileToString(journal_path, &journal))
+    return 0;
+  int replayed = 0;
+  // The end of the last entry that was read back.
+  size_t offset = 0;
+  while (journal.size() - offset >= sizeof(uint32)) {
+    uint32 size;
+    memcpy(&size, journal.data() + offset, sizeof(size));
+    const size_t entry_offset = offset + sizeof(size);
+    InMemoryURLIndexJournalEntry entry;
+    if (size > journal.size() - entry_offset ||
+        !entry.ParseFromArray(journal.data() + entry_offset, size))
+      break;
+    offset = entry_offset + size;
+
+    if (entry.deleted()) {
+      HistoryInfoMap::iterator pos =
+          history_info_map_.find(entry.history_id());
+      if (pos != history_info_map_.end()) {
+        RemoveRowFromIndex(pos->second);
+        search_term_cache_.clear();
+      }
+    } else {
+      URLRow row(GURL(entry.url()), entry.history_id());
+      row.set_visit_count(entry.visit_count());
+      row.set_typed_count(entry.typed_count());
+      row.set_last_visit(base::Time::FromInternalValue(entry.last_visit()));
+      row.set_title(UTF8ToUTF16(entry.title()));
+      UpdateURL(row, languages, scheme_whitelist);
+    }
+    ++replayed;
+  }
+
+  // A crash while appending leaves a partly written entry at the end.  Cut it
+  // off before anything else is appended, or the later entries would be
+  // hidden behind it on every restore and then lost when compacting.
+  if (offset < journal.size()) {
+    LOG(WARNING) << "Dropping " << journal.size() - offset
+                 << " bytes of damaged journal from " << journal_path.value();
+    if (!TruncateFile(journal_path, offset))
+      LOG(WARNING) << "Failed to truncate " << journal_path.value();
+  }
+  return replayed;
+}
+
 // static
 bool URLIndexPrivateData::URLSchemeIsWhitelisted(
     const GURL& gurl,
@@ -48,7 +48,11 @@ class URLIndexPrivateData
   friend class ::HistoryQuickProviderTest;
   friend class InMemoryURLIndex;
   friend class InMemoryURLIndexTest;
+  friend class InMemoryURLIndexPerfTest;
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, CacheJournal);
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, TornJournalEntry);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, CacheSaveRestore);
+  FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, DamagedCache);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, HugeResultSet);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, Scoring);
   FRIEND_TEST_ALL_PREFIXES(InMemoryURLIndexTest, TitleSearch);
@@ -139,21 +143,44 @@ class URLIndexPrivateData
   // to this function.
   ScoredHistoryMatches HistoryItemsForTerms(const string16& term_string);
 
-  // Creates a new URLIndexPrivateData object, populates it from the contents
-  // of the cache file stored in |file_path|, and assigns it to |private_data|.
-  // |languages| will be used to break URLs and page titles into words.
-  static void RestoreFromFileTask(
-      const FilePath& file_path,
-      scoped_refptr<URLIndexPrivateData> private_data,
-      const std::string& languages);
-
-  // Constructs a new object by restoring its contents from the file at |path|.
-  // Returns the new URLIndexPrivateData which on success will contain the
-  // restored data but upon failure will be empty.  |languages| will be used to
-  // break URLs and page titles into words
+  // Constructs a new object by restoring its contents from the cache file at
+  // |path|, then applying the changes recorded in its journal.  Returns the
+  // new URLIndexPrivateData, or NULL if the cache file is missing, damaged or
+  // empty.  |languages| will be used to break URLs and page titles into
+  // words, and |scheme_whitelist| to filter the journaled rows.  The cache is
+  // read through a memory mapping and checked against its checksum before it
+  // is parsed.
   static scoped_refptr<URLIndexPrivateData> RestoreFromFile(
       const FilePath& path,
-      const std::string& languages);
+      const std::string& languages,
+      const std::set<std::string>& scheme_whitelist);
+
+  // Returns the path of the journal kept next to the cache file at
+  // |cache_path|.
+  static FilePath GetJournalFilePath(const FilePath& cache_path);
+
+  // Appends a journal entry for |row| to |entries|.  |deleted| is true if the
+  // row was removed from history, in which case only its ID is recorded.
+  static void AddJournalEntry(const URLRow& row,
+                              bool deleted,
+                              std::string* entries);
+
+  // Appends |entries| to the journal of the cache file at |cache_path|.  Runs
+  // on the FILE thread.
+  static void WriteJournalEntriesTask(const FilePath& cache_path,
+                                      const std::string& entries);
+
+  // Deletes the cache file at |cache_path| and its journal.  Runs on the FILE
+  // thread.
+  static void DeleteCacheFilesTask(const FilePath& cache_path);
+
+  // Rewrites the cache file at |cache_path| with its journal applied, which
+  // clears the journal.  Leaves both files alone if the cache can't be read.
+  // Runs on the FILE thread.
+  static void CompactCacheFileTask(
+      const FilePath& cache_path,
+      const std::string& languages,
+      const std::set<std::string>& scheme_whitelist);
 
   // Constructs a new object by rebuilding its contents from the history
   // database in |history_db|. Returns the new URLIndexPrivateData which on
@@ -166,7 +193,8 @@ class URLIndexPrivateData
       const std::set<std::string>& scheme_whitelist);
 
   // Writes |private_data| as a cache file to |file_path| and returns success
-  // via |succeeded|.
+  // via |succeeded|.  The journal of the file is cleared on success, since
+  // the new cache includes its changes.
   static void WritePrivateDataToCacheFileTask(
       scoped_refptr<URLIndexPrivateData> private_data,
       const FilePath& file_path,
@@ -183,6 +211,14 @@ class URLIndexPrivateData
   // Returns true if there is no data in the index.
   bool Empty() const;
 
+  // Releases the memory the ID sets reserved for growth while the index was
+  // being built.
+  void ShrinkIndex();
+
+  // Returns a rough count of the bytes used by the word and history indexes,
+  // including an estimate of the allocator overhead of each map node.
+  size_t EstimateIndexMemoryUsage() const;
+
   // Creates a copy of ourself.
   scoped_refptr<URLIndexPrivateData> Duplicate() const;
 
@@ -301,6 +337,24 @@ class URLIndexPrivateData
   bool RestoreWordStartsMap(const imui::InMemoryURLIndexCacheItem& cache,
                             const std::string& languages);
 
+  // Does the work of RestoreFromFile() other than recording the restore time
+  // and size histograms, so that compacting the cache does not skew them.
+  // Sets |cache_size| and |journal_entries| for a restored cache.
+  static scoped_refptr<URLIndexPrivateData> ReadFromFile(
+      const FilePath& file_path,
+      const std::string& languages,
+      const std::set<std::string>& scheme_whitelist,
+      int64* cache_size,
+      int* journal_entries);
+
+  // Applies the changes recorded in the journal at |journal_path|, stopping
+  // at the first entry that was not completely written, and truncates the
+  // journal there so that later entries are appended after the last good
+  // one.  Returns the number of entries applied.  Runs on the FILE thread.
+  int ReplayJournal(const FilePath& journal_path,
+                    const std::string& languages,
+                    const std::set<std::string>& scheme_whitelist);
+
   // Determines if |gurl| has a whitelisted scheme and returns true if so.
   static bool URLSchemeIsWhitelisted(const GURL& gurl,
                                      const std::set<std::string>& whitelist);
@@ -187,6 +187,53 @@ void VisitDatabase::DeleteVisit(const VisitRow& visit) {
   del.Run();
 }
 
+void VisitDatabase::DeleteVisits(const VisitVector& visits) {
+  // Patch around each visit first, as DeleteVisit() does. A visit's referrer
+  // may be deleted along with it, so follow the referrers through the batch
+  // to the first visit that stays.
+  std::map<VisitID, VisitID> deleted_referrers;
+  for (size_t i = 0; i < visits.size(); i++)
+    deleted_referrers[visits[i].visit_id] = visits[i].referring_visit;
+  for (size_t i = 0; i < visits.size(); i++) {
+    VisitID referrer = visits[i].referring_visit;
+    // The step limit guards against referrers that loop, in which case the
+    // chain is cut.
+    for (size_t steps = 0; referrer && steps <= visits.size(); steps++) {
+      std::map<VisitID, VisitID>::const_iterator it =
+          deleted_referrers.find(referrer);
+      if (it == deleted_referrers.end())
+        break;
+      referrer = steps < visits.size() ? it->second : 0;
+    }
+    sql::Statement update_chain(GetDB().GetCachedStatement(SQL_FROM_HERE,
+        "UPDATE visits SET from_visit=? WHERE from_visit=?"));
+    update_chain.BindInt64(0, referrer);
+    update_chain.BindInt64(1, visits[i].visit_id);
+    if (!update_chain.Run())
+      return;
+  }
+
+  // Now delete the visits and their visit_source entries in batches, as
+  // GetVisitsSource() reads them.
+  const size_t batch_size = 500;
+  for (size_t start_index = 0; start_index < visits.size();
+       start_index += batch_size) {
+    size_t end_index = std::min(start_index + batch_size, visits.size());
+    std::string ids;
+    for (size_t j = start_index; j < end_index; j++) {
+      if (j != start_index)
+        ids.push_back(',');
+      ids.append(base::Int64ToString(visits[j].visit_id));
+    }
+
+    std::string sql = "DELETE FROM visits WHERE id IN (" + ids + ")";
+    if (!GetDB().Execute(sql.c_str()))
+      return;
+    sql = "DELETE FROM visit_source WHERE id IN (" + ids + ")";
+    GetDB().Execute(sql.c_str());
+  }
+}
+
 bool VisitDatabase::GetRowForVisit(VisitID visit_id, VisitRow* out_visit) {
   sql::Statement statement(GetDB().GetCachedStatement(SQL_FROM_HERE,
       "SELECT" HISTORY_VISIT_ROW_FIELDS "FROM visits WHERE id=?"));
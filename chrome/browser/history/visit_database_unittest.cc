@@ -134,6 +134,39 @@ TEST_F(VisitDatabaseTest, Delete) {
               IsVisitInfoEqual(matches[1], visit_info3));
 }
 
+TEST_F(VisitDatabaseTest, DeleteVisits) {
+  // Add a chain of four visits, two with a source, and delete the middle two
+  // together. The chain should link the outer two.
+  VisitRow visits[4];
+  for (int i = 0; i < 4; i++) {
+    visits[i] = VisitRow(1, Time::FromInternalValue(1000 + i),
+                         i ? visits[i - 1].visit_id : 0,
+                         content::PAGE_TRANSITION_LINK, 0);
+    EXPECT_TRUE(AddVisit(&visits[i], i % 2 ? SOURCE_SYNCED : SOURCE_BROWSED));
+  }
+
+  // Delete the rows as they are read back, so that visits[2] still refers to
+  // visits[1], which goes in the same batch.
+  std::vector<VisitRow> matches;
+  EXPECT_TRUE(GetVisitsForURL(visits[0].url_id, &matches));
+  ASSERT_EQ(static_cast<size_t>(4), matches.size());
+  VisitVector deleted(matches.begin() + 1, matches.begin() + 3);
+  DeleteVisits(deleted);
+
+  visits[3].referring_visit = visits[0].visit_id;
+  matches.clear();
+  EXPECT_TRUE(GetVisitsForURL(visits[0].url_id, &matches));
+  ASSERT_EQ(static_cast<size_t>(2), matches.size());
+  EXPECT_TRUE(IsVisitInfoEqual(matches[0], visits[0]) &&
+              IsVisitInfoEqual(matches[1], visits[3]));
+
+  // Only the source of the remaining synced visit is left.
+  VisitSourceMap sources;
+  GetVisitsSource(VisitVector(visits, visits + 4), &sources);
+  ASSERT_EQ(static_cast<size_t>(1), sources.size());
+  EXPECT_EQ(SOURCE_SYNCED, sources[visits[3].visit_id]);
+}
+
 TEST_F(VisitDatabaseTest, Update) {
   // Make something in the database.
   VisitRow original(1, Time::Now(), 23, content::PageTransitionFromInt(0), 19);
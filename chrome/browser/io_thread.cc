@@ -12,6 +12,7 @@
 #include "base/compiler_specific.h"
 #include "base/debug/leak_tracker.h"
 #include "base/logging.h"
+#include "base/path_service.h"
 #include "base/stl_util.h"
 #include "base/string_number_conversions.h"
 #include "base/string_split.h"
@@ -21,6 +22,7 @@
 #include "build/build_config.h"
 #include "chrome/browser/browser_process.h"
 #include "chrome/browser/extensions/extension_event_router_forwarder.h"
+#include "chrome/browser/net/cert_verifier_cache_persister.h"
 #include "chrome/browser/net/chrome_net_log.h"
 #include "chrome/browser/net/chrome_network_delegate.h"
 #include "chrome/browser/net/chrome_url_request_context.h"
@@ -30,6 +32,7 @@
 #include "chrome/browser/net/proxy_service_factory.h"
 #include "chrome/browser/net/sdch_dictionary_fetcher.h"
 #include "chrome/browser/prefs/pref_service.h"
+#include "chrome/common/chrome_paths.h"
 #include "chrome/common/chrome_switches.h"
 #include "chrome/common/pref_names.h"
 #include "content/public/browser/browser_thread.h"
@@ -40,6 +43,7 @@
 #include "net/base/host_cache.h"
 #include "net/base/host_resolver.h"
 #include "net/base/mapped_host_resolver.h"
+#include "net/base/multi_threaded_cert_verifier.h"
 #include "net/base/net_util.h"
 #include "net/base/sdch_manager.h"
 #include "net/base/server_bound_cert_service.h"
@@ -318,6 +322,7 @@ IOThread::IOThread(
       extension_event_router_forwarder_(extension_event_router_forwarder),
       globals_(NULL),
       sdch_manager_(NULL),
+      cert_verifier_cache_persister_(NULL),
       ALLOW_THIS_IN_INITIALIZER_LIST(weak_factory_(this)) {
   // We call RegisterPrefs() here (instead of inside browser_prefs.cc) to make
   // sure that everything is initialized in the right order.
@@ -404,7 +409,19 @@ void IOThread::Init() {
       &system_enable_referrers_));
   globals_->host_resolver.reset(
       CreateGlobalHostResolver(net_log_));
-  globals_->cert_verifier.reset(net::CertVerifier::CreateDefault());
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kEnableCertVerifierDiskCache)) {
+    net::MultiThreadedCertVerifier* cert_verifier =
+        new net::MultiThreadedCertVerifier();
+    globals_->cert_verifier.reset(cert_verifier);
+    FilePath user_data_dir;
+    if (PathService::Get(chrome::DIR_USER_DATA, &user_data_dir)) {
+      cert_verifier_cache_persister_ =
+          new CertVerifierCachePersister(cert_verifier, user_data_dir);
+    }
+  } else {
+    globals_->cert_verifier.reset(net::CertVerifier::CreateDefault());
+  }
   globals_->transport_security_state.reset(new net::TransportSecurityState());
   globals_->ssl_config_service = GetSSLConfigService();
   globals_->http_auth_handler_factory.reset(CreateDefaultAuthHandlerFactory(
@@ -487,6 +504,10 @@ void IOThread::CleanUp() {
   delete sdch_manager_;
   sdch_manager_ = NULL;
 
+  // Must be deleted before |globals_->cert_verifier|.
+  delete cert_verifier_cache_persister_;
+  cert_verifier_cache_persister_ = NULL;
+
 #if defined(USE_NSS)
   net::ShutdownNSSHttpIO();
 #endif  // defined(USE_NSS)
@@ -19,6 +19,7 @@
 #include "content/public/browser/browser_thread_delegate.h"
 #include "net/base/network_change_notifier.h"
 
+class CertVerifierCachePersister;
 class ChromeNetLog;
 class ExtensionEventRouterForwarder;
 class PrefProxyConfigTrackerImpl;
@@ -212,6 +213,10 @@ class IOThread : public content::BrowserThreadDelegate {
 
   net::SdchManager* sdch_manager_;
 
+  // Persists |globals_->cert_verifier|'s cache when
+  // --enable-cert-verifier-disk-cache is given; otherwise NULL.
+  CertVerifierCachePersister* cert_verifier_cache_persister_;
+
   base::WeakPtrFactory<IOThread> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(IOThread);
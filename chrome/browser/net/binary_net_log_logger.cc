@@ -0,0 +1,220 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/binary_net_log_logger.h"
+
+#include <stdio.h>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/scoped_handle.h"
+#include "base/message_loop.h"
+#include "base/string_number_conversions.h"
+#include "base/timer.h"
+#include "base/values.h"
+#include "chrome/browser/net/net_log_binary_format.h"
+#include "chrome/browser/ui/webui/net_internals/net_internals_ui.h"
+
+namespace {
+
+// Together these bound the memory used by the logger to about 1MB.
+const size_t kBufferSize = 64 * 1024;
+const size_t kNumBuffers = 16;
+
+// How often a partly filled buffer is written out, so that a quiet session
+// still reaches the disk.
+const int kFlushIntervalSeconds = 10;
+
+}  // namespace
+
+const int BinaryNetLogLogger::kMaxFiles = 5;
+
+class BinaryNetLogLogger::Writer {
+ public:
+  Writer(BinaryNetLogLogger* logger,
+         const FilePath& log_path,
+         int64 max_file_size,
+         const std::string& constants_json)
+      : logger_(logger),
+        log_path_(log_path),
+        max_file_size_(max_file_size),
+        file_size_(0) {
+    net_log_binary::AppendFileHeader(constants_json, &file_header_);
+  }
+
+  // Starts writing out partly filled buffers periodically.
+  void StartFlushTimer() {
+    flush_timer_.Start(FROM_HERE,
+                       base::TimeDelta::FromSeconds(kFlushIntervalSeconds),
+                       logger_, &BinaryNetLogLogger::FlushOnTimer);
+  }
+
+  // Rotates out any existing logs and starts a new one.
+  void OpenFile() {
+    file_.Close();
+    for (int i = kMaxFiles - 1; i > 0; --i) {
+      FilePath from = i > 1 ? RotatedPath(i - 1) : log_path_;
+      if (file_util::PathExists(from))
+        file_util::Move(from, RotatedPath(i));
+    }
+    file_.Set(file_util::OpenFile(log_path_, "wb"));
+    if (!file_.get()) {
+      LOG(ERROR) << "Unable to open " << log_path_.value();
+      return;
+    }
+    file_size_ = 0;
+    Append(file_header_);
+  }
+
+  void Write(std::string* buffer) {
+    if (max_file_size_ > 0 &&
+        file_size_ > static_cast<int64>(file_header_.size()) &&
+        file_size_ + static_cast<int64>(buffer->size()) > max_file_size_) {
+      OpenFile();
+    }
+    Append(*buffer);
+    // Records never straddle buffers, so the file is always readable up to
+    // the last buffer written.
+    if (file_.get())
+      fflush(file_.get());
+    logger_->ReturnBuffer(buffer);
+  }
+
+ private:
+  FilePath RotatedPath(int index) const {
+    return log_path_.AddExtension(
+        FilePath::FromUTF8Unsafe(base::IntToString(index)).value());
+  }
+
+  void Append(const std::string& data) {
+    if (!file_.get())
+      return;
+    if (fwrite(data.data(), 1, data.size(), file_.get()) != data.size()) {
+      LOG(ERROR) << "Failed writing " << log_path_.value();
+      file_.Close();
+      return;
+    }
+    file_size_ += data.size();
+  }
+
+  BinaryNetLogLogger* const logger_;
+  const FilePath log_path_;
+  const int64 max_file_size_;
+  std::string file_header_;
+  ScopedStdioHandle file_;
+  int64 file_size_;
+  base::RepeatingTimer<BinaryNetLogLogger> flush_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(Writer);
+};
+
+BinaryNetLogLogger::BinaryNetLogLogger(const FilePath& log_path,
+                                       int64 max_file_size)
+    : writer_thread_("NetLogBinaryWriter"),
+      current_buffer_(NULL),
+      unrecorded_dropped_events_(0),
+      dropped_events_(0) {
+  // Store the constants with every file, so files can be loaded by versions
+  // of Chrome with different source and event types.
+  scoped_ptr<Value> constants(NetInternalsUI::GetConstants());
+  std::string constants_json;
+  base::JSONWriter::Write(constants.get(), &constants_json);
+
+  for (size_t i = 0; i < kNumBuffers; ++i) {
+    std::string* buffer = new std::string();
+    buffer->reserve(kBufferSize);
+    buffers_.push_back(buffer);
+    free_buffers_.push_back(buffer);
+  }
+  current_buffer_ = free_buffers_.back();
+  free_buffers_.pop_back();
+
+  writer_.reset(new Writer(this, log_path, max_file_size, constants_json));
+  writer_thread_.Start();
+  writer_thread_.message_loop()->PostTask(
+      FROM_HERE,
+      base::Bind(&Writer::OpenFile, base::Unretained(writer_.get())));
+  writer_thread_.message_loop()->PostTask(
+      FROM_HERE,
+      base::Bind(&Writer::StartFlushTimer, base::Unretained(writer_.get())));
+}
+
+BinaryNetLogLogger::~BinaryNetLogLogger() {
+  {
+    base::AutoLock lock(lock_);
+    FlushCurrentBuffer();
+  }
+  // Close the file on the writer thread, once everything queued before it has
+  // been written.  Stopping the thread waits for both.
+  writer_thread_.message_loop()->DeleteSoon(FROM_HERE, writer_.release());
+  writer_thread_.Stop();
+}
+
+void BinaryNetLogLogger::StartObserving(net::NetLog* net_log) {
+  net_log->AddThreadSafeObserver(this, net::NetLog::LOG_ALL_BUT_BYTES);
+}
+
+uint64 BinaryNetLogLogger::dropped_events() const {
+  base::AutoLock lock(lock_);
+  return dropped_events_;
+}
+
+void BinaryNetLogLogger::OnAddEntry(net::NetLog::EventType type,
+                                    const base::TimeTicks& time,
+                                    const net::NetLog::Source& source,
+                                    net::NetLog::EventPhase phase,
+                                    net::NetLog::EventParameters* params) {
+  // Do the expensive part without holding |lock_|.  EventParameters can only
+  // describe themselves as a Value, so one is still built for every entry
+  // that has parameters and then encoded.
+  scoped_ptr<Value> params_value(params ? params->ToValue() : NULL);
+  std::string record;
+  net_log_binary::AppendEvent(type, time, source.id, source.type, phase,
+                              params_value.get(), &record);
+
+  base::AutoLock lock(lock_);
+  if (current_buffer_ &&
+      current_buffer_->size() + record.size() > kBufferSize) {
+    FlushCurrentBuffer();
+  }
+  if (!current_buffer_) {
+    if (free_buffers_.empty()) {
+      ++unrecorded_dropped_events_;
+      ++dropped_events_;
+      return;
+    }
+    current_buffer_ = free_buffers_.back();
+    free_buffers_.pop_back();
+  }
+  if (unrecorded_dropped_events_) {
+    net_log_binary::AppendDroppedEvents(unrecorded_dropped_events_,
+                                        current_buffer_);
+    unrecorded_dropped_events_ = 0;
+  }
+  current_buffer_->append(record);
+}
+
+void BinaryNetLogLogger::FlushCurrentBuffer() {
+  lock_.AssertAcquired();
+  if (!current_buffer_ || current_buffer_->empty())
+    return;
+  writer_thread_.message_loop()->PostTask(
+      FROM_HERE,
+      base::Bind(&Writer::Write, base::Unretained(writer_.get()),
+                 current_buffer_));
+  current_buffer_ = NULL;
+}
+
+void BinaryNetLogLogger::FlushOnTimer() {
+  base::AutoLock lock(lock_);
+  FlushCurrentBuffer();
+}
+
+void BinaryNetLogLogger::ReturnBuffer(std::string* buffer) {
+  buffer->clear();
+  base::AutoLock lock(lock_);
+  free_buffers_.push_back(buffer);
+}
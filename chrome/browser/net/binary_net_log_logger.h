@@ -0,0 +1,97 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_NET_BINARY_NET_LOG_LOGGER_H_
+#define CHROME_BROWSER_NET_BINARY_NET_LOG_LOGGER_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread.h"
+#include "net/base/net_log.h"
+
+// BinaryNetLogLogger watches the NetLog event stream and writes every entry
+// to disk in the format described in net_log_binary_format.h.  Unlike
+// NetLogLogger, it is intended to be left running for long sessions.
+//
+// Entries are encoded on the thread that logs them and appended to one of a
+// fixed ring of buffers.  Full buffers, and every few seconds a partly filled
+// one, are written out by a dedicated thread, so logging never blocks on
+// disk.  If the writer falls behind and every buffer is in use, entries are
+// dropped and counted instead, and the count is recorded in the file.
+//
+// If |max_file_size| is non-zero, the log is rotated whenever it would grow
+// past that size: |log_path| is renamed to |log_path|.1, and so on, keeping at
+// most kMaxFiles files.  Logs from a previous session are rotated out of the
+// way on startup.
+//
+// OnAddEntry() may be called on any number of threads at once.
+class BinaryNetLogLogger : public net::NetLog::ThreadSafeObserver {
+ public:
+  // The number of files kept when rotating, including |log_path| itself.
+  static const int kMaxFiles;
+
+  BinaryNetLogLogger(const FilePath& log_path, int64 max_file_size);
+  virtual ~BinaryNetLogLogger();
+
+  // Starts observing specified NetLog.  Must not already be watching a NetLog.
+  // Separate from constructor to enforce thread safety.
+  void StartObserving(net::NetLog* net_log);
+
+  // Total number of entries dropped because the writer fell behind.
+  uint64 dropped_events() const;
+
+  // net::NetLog::ThreadSafeObserver implementation:
+  virtual void OnAddEntry(net::NetLog::EventType type,
+                          const base::TimeTicks& time,
+                          const net::NetLog::Source& source,
+                          net::NetLog::EventPhase phase,
+                          net::NetLog::EventParameters* params) OVERRIDE;
+
+ private:
+  // Owns the output file.  Lives on |writer_thread_|.
+  class Writer;
+
+  // Hands |current_buffer_| to the writer thread, if it holds anything.  Must
+  // have acquired |lock_| prior to calling.
+  void FlushCurrentBuffer();
+
+  // Called periodically on the writer thread, so entries do not sit in a
+  // partly filled buffer indefinitely.
+  void FlushOnTimer();
+
+  // Called on the writer thread once |buffer| has been written out.
+  void ReturnBuffer(std::string* buffer);
+
+  base::Thread writer_thread_;
+  scoped_ptr<Writer> writer_;
+
+  // |lock_| protects all members below.
+  mutable base::Lock lock_;
+
+  // Owns every buffer in the ring.
+  ScopedVector<std::string> buffers_;
+
+  // Buffers that are not being filled or written.
+  std::vector<std::string*> free_buffers_;
+
+  // The buffer entries are currently appended to.  NULL if every buffer is
+  // waiting on the writer.
+  std::string* current_buffer_;
+
+  // Entries dropped since the last dropped event record was written.
+  uint32 unrecorded_dropped_events_;
+  uint64 dropped_events_;
+
+  DISALLOW_COPY_AND_ASSIGN(BinaryNetLogLogger);
+};
+
+#endif  // CHROME_BROWSER_NET_BINARY_NET_LOG_LOGGER_H_
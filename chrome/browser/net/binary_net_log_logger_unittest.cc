@@ -0,0 +1,177 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/binary_net_log_logger.h"
+
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/scoped_temp_dir.h"
+#include "base/string_number_conversions.h"
+#include "base/values.h"
+#include "chrome/browser/net/net_log_binary_format.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+class BinaryNetLogLoggerTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    log_path_ = temp_dir_.path().AppendASCII("net.bin");
+  }
+
+  void AddEntry(BinaryNetLogLogger* logger, uint32 source_id,
+                net::NetLog::EventParameters* params) {
+    logger->OnAddEntry(net::NetLog::TYPE_REQUEST_ALIVE,
+                       base::TimeTicks::Now(),
+                       net::NetLog::Source(net::NetLog::SOURCE_URL_REQUEST,
+                                           source_id),
+                       net::NetLog::PHASE_BEGIN,
+                       params);
+  }
+
+  // Returns the number of events in the log at |path|, or -1 on error.
+  int CountEvents(const FilePath& path) {
+    std::string data;
+    std::string constants;
+    if (!file_util::ReadFileToString(path, &data))
+      return -1;
+    net_log_binary::Reader reader(data);
+    if (!reader.ReadHeader(&constants))
+      return -1;
+    int count = 0;
+    scoped_ptr<DictionaryValue> event;
+    while (reader.ReadEvent(&event))
+      ++count;
+    return count;
+  }
+
+  ScopedTempDir temp_dir_;
+  FilePath log_path_;
+};
+
+TEST_F(BinaryNetLogLoggerTest, RoundTrip) {
+  {
+    BinaryNetLogLogger logger(log_path_, 0);
+    AddEntry(&logger, 1, NULL);
+    scoped_refptr<net::NetLog::EventParameters> params(
+        new net::NetLogStringParameter("url", "http://www.example.com/"));
+    AddEntry(&logger, 2, params);
+    EXPECT_EQ(0u, logger.dropped_events());
+  }
+
+  std::string data;
+  ASSERT_TRUE(file_util::ReadFileToString(log_path_, &data));
+  net_log_binary::Reader reader(data);
+  std::string constants_json;
+  ASSERT_TRUE(reader.ReadHeader(&constants_json));
+  EXPECT_FALSE(constants_json.empty());
+
+  scoped_ptr<DictionaryValue> event;
+  ASSERT_TRUE(reader.ReadEvent(&event));
+  int value;
+  EXPECT_TRUE(event->GetInteger("source.id", &value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(event->GetInteger("source.type", &value));
+  EXPECT_EQ(net::NetLog::SOURCE_URL_REQUEST, value);
+  EXPECT_TRUE(event->GetInteger("type", &value));
+  EXPECT_EQ(net::NetLog::TYPE_REQUEST_ALIVE, value);
+  EXPECT_TRUE(event->GetInteger("phase", &value));
+  EXPECT_EQ(net::NetLog::PHASE_BEGIN, value);
+  EXPECT_FALSE(event->HasKey("params"));
+
+  ASSERT_TRUE(reader.ReadEvent(&event));
+  EXPECT_TRUE(event->GetInteger("source.id", &value));
+  EXPECT_EQ(2, value);
+  std::string url;
+  EXPECT_TRUE(event->GetString("params.url", &url));
+  EXPECT_EQ("http://www.example.com/", url);
+
+  EXPECT_FALSE(reader.ReadEvent(&event));
+  EXPECT_EQ(0u, reader.dropped_events());
+}
+
+TEST_F(BinaryNetLogLoggerTest, NestedParams) {
+  DictionaryValue params;
+  params.SetBoolean("bool", true);
+  params.SetDouble("double", 1.5);
+  ListValue* list = new ListValue();
+  list->Append(Value::CreateNullValue());
+  list->Append(Value::CreateIntegerValue(-7));
+  list->Append(BinaryValue::CreateWithCopiedBuffer("\0\1", 2));
+  params.Set("list", list);
+
+  std::string data;
+  net_log_binary::AppendFileHeader("{}", &data);
+  net_log_binary::AppendEvent(0, base::TimeTicks(), 0, 0, 0, &params, &data);
+
+  net_log_binary::Reader reader(data);
+  std::string constants_json;
+  ASSERT_TRUE(reader.ReadHeader(&constants_json));
+  EXPECT_EQ("{}", constants_json);
+  scoped_ptr<DictionaryValue> event;
+  ASSERT_TRUE(reader.ReadEvent(&event));
+  DictionaryValue* read_params;
+  ASSERT_TRUE(event->GetDictionary("params", &read_params));
+  EXPECT_TRUE(params.Equals(read_params));
+}
+
+TEST_F(BinaryNetLogLoggerTest, TruncatedRecord) {
+  std::string data;
+  net_log_binary::AppendFileHeader("{}", &data);
+  net_log_binary::AppendEvent(0, base::TimeTicks(), 1, 0, 0, NULL, &data);
+  net_log_binary::AppendDroppedEvents(3, &data);
+  net_log_binary::AppendEvent(0, base::TimeTicks(), 2, 0, 0, NULL, &data);
+  data.resize(data.size() - 1);
+
+  net_log_binary::Reader reader(data);
+  std::string constants_json;
+  ASSERT_TRUE(reader.ReadHeader(&constants_json));
+  scoped_ptr<DictionaryValue> event;
+  EXPECT_TRUE(reader.ReadEvent(&event));
+  EXPECT_FALSE(reader.ReadEvent(&event));
+  EXPECT_EQ(3u, reader.dropped_events());
+}
+
+TEST_F(BinaryNetLogLoggerTest, Rotation) {
+  const int64 kMaxFileSize = 256 * 1024;
+  const int kNumEvents = 10000;
+  scoped_refptr<net::NetLog::EventParameters> params(
+      new net::NetLogStringParameter("url", std::string(100, 'a')));
+  uint64 dropped_events;
+  {
+    BinaryNetLogLogger logger(log_path_, kMaxFileSize);
+    for (int i = 0; i < kNumEvents; ++i)
+      AddEntry(&logger, i, params);
+    dropped_events = logger.dropped_events();
+  }
+
+  // Every file kept must be capped and readable on its own.
+  int events = 0;
+  for (int i = 0; i < BinaryNetLogLogger::kMaxFiles; ++i) {
+    FilePath path = log_path_;
+    if (i > 0) {
+      path = log_path_.AddExtension(
+          FilePath::FromUTF8Unsafe(base::IntToString(i)).value());
+    }
+    if (!file_util::PathExists(path)) {
+      // Only possible if so many events were dropped that fewer files were
+      // needed.
+      EXPECT_GT(i, 0);
+      EXPECT_GT(dropped_events, 0u);
+      break;
+    }
+    int64 size;
+    ASSERT_TRUE(file_util::GetFileSize(path, &size));
+    EXPECT_LE(size, kMaxFileSize);
+    int count = CountEvents(path);
+    EXPECT_GT(count, 0);
+    events += count;
+  }
+  EXPECT_LE(static_cast<uint64>(events), kNumEvents - dropped_events);
+  EXPECT_FALSE(file_util::PathExists(log_path_.AddExtension(
+      FILE_PATH_LITERAL("5"))));
+}
+
+}  // namespace
@@ -0,0 +1,112 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/cert_verifier_cache_persister.h"
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/metrics/histogram.h"
+#include "content/public/browser/browser_thread.h"
+
+using content::BrowserThread;
+
+namespace {
+
+const FilePath::CharType kCertVerifierCacheFilename[] =
+    FILE_PATH_LITERAL("CertVerifierCache");
+
+}  // namespace
+
+class CertVerifierCachePersister::Loader {
+ public:
+  Loader(const base::WeakPtr<CertVerifierCachePersister>& persister,
+         const FilePath& path)
+      : persister_(persister),
+        path_(path),
+        data_valid_(false) {
+  }
+
+  void Load() {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+    data_valid_ = file_util::ReadFileToString(path_, &data_);
+  }
+
+  void CompleteLoad() {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+    // Make sure we're deleted.
+    scoped_ptr<Loader> deleter(this);
+
+    if (!persister_ || !data_valid_)
+      return;
+    persister_->CompleteLoad(data_);
+  }
+
+ private:
+  base::WeakPtr<CertVerifierCachePersister> persister_;
+
+  FilePath path_;
+
+  std::string data_;
+  bool data_valid_;
+
+  DISALLOW_COPY_AND_ASSIGN(Loader);
+};
+
+CertVerifierCachePersister::CertVerifierCachePersister(
+    net::MultiThreadedCertVerifier* verifier,
+    const FilePath& directory)
+    : verifier_(verifier),
+      writer_(directory.Append(kCertVerifierCacheFilename),
+              BrowserThread::GetMessageLoopProxyForThread(BrowserThread::FILE)),
+      weak_ptr_factory_(ALLOW_THIS_IN_INITIALIZER_LIST(this)) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  verifier_->SetDelegate(this);
+
+  Loader* loader = new Loader(weak_ptr_factory_.GetWeakPtr(), writer_.path());
+  BrowserThread::PostTaskAndReply(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&Loader::Load, base::Unretained(loader)),
+      base::Bind(&Loader::CompleteLoad, base::Unretained(loader)));
+}
+
+CertVerifierCachePersister::~CertVerifierCachePersister() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  if (writer_.HasPendingWrite())
+    writer_.DoScheduledWrite();
+
+  verifier_->SetDelegate(NULL);
+
+  UMA_HISTOGRAM_COUNTS("Net.CertVerifier_PersistedCacheHits",
+                       verifier_->persisted_cache_hits());
+  UMA_HISTOGRAM_LONG_TIMES("Net.CertVerifier_PersistedCacheTimeSaved",
+                           verifier_->verification_time_saved());
+}
+
+void CertVerifierCachePersister::CacheIsDirty(
+    net::MultiThreadedCertVerifier* verifier) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK_EQ(verifier_, verifier);
+
+  writer_.ScheduleWrite(this);
+}
+
+bool CertVerifierCachePersister::SerializeData(std::string* data) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  verifier_->SerializeCache(data);
+  return true;
+}
+
+void CertVerifierCachePersister::CompleteLoad(const std::string& serialized) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  bool loaded = verifier_->LoadCache(serialized);
+  UMA_HISTOGRAM_BOOLEAN("Net.CertVerifier_PersistedCacheLoaded", loaded);
+  if (!loaded) {
+    // Replace the unreadable file with the current contents.
+    writer_.ScheduleWrite(this);
+  }
+}
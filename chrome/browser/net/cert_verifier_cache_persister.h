@@ -0,0 +1,59 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// CertVerifierCachePersister writes the results cached by a
+// net::MultiThreadedCertVerifier to disk, and restores them at startup, so
+// that TLS connections made shortly after a restart do not have to repeat
+// full certificate chain verification.
+//
+// Like TransportSecurityPersister, the load happens asynchronously on the
+// file thread, and the verifier runs unloaded until it completes. Writes are
+// coalesced through an ImportantFileWriter.
+
+#ifndef CHROME_BROWSER_NET_CERT_VERIFIER_CACHE_PERSISTER_H_
+#define CHROME_BROWSER_NET_CERT_VERIFIER_CACHE_PERSISTER_H_
+#pragma once
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/memory/weak_ptr.h"
+#include "chrome/common/important_file_writer.h"
+#include "net/base/multi_threaded_cert_verifier.h"
+
+// Reads and updates the on-disk certificate verification cache.
+// Must be created, used and destroyed only on the IO thread.
+class CertVerifierCachePersister
+    : public net::MultiThreadedCertVerifier::Delegate,
+      public ImportantFileWriter::DataSerializer {
+ public:
+  // |verifier| must outlive this object. The cache is stored in the file
+  // "CertVerifierCache" inside |directory|.
+  CertVerifierCachePersister(net::MultiThreadedCertVerifier* verifier,
+                             const FilePath& directory);
+  virtual ~CertVerifierCachePersister();
+
+  // net::MultiThreadedCertVerifier::Delegate:
+  virtual void CacheIsDirty(
+      net::MultiThreadedCertVerifier* verifier) OVERRIDE;
+
+  // ImportantFileWriter::DataSerializer:
+  virtual bool SerializeData(std::string* data) OVERRIDE;
+
+ private:
+  class Loader;
+
+  void CompleteLoad(const std::string& serialized);
+
+  net::MultiThreadedCertVerifier* verifier_;
+
+  // Helper for safely writing the data.
+  ImportantFileWriter writer_;
+
+  base::WeakPtrFactory<CertVerifierCachePersister> weak_ptr_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(CertVerifierCachePersister);
+};
+
+#endif  // CHROME_BROWSER_NET_CERT_VERIFIER_CACHE_PERSISTER_H_
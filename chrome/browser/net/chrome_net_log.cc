@@ -4,20 +4,35 @@
 
 #include "chrome/browser/net/chrome_net_log.h"
 
+#include <algorithm>
+
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
+#include "base/threading/platform_thread.h"
 #include "base/values.h"
+#include "chrome/browser/net/binary_net_log_logger.h"
 #include "chrome/browser/net/load_timing_observer.h"
 #include "chrome/browser/net/net_log_logger.h"
 #include "chrome/common/chrome_switches.h"
 
+ChromeNetLog::ObserverSnapshot::ObserverSnapshot() : active_dispatches(0) {}
+
+ChromeNetLog::ObserverSnapshot::~ObserverSnapshot() {}
+
 ChromeNetLog::ChromeNetLog()
     : last_id_(0),
       base_log_level_(LOG_BASIC),
-      effective_log_level_(LOG_BASIC),
-      load_timing_observer_(new LoadTimingObserver()) {
+      effective_log_level_(LOG_NONE),
+      load_timing_observer_(new LoadTimingObserver()),
+      active_dispatches_(0),
+      current_snapshot_(0) {
+  {
+    base::AutoLock lock(lock_);
+    PublishObserverSnapshot();
+  }
+
   const CommandLine* command_line = CommandLine::ForCurrentProcess();
   // Adjust base log level based on command line switch, if present.
   // This is done before adding any observers so the call to UpdateLogLevel when
@@ -28,25 +43,49 @@ ChromeNetLog::ChromeNetLog()
     int command_line_log_level;
     if (base::StringToInt(log_level_string, &command_line_log_level) &&
         command_line_log_level >= LOG_ALL &&
-        command_line_log_level <= LOG_BASIC) {
+        command_line_log_level <= LOG_NONE) {
       base_log_level_ = static_cast<LogLevel>(command_line_log_level);
     }
   }
 
-  load_timing_observer_->StartObserving(this);
+  // LoadTimingObserver needs LOG_BASIC events from every request, so while it
+  // is watching, the effective log level can never drop to LOG_NONE.  Only
+  // leave it out when logging was explicitly turned off, at the cost of
+  // devtools' load timing information.
+  if (base_log_level_ != LOG_NONE)
+    load_timing_observer_->StartObserving(this);
 
   if (command_line->HasSwitch(switches::kLogNetLog)) {
     net_log_logger_.reset(new NetLogLogger(
         command_line->GetSwitchValuePath(switches::kLogNetLog)));
     net_log_logger_->StartObserving(this);
   }
+
+  if (command_line->HasSwitch(switches::kLogNetLogBinary)) {
+    int max_file_size_mb = 0;
+    if (command_line->HasSwitch(switches::kNetLogMaxFileSize)) {
+      base::StringToInt(
+          command_line->GetSwitchValueASCII(switches::kNetLogMaxFileSize),
+          &max_file_size_mb);
+    }
+    binary_net_log_logger_.reset(new BinaryNetLogLogger(
+        command_line->GetSwitchValuePath(switches::kLogNetLogBinary),
+        static_cast<int64>(std::max(max_file_size_mb, 0)) * 1024 * 1024));
+    binary_net_log_logger_->StartObserving(this);
+  }
 }
 
 ChromeNetLog::~ChromeNetLog() {
   // Remove the observers we own before we're destroyed.
-  RemoveThreadSafeObserver(load_timing_observer_.get());
+  if (load_timing_observer_->net_log())
+    RemoveThreadSafeObserver(load_timing_observer_.get());
   if (net_log_logger_.get())
     RemoveThreadSafeObserver(net_log_logger_.get());
+  if (binary_net_log_logger_.get())
+    RemoveThreadSafeObserver(binary_net_log_logger_.get());
+
+  delete reinterpret_cast<ObserverSnapshot*>(
+      base::subtle::NoBarrier_Load(&current_snapshot_));
 }
 
 void ChromeNetLog::AddEntry(
@@ -54,13 +93,35 @@ void ChromeNetLog::AddEntry(
     const Source& source,
     EventPhase phase,
     const scoped_refptr<EventParameters>& params) {
+  if (GetLogLevel() == LOG_NONE)
+    return;
+
   base::TimeTicks time(base::TimeTicks::Now());
 
-  base::AutoLock lock(lock_);
+  // Keeps every snapshot this call may look at from being deleted.
+  base::subtle::Barrier_AtomicIncrement(&active_dispatches_, 1);
+
+  // Register as a dispatcher of the current snapshot.  If the snapshot was
+  // replaced in the meantime, PublishObserverSnapshot() may not have seen the
+  // registration, so back off and use the new one instead.
+  ObserverSnapshot* snapshot;
+  while (true) {
+    snapshot = reinterpret_cast<ObserverSnapshot*>(
+        base::subtle::Acquire_Load(&current_snapshot_));
+    base::subtle::Barrier_AtomicIncrement(&snapshot->active_dispatches, 1);
+    if (snapshot == reinterpret_cast<ObserverSnapshot*>(
+            base::subtle::Acquire_Load(&current_snapshot_))) {
+      break;
+    }
+    base::subtle::Barrier_AtomicIncrement(&snapshot->active_dispatches, -1);
+  }
 
   // Notify all of the log observers.
-  FOR_EACH_OBSERVER(ThreadSafeObserver, observers_,
-                    OnAddEntry(type, time, source, phase, params));
+  for (size_t i = 0; i < snapshot->observers.size(); ++i)
+    snapshot->observers[i]->OnAddEntry(type, time, source, phase, params);
+
+  base::subtle::Barrier_AtomicIncrement(&snapshot->active_dispatches, -1);
+  base::subtle::Barrier_AtomicIncrement(&active_dispatches_, -1);
 }
 
 uint32 ChromeNetLog::NextID() {
@@ -81,6 +142,7 @@ void ChromeNetLog::AddThreadSafeObserver(
   observers_.AddObserver(observer);
   OnAddObserver(observer, log_level);
   UpdateLogLevel();
+  PublishObserverSnapshot();
 }
 
 void ChromeNetLog::SetObserverLogLevel(
@@ -101,20 +163,56 @@ void ChromeNetLog::RemoveThreadSafeObserver(
   observers_.RemoveObserver(observer);
   OnRemoveObserver(observer);
   UpdateLogLevel();
+  PublishObserverSnapshot();
 }
 
 void ChromeNetLog::UpdateLogLevel() {
   lock_.AssertAcquired();
 
   // Look through all the observers and find the finest granularity
-  // log level (higher values of the enum imply *lower* log levels).
-  LogLevel new_effective_log_level = base_log_level_;
+  // log level (higher values of the enum imply *lower* log levels).  With no
+  // observers at all, nothing needs to be logged.
+  LogLevel new_effective_log_level = LOG_NONE;
   ObserverListBase<ThreadSafeObserver>::Iterator it(observers_);
   ThreadSafeObserver* observer;
   while ((observer = it.GetNext()) != NULL) {
-    new_effective_log_level =
-        std::min(new_effective_log_level, observer->log_level());
+    new_effective_log_level = std::min(
+        new_effective_log_level,
+        std::min(base_log_level_, observer->log_level()));
   }
   base::subtle::NoBarrier_Store(&effective_log_level_,
                                 new_effective_log_level);
 }
+
+void ChromeNetLog::PublishObserverSnapshot() {
+  lock_.AssertAcquired();
+
+  ObserverSnapshot* snapshot = new ObserverSnapshot;
+  ObserverListBase<ThreadSafeObserver>::Iterator it(observers_);
+  ThreadSafeObserver* observer;
+  while ((observer = it.GetNext()) != NULL)
+    snapshot->observers.push_back(observer);
+
+  ObserverSnapshot* old_snapshot = reinterpret_cast<ObserverSnapshot*>(
+      base::subtle::NoBarrier_Load(&current_snapshot_));
+  base::subtle::Release_Store(&current_snapshot_,
+                              reinterpret_cast<base::subtle::AtomicWord>(
+                                  snapshot));
+  base::subtle::MemoryBarrier();
+
+  // Any AddEntry() call that registers with |old_snapshot| from here on will
+  // see the new snapshot and back off, so waiting for the count to drain is
+  // enough to guarantee |old_snapshot|'s observers are no longer in use.
+  if (!old_snapshot)
+    return;
+  while (base::subtle::Acquire_Load(&old_snapshot->active_dispatches) != 0)
+    base::PlatformThread::YieldCurrentThread();
+
+  // A thread that has loaded a replaced snapshot, but not yet registered with
+  // it, still counts in |active_dispatches_|.  Once that is zero, every
+  // AddEntry() call that starts from here on sees |snapshot|, so the retired
+  // ones can go.  Otherwise they wait for a later publish, or for |this|.
+  retired_snapshots_.push_back(old_snapshot);
+  if (base::subtle::Acquire_Load(&active_dispatches_) == 0)
+    retired_snapshots_.reset();
+}
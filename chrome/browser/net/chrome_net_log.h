@@ -6,13 +6,17 @@
 #define CHROME_BROWSER_NET_CHROME_NET_LOG_H_
 #pragma once
 
+#include <vector>
+
 #include "base/atomicops.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/observer_list.h"
 #include "base/synchronization/lock.h"
 #include "base/time.h"
 #include "net/base/net_log.h"
 
+class BinaryNetLogLogger;
 class LoadTimingObserver;
 class NetLogLogger;
 
@@ -22,6 +26,10 @@ class NetLogLogger;
 // All methods are thread safe, with the exception that no NetLog or
 // NetLog::ThreadSafeObserver functions may be called by an observer's
 // OnAddEntry() method.  Doing so will result in a deadlock.
+//
+// Adding an entry does not take a lock.  Entries are dispatched to an
+// immutable snapshot of the observer list, which is replaced whenever an
+// observer is added or removed.
 class ChromeNetLog : public net::NetLog {
  public:
   ChromeNetLog();
@@ -47,11 +55,28 @@ class ChromeNetLog : public net::NetLog {
                         EventPhase phase,
                         const scoped_refptr<EventParameters>& params) OVERRIDE;
 
+  // An immutable copy of |observers_| that AddEntry() dispatches to.
+  struct ObserverSnapshot {
+    ObserverSnapshot();
+    ~ObserverSnapshot();
+
+    std::vector<ThreadSafeObserver*> observers;
+
+    // Number of AddEntry() calls currently dispatching to |observers|.
+    base::subtle::Atomic32 active_dispatches;
+  };
+
   // Called whenever an observer is added or removed, or has its log level
   // changed.  Must have acquired |lock_| prior to calling.
   void UpdateLogLevel();
 
-  // |lock_| protects access to |observers_|.
+  // Publishes a new snapshot of |observers_| and waits for AddEntry() calls
+  // dispatching to the previous one to finish, so that a removed observer
+  // receives no further events.  Must have acquired |lock_| prior to calling.
+  void PublishObserverSnapshot();
+
+  // |lock_| protects access to |observers_| and |retired_snapshots_|, and
+  // serializes publishing of |current_snapshot_|.
   base::Lock lock_;
 
   // Last assigned source ID.  Incremented to get the next one.
@@ -66,10 +91,21 @@ class ChromeNetLog : public net::NetLog {
 
   scoped_ptr<LoadTimingObserver> load_timing_observer_;
   scoped_ptr<NetLogLogger> net_log_logger_;
+  scoped_ptr<BinaryNetLogLogger> binary_net_log_logger_;
 
   // |lock_| must be acquired whenever reading or writing to this.
   ObserverList<ThreadSafeObserver, true> observers_;
 
+  // Number of AddEntry() calls in progress, whichever snapshot they use.
+  base::subtle::Atomic32 active_dispatches_;
+
+  // The ObserverSnapshot* that AddEntry() dispatches to.  Owned.
+  base::subtle::AtomicWord current_snapshot_;
+
+  // Replaced snapshots that an AddEntry() call may still be looking at.  They
+  // are deleted by the first publish that finds |active_dispatches_| at zero.
+  ScopedVector<ObserverSnapshot> retired_snapshots_;
+
   DISALLOW_COPY_AND_ASSIGN(ChromeNetLog);
 };
 
@@ -0,0 +1,139 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "chrome/browser/net/binary_net_log_logger.h"
+#include "chrome/browser/net/chrome_net_log.h"
+#include "chrome/browser/net/load_timing_observer.h"
+#include "chrome/browser/net/net_log_logger.h"
+#include "content/test/test_browser_thread.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_job_factory.h"
+#include "net/url_request/url_request_test_job.h"
+#include "net/url_request/url_request_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using content::BrowserThread;
+
+namespace {
+
+const int kNumRequests = 2000;
+
+// Serves every "test:" request with canned data, completing asynchronously
+// without touching the network.
+class TestJobProtocolHandler
+    : public net::URLRequestJobFactory::ProtocolHandler {
+ public:
+  virtual net::URLRequestJob* MaybeCreateJob(
+      net::URLRequest* request) const OVERRIDE {
+    return new net::URLRequestTestJob(request, true);
+  }
+};
+
+// Counts entries without keeping them, so that a run at a given level
+// measures what producing the entries costs rather than what an observer
+// does with them.
+class CountingObserver : public net::NetLog::ThreadSafeObserver {
+ public:
+  CountingObserver() : count_(0) {}
+
+  virtual void OnAddEntry(net::NetLog::EventType type,
+                          const base::TimeTicks& time,
+                          const net::NetLog::Source& source,
+                          net::NetLog::EventPhase phase,
+                          net::NetLog::EventParameters* params) OVERRIDE {
+    ++count_;
+  }
+
+  int count() const { return count_; }
+
+ private:
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingObserver);
+};
+
+// Issues kNumRequests sequential requests through a context using |net_log|
+// and reports the mean wall time of a request.
+void RunRequests(const char* name, net::NetLog* net_log) {
+  net::URLRequestJobFactory job_factory;
+  job_factory.SetProtocolHandler("test", new TestJobProtocolHandler);
+  TestURLRequestContext context(true);
+  context.set_net_log(net_log);
+  context.set_job_factory(&job_factory);
+  context.Init();
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumRequests; ++i) {
+    TestDelegate delegate;
+    net::URLRequest request(net::URLRequestTestJob::test_url_1(), &delegate);
+    request.set_context(&context);
+    request.Start();
+    MessageLoop::current()->Run();
+    ASSERT_EQ(net::URLRequestTestJob::test_data_1(), delegate.data_received());
+  }
+  LogPerfResult(name,
+                timer.Elapsed().InMicrosecondsF() / kNumRequests,
+                "us/request");
+}
+
+}  // namespace
+
+// Measures the cost NetLog adds to a URLRequest at each level of capture:
+// with no observer at all (LOG_NONE), with only the LoadTimingObserver every
+// browser has (LOG_BASIC), and with an observer asking for everything,
+// including bytes (LOG_ALL).  The last two runs also write the log out with
+// the loggers behind --log-net-log and --log-net-log-binary.
+TEST(ChromeNetLogPerfTest, URLRequestOverhead) {
+  content::TestBrowserThread io_thread(BrowserThread::IO,
+                                       MessageLoop::current());
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  RunRequests("NetLog_URLRequest_NoNetLog", NULL);
+
+  {
+    ChromeNetLog net_log;
+    net_log.RemoveThreadSafeObserver(net_log.load_timing_observer());
+    ASSERT_EQ(net::NetLog::LOG_NONE, net_log.GetLogLevel());
+    RunRequests("NetLog_URLRequest_NoObserver", &net_log);
+  }
+
+  {
+    ChromeNetLog net_log;
+    ASSERT_EQ(net::NetLog::LOG_BASIC, net_log.GetLogLevel());
+    RunRequests("NetLog_URLRequest_LogBasic", &net_log);
+  }
+
+  {
+    ChromeNetLog net_log;
+    CountingObserver observer;
+    net_log.AddThreadSafeObserver(&observer, net::NetLog::LOG_ALL);
+    ASSERT_EQ(net::NetLog::LOG_ALL, net_log.GetLogLevel());
+    RunRequests("NetLog_URLRequest_LogAll", &net_log);
+    net_log.RemoveThreadSafeObserver(&observer);
+    EXPECT_LT(0, observer.count());
+  }
+
+  {
+    ChromeNetLog net_log;
+    NetLogLogger logger(temp_dir.path().AppendASCII("net.log"));
+    logger.StartObserving(&net_log);
+    RunRequests("NetLog_URLRequest_LogAllButBytes_JSON", &net_log);
+    net_log.RemoveThreadSafeObserver(&logger);
+  }
+
+  {
+    ChromeNetLog net_log;
+    BinaryNetLogLogger logger(temp_dir.path().AppendASCII("net.bin"), 0);
+    logger.StartObserving(&net_log);
+    RunRequests("NetLog_URLRequest_LogAllButBytes_Binary", &net_log);
+    net_log.RemoveThreadSafeObserver(&logger);
+  }
+}
@@ -272,4 +272,27 @@ TEST(ChromeNetLogTest, NetLogAddRemoveObserverThreads) {
   RunTestThreads<AddRemoveObserverTestThread>(&net_log);
 }
 
+// Makes sure that once RemoveThreadSafeObserver() returns, the observer gets
+// no further events, even while other threads are still adding entries.
+TEST(ChromeNetLogTest, NetLogRemoveObserverWhileAddingEvents) {
+  ChromeNetLog net_log;
+  CountingObserver observer;
+  net_log.AddThreadSafeObserver(&observer, net::NetLog::LOG_BASIC);
+
+  AddEventsTestThread threads[kThreads];
+  base::WaitableEvent start_event(true, false);
+  for (size_t i = 0; i < arraysize(threads); ++i) {
+    threads[i].Init(&net_log, &start_event);
+    threads[i].Start();
+  }
+  start_event.Signal();
+
+  net_log.RemoveThreadSafeObserver(&observer);
+  int count = observer.count();
+
+  for (size_t i = 0; i < arraysize(threads); ++i)
+    threads[i].Join();
+  EXPECT_EQ(count, observer.count());
+}
+
 }  // namespace
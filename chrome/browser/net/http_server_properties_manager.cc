@@ -199,6 +199,40 @@ HttpServerPropertiesManager::GetPipelineCapabilityMap() const {
   return http_server_properties_impl_->GetPipelineCapabilityMap();
 }
 
+int HttpServerPropertiesManager::GetPipelineMaxDepth(
+    const net::HostPortPair& origin) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  return http_server_properties_impl_->GetPipelineMaxDepth(origin);
+}
+
+void HttpServerPropertiesManager::SetPipelineMaxDepth(
+    const net::HostPortPair& origin,
+    int depth) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (depth <= http_server_properties_impl_->GetPipelineMaxDepth(origin))
+    return;
+  http_server_properties_impl_->SetPipelineMaxDepth(origin, depth);
+  ScheduleUpdatePrefsOnIO();
+}
+
+net::PipelineDepthMap
+HttpServerPropertiesManager::GetPipelineMaxDepthMap() const {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  return http_server_properties_impl_->GetPipelineMaxDepthMap();
+}
+
+void HttpServerPropertiesManager::RecordServerUsage(
+    const net::HostPortPair& server,
+    bool is_secure) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  http_server_properties_impl_->RecordServerUsage(server, is_secure);
+}
+
+net::ServerUsageMap HttpServerPropertiesManager::GetServerUsageMap() const {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  return http_server_properties_impl_->GetServerUsageMap();
+}
+
 //
 // Update the HttpServerPropertiesImpl's cache with data from preferences.
 //
@@ -238,6 +272,8 @@ void HttpServerPropertiesManager::UpdateCacheFromPrefsOnUI() {
   net::PipelineCapabilityMap* pipeline_capability_map =
       new net::PipelineCapabilityMap;
 
+  net::PipelineDepthMap* pipeline_depth_map = new net::PipelineDepthMap;
+
   bool detected_corrupted_prefs = false;
   const base::DictionaryValue& http_server_properties_dict =
       *pref_service_->GetDictionary(prefs::kHttpServerProperties);
@@ -319,6 +355,13 @@ void HttpServerPropertiesManager::UpdateCacheFromPrefsOnUI() {
           static_cast<net::HttpPipelinedHostCapability>(pipeline_capability);
     }
 
+    int pipeline_max_depth = 0;
+    if (server_pref_dict->GetInteger(
+            "pipeline_max_depth", &pipeline_max_depth) &&
+        pipeline_max_depth > 0) {
+      (*pipeline_depth_map)[server] = pipeline_max_depth;
+    }
+
     // Get alternate_protocol server.
     DCHECK(!ContainsKey(*alternate_protocol_map, server));
     base::DictionaryValue* port_alternate_protocol_dict = NULL;
@@ -368,6 +411,7 @@ void HttpServerPropertiesManager::UpdateCacheFromPrefsOnUI() {
                  base::Owned(spdy_settings_map),
                  base::Owned(alternate_protocol_map),
                  base::Owned(pipeline_capability_map),
+                 base::Owned(pipeline_depth_map),
                  detected_corrupted_prefs));
 }
 
@@ -376,6 +420,7 @@ void HttpServerPropertiesManager::UpdateCacheFromPrefsOnIO(
     net::SpdySettingsMap* spdy_settings_map,
     net::AlternateProtocolMap* alternate_protocol_map,
     net::PipelineCapabilityMap* pipeline_capability_map,
+    net::PipelineDepthMap* pipeline_depth_map,
     bool detected_corrupted_prefs) {
   // Preferences have the master data because admins might have pushed new
   // preferences. Update the cached data with new data from preferences.
@@ -395,6 +440,8 @@ void HttpServerPropertiesManager::UpdateCacheFromPrefsOnIO(
   http_server_properties_impl_->InitializePipelineCapabilities(
       pipeline_capability_map);
 
+  http_server_properties_impl_->InitializePipelineMaxDepths(pipeline_depth_map);
+
   // Update the prefs with what we have read (delete all corrupted prefs).
   if (detected_corrupted_prefs)
     ScheduleUpdatePrefsOnIO();
@@ -440,6 +487,9 @@ void HttpServerPropertiesManager::UpdatePrefsFromCacheOnIO() {
   *pipeline_capability_map =
       http_server_properties_impl_->GetPipelineCapabilityMap();
 
+  net::PipelineDepthMap* pipeline_depth_map = new net::PipelineDepthMap;
+  *pipeline_depth_map = http_server_properties_impl_->GetPipelineMaxDepthMap();
+
   // Update the preferences on the UI thread.
   BrowserThread::PostTask(
       BrowserThread::UI,
@@ -449,18 +499,20 @@ void HttpServerPropertiesManager::UpdatePrefsFromCacheOnIO() {
                  base::Owned(spdy_server_list),
                  base::Owned(spdy_settings_map),
                  base::Owned(alternate_protocol_map),
-                 base::Owned(pipeline_capability_map)));
+                 base::Owned(pipeline_capability_map),
+                 base::Owned(pipeline_depth_map)));
 }
 
 // A local or temporary data structure to hold |supports_spdy|, SpdySettings,
-// PortAlternateProtocolPair, and |pipeline_capability| preferences for a
-// server. This is used only in UpdatePrefsOnUI.
+// PortAlternateProtocolPair, |pipeline_capability| and |pipeline_max_depth|
+// preferences for a server. This is used only in UpdatePrefsOnUI.
 struct ServerPref {
   ServerPref()
       : supports_spdy(false),
         settings_map(NULL),
         alternate_protocol(NULL),
-        pipeline_capability(net::PIPELINE_UNKNOWN) {
+        pipeline_capability(net::PIPELINE_UNKNOWN),
+        pipeline_max_depth(0) {
   }
   ServerPref(bool supports_spdy,
              const net::SettingsMap* settings_map,
@@ -468,19 +520,22 @@ struct ServerPref {
       : supports_spdy(supports_spdy),
         settings_map(settings_map),
         alternate_protocol(alternate_protocol),
-        pipeline_capability(net::PIPELINE_UNKNOWN) {
+        pipeline_capability(net::PIPELINE_UNKNOWN),
+        pipeline_max_depth(0) {
   }
   bool supports_spdy;
   const net::SettingsMap* settings_map;
   const net::PortAlternateProtocolPair* alternate_protocol;
   net::HttpPipelinedHostCapability pipeline_capability;
+  int pipeline_max_depth;
 };
 
 void HttpServerPropertiesManager::UpdatePrefsOnUI(
     base::ListValue* spdy_server_list,
     net::SpdySettingsMap* spdy_settings_map,
     net::AlternateProtocolMap* alternate_protocol_map,
-    net::PipelineCapabilityMap* pipeline_capability_map) {
+    net::PipelineCapabilityMap* pipeline_capability_map,
+    net::PipelineDepthMap* pipeline_depth_map) {
 
   typedef std::map<net::HostPortPair, ServerPref> ServerPrefMap;
   ServerPrefMap server_pref_map;
@@ -557,6 +612,21 @@ void HttpServerPropertiesManager::UpdatePrefsOnUI(
     }
   }
 
+  for (net::PipelineDepthMap::const_iterator map_it =
+           pipeline_depth_map->begin();
+       map_it != pipeline_depth_map->end(); ++map_it) {
+    const net::HostPortPair& server = map_it->first;
+
+    ServerPrefMap::iterator it = server_pref_map.find(server);
+    if (it == server_pref_map.end()) {
+      ServerPref server_pref;
+      server_pref.pipeline_max_depth = map_it->second;
+      server_pref_map[server] = server_pref;
+    } else {
+      it->second.pipeline_max_depth = map_it->second;
+    }
+  }
+
   // Persist the prefs::kHttpServerProperties.
   base::DictionaryValue http_server_properties_dict;
   for (ServerPrefMap::const_iterator map_it =
@@ -606,6 +676,11 @@ void HttpServerPropertiesManager::UpdatePrefsOnUI(
                                    server_pref.pipeline_capability);
     }
 
+    if (server_pref.pipeline_max_depth > 0) {
+      server_pref_dict->SetInteger("pipeline_max_depth",
+                                   server_pref.pipeline_max_depth);
+    }
+
     http_server_properties_dict.SetWithoutPathExpansion(server.ToString(),
                                                         server_pref_dict);
   }
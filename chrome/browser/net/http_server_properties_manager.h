@@ -136,6 +136,19 @@ class HttpServerPropertiesManager
 
   virtual net::PipelineCapabilityMap GetPipelineCapabilityMap() const OVERRIDE;
 
+  virtual int GetPipelineMaxDepth(const net::HostPortPair& origin) OVERRIDE;
+
+  virtual void SetPipelineMaxDepth(const net::HostPortPair& origin,
+                                   int depth) OVERRIDE;
+
+  virtual net::PipelineDepthMap GetPipelineMaxDepthMap() const OVERRIDE;
+
+  // Server usage is only kept in memory, so these don't update prefs.
+  virtual void RecordServerUsage(const net::HostPortPair& server,
+                                 bool is_secure) OVERRIDE;
+
+  virtual net::ServerUsageMap GetServerUsageMap() const OVERRIDE;
+
  protected:
   // --------------------
   // SPDY related methods
@@ -161,6 +174,7 @@ class HttpServerPropertiesManager
       net::SpdySettingsMap* spdy_settings_map,
       net::AlternateProtocolMap* alternate_protocol_map,
       net::PipelineCapabilityMap* pipeline_capability_map,
+      net::PipelineDepthMap* pipeline_depth_map,
       bool detected_corrupted_prefs);
 
   // These are used to delay updating the preferences when cached data in
@@ -184,7 +198,8 @@ class HttpServerPropertiesManager
       base::ListValue* spdy_server_list,
       net::SpdySettingsMap* spdy_settings_map,
       net::AlternateProtocolMap* alternate_protocol_map,
-      net::PipelineCapabilityMap* pipeline_capability_map);
+      net::PipelineCapabilityMap* pipeline_capability_map,
+      net::PipelineDepthMap* pipeline_depth_map);
 
  private:
   // Callback for preference changes.
@@ -60,17 +60,19 @@ class TestingHttpServerPropertiesManager : public HttpServerPropertiesManager {
 
   MOCK_METHOD0(UpdateCacheFromPrefsOnUI, void());
   MOCK_METHOD0(UpdatePrefsFromCacheOnIO, void());
-  MOCK_METHOD5(UpdateCacheFromPrefsOnIO,
+  MOCK_METHOD6(UpdateCacheFromPrefsOnIO,
                void(std::vector<std::string>* spdy_servers,
                     net::SpdySettingsMap* spdy_settings_map,
                     net::AlternateProtocolMap* alternate_protocol_map,
                     net::PipelineCapabilityMap* pipeline_capability_map,
+                    net::PipelineDepthMap* pipeline_depth_map,
                     bool detected_corrupted_prefs));
-  MOCK_METHOD4(UpdatePrefsOnUI,
+  MOCK_METHOD5(UpdatePrefsOnUI,
                void(base::ListValue* spdy_server_list,
                     net::SpdySettingsMap* spdy_settings_map,
                     net::AlternateProtocolMap* alternate_protocol_map,
-                    net::PipelineCapabilityMap* pipeline_capability_map));
+                    net::PipelineCapabilityMap* pipeline_capability_map,
+                    net::PipelineDepthMap* pipeline_depth_map));
 
  private:
   DISALLOW_COPY_AND_ASSIGN(TestingHttpServerPropertiesManager);
@@ -148,6 +150,7 @@ TEST_F(HttpServerPropertiesManagerTest,
 
   // Set pipeline capability for www.google.com:80.
   server_pref_dict->SetInteger("pipeline_capability", net::PIPELINE_CAPABLE);
+  server_pref_dict->SetInteger("pipeline_max_depth", 4);
 
   // Set the server preference for www.google.com:80.
   base::DictionaryValue* http_server_properties_dict =
@@ -218,6 +221,10 @@ TEST_F(HttpServerPropertiesManagerTest,
   EXPECT_EQ(net::PIPELINE_INCAPABLE,
             http_server_props_manager_->GetPipelineCapability(
                 net::HostPortPair::FromString("mail.google.com:80")));
+  EXPECT_EQ(4, http_server_props_manager_->GetPipelineMaxDepth(
+      net::HostPortPair::FromString("www.google.com:80")));
+  EXPECT_EQ(0, http_server_props_manager_->GetPipelineMaxDepth(
+      net::HostPortPair::FromString("mail.google.com:80")));
 }
 
 TEST_F(HttpServerPropertiesManagerTest, SupportsSpdy) {
@@ -312,6 +319,37 @@ TEST_F(HttpServerPropertiesManagerTest, PipelineCapability) {
   Mock::VerifyAndClearExpectations(http_server_props_manager_.get());
 }
 
+TEST_F(HttpServerPropertiesManagerTest, PipelineMaxDepth) {
+  ExpectPrefsUpdate();
+
+  net::HostPortPair known_pipeliner("pipeline.com", 8080);
+  EXPECT_EQ(0, http_server_props_manager_->GetPipelineMaxDepth(
+      known_pipeliner));
+
+  http_server_props_manager_->SetPipelineMaxDepth(known_pipeliner, 3);
+
+  // Run the task.
+  loop_.RunAllPending();
+  Mock::VerifyAndClearExpectations(http_server_props_manager_.get());
+
+  EXPECT_EQ(3, http_server_props_manager_->GetPipelineMaxDepth(
+      known_pipeliner));
+  base::DictionaryValue* server_pref_dict = NULL;
+  ASSERT_TRUE(pref_service_.GetDictionary(prefs::kHttpServerProperties)->
+      GetDictionaryWithoutPathExpansion("pipeline.com:8080",
+                                        &server_pref_dict));
+  int pipeline_max_depth = 0;
+  EXPECT_TRUE(server_pref_dict->GetInteger("pipeline_max_depth",
+                                           &pipeline_max_depth));
+  EXPECT_EQ(3, pipeline_max_depth);
+
+  // A shallower depth doesn't update the prefs.
+  http_server_props_manager_->SetPipelineMaxDepth(known_pipeliner, 2);
+  loop_.RunAllPending();
+  EXPECT_EQ(3, http_server_props_manager_->GetPipelineMaxDepth(
+      known_pipeliner));
+}
+
 TEST_F(HttpServerPropertiesManagerTest, Clear) {
   ExpectPrefsUpdate();
 
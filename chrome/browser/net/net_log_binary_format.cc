@@ -0,0 +1,308 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/net_log_binary_format.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "base/string_number_conversions.h"
+#include "base/values.h"
+
+namespace net_log_binary {
+
+namespace {
+
+const char kMagic[8] = { 'C', 'R', 'N', 'E', 'T', 'L', 'O', 'G' };
+const size_t kFileHeaderSize = sizeof(kMagic) + 2 * sizeof(uint32);
+
+enum RecordType {
+  RECORD_EVENT = 0,
+  RECORD_DROPPED_EVENTS = 1,
+};
+
+// Params nested deeper than this are considered corrupt when reading.
+const int kMaxValueDepth = 100;
+
+void AppendUInt32(uint32 value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool ReadUInt32(const base::StringPiece& data, size_t offset, uint32* value) {
+  if (offset > data.size() || data.size() - offset < sizeof(*value))
+    return false;
+  memcpy(value, data.data() + offset, sizeof(*value));
+  return true;
+}
+
+void AppendPickle(const Pickle& pickle, std::string* out) {
+  AppendUInt32(pickle.size(), out);
+  out->append(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+void WriteValue(const base::Value& value, Pickle* pickle) {
+  pickle->WriteInt(value.GetType());
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      break;
+    case base::Value::TYPE_BOOLEAN: {
+      bool bool_value = false;
+      value.GetAsBoolean(&bool_value);
+      pickle->WriteBool(bool_value);
+      break;
+    }
+    case base::Value::TYPE_INTEGER: {
+      int int_value = 0;
+      value.GetAsInteger(&int_value);
+      pickle->WriteInt(int_value);
+      break;
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double double_value = 0;
+      value.GetAsDouble(&double_value);
+      pickle->WriteBytes(&double_value, sizeof(double_value));
+      break;
+    }
+    case base::Value::TYPE_STRING: {
+      std::string string_value;
+      value.GetAsString(&string_value);
+      pickle->WriteString(string_value);
+      break;
+    }
+    case base::Value::TYPE_BINARY: {
+      const base::BinaryValue& binary =
+          static_cast<const base::BinaryValue&>(value);
+      pickle->WriteData(binary.GetBuffer(), binary.GetSize());
+      break;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue& dict =
+          static_cast<const base::DictionaryValue&>(value);
+      pickle->WriteInt(dict.size());
+      for (base::DictionaryValue::Iterator it(dict); it.HasNext();
+           it.Advance()) {
+        pickle->WriteString(it.key());
+        WriteValue(it.value(), pickle);
+      }
+      break;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue& list = static_cast<const base::ListValue&>(value);
+      pickle->WriteInt(list.GetSize());
+      for (base::ListValue::const_iterator it = list.begin();
+           it != list.end(); ++it) {
+        WriteValue(**it, pickle);
+      }
+      break;
+    }
+    default:
+      NOTREACHED();
+  }
+}
+
+// Returns NULL if the pickle does not hold a valid Value.
+base::Value* ReadValue(const Pickle& pickle, PickleIterator* iter, int depth) {
+  int type;
+  if (depth > kMaxValueDepth || !pickle.ReadInt(iter, &type))
+    return NULL;
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      return base::Value::CreateNullValue();
+    case base::Value::TYPE_BOOLEAN: {
+      bool bool_value;
+      if (!pickle.ReadBool(iter, &bool_value))
+        return NULL;
+      return base::Value::CreateBooleanValue(bool_value);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int int_value;
+      if (!pickle.ReadInt(iter, &int_value))
+        return NULL;
+      return base::Value::CreateIntegerValue(int_value);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      const char* bytes;
+      double double_value;
+      if (!pickle.ReadBytes(iter, &bytes, sizeof(double_value)))
+        return NULL;
+      memcpy(&double_value, bytes, sizeof(double_value));
+      return base::Value::CreateDoubleValue(double_value);
+    }
+    case base::Value::TYPE_STRING: {
+      std::string string_value;
+      if (!pickle.ReadString(iter, &string_value))
+        return NULL;
+      return base::Value::CreateStringValue(string_value);
+    }
+    case base::Value::TYPE_BINARY: {
+      const char* data;
+      int length;
+      if (!pickle.ReadData(iter, &data, &length))
+        return NULL;
+      return base::BinaryValue::CreateWithCopiedBuffer(data, length);
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      int size;
+      if (!pickle.ReadLength(iter, &size))
+        return NULL;
+      scoped_ptr<base::DictionaryValue> dict(new base::DictionaryValue());
+      for (int i = 0; i < size; ++i) {
+        std::string key;
+        if (!pickle.ReadString(iter, &key))
+          return NULL;
+        base::Value* child = ReadValue(pickle, iter, depth + 1);
+        if (!child)
+          return NULL;
+        dict->SetWithoutPathExpansion(key, child);
+      }
+      return dict.release();
+    }
+    case base::Value::TYPE_LIST: {
+      int size;
+      if (!pickle.ReadLength(iter, &size))
+        return NULL;
+      scoped_ptr<base::ListValue> list(new base::ListValue());
+      for (int i = 0; i < size; ++i) {
+        base::Value* child = ReadValue(pickle, iter, depth + 1);
+        if (!child)
+          return NULL;
+        list->Append(child);
+      }
+      return list.release();
+    }
+    default:
+      return NULL;
+  }
+}
+
+}  // namespace
+
+const uint32 kVersion = 1;
+
+void AppendFileHeader(const std::string& constants_json, std::string* out) {
+  out->append(kMagic, sizeof(kMagic));
+  AppendUInt32(kVersion, out);
+  AppendUInt32(constants_json.size(), out);
+  out->append(constants_json);
+}
+
+void AppendEvent(int type,
+                 const base::TimeTicks& time,
+                 uint32 source_id,
+                 int source_type,
+                 int phase,
+                 const base::Value* params,
+                 std::string* out) {
+  Pickle pickle;
+  pickle.WriteInt(RECORD_EVENT);
+  pickle.WriteInt64(time.ToInternalValue());
+  pickle.WriteUInt32(source_id);
+  pickle.WriteInt(source_type);
+  pickle.WriteInt(type);
+  pickle.WriteInt(phase);
+  pickle.WriteBool(params != NULL);
+  if (params)
+    WriteValue(*params, &pickle);
+  AppendPickle(pickle, out);
+}
+
+void AppendDroppedEvents(uint32 count, std::string* out) {
+  Pickle pickle;
+  pickle.WriteInt(RECORD_DROPPED_EVENTS);
+  pickle.WriteUInt32(count);
+  AppendPickle(pickle, out);
+}
+
+Reader::Reader(const base::StringPiece& data)
+    : data_(data),
+      offset_(0),
+      dropped_events_(0) {
+}
+
+Reader::~Reader() {}
+
+bool Reader::ReadHeader(std::string* constants_json) {
+  DCHECK_EQ(0u, offset_);
+  uint32 version;
+  uint32 constants_length;
+  if (data_.size() < kFileHeaderSize ||
+      memcmp(data_.data(), kMagic, sizeof(kMagic)) != 0 ||
+      !ReadUInt32(data_, sizeof(kMagic), &version) ||
+      version != kVersion ||
+      !ReadUInt32(data_, sizeof(kMagic) + sizeof(uint32), &constants_length) ||
+      constants_length > data_.size() - kFileHeaderSize) {
+    return false;
+  }
+  constants_json->assign(data_.data() + kFileHeaderSize, constants_length);
+  offset_ = kFileHeaderSize + constants_length;
+  return true;
+}
+
+bool Reader::ReadEvent(scoped_ptr<base::DictionaryValue>* event) {
+  DCHECK_NE(0u, offset_);
+  while (true) {
+    uint32 length;
+    if (!ReadUInt32(data_, offset_, &length) ||
+        length > data_.size() - offset_ - sizeof(length)) {
+      return false;
+    }
+    // Copy the record out: Pickle requires its buffer to be aligned.
+    std::string record(data_.data() + offset_ + sizeof(length), length);
+    offset_ += sizeof(length) + length;
+
+    Pickle pickle(record.data(), record.size());
+    PickleIterator iter(pickle);
+    int record_type;
+    if (!pickle.ReadInt(&iter, &record_type))
+      return false;
+
+    if (record_type == RECORD_DROPPED_EVENTS) {
+      uint32 count;
+      if (!pickle.ReadUInt32(&iter, &count))
+        return false;
+      dropped_events_ += count;
+      continue;
+    }
+    if (record_type != RECORD_EVENT)
+      return false;
+
+    int64 time;
+    uint32 source_id;
+    int source_type;
+    int type;
+    int phase;
+    bool has_params;
+    if (!pickle.ReadInt64(&iter, &time) ||
+        !pickle.ReadUInt32(&iter, &source_id) ||
+        !pickle.ReadInt(&iter, &source_type) ||
+        !pickle.ReadInt(&iter, &type) ||
+        !pickle.ReadInt(&iter, &phase) ||
+        !pickle.ReadBool(&iter, &has_params)) {
+      return false;
+    }
+
+    // Matches the output of NetLog::EntryToDictionaryValue().
+    scoped_ptr<base::DictionaryValue> entry(new base::DictionaryValue());
+    base::TimeTicks ticks = base::TimeTicks::FromInternalValue(time);
+    entry->SetString("time", base::Int64ToString(
+        (ticks - base::TimeTicks()).InMilliseconds()));
+    base::DictionaryValue* source = new base::DictionaryValue();
+    source->SetInteger("id", source_id);
+    source->SetInteger("type", source_type);
+    entry->Set("source", source);
+    entry->SetInteger("type", type);
+    entry->SetInteger("phase", phase);
+    if (has_params) {
+      base::Value* params = ReadValue(pickle, &iter, 0);
+      if (!params)
+        return false;
+      entry->Set("params", params);
+    }
+    event->reset(entry.release());
+    return true;
+  }
+}
+
+}  // namespace net_log_binary
@@ -0,0 +1,81 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_NET_NET_LOG_BINARY_FORMAT_H_
+#define CHROME_BROWSER_NET_NET_LOG_BINARY_FORMAT_H_
+#pragma once
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/string_piece.h"
+#include "base/time.h"
+
+namespace base {
+class DictionaryValue;
+class Value;
+}
+
+// Encoding used by BinaryNetLogLogger.  Only depends on base, so that the
+// offline converter does not need to link against the browser.
+//
+// A file consists of:
+//   char magic[8] ("CRNETLOG"), uint32 version, uint32 constants_length,
+//   followed by |constants_length| bytes of JSON (the output of
+//   NetInternalsUI::GetConstants() at capture time),
+//   followed by records, each a uint32 length and a Pickle of that length.
+//
+// A record is either an event, or a marker noting that some number of events
+// were dropped because the writer fell behind.  Every file written by a
+// rotating logger is self-contained.
+namespace net_log_binary {
+
+extern const uint32 kVersion;
+
+// Appends the file header to |out|.
+void AppendFileHeader(const std::string& constants_json, std::string* out);
+
+// Appends an event record to |out|.  |params| may be NULL.
+void AppendEvent(int type,
+                 const base::TimeTicks& time,
+                 uint32 source_id,
+                 int source_type,
+                 int phase,
+                 const base::Value* params,
+                 std::string* out);
+
+// Appends a record noting that |count| events were dropped to |out|.
+void AppendDroppedEvents(uint32 count, std::string* out);
+
+// Reads back a file produced by the functions above.  |data| must outlive the
+// reader.
+class Reader {
+ public:
+  explicit Reader(const base::StringPiece& data);
+  ~Reader();
+
+  // Parses the file header.  Must be called, and succeed, before ReadEvent().
+  bool ReadHeader(std::string* constants_json);
+
+  // Reads the next event, converted to the dictionary format used by
+  // about:net-internals.  Dropped event markers are skipped, and added to
+  // dropped_events().  Returns false at the end of the file, or if the rest
+  // of the file is corrupt.  A truncated final record, as left behind by a
+  // crash, is treated as the end of the file.
+  bool ReadEvent(scoped_ptr<base::DictionaryValue>* event);
+
+  uint64 dropped_events() const { return dropped_events_; }
+
+ private:
+  base::StringPiece data_;
+  size_t offset_;
+  uint64 dropped_events_;
+
+  DISALLOW_COPY_AND_ASSIGN(Reader);
+};
+
+}  // namespace net_log_binary
+
+#endif  // CHROME_BROWSER_NET_NET_LOG_BINARY_FORMAT_H_
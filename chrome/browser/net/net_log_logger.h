@@ -19,8 +19,10 @@ class FilePath;
 // contain a single JSON object, with an extra comma on the end and missing
 // a terminal "]}".
 //
-// Relies on ChromeNetLog only calling an Observer once at a time for
-// thread-safety.
+// OnAddEntry() may be called on several threads at once.  Each entry is
+// written with a single stdio call, which stdio serializes.
+//
+// This is too slow to leave on for long; see BinaryNetLogLogger for that.
 class NetLogLogger : public net::NetLog::ThreadSafeObserver {
  public:
   // If |log_path| is empty or file creation fails, writes to VLOG(1).
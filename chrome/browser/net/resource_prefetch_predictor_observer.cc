@@ -0,0 +1,72 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/resource_prefetch_predictor_observer.h"
+
+#include "base/bind.h"
+#include "chrome/browser/predictors/resource_prefetch_predictor.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/resource_request_info.h"
+#include "net/url_request/url_request.h"
+
+using content::BrowserThread;
+using predictors::ResourcePrefetchPredictor;
+
+namespace chrome_browser_net {
+
+ResourcePrefetchPredictorObserver::ResourcePrefetchPredictorObserver(
+    ResourcePrefetchPredictor* predictor)
+    : predictor_(predictor->AsWeakPtr()) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+}
+
+ResourcePrefetchPredictorObserver::~ResourcePrefetchPredictorObserver() {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI) ||
+        BrowserThread::CurrentlyOn(BrowserThread::IO));
+}
+
+void ResourcePrefetchPredictorObserver::OnRequestStarted(
+    net::URLRequest* request,
+    ResourceType::Type resource_type,
+    int child_id,
+    int route_id) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  if (!ResourcePrefetchPredictor::ShouldRecordRequest(request, resource_type))
+    return;
+
+  ResourcePrefetchPredictor::URLRequestSummary summary;
+  summary.navigation_id =
+      ResourcePrefetchPredictor::NavigationID(child_id, route_id);
+  summary.resource_url = request->original_url();
+  summary.resource_type = resource_type;
+
+  BrowserThread::PostTask(BrowserThread::UI, FROM_HERE,
+      base::Bind(&ResourcePrefetchPredictor::RecordMainFrameRequest,
+                 predictor_, summary));
+}
+
+void ResourcePrefetchPredictorObserver::OnResponseStarted(
+    net::URLRequest* request) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  if (!ResourcePrefetchPredictor::ShouldRecordResponse(request))
+    return;
+
+  const content::ResourceRequestInfo* info =
+      content::ResourceRequestInfo::ForRequest(request);
+
+  ResourcePrefetchPredictor::URLRequestSummary summary;
+  summary.navigation_id = ResourcePrefetchPredictor::NavigationID(
+      info->GetChildID(), info->GetRouteID());
+  summary.resource_url = request->original_url();
+  summary.resource_type = info->GetResourceType();
+  summary.was_cached = request->was_cached();
+
+  BrowserThread::PostTask(BrowserThread::UI, FROM_HERE,
+      base::Bind(&ResourcePrefetchPredictor::RecordURLResponse,
+                 predictor_, summary));
+}
+
+}  // namespace chrome_browser_net
@@ -0,0 +1,53 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_NET_RESOURCE_PREFETCH_PREDICTOR_OBSERVER_H_
+#define CHROME_BROWSER_NET_RESOURCE_PREFETCH_PREDICTOR_OBSERVER_H_
+#pragma once
+
+#include "base/basictypes.h"
+#include "base/memory/weak_ptr.h"
+#include "webkit/glue/resource_type.h"
+
+namespace net {
+class URLRequest;
+}
+
+namespace predictors {
+class ResourcePrefetchPredictor;
+}
+
+namespace chrome_browser_net {
+
+// Forwards the main frame requests and the subresource responses of a profile
+// from the IO thread to its predictors::ResourcePrefetchPredictor on the UI
+// thread.
+//
+// Created on the UI thread, then owned by the ProfileIOData and used on the IO
+// thread only.
+class ResourcePrefetchPredictorObserver {
+ public:
+  explicit ResourcePrefetchPredictorObserver(
+      predictors::ResourcePrefetchPredictor* predictor);
+  ~ResourcePrefetchPredictorObserver();
+
+  // Called when |request| is about to start.
+  void OnRequestStarted(net::URLRequest* request,
+                        ResourceType::Type resource_type,
+                        int child_id,
+                        int route_id);
+
+  // Called when the response headers of |request| have been received.
+  void OnResponseStarted(net::URLRequest* request);
+
+ private:
+  // Only dereferenced on the UI thread.
+  base::WeakPtr<predictors::ResourcePrefetchPredictor> predictor_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourcePrefetchPredictorObserver);
+};
+
+}  // namespace chrome_browser_net
+
+#endif  // CHROME_BROWSER_NET_RESOURCE_PREFETCH_PREDICTOR_OBSERVER_H_
@@ -0,0 +1,305 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/sdch_dictionary_persister.h"
+
+#include <set>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_vector.h"
+#include "base/metrics/histogram.h"
+#include "base/string_number_conversions.h"
+#include "base/string_util.h"
+#include "base/values.h"
+#include "content/public/browser/browser_thread.h"
+
+using content::BrowserThread;
+
+namespace {
+
+const FilePath::CharType kSdchDictionariesDirectory[] =
+    FILE_PATH_LITERAL("SDCH Dictionaries");
+const FilePath::CharType kIndexFilename[] = FILE_PATH_LITERAL("Index");
+
+const char kUrlKey[] = "url";
+const char kExpirationKey[] = "expiration";
+
+// Server hashes are eight URL safe base64 characters, so they can be used as
+// file names as they are.
+bool IsValidServerHash(const std::string& server_hash) {
+  if (server_hash.size() != 8)
+    return false;
+  for (size_t i = 0; i < server_hash.size(); ++i) {
+    char c = server_hash[i];
+    if (!IsAsciiAlpha(c) && !IsAsciiDigit(c) && c != '-' && c != '_')
+      return false;
+  }
+  return true;
+}
+
+void WriteDictionaryFile(const FilePath& directory,
+                         const std::string& server_hash,
+                         const std::string& dictionary_text) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  if (!file_util::CreateDirectory(directory))
+    return;
+  // The index is written later on this same thread, so it only refers to the
+  // file once it has been written.  A file that was cut short fails the hash
+  // check when it is loaded.
+  file_util::WriteFile(directory.AppendASCII(server_hash),
+                       dictionary_text.data(), dictionary_text.size());
+}
+
+void DeleteDirectory(const FilePath& directory) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+  file_util::Delete(directory, true);
+}
+
+}  // namespace
+
+class SdchDictionaryPersister::Loader {
+ public:
+  struct LoadedDictionary {
+    LoadedDictionary() {}
+
+    std::string server_hash;
+    std::string client_hash;
+    GURL url;
+    base::Time expiration;
+    scoped_ptr<file_util::MemoryMappedFile> mapped_file;
+  };
+
+  Loader(const base::WeakPtr<SdchDictionaryPersister>& persister,
+         const FilePath& directory)
+      : persister_(persister),
+        directory_(directory),
+        num_index_entries_(0) {
+  }
+
+  void Load() {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+
+    std::string index;
+    scoped_ptr<Value> value;
+    if (file_util::ReadFileToString(directory_.Append(kIndexFilename), &index))
+      value.reset(base::JSONReader::Read(index));
+    DictionaryValue* dictionaries = NULL;
+    if (value.get())
+      value->GetAsDictionary(&dictionaries);
+
+    std::set<FilePath> kept_files;
+    kept_files.insert(directory_.Append(kIndexFilename));
+    if (dictionaries) {
+      base::Time now = base::Time::Now();
+      for (DictionaryValue::key_iterator it = dictionaries->begin_keys();
+           it != dictionaries->end_keys(); ++it) {
+        ++num_index_entries_;
+        LoadDictionary(*it, dictionaries, now, &kept_files);
+      }
+    }
+
+    // Remove expired dictionaries, and those whose index entry was lost.
+    file_util::FileEnumerator files(directory_, false,
+                                    file_util::FileEnumerator::FILES);
+    for (FilePath path = files.Next(); !path.empty(); path = files.Next()) {
+      if (kept_files.find(path) == kept_files.end())
+        file_util::Delete(path, false);
+    }
+  }
+
+  void CompleteLoad() {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+    // Make sure we're deleted.
+    scoped_ptr<Loader> deleter(this);
+
+    if (!persister_)
+      return;
+    persister_->CompleteLoad(this);
+  }
+
+  ScopedVector<LoadedDictionary>& dictionaries() { return dictionaries_; }
+  int num_index_entries() const { return num_index_entries_; }
+
+ private:
+  // Maps the dictionary |server_hash| from the index in |dictionaries|, if it
+  // is still valid, and adds its file to |kept_files|.
+  void LoadDictionary(const std::string& server_hash,
+                      DictionaryValue* dictionaries,
+                      const base::Time& now,
+                      std::set<FilePath>* kept_files) {
+    DictionaryValue* entry = NULL;
+    std::string url;
+    std::string expiration_string;
+    int64 expiration;
+    if (!IsValidServerHash(server_hash) ||
+        !dictionaries->GetDictionaryWithoutPathExpansion(server_hash,
+                                                         &entry) ||
+        !entry->GetString(kUrlKey, &url) ||
+        !entry->GetString(kExpirationKey, &expiration_string) ||
+        !base::StringToInt64(expiration_string, &expiration)) {
+      return;
+    }
+    scoped_ptr<LoadedDictionary> loaded(new LoadedDictionary);
+    loaded->server_hash = server_hash;
+    loaded->url = GURL(url);
+    loaded->expiration = base::Time::FromInternalValue(expiration);
+    if (!loaded->url.is_valid() || loaded->expiration < now)
+      return;
+
+    FilePath path = directory_.AppendASCII(server_hash);
+    loaded->mapped_file.reset(new file_util::MemoryMappedFile);
+    if (!loaded->mapped_file->Initialize(path))
+      return;
+
+    // Hashing reads the whole dictionary once, here rather than on the IO
+    // thread, and catches files that were damaged on disk.
+    std::string server_hash_of_file;
+    net::SdchManager::GenerateHash(
+        base::StringPiece(
+            reinterpret_cast<const char*>(loaded->mapped_file->data()),
+            loaded->mapped_file->length()),
+        &loaded->client_hash, &server_hash_of_file);
+    if (server_hash_of_file != server_hash)
+      return;
+
+    kept_files->insert(path);
+    dictionaries_.push_back(loaded.release());
+  }
+
+  base::WeakPtr<SdchDictionaryPersister> persister_;
+
+  const FilePath directory_;
+
+  ScopedVector<LoadedDictionary> dictionaries_;
+
+  // The number of dictionaries in the index, including those not loaded.
+  int num_index_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(Loader);
+};
+
+SdchDictionaryPersister::SdchDictionaryPersister(
+    const FilePath& profile_path,
+    const net::URLRequestContext* main_context)
+    : directory_(profile_path.Append(kSdchDictionariesDirectory)),
+      main_context_(main_context),
+      writer_(directory_.Append(kIndexFilename),
+              BrowserThread::GetMessageLoopProxyForThread(BrowserThread::FILE)),
+      weak_ptr_factory_(ALLOW_THIS_IN_INITIALIZER_LIST(this)) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  net::SdchManager::Global()->set_dictionary_store(this);
+
+  Loader* loader = new Loader(weak_ptr_factory_.GetWeakPtr(), directory_);
+  BrowserThread::PostTaskAndReply(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&Loader::Load, base::Unretained(loader)),
+      base::Bind(&Loader::CompleteLoad, base::Unretained(loader)));
+}
+
+SdchDictionaryPersister::~SdchDictionaryPersister() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  if (writer_.HasPendingWrite())
+    writer_.DoScheduledWrite();
+
+  if (net::SdchManager::Global())
+    net::SdchManager::Global()->set_dictionary_store(NULL);
+}
+
+bool SdchDictionaryPersister::CanSaveDictionariesFor(
+    const net::URLRequestContext* context) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  return context == main_context_;
+}
+
+void SdchDictionaryPersister::SaveDictionary(const std::string& dictionary_text,
+                                             const GURL& dictionary_url,
+                                             const std::string& server_hash,
+                                             const base::Time& expiration) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (!IsValidServerHash(server_hash))
+    return;
+
+  BrowserThread::PostTask(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&WriteDictionaryFile, directory_, server_hash,
+                 dictionary_text));
+
+  Entry& entry = entries_[server_hash];
+  entry.url = dictionary_url;
+  entry.expiration = expiration;
+  writer_.ScheduleWrite(this);
+}
+
+void SdchDictionaryPersister::DeleteSavedDictionaries() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  // A load still in progress would bring the deleted dictionaries back.
+  weak_ptr_factory_.InvalidateWeakPtrs();
+
+  // Dictionary files and the index are all written on the FILE thread, so the
+  // directory is deleted after any pending writes.  A scheduled index write is
+  // done now, while it is empty, so it can't recreate the index later.
+  entries_.clear();
+  if (writer_.HasPendingWrite())
+    writer_.DoScheduledWrite();
+  BrowserThread::PostTask(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&DeleteDirectory, directory_));
+}
+
+bool SdchDictionaryPersister::SerializeData(std::string* data) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  DictionaryValue dictionaries;
+  base::Time now = base::Time::Now();
+  for (EntryMap::const_iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    if (it->second.expiration < now)
+      continue;
+    DictionaryValue* entry = new DictionaryValue;
+    entry->SetString(kUrlKey, it->second.url.spec());
+    entry->SetString(
+        kExpirationKey,
+        base::Int64ToString(it->second.expiration.ToInternalValue()));
+    dictionaries.SetWithoutPathExpansion(it->first, entry);
+  }
+  base::JSONWriter::Write(&dictionaries, data);
+  return true;
+}
+
+void SdchDictionaryPersister::CompleteLoad(Loader* loader) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  net::SdchManager* manager = net::SdchManager::Global();
+  ScopedVector<Loader::LoadedDictionary>& dictionaries =
+      loader->dictionaries();
+  int added = 0;
+  for (size_t i = 0; i < dictionaries.size(); ++i) {
+    Loader::LoadedDictionary* loaded = dictionaries[i];
+    // The manager checks the dictionary as if it had just been fetched, so
+    // one that would no longer be accepted is dropped.
+    if (!manager->AddPersistedSdchDictionary(loaded->mapped_file.release(),
+                                             loaded->url,
+                                             loaded->client_hash,
+                                             loaded->server_hash,
+                                             loaded->expiration)) {
+      continue;
+    }
+    ++added;
+    Entry& entry = entries_[loaded->server_hash];
+    entry.url = loaded->url;
+    entry.expiration = loaded->expiration;
+  }
+  UMA_HISTOGRAM_COUNTS_100("Sdch3.PersistedDictionariesLoaded", added);
+
+  // Rewrite the index if anything in it was dropped.
+  if (added != loader->num_index_entries())
+    writer_.ScheduleWrite(this);
+}
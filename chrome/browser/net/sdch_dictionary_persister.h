@@ -0,0 +1,89 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SdchDictionaryPersister saves the SDCH dictionaries the browser fetches in
+// the profile directory, and hands them back to the net::SdchManager at
+// startup, so that SDCH can be advertised from the first page loads after a
+// restart rather than only once the dictionaries have been fetched again.
+//
+// Each dictionary is kept in its own file, named by its server hash, inside
+// the "SDCH Dictionaries" directory.  An index next to them, written through
+// an ImportantFileWriter, records the URL each came from and when it expires.
+// Saved dictionaries are memory-mapped when loaded, so they are not copied
+// onto the heap.  Only dictionaries fetched for requests made in the profile's
+// main request context are saved, so off the record browsing, which has its
+// own context, never reaches the disk.
+
+#ifndef CHROME_BROWSER_NET_SDCH_DICTIONARY_PERSISTER_H_
+#define CHROME_BROWSER_NET_SDCH_DICTIONARY_PERSISTER_H_
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "base/file_path.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time.h"
+#include "chrome/common/important_file_writer.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/sdch_manager.h"
+
+namespace net {
+class URLRequestContext;
+}
+
+// Saves and restores the dictionaries of the global net::SdchManager.  Must be
+// created, used and destroyed only on the IO thread, while the SdchManager
+// exists.
+class SdchDictionaryPersister
+    : public net::SdchDictionaryStore,
+      public ImportantFileWriter::DataSerializer {
+ public:
+  // Registers with the SdchManager, and starts loading the dictionaries
+  // saved inside |profile_path|.  Dictionaries fetched for requests made in
+  // |main_context|, which is not owned, are saved.
+  SdchDictionaryPersister(const FilePath& profile_path,
+                          const net::URLRequestContext* main_context);
+  virtual ~SdchDictionaryPersister();
+
+  // net::SdchDictionaryStore:
+  virtual bool CanSaveDictionariesFor(
+      const net::URLRequestContext* context) OVERRIDE;
+  virtual void SaveDictionary(const std::string& dictionary_text,
+                              const GURL& dictionary_url,
+                              const std::string& server_hash,
+                              const base::Time& expiration) OVERRIDE;
+  virtual void DeleteSavedDictionaries() OVERRIDE;
+
+  // ImportantFileWriter::DataSerializer:
+  virtual bool SerializeData(std::string* data) OVERRIDE;
+
+ private:
+  class Loader;
+
+  struct Entry {
+    GURL url;
+    base::Time expiration;
+  };
+  // Maps the server hash of each saved dictionary to its entry.
+  typedef std::map<std::string, Entry> EntryMap;
+
+  void CompleteLoad(Loader* loader);
+
+  const FilePath directory_;
+
+  const net::URLRequestContext* const main_context_;
+
+  // The dictionaries that have been saved, and are in the index.
+  EntryMap entries_;
+
+  // Helper for safely writing the index.
+  ImportantFileWriter writer_;
+
+  base::WeakPtrFactory<SdchDictionaryPersister> weak_ptr_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(SdchDictionaryPersister);
+};
+
+#endif  // CHROME_BROWSER_NET_SDCH_DICTIONARY_PERSISTER_H_
@@ -304,6 +304,17 @@ bool InitTable(sql::Connection* db) {
   return true;
 }
 
+// Returns a connection for the cookie database, set up before it is opened.
+// Commits go to a write-ahead log, synced only at checkpoints, since cookie
+// writes are already batched and losing the last batch to a power failure
+// is no worse than losing it to a crash.
+sql::Connection* CreateConnection() {
+  sql::Connection* db = new sql::Connection;
+  db->set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+  db->set_synchronous(sql::Connection::SYNCHRONOUS_NORMAL);
+  return db;
+}
+
 }  // namespace
 
 void SQLitePersistentCookieStore::Backend::Load(
@@ -478,7 +489,7 @@ bool SQLitePersistentCookieStore::Backend::InitializeDatabase() {
     UMA_HISTOGRAM_COUNTS("Cookie.DBSizeInKB", db_size / 1024 );
   }
 
-  db_.reset(new sql::Connection);
+  db_.reset(CreateConnection());
   if (!db_->Open(path_)) {
     NOTREACHED() << "Unable to open cookie DB.";
     db_.reset();
@@ -720,7 +731,7 @@ bool SQLitePersistentCookieStore::Backend::EnsureDatabaseVersion() {
     UMA_HISTOGRAM_COUNTS_100("Cookie.CorruptMetaTable", 1);
 
     meta_table_.Reset();
-    db_.reset(new sql::Connection);
+    db_.reset(CreateConnection());
     if (!file_util::Delete(path_, false) ||
         !db_->Open(path_) ||
         !meta_table_.Init(
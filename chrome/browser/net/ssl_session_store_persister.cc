@@ -0,0 +1,169 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/ssl_session_store_persister.h"
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram.h"
+#include "chrome/browser/password_manager/encryptor.h"
+#include "chrome/common/important_file_writer.h"
+#include "content/public/browser/browser_thread.h"
+
+using content::BrowserThread;
+
+namespace {
+
+const FilePath::CharType kSSLSessionsFilename[] =
+    FILE_PATH_LITERAL("SSL Sessions");
+
+// How long changes are batched before the file is rewritten.
+const int kCommitIntervalSeconds = 10;
+
+}  // namespace
+
+// Owns the file, and does the encryption, which may block (on the Mac
+// Keychain), on the file thread.
+class SSLSessionStorePersister::Backend {
+ public:
+  explicit Backend(const FilePath& path) : path_(path) {}
+
+  // Returns false if there is no file.  If the file cannot be decrypted,
+  // returns true with |serialized| empty, so that it gets replaced.
+  bool Load(std::string* serialized) {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+    std::string ciphertext;
+    if (!file_util::ReadFileToString(path_, &ciphertext))
+      return false;
+    if (!Encryptor::DecryptString(ciphertext, serialized))
+      serialized->clear();
+    return true;
+  }
+
+  void Write(const std::string& serialized) {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+    std::string ciphertext;
+    if (!Encryptor::EncryptString(serialized, &ciphertext)) {
+      // Sessions hold master secrets, so never fall back to plaintext.
+      file_util::Delete(path_, false);
+      return;
+    }
+    if (!writer_.get()) {
+      writer_.reset(new ImportantFileWriter(
+          path_,
+          BrowserThread::GetMessageLoopProxyForThread(BrowserThread::FILE)));
+    }
+    writer_->WriteNow(ciphertext);
+  }
+
+ private:
+  const FilePath path_;
+
+  // Created on first use, as it must live on the file thread.
+  scoped_ptr<ImportantFileWriter> writer_;
+
+  DISALLOW_COPY_AND_ASSIGN(Backend);
+};
+
+class SSLSessionStorePersister::Loader {
+ public:
+  Loader(const base::WeakPtr<SSLSessionStorePersister>& persister,
+         Backend* backend)
+      : persister_(persister),
+        backend_(backend),
+        data_valid_(false) {
+  }
+
+  void Load() {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::FILE));
+    data_valid_ = backend_->Load(&data_);
+  }
+
+  void CompleteLoad() {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+    // Make sure we're deleted.
+    scoped_ptr<Loader> deleter(this);
+
+    if (!persister_ || !data_valid_)
+      return;
+    persister_->CompleteLoad(data_);
+  }
+
+ private:
+  base::WeakPtr<SSLSessionStorePersister> persister_;
+
+  // Only used on the file thread, where it is deleted after Load() has run.
+  Backend* backend_;
+
+  std::string data_;
+  bool data_valid_;
+
+  DISALLOW_COPY_AND_ASSIGN(Loader);
+};
+
+SSLSessionStorePersister::SSLSessionStorePersister(const std::string& shard,
+                                                   const FilePath& directory)
+    : shard_(shard),
+      backend_(new Backend(directory.Append(kSSLSessionsFilename))),
+      weak_ptr_factory_(ALLOW_THIS_IN_INITIALIZER_LIST(this)) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  net::SSLSessionStore::GetInstance()->SetDelegate(shard_, this);
+
+  Loader* loader = new Loader(weak_ptr_factory_.GetWeakPtr(), backend_);
+  BrowserThread::PostTaskAndReply(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&Loader::Load, base::Unretained(loader)),
+      base::Bind(&Loader::CompleteLoad, base::Unretained(loader)));
+}
+
+SSLSessionStorePersister::~SSLSessionStorePersister() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  if (write_timer_.IsRunning()) {
+    write_timer_.Stop();
+    Write();
+  }
+
+  net::SSLSessionStore::GetInstance()->SetDelegate(shard_, NULL);
+
+  BrowserThread::DeleteSoon(BrowserThread::FILE, FROM_HERE, backend_);
+}
+
+void SSLSessionStorePersister::SessionStoreIsDirty(const std::string& shard) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK_EQ(shard_, shard);
+
+  ScheduleWrite();
+}
+
+void SSLSessionStorePersister::ScheduleWrite() {
+  if (write_timer_.IsRunning())
+    return;
+  write_timer_.Start(FROM_HERE,
+                     base::TimeDelta::FromSeconds(kCommitIntervalSeconds),
+                     this, &SSLSessionStorePersister::Write);
+}
+
+void SSLSessionStorePersister::Write() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  std::string serialized;
+  net::SSLSessionStore::GetInstance()->Serialize(shard_, &serialized);
+  BrowserThread::PostTask(
+      BrowserThread::FILE, FROM_HERE,
+      base::Bind(&Backend::Write, base::Unretained(backend_), serialized));
+}
+
+void SSLSessionStorePersister::CompleteLoad(const std::string& serialized) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  bool loaded = net::SSLSessionStore::GetInstance()->Load(shard_, serialized);
+  UMA_HISTOGRAM_BOOLEAN("Net.SSLSessionStore_PersistedLoaded", loaded);
+  if (!loaded) {
+    // Replace the unreadable file with the current contents.
+    ScheduleWrite();
+  }
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SSLSessionStorePersister writes the TLS sessions a profile negotiated to
+// disk, and restores them at startup, so that the first connection to a server
+// after a restart can resume its session instead of doing a full handshake.
+//
+// Sessions carry their master secrets, so the file is encrypted with the
+// OS-keyed Encryptor that also protects saved passwords. Encryption, and the
+// ImportantFileWriter that replaces the file, run on the file thread.
+
+#ifndef CHROME_BROWSER_NET_SSL_SESSION_STORE_PERSISTER_H_
+#define CHROME_BROWSER_NET_SSL_SESSION_STORE_PERSISTER_H_
+#pragma once
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/memory/weak_ptr.h"
+#include "base/timer.h"
+#include "net/socket/ssl_session_store.h"
+
+// Reads and updates the on-disk sessions of one SSL session cache shard.
+// Must be created, used and destroyed only on the IO thread.
+class SSLSessionStorePersister : public net::SSLSessionStore::Delegate {
+ public:
+  // Persists the sessions of |shard|. The sessions are stored in the file
+  // "SSL Sessions" inside |directory|.
+  SSLSessionStorePersister(const std::string& shard,
+                           const FilePath& directory);
+  virtual ~SSLSessionStorePersister();
+
+  // net::SSLSessionStore::Delegate:
+  virtual void SessionStoreIsDirty(const std::string& shard) OVERRIDE;
+
+ private:
+  class Backend;
+  class Loader;
+
+  // Writes the sessions out after a delay, batching later changes.
+  void ScheduleWrite();
+
+  // Hands the serialized sessions to |backend_| to encrypt and write.
+  void Write();
+
+  void CompleteLoad(const std::string& serialized);
+
+  const std::string shard_;
+
+  // Owned, but lives on, and is deleted on, the file thread.
+  Backend* backend_;
+
+  base::OneShotTimer<SSLSessionStorePersister> write_timer_;
+
+  base::WeakPtrFactory<SSLSessionStorePersister> weak_ptr_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(SSLSessionStorePersister);
+};
+
+#endif  // CHROME_BROWSER_NET_SSL_SESSION_STORE_PERSISTER_H_
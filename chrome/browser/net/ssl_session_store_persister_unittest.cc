@@ -0,0 +1,119 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/ssl_session_store_persister.h"
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/scoped_temp_dir.h"
+#include "base/time.h"
+#include "chrome/browser/password_manager/encryptor.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/test/test_browser_thread.h"
+#include "net/base/host_port_pair.h"
+#include "net/socket/ssl_session_store.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const char kShard[] = "ssl_session_store_persister_unittest";
+
+// Stand-ins for the parts of a serialized session that must not reach the disk
+// in the clear.
+const char kSessionID[] = "session-id:0123456789abcdef0123456789abcdef";
+const char kMasterSecret[] = "master-secret:fedcba9876543210fedcba98765432";
+
+class SSLSessionStorePersisterTest : public testing::Test {
+ public:
+  SSLSessionStorePersisterTest()
+      : message_loop_(MessageLoop::TYPE_IO),
+        test_file_thread_(content::BrowserThread::FILE, &message_loop_),
+        test_io_thread_(content::BrowserThread::IO, &message_loop_) {
+  }
+
+  virtual void SetUp() OVERRIDE {
+#if defined(OS_MACOSX)
+    Encryptor::UseMockKeychain(true);
+#endif
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    net::SSLSessionStore::GetInstance()->Clear();
+  }
+
+  virtual void TearDown() OVERRIDE {
+    persister_.reset();
+    // Once for the encryption task, once for the write it posts.
+    message_loop_.RunAllPending();
+    message_loop_.RunAllPending();
+    net::SSLSessionStore::GetInstance()->Clear();
+  }
+
+ protected:
+  FilePath SessionsPath() const {
+    return temp_dir_.path().Append(FILE_PATH_LITERAL("SSL Sessions"));
+  }
+
+  // Ordering is important here, so that the persister goes before the threads
+  // it runs on.
+  MessageLoop message_loop_;
+  content::TestBrowserThread test_file_thread_;
+  content::TestBrowserThread test_io_thread_;
+
+  ScopedTempDir temp_dir_;
+  scoped_ptr<SSLSessionStorePersister> persister_;
+};
+
+// The file holds no session material in the clear, and still loads back.
+TEST_F(SSLSessionStorePersisterTest, SessionsAreEncrypted) {
+  persister_.reset(new SSLSessionStorePersister(kShard, temp_dir_.path()));
+  message_loop_.RunAllPending();
+
+  const std::string session = std::string(kSessionID) + kMasterSecret;
+  const net::HostPortPair host("www.example.com", 443);
+  net::SSLSessionStore::GetInstance()->Add(
+      kShard, host, session,
+      base::Time::Now() + base::TimeDelta::FromHours(1));
+
+  // Destroying the persister writes out pending changes.
+  persister_.reset();
+  message_loop_.RunAllPending();
+  message_loop_.RunAllPending();
+
+  std::string contents;
+  ASSERT_TRUE(file_util::ReadFileToString(SessionsPath(), &contents));
+  EXPECT_FALSE(contents.empty());
+  EXPECT_EQ(std::string::npos, contents.find(kSessionID));
+  EXPECT_EQ(std::string::npos, contents.find(kMasterSecret));
+  EXPECT_EQ(std::string::npos, contents.find("www.example.com"));
+
+  net::SSLSessionStore::GetInstance()->Clear();
+  persister_.reset(new SSLSessionStorePersister(kShard, temp_dir_.path()));
+  message_loop_.RunAllPending();
+
+  std::string loaded;
+  EXPECT_TRUE(
+      net::SSLSessionStore::GetInstance()->Lookup(kShard, host, &loaded));
+  EXPECT_EQ(session, loaded);
+}
+
+// A file that does not decrypt, such as one written in the clear, is
+// discarded rather than loaded.
+TEST_F(SSLSessionStorePersisterTest, PlaintextFileIsNotLoaded) {
+  const std::string garbage = std::string(kSessionID) + kMasterSecret;
+  ASSERT_EQ(static_cast<int>(garbage.size()),
+            file_util::WriteFile(SessionsPath(), garbage.data(),
+                                 garbage.size()));
+
+  persister_.reset(new SSLSessionStorePersister(kShard, temp_dir_.path()));
+  message_loop_.RunAllPending();
+
+  std::string loaded;
+  EXPECT_FALSE(net::SSLSessionStore::GetInstance()->Lookup(
+      kShard, net::HostPortPair("www.example.com", 443), &loaded));
+}
+
+}  // namespace
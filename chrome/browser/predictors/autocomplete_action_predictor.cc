@@ -31,6 +31,7 @@
 #include "content/public/browser/notification_details.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/notification_source.h"
+#include "sql/async_connection.h"
 
 namespace {
 
@@ -81,6 +82,8 @@ AutocompleteActionPredictor::AutocompleteActionPredictor(Profile* profile)
     : profile_(profile),
       table_(PredictorDatabaseFactory::GetForProfile(
           profile)->autocomplete_table()),
+      db_(PredictorDatabaseFactory::GetForProfile(
+          profile)->async_connection()),
       initialized_(false) {
   // Request the in-memory database from the history to force it to load so it's
   // available as soon as possible.
@@ -94,8 +97,7 @@ AutocompleteActionPredictor::AutocompleteActionPredictor(Profile* profile)
   // available.
   std::vector<AutocompleteActionPredictorTable::Row>* rows =
       new std::vector<AutocompleteActionPredictorTable::Row>();
-  content::BrowserThread::PostTaskAndReply(
-      content::BrowserThread::DB, FROM_HERE,
+  db_->Read(
       base::Bind(&AutocompleteActionPredictorTable::GetAllRows,
                  table_,
                  rows),
@@ -349,10 +351,11 @@ void AutocompleteActionPredictor::DeleteOldEntries(
   std::vector<AutocompleteActionPredictorTable::Row::Id> ids_to_delete;
   DeleteOldIdsFromCaches(url_db, &ids_to_delete);
 
-  content::BrowserThread::PostTask(content::BrowserThread::DB, FROM_HERE,
+  db_->Write(
       base::Bind(&AutocompleteActionPredictorTable::DeleteRows,
                  table_,
-                 ids_to_delete));
+                 ids_to_delete),
+      base::Closure());
 
   // Register for notifications and set the |initialized_| flag.
   notification_registrar_.Add(this, chrome::NOTIFICATION_OMNIBOX_OPENED_URL,
@@ -460,11 +463,12 @@ void AutocompleteActionPredictor::AddAndUpdateRows(
                               DATABASE_ACTION_UPDATE, DATABASE_ACTION_COUNT);
   }
 
-  content::BrowserThread::PostTask(content::BrowserThread::DB, FROM_HERE,
+  db_->Write(
       base::Bind(&AutocompleteActionPredictorTable::AddAndUpdateRows,
                  table_,
                  rows_to_add,
-                 rows_to_update));
+                 rows_to_update),
+      base::Closure());
 }
 
 void AutocompleteActionPredictor::DeleteAllRows() {
@@ -473,9 +477,10 @@ void AutocompleteActionPredictor::DeleteAllRows() {
 
   db_cache_.clear();
   db_id_cache_.clear();
-  content::BrowserThread::PostTask(content::BrowserThread::DB, FROM_HERE,
+  db_->Write(
       base::Bind(&AutocompleteActionPredictorTable::DeleteAllRows,
-                 table_));
+                 table_),
+      base::Closure());
   UMA_HISTOGRAM_ENUMERATION("AutocompleteActionPredictor.DatabaseAction",
                             DATABASE_ACTION_DELETE_ALL, DATABASE_ACTION_COUNT);
 }
@@ -500,9 +505,10 @@ void AutocompleteActionPredictor::DeleteRowsWithURLs(
     }
   }
 
-  content::BrowserThread::PostTask(content::BrowserThread::DB, FROM_HERE,
+  db_->Write(
       base::Bind(&AutocompleteActionPredictorTable::DeleteRows, table_,
-                 id_list));
+                 id_list),
+      base::Closure());
   UMA_HISTOGRAM_ENUMERATION("AutocompleteActionPredictor.DatabaseAction",
                             DATABASE_ACTION_DELETE_SOME, DATABASE_ACTION_COUNT);
 }
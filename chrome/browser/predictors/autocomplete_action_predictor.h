@@ -30,6 +30,10 @@ namespace history {
 class URLDatabase;
 }
 
+namespace sql {
+class AsyncConnection;
+}
+
 namespace predictors {
 
 // This class is responsible for determining the correct predictive network
@@ -179,6 +183,8 @@ class AutocompleteActionPredictor
 
   Profile* profile_;
   scoped_refptr<AutocompleteActionPredictorTable> table_;
+  // Runs the |table_| methods.
+  scoped_refptr<sql::AsyncConnection> db_;
   content::NotificationRegistrar notification_registrar_;
 
   // This is cleared after every Omnibox navigation.
@@ -11,8 +11,10 @@
 #include "base/stringprintf.h"
 #include "base/metrics/histogram.h"
 #include "chrome/browser/predictors/autocomplete_action_predictor_table.h"
+#include "chrome/browser/predictors/resource_prefetch_predictor_tables.h"
 #include "chrome/browser/profiles/profile.h"
 #include "content/public/browser/browser_thread.h"
+#include "sql/async_connection.h"
 #include "sql/connection.h"
 #include "sql/statement.h"
 
@@ -22,6 +24,11 @@ namespace {
 const FilePath::CharType kPredictorDatabaseName[] =
     FILE_PATH_LITERAL("Network Action Predictor");
 
+// How long writes are batched for before being committed.  The predictors
+// write a little on most navigations, and losing the last few seconds of
+// them in a crash is harmless.
+const int kCommitDelaySeconds = 5;
+
 }  // namespace
 
 namespace predictors {
@@ -46,9 +53,12 @@ class PredictorDatabaseInternal
   // Cancels pending DB transactions. Should only be called on the UI thread.
   void SetCancelled();
 
+  sql::Connection* db() { return db_->connection(); }
+
   FilePath db_path_;
-  sql::Connection db_;
+  scoped_refptr<sql::AsyncConnection> db_;
   scoped_refptr<AutocompleteActionPredictorTable> autocomplete_table_;
+  scoped_refptr<ResourcePrefetchPredictorTables> resource_prefetch_tables_;
 
   DISALLOW_COPY_AND_ASSIGN(PredictorDatabaseInternal);
 };
@@ -56,7 +66,12 @@ class PredictorDatabaseInternal
 
 PredictorDatabaseInternal::PredictorDatabaseInternal(Profile* profile)
     : db_path_(profile->GetPath().Append(kPredictorDatabaseName)),
-      autocomplete_table_(new AutocompleteActionPredictorTable()) {
+      db_(new sql::AsyncConnection(
+          content::BrowserThread::GetMessageLoopProxyForThread(
+              content::BrowserThread::DB),
+          base::TimeDelta::FromSeconds(kCommitDelaySeconds))),
+      autocomplete_table_(new AutocompleteActionPredictorTable()),
+      resource_prefetch_tables_(new ResourcePrefetchPredictorTables()) {
 }
 
 PredictorDatabaseInternal::~PredictorDatabaseInternal() {
@@ -65,13 +80,14 @@ PredictorDatabaseInternal::~PredictorDatabaseInternal() {
 void PredictorDatabaseInternal::Initialize() {
   CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::DB));
 
-  db_.set_exclusive_locking();
-  bool success = db_.Open(db_path_);
+  db()->set_exclusive_locking();
+  bool success = db()->Open(db_path_);
 
   if (!success)
     return;
 
-  autocomplete_table_->Initialize(&db_);
+  autocomplete_table_->Initialize(db());
+  resource_prefetch_tables_->Initialize(db());
 
   LogDatabaseStats();
 }
@@ -80,6 +96,7 @@ void PredictorDatabaseInternal::SetCancelled() {
   CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
 
   autocomplete_table_->cancelled_.Set();
+  resource_prefetch_tables_->cancelled_.Set();
 }
 
 void PredictorDatabaseInternal::LogDatabaseStats() {
@@ -92,13 +109,14 @@ void PredictorDatabaseInternal::LogDatabaseStats() {
                           static_cast<int>(db_size / 1024));
 
   autocomplete_table_->LogDatabaseStats();
+  resource_prefetch_tables_->LogDatabaseStats();
 }
 
 
 PredictorDatabase::PredictorDatabase(Profile* profile)
     : db_(new PredictorDatabaseInternal(profile)) {
-  content::BrowserThread::PostTask(content::BrowserThread::DB, FROM_HERE,
-      base::Bind(&PredictorDatabaseInternal::Initialize, db_));
+  db_->db_->Execute(base::Bind(&PredictorDatabaseInternal::Initialize, db_),
+                   base::Closure());
 }
 
 PredictorDatabase::~PredictorDatabase() {
@@ -106,6 +124,8 @@ PredictorDatabase::~PredictorDatabase() {
 
 void PredictorDatabase::Shutdown() {
   db_->SetCancelled();
+  // Commits the writes still batched.
+  db_->db_->Close();
 }
 
 scoped_refptr<AutocompleteActionPredictorTable>
@@ -113,8 +133,17 @@ scoped_refptr<AutocompleteActionPredictorTable>
   return db_->autocomplete_table_;
 }
 
+scoped_refptr<ResourcePrefetchPredictorTables>
+    PredictorDatabase::resource_prefetch_tables() {
+  return db_->resource_prefetch_tables_;
+}
+
+scoped_refptr<sql::AsyncConnection> PredictorDatabase::async_connection() {
+  return db_->db_;
+}
+
 sql::Connection* PredictorDatabase::GetDatabase() {
-  return &db_->db_;
+  return db_->db();
 }
 
 }  // namespace predictors
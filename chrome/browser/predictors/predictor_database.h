@@ -12,6 +12,7 @@
 class Profile;
 
 namespace sql {
+class AsyncConnection;
 class Connection;
 }
 
@@ -19,6 +20,7 @@ namespace predictors {
 
 class AutocompleteActionPredictorTable;
 class PredictorDatabaseInternal;
+class ResourcePrefetchPredictorTables;
 
 class PredictorDatabase : public ProfileKeyedService {
  public:
@@ -26,6 +28,11 @@ class PredictorDatabase : public ProfileKeyedService {
   virtual ~PredictorDatabase();
 
   scoped_refptr<AutocompleteActionPredictorTable> autocomplete_table();
+  scoped_refptr<ResourcePrefetchPredictorTables> resource_prefetch_tables();
+
+  // Runs the table methods on the DB thread.  Writes are batched into
+  // transactions committed every few seconds.
+  scoped_refptr<sql::AsyncConnection> async_connection();
 
   // Used for testing.
   sql::Connection* GetDatabase();
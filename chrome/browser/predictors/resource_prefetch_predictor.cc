@@ -0,0 +1,479 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/predictors/resource_prefetch_predictor.h"
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/metrics/histogram.h"
+#include "chrome/browser/history/history_notifications.h"
+#include "chrome/browser/net/preconnect.h"
+#include "chrome/browser/predictors/predictor_database.h"
+#include "chrome/browser/predictors/predictor_database_factory.h"
+#include "chrome/browser/profiles/profile.h"
+#include "chrome/common/chrome_notification_types.h"
+#include "chrome/common/chrome_switches.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/notification_details.h"
+#include "content/public/browser/notification_service.h"
+#include "content/public/browser/notification_source.h"
+#include "content/public/browser/notification_types.h"
+#include "content/public/browser/render_process_host.h"
+#include "content/public/browser/render_view_host.h"
+#include "content/public/browser/resource_request_info.h"
+#include "content/public/browser/web_contents.h"
+#include "net/url_request/url_request.h"
+#include "sql/async_connection.h"
+
+using content::BrowserThread;
+
+namespace {
+
+// Resources predicted with less confidence than this are not acted on.
+const double kMinConfidence = 0.7;
+
+// Resources need to have been seen this many times to be acted on.
+const int kMinHits = 2;
+
+// Resources not seen in this many consecutive loads of a page are forgotten.
+const int kMaxConsecutiveMisses = 3;
+
+// At most this many resources are predicted per navigation.
+const size_t kMaxResourcesToPredict = 25;
+
+// At most this many resources are remembered per page.
+const size_t kMaxResourcesPerPage = 100;
+
+// At most this many pages are remembered. The least recently visited pages are
+// evicted first.
+const size_t kMaxPages = 200;
+
+// Navigations that have not completed after this long are assumed abandoned.
+const int kMaxNavigationLifetimeSeconds = 60;
+
+struct ResourceOrderer {
+  bool operator()(
+      const predictors::ResourcePrefetchPredictorTables::ResourceRow& x,
+      const predictors::ResourcePrefetchPredictorTables::ResourceRow& y) const {
+    return x.average_position < y.average_position;
+  }
+};
+
+}  // namespace
+
+namespace predictors {
+
+ResourcePrefetchPredictor::NavigationID::NavigationID()
+    : render_process_id(-1),
+      render_view_id(-1) {
+}
+
+ResourcePrefetchPredictor::NavigationID::NavigationID(int render_process_id,
+                                                      int render_view_id)
+    : render_process_id(render_process_id),
+      render_view_id(render_view_id) {
+}
+
+ResourcePrefetchPredictor::NavigationID::NavigationID(
+    const content::WebContents& web_contents)
+    : render_process_id(web_contents.GetRenderProcessHost()->GetID()),
+      render_view_id(web_contents.GetRenderViewHost()->GetRoutingID()) {
+}
+
+bool ResourcePrefetchPredictor::NavigationID::operator<(
+    const NavigationID& rhs) const {
+  return std::make_pair(render_process_id, render_view_id) <
+      std::make_pair(rhs.render_process_id, rhs.render_view_id);
+}
+
+ResourcePrefetchPredictor::URLRequestSummary::URLRequestSummary()
+    : resource_type(ResourceType::LAST_TYPE),
+      was_cached(false) {
+}
+
+ResourcePrefetchPredictor::URLRequestSummary::~URLRequestSummary() {
+}
+
+ResourcePrefetchPredictor::Navigation::Navigation() {
+}
+
+ResourcePrefetchPredictor::Navigation::~Navigation() {
+}
+
+ResourcePrefetchPredictor::ResourcePrefetchPredictor(Profile* profile)
+    : profile_(profile),
+      tables_(PredictorDatabaseFactory::GetForProfile(
+          profile)->resource_prefetch_tables()),
+      db_(PredictorDatabaseFactory::GetForProfile(
+          profile)->async_connection()),
+      initialized_(false) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+
+  PrefetchDataMap* data_map = new PrefetchDataMap();
+  db_->Read(
+      base::Bind(&ResourcePrefetchPredictorTables::GetAllData,
+                 tables_,
+                 data_map),
+      base::Bind(&ResourcePrefetchPredictor::CreateCaches, AsWeakPtr(),
+                 base::Owned(data_map)));
+}
+
+ResourcePrefetchPredictor::~ResourcePrefetchPredictor() {
+}
+
+// static
+bool ResourcePrefetchPredictor::IsEnabled(Profile* profile) {
+  return CommandLine::ForCurrentProcess()->HasSwitch(
+      switches::kEnableSpeculativeResourcePrefetching) &&
+      !profile->IsOffTheRecord();
+}
+
+// static
+bool ResourcePrefetchPredictor::ShouldRecordRequest(
+    net::URLRequest* request,
+    ResourceType::Type resource_type) {
+  return resource_type == ResourceType::MAIN_FRAME &&
+      request->method() == "GET" &&
+      request->original_url().SchemeIsHTTPOrHTTPS();
+}
+
+// static
+bool ResourcePrefetchPredictor::ShouldRecordResponse(
+    net::URLRequest* response) {
+  if (response->method() != "GET" ||
+      !response->original_url().SchemeIsHTTPOrHTTPS()) {
+    return false;
+  }
+  // Only learn the resources that block rendering, or that the page is likely
+  // to request from the same hosts on every load.
+  const content::ResourceRequestInfo* info =
+      content::ResourceRequestInfo::ForRequest(response);
+  if (!info)
+    return false;
+  switch (info->GetResourceType()) {
+    case ResourceType::STYLESHEET:
+    case ResourceType::SCRIPT:
+    case ResourceType::IMAGE:
+    case ResourceType::FONT_RESOURCE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void ResourcePrefetchPredictor::RecordMainFrameRequest(
+    const URLRequestSummary& request) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (!initialized_)
+    return;
+
+  RemoveAbandonedNavigations();
+
+  // A new main frame load replaces any in progress in the same tab.
+  Navigation& navigation = inflight_navigations_[request.navigation_id];
+  navigation = Navigation();
+  navigation.main_frame_url = request.resource_url;
+  navigation.start_time = base::TimeTicks::Now();
+
+  Predict(request.resource_url, &navigation.predicted_resources);
+  Preconnect(navigation.predicted_resources);
+}
+
+void ResourcePrefetchPredictor::RecordURLResponse(
+    const URLRequestSummary& response) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (!initialized_)
+    return;
+
+  NavigationMap::iterator it =
+      inflight_navigations_.find(response.navigation_id);
+  if (it == inflight_navigations_.end())
+    return;
+
+  std::vector<URLRequestSummary>& resources = it->second.resources;
+  for (std::vector<URLRequestSummary>::const_iterator resource =
+           resources.begin(); resource != resources.end(); ++resource) {
+    if (resource->resource_url == response.resource_url)
+      return;
+  }
+  resources.push_back(response);
+}
+
+void ResourcePrefetchPredictor::Observe(
+    int type,
+    const content::NotificationSource& source,
+    const content::NotificationDetails& details) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+
+  switch (type) {
+    case content::NOTIFICATION_LOAD_COMPLETED_MAIN_FRAME: {
+      content::WebContents* web_contents =
+          content::Source<content::WebContents>(source).ptr();
+      // Notifications are registered for all sources, so filter out the other
+      // profiles.
+      if (Profile::FromBrowserContext(web_contents->GetBrowserContext()) ==
+          profile_) {
+        OnNavigationComplete(web_contents);
+      }
+      break;
+    }
+
+    case chrome::NOTIFICATION_HISTORY_URLS_DELETED: {
+      const content::Details<const history::URLsDeletedDetails>
+          urls_deleted_details =
+              content::Details<const history::URLsDeletedDetails>(details);
+      if (urls_deleted_details->all_history)
+        DeleteAllUrls();
+      else
+        DeleteUrls(urls_deleted_details->rows);
+      break;
+    }
+
+    default:
+      NOTREACHED() << "Unexpected notification observed.";
+      break;
+  }
+}
+
+void ResourcePrefetchPredictor::CreateCaches(PrefetchDataMap* data_map) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  DCHECK(!initialized_);
+  DCHECK(url_table_cache_.empty());
+
+  url_table_cache_.swap(*data_map);
+
+  notification_registrar_.Add(this,
+                              content::NOTIFICATION_LOAD_COMPLETED_MAIN_FRAME,
+                              content::NotificationService::AllSources());
+  notification_registrar_.Add(this, chrome::NOTIFICATION_HISTORY_URLS_DELETED,
+                              content::Source<Profile>(profile_));
+  initialized_ = true;
+}
+
+void ResourcePrefetchPredictor::OnNavigationComplete(
+    content::WebContents* web_contents) {
+  NavigationMap::iterator it =
+      inflight_navigations_.find(NavigationID(*web_contents));
+  if (it == inflight_navigations_.end())
+    return;
+
+  // Redirects change the URL of the main frame, so only learn the load if it
+  // ended on the URL that was predicted for.
+  if (it->second.main_frame_url == web_contents->GetURL()) {
+    ReportAccuracy(it->second);
+    LearnNavigation(it->second.main_frame_url, it->second.resources);
+  }
+  inflight_navigations_.erase(it);
+}
+
+void ResourcePrefetchPredictor::Predict(const GURL& main_frame_url,
+                                        std::vector<GURL>* resources) const {
+  resources->clear();
+
+  PrefetchDataMap::const_iterator it = url_table_cache_.find(main_frame_url);
+  if (it == url_table_cache_.end())
+    return;
+
+  ResourceRows candidates;
+  for (ResourceRows::const_iterator row = it->second.resources.begin();
+       row != it->second.resources.end(); ++row) {
+    if (row->number_of_hits >= kMinHits &&
+        row->GetConfidence() >= kMinConfidence) {
+      candidates.push_back(*row);
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(), ResourceOrderer());
+  if (candidates.size() > kMaxResourcesToPredict)
+    candidates.resize(kMaxResourcesToPredict);
+
+  for (ResourceRows::const_iterator row = candidates.begin();
+       row != candidates.end(); ++row) {
+    resources->push_back(row->resource_url);
+  }
+}
+
+void ResourcePrefetchPredictor::Preconnect(const std::vector<GURL>& resources) {
+  // One connection per host is enough to save the connection setup on the
+  // critical path; the renderer opens more as it needs them.
+  std::set<GURL> origins;
+  for (std::vector<GURL>::const_iterator it = resources.begin();
+       it != resources.end(); ++it) {
+    GURL origin = it->GetOrigin();
+    if (!origins.insert(origin).second)
+      continue;
+    chrome_browser_net::PreconnectOnUIThread(
+        origin,
+        chrome_browser_net::UrlInfo::LEARNED_REFERAL_MOTIVATED,
+        1,
+        profile_->GetRequestContext());
+  }
+}
+
+void ResourcePrefetchPredictor::ReportAccuracy(
+    const Navigation& navigation) const {
+  base::TimeDelta load_time = base::TimeTicks::Now() - navigation.start_time;
+  if (navigation.predicted_resources.empty()) {
+    UMA_HISTOGRAM_MEDIUM_TIMES(
+        "ResourcePrefetchPredictor.PageLoadTime.NotPredicted", load_time);
+    return;
+  }
+  UMA_HISTOGRAM_MEDIUM_TIMES(
+      "ResourcePrefetchPredictor.PageLoadTime.Predicted", load_time);
+
+  std::set<GURL> actual;
+  for (std::vector<URLRequestSummary>::const_iterator it =
+           navigation.resources.begin();
+       it != navigation.resources.end(); ++it) {
+    actual.insert(it->resource_url);
+  }
+  int correct = 0;
+  for (std::vector<GURL>::const_iterator it =
+           navigation.predicted_resources.begin();
+       it != navigation.predicted_resources.end(); ++it) {
+    if (actual.count(*it))
+      ++correct;
+  }
+  UMA_HISTOGRAM_PERCENTAGE(
+      "ResourcePrefetchPredictor.Precision",
+      correct * 100 / static_cast<int>(navigation.predicted_resources.size()));
+  if (!actual.empty()) {
+    UMA_HISTOGRAM_PERCENTAGE(
+        "ResourcePrefetchPredictor.Recall",
+        correct * 100 / static_cast<int>(actual.size()));
+  }
+}
+
+void ResourcePrefetchPredictor::LearnNavigation(
+    const GURL& main_frame_url,
+    const std::vector<URLRequestSummary>& resources) {
+  PrefetchDataMap::iterator cache_it = url_table_cache_.find(main_frame_url);
+  if (cache_it == url_table_cache_.end()) {
+    if (resources.empty())
+      return;
+
+    // Make room for the new page by evicting the least recently visited one.
+    if (url_table_cache_.size() >= kMaxPages) {
+      PrefetchDataMap::iterator oldest = url_table_cache_.begin();
+      for (PrefetchDataMap::iterator it = url_table_cache_.begin();
+           it != url_table_cache_.end(); ++it) {
+        if (it->second.last_visit < oldest->second.last_visit)
+          oldest = it;
+      }
+      db_->Write(
+          base::Bind(&ResourcePrefetchPredictorTables::DeleteData, tables_,
+                     std::vector<GURL>(1, oldest->first)),
+          base::Closure());
+      url_table_cache_.erase(oldest);
+    }
+    cache_it = url_table_cache_.insert(std::make_pair(
+        main_frame_url, PrefetchData(main_frame_url))).first;
+  }
+
+  PrefetchData& data = cache_it->second;
+  data.last_visit = base::Time::Now();
+
+  // Update the resources already known for the page.
+  std::map<GURL, int> positions;
+  for (size_t i = 0; i < resources.size(); ++i) {
+    positions.insert(std::make_pair(resources[i].resource_url,
+                                    static_cast<int>(i + 1)));
+  }
+
+  ResourceRows updated;
+  for (ResourceRows::iterator row = data.resources.begin();
+       row != data.resources.end(); ++row) {
+    std::map<GURL, int>::iterator position = positions.find(row->resource_url);
+    if (position == positions.end()) {
+      ++row->number_of_misses;
+      if (++row->consecutive_misses >= kMaxConsecutiveMisses)
+        continue;
+    } else {
+      row->average_position =
+          (row->average_position * row->number_of_hits + position->second) /
+          (row->number_of_hits + 1);
+      ++row->number_of_hits;
+      row->consecutive_misses = 0;
+      positions.erase(position);
+    }
+    updated.push_back(*row);
+  }
+
+  // Add the resources seen for the first time, in the order they were seen.
+  for (size_t i = 0; i < resources.size(); ++i) {
+    std::map<GURL, int>::iterator position =
+        positions.find(resources[i].resource_url);
+    if (position == positions.end())
+      continue;
+    updated.push_back(ResourceRow(resources[i].resource_url,
+                                  resources[i].resource_type, 1, 0, 0,
+                                  position->second));
+  }
+
+  if (updated.size() > kMaxResourcesPerPage) {
+    std::stable_sort(updated.begin(), updated.end(), ResourceOrderer());
+    updated.resize(kMaxResourcesPerPage);
+  }
+  data.resources.swap(updated);
+
+  if (data.resources.empty()) {
+    db_->Write(
+        base::Bind(&ResourcePrefetchPredictorTables::DeleteData, tables_,
+                   std::vector<GURL>(1, main_frame_url)),
+        base::Closure());
+    url_table_cache_.erase(cache_it);
+    return;
+  }
+
+  db_->Write(
+      base::Bind(&ResourcePrefetchPredictorTables::UpdateData, tables_, data),
+      base::Closure());
+}
+
+void ResourcePrefetchPredictor::RemoveAbandonedNavigations() {
+  base::TimeTicks cutoff = base::TimeTicks::Now() -
+      base::TimeDelta::FromSeconds(kMaxNavigationLifetimeSeconds);
+  for (NavigationMap::iterator it = inflight_navigations_.begin();
+       it != inflight_navigations_.end();) {
+    if (it->second.start_time < cutoff)
+      inflight_navigations_.erase(it++);
+    else
+      ++it;
+  }
+}
+
+void ResourcePrefetchPredictor::DeleteAllUrls() {
+  if (!initialized_)
+    return;
+
+  inflight_navigations_.clear();
+  url_table_cache_.clear();
+  db_->Write(
+      base::Bind(&ResourcePrefetchPredictorTables::DeleteAllData, tables_),
+      base::Closure());
+}
+
+void ResourcePrefetchPredictor::DeleteUrls(const history::URLRows& urls) {
+  if (!initialized_)
+    return;
+
+  std::vector<GURL> urls_to_delete;
+  for (history::URLRows::const_iterator it = urls.begin(); it != urls.end();
+       ++it) {
+    if (url_table_cache_.erase(it->url()))
+      urls_to_delete.push_back(it->url());
+  }
+  if (urls_to_delete.empty())
+    return;
+
+  db_->Write(
+      base::Bind(&ResourcePrefetchPredictorTables::DeleteData, tables_,
+                 urls_to_delete),
+      base::Closure());
+}
+
+}  // namespace predictors
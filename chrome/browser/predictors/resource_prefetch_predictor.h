@@ -0,0 +1,174 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_PREDICTORS_RESOURCE_PREFETCH_PREDICTOR_H_
+#define CHROME_BROWSER_PREDICTORS_RESOURCE_PREFETCH_PREDICTOR_H_
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/gtest_prod_util.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time.h"
+#include "chrome/browser/history/history_types.h"
+#include "chrome/browser/predictors/resource_prefetch_predictor_tables.h"
+#include "chrome/browser/profiles/profile_keyed_service.h"
+#include "content/public/browser/notification_observer.h"
+#include "content/public/browser/notification_registrar.h"
+#include "googleurl/src/gurl.h"
+#include "webkit/glue/resource_type.h"
+
+class Profile;
+
+namespace content {
+class WebContents;
+}
+
+namespace net {
+class URLRequest;
+}
+
+namespace sql {
+class AsyncConnection;
+}
+
+namespace predictors {
+
+// This class learns, for each main frame URL, the subresources the page loads,
+// with a confidence score for each. When a navigation to a known URL starts,
+// it preconnects to the hosts of the subresources it is confident the page
+// will request, before the renderer has even seen the main resource.
+//
+// It lives on the UI thread, and learns from URLRequestSummaries that
+// chrome_browser_net::ResourcePrefetchPredictorObserver forwards from the IO
+// thread. What it learned is kept in memory, and persisted asynchronously in
+// the ResourcePrefetchPredictorTables on the DB thread. It can be accessed as a
+// weak pointer so that replies from the DB thread and the IO thread are dropped
+// if it is destroyed first.
+class ResourcePrefetchPredictor
+    : public ProfileKeyedService,
+      public content::NotificationObserver,
+      public base::SupportsWeakPtr<ResourcePrefetchPredictor> {
+ public:
+  // Identifies the main frame load in a tab.
+  struct NavigationID {
+    NavigationID();
+    NavigationID(int render_process_id, int render_view_id);
+    explicit NavigationID(const content::WebContents& web_contents);
+
+    // Only the tab is compared, as a tab loads one main frame at a time.
+    bool operator<(const NavigationID& rhs) const;
+
+    int render_process_id;
+    int render_view_id;
+  };
+
+  // The parts of a URLRequest the predictor learns from. Filled in on the IO
+  // thread.
+  struct URLRequestSummary {
+    URLRequestSummary();
+    ~URLRequestSummary();
+
+    NavigationID navigation_id;
+    GURL resource_url;
+    ResourceType::Type resource_type;
+    bool was_cached;
+  };
+
+  explicit ResourcePrefetchPredictor(Profile* profile);
+  virtual ~ResourcePrefetchPredictor();
+
+  // Returns true if the predictor should be created for |profile|.
+  static bool IsEnabled(Profile* profile);
+
+  // Return true if the predictor is interested in |request|. IO thread.
+  static bool ShouldRecordRequest(net::URLRequest* request,
+                                  ResourceType::Type resource_type);
+  static bool ShouldRecordResponse(net::URLRequest* response);
+
+  // Called when a main frame request starts, which is when the predictor makes
+  // its prediction.
+  void RecordMainFrameRequest(const URLRequestSummary& request);
+
+  // Called when the response to a subresource request starts.
+  void RecordURLResponse(const URLRequestSummary& response);
+
+ private:
+  friend class ResourcePrefetchPredictorTest;
+  FRIEND_TEST_ALL_PREFIXES(ResourcePrefetchPredictorTest, LearnNewPage);
+  FRIEND_TEST_ALL_PREFIXES(ResourcePrefetchPredictorTest, LearnKnownPage);
+  FRIEND_TEST_ALL_PREFIXES(ResourcePrefetchPredictorTest, Predict);
+
+  typedef ResourcePrefetchPredictorTables::ResourceRow ResourceRow;
+  typedef ResourcePrefetchPredictorTables::ResourceRows ResourceRows;
+  typedef ResourcePrefetchPredictorTables::PrefetchData PrefetchData;
+  typedef ResourcePrefetchPredictorTables::PrefetchDataMap PrefetchDataMap;
+
+  // A main frame load in progress.
+  struct Navigation {
+    Navigation();
+    ~Navigation();
+
+    GURL main_frame_url;
+    base::TimeTicks start_time;
+    // The subresources loaded so far, in the order their responses started.
+    std::vector<URLRequestSummary> resources;
+    // The subresources predicted when the navigation started.
+    std::vector<GURL> predicted_resources;
+  };
+  typedef std::map<NavigationID, Navigation> NavigationMap;
+
+  // content::NotificationObserver:
+  virtual void Observe(int type,
+                       const content::NotificationSource& source,
+                       const content::NotificationDetails& details) OVERRIDE;
+
+  // Called with the data read from the database on startup.
+  void CreateCaches(PrefetchDataMap* data_map);
+
+  // Called when the main frame of |web_contents| finished loading.
+  void OnNavigationComplete(content::WebContents* web_contents);
+
+  // Returns the subresources of |main_frame_url| that are worth acting on,
+  // in the order the page is expected to request them.
+  void Predict(const GURL& main_frame_url, std::vector<GURL>* resources) const;
+
+  // Issues the preconnects for |resources|.
+  void Preconnect(const std::vector<GURL>& resources);
+
+  // Records the histograms comparing |navigation| to its prediction.
+  void ReportAccuracy(const Navigation& navigation) const;
+
+  // Updates the cache and the database with the subresources of a completed
+  // load of |main_frame_url|.
+  void LearnNavigation(const GURL& main_frame_url,
+                       const std::vector<URLRequestSummary>& resources);
+
+  // Forgets navigations that never completed, e.g. because the tab closed.
+  void RemoveAbandonedNavigations();
+
+  // Deletes learned data, when history is deleted.
+  void DeleteAllUrls();
+  void DeleteUrls(const history::URLRows& urls);
+
+  Profile* const profile_;
+  scoped_refptr<ResourcePrefetchPredictorTables> tables_;
+  // Runs the |tables_| methods.
+  scoped_refptr<sql::AsyncConnection> db_;
+  content::NotificationRegistrar notification_registrar_;
+
+  bool initialized_;
+
+  NavigationMap inflight_navigations_;
+  PrefetchDataMap url_table_cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourcePrefetchPredictor);
+};
+
+}  // namespace predictors
+
+#endif  // CHROME_BROWSER_PREDICTORS_RESOURCE_PREFETCH_PREDICTOR_H_
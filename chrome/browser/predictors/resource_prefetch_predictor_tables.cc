@@ -0,0 +1,280 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/predictors/resource_prefetch_predictor_tables.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/pickle.h"
+#include "base/stringprintf.h"
+#include "content/public/browser/browser_thread.h"
+#include "sql/statement.h"
+
+namespace {
+
+const char kResourcePrefetchPredictorTableName[] =
+    "resource_prefetch_predictor_url";
+
+// Bump whenever the encoding of the resources column changes. Rows in an older
+// encoding are dropped when read.
+const int kResourcesEncodingVersion = 1;
+
+// The maximum length allowed for URLs in the database.
+const size_t kMaxURLLength = 1024;
+
+// Upper bound on the number of resources decoded for a page, so that a corrupt
+// row cannot make us allocate unbounded memory.
+const int kMaxResourcesPerPage = 1000;
+
+}  // namespace
+
+namespace predictors {
+
+ResourcePrefetchPredictorTables::ResourceRow::ResourceRow()
+    : resource_type(ResourceType::LAST_TYPE),
+      number_of_hits(0),
+      number_of_misses(0),
+      consecutive_misses(0),
+      average_position(0.0) {
+}
+
+ResourcePrefetchPredictorTables::ResourceRow::ResourceRow(
+    const GURL& resource_url,
+    ResourceType::Type resource_type,
+    int number_of_hits,
+    int number_of_misses,
+    int consecutive_misses,
+    double average_position)
+    : resource_url(resource_url),
+      resource_type(resource_type),
+      number_of_hits(number_of_hits),
+      number_of_misses(number_of_misses),
+      consecutive_misses(consecutive_misses),
+      average_position(average_position) {
+}
+
+double ResourcePrefetchPredictorTables::ResourceRow::GetConfidence() const {
+  int total = number_of_hits + number_of_misses;
+  return total > 0 ? static_cast<double>(number_of_hits) / total : 0.0;
+}
+
+bool ResourcePrefetchPredictorTables::ResourceRow::operator==(
+    const ResourceRow& rhs) const {
+  return resource_url == rhs.resource_url &&
+      resource_type == rhs.resource_type &&
+      number_of_hits == rhs.number_of_hits &&
+      number_of_misses == rhs.number_of_misses &&
+      consecutive_misses == rhs.consecutive_misses &&
+      average_position == rhs.average_position;
+}
+
+ResourcePrefetchPredictorTables::PrefetchData::PrefetchData() {
+}
+
+ResourcePrefetchPredictorTables::PrefetchData::PrefetchData(
+    const GURL& main_frame_url)
+    : main_frame_url(main_frame_url) {
+}
+
+ResourcePrefetchPredictorTables::PrefetchData::~PrefetchData() {
+}
+
+void ResourcePrefetchPredictorTables::GetAllData(PrefetchDataMap* data_map) {
+  CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::DB));
+  if (CantAccessDatabase())
+    return;
+
+  data_map->clear();
+
+  sql::Statement statement(DB()->GetCachedStatement(SQL_FROM_HERE,
+      base::StringPrintf(
+          "SELECT main_page_url, last_visit_time, resources FROM %s",
+          kResourcePrefetchPredictorTableName).c_str()));
+
+  std::vector<GURL> corrupt_urls;
+  while (statement.Step()) {
+    GURL main_frame_url(statement.ColumnString(0));
+    PrefetchData data(main_frame_url);
+    data.last_visit = base::Time::FromInternalValue(statement.ColumnInt64(1));
+    std::string resources;
+    if (!statement.ColumnBlobAsString(2, &resources) ||
+        !DecodeResources(resources, &data.resources)) {
+      corrupt_urls.push_back(main_frame_url);
+      continue;
+    }
+    (*data_map)[main_frame_url] = data;
+  }
+
+  if (!corrupt_urls.empty())
+    DeleteData(corrupt_urls);
+}
+
+void ResourcePrefetchPredictorTables::UpdateData(const PrefetchData& data) {
+  CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::DB));
+  if (CantAccessDatabase())
+    return;
+
+  std::string main_page_url = data.main_frame_url.spec();
+  if (main_page_url.length() > kMaxURLLength)
+    return;
+
+  std::string resources;
+  EncodeResources(data.resources, &resources);
+
+  sql::Statement statement(DB()->GetCachedStatement(SQL_FROM_HERE,
+      base::StringPrintf(
+          "INSERT OR REPLACE INTO %s "
+          "(main_page_url, last_visit_time, resources) VALUES (?,?,?)",
+          kResourcePrefetchPredictorTableName).c_str()));
+  statement.BindString(0, main_page_url);
+  statement.BindInt64(1, data.last_visit.ToInternalValue());
+  statement.BindBlob(2, resources.data(), resources.size());
+  statement.Run();
+}
+
+void ResourcePrefetchPredictorTables::DeleteData(
+    const std::vector<GURL>& urls) {
+  CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::DB));
+  if (CantAccessDatabase())
+    return;
+
+  sql::Statement statement(DB()->GetUniqueStatement(base::StringPrintf(
+      "DELETE FROM %s WHERE main_page_url=?",
+      kResourcePrefetchPredictorTableName).c_str()));
+
+  if (!DB()->BeginTransaction())
+    return;
+  for (std::vector<GURL>::const_iterator it = urls.begin();
+       it != urls.end(); ++it) {
+    statement.BindString(0, it->spec());
+    if (!statement.Run()) {
+      DB()->RollbackTransaction();
+      return;
+    }
+    statement.Reset(true);
+  }
+  DB()->CommitTransaction();
+}
+
+void ResourcePrefetchPredictorTables::DeleteAllData() {
+  CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::DB));
+  if (CantAccessDatabase())
+    return;
+
+  sql::Statement statement(DB()->GetCachedStatement(SQL_FROM_HERE,
+      base::StringPrintf("DELETE FROM %s",
+                         kResourcePrefetchPredictorTableName).c_str()));
+
+  statement.Run();
+}
+
+// static
+void ResourcePrefetchPredictorTables::EncodeResources(
+    const ResourceRows& resources,
+    std::string* out) {
+  Pickle pickle;
+  pickle.WriteInt(kResourcesEncodingVersion);
+
+  std::vector<const ResourceRow*> valid_resources;
+  for (ResourceRows::const_iterator it = resources.begin();
+       it != resources.end(); ++it) {
+    if (it->resource_url.spec().length() <= kMaxURLLength)
+      valid_resources.push_back(&*it);
+  }
+
+  pickle.WriteInt(valid_resources.size());
+  for (size_t i = 0; i < valid_resources.size(); ++i) {
+    const ResourceRow& row = *valid_resources[i];
+    pickle.WriteString(row.resource_url.spec());
+    pickle.WriteInt(row.resource_type);
+    pickle.WriteInt(row.number_of_hits);
+    pickle.WriteInt(row.number_of_misses);
+    pickle.WriteInt(row.consecutive_misses);
+    pickle.WriteBytes(&row.average_position, sizeof(row.average_position));
+  }
+  out->assign(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+// static
+bool ResourcePrefetchPredictorTables::DecodeResources(
+    const std::string& data,
+    ResourceRows* resources) {
+  resources->clear();
+
+  Pickle pickle(data.data(), data.size());
+  PickleIterator iter(pickle);
+  int version;
+  int count;
+  if (!pickle.ReadInt(&iter, &version) ||
+      version != kResourcesEncodingVersion ||
+      !pickle.ReadLength(&iter, &count) ||
+      count > kMaxResourcesPerPage) {
+    return false;
+  }
+
+  resources->reserve(count);
+  for (int i = 0; i < count; ++i) {
+    std::string spec;
+    int resource_type;
+    ResourceRow row;
+    const char* position;
+    if (!pickle.ReadString(&iter, &spec) ||
+        !pickle.ReadInt(&iter, &resource_type) ||
+        !ResourceType::ValidType(resource_type) ||
+        !pickle.ReadInt(&iter, &row.number_of_hits) ||
+        !pickle.ReadInt(&iter, &row.number_of_misses) ||
+        !pickle.ReadInt(&iter, &row.consecutive_misses) ||
+        !pickle.ReadBytes(&iter, &position, sizeof(row.average_position))) {
+      resources->clear();
+      return false;
+    }
+    row.resource_url = GURL(spec);
+    row.resource_type = ResourceType::FromInt(resource_type);
+    memcpy(&row.average_position, position, sizeof(row.average_position));
+    resources->push_back(row);
+  }
+  return true;
+}
+
+ResourcePrefetchPredictorTables::ResourcePrefetchPredictorTables()
+    : PredictorTableBase() {
+}
+
+ResourcePrefetchPredictorTables::~ResourcePrefetchPredictorTables() {
+}
+
+void ResourcePrefetchPredictorTables::CreateTableIfNonExistent() {
+  CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::DB));
+  if (CantAccessDatabase())
+    return;
+
+  if (DB()->DoesTableExist(kResourcePrefetchPredictorTableName))
+    return;
+
+  bool success = DB()->Execute(base::StringPrintf(
+      "CREATE TABLE %s ( "
+      "main_page_url TEXT PRIMARY KEY, "
+      "last_visit_time INTEGER, "
+      "resources BLOB)", kResourcePrefetchPredictorTableName).c_str());
+  if (!success)
+    ResetDB();
+}
+
+void ResourcePrefetchPredictorTables::LogDatabaseStats() {
+  CHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::DB));
+  if (CantAccessDatabase())
+    return;
+
+  sql::Statement statement(DB()->GetUniqueStatement(
+      base::StringPrintf("SELECT count(*) FROM %s",
+                         kResourcePrefetchPredictorTableName).c_str()));
+  if (!statement.Step())
+    return;
+  UMA_HISTOGRAM_COUNTS("ResourcePrefetchPredictor.DatabaseRowCount",
+                       statement.ColumnInt(0));
+}
+
+}  // namespace predictors
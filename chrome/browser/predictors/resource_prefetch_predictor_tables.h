@@ -0,0 +1,103 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_PREDICTORS_RESOURCE_PREFETCH_PREDICTOR_TABLES_H_
+#define CHROME_BROWSER_PREDICTORS_RESOURCE_PREFETCH_PREDICTOR_TABLES_H_
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/time.h"
+#include "chrome/browser/predictors/predictor_table_base.h"
+#include "googleurl/src/gurl.h"
+#include "webkit/glue/resource_type.h"
+
+namespace predictors {
+
+// This manages the resource prefetch predictor table within the SQLite
+// database passed in to the constructor. It expects the following scheme:
+//
+// resource_prefetch_predictor_url
+//   main_page_url      The URL of the main frame, the primary key.
+//   last_visit_time    Internal value of the time of the last visit.
+//   resources          The subresources the page loaded, in the binary format
+//                      written by EncodeResources().
+//
+// Storing all the subresources of a page in a single row keeps the table small
+// and lets a page be read or written with a single statement.
+//
+// All the functions apart from constructor and destructor have to be called in
+// the DB thread.
+class ResourcePrefetchPredictorTables : public PredictorTableBase {
+ public:
+  // A subresource loaded by a main frame URL.
+  struct ResourceRow {
+    ResourceRow();
+    ResourceRow(const GURL& resource_url,
+                ResourceType::Type resource_type,
+                int number_of_hits,
+                int number_of_misses,
+                int consecutive_misses,
+                double average_position);
+
+    // The fraction of the loads of the page that also loaded this resource.
+    double GetConfidence() const;
+
+    bool operator==(const ResourceRow& rhs) const;
+
+    GURL resource_url;
+    ResourceType::Type resource_type;
+    int number_of_hits;
+    int number_of_misses;
+    int consecutive_misses;
+    // The average position at which the page requested this resource, with the
+    // first subresource requested at position 1.
+    double average_position;
+  };
+  typedef std::vector<ResourceRow> ResourceRows;
+
+  // All that is known about a main frame URL.
+  struct PrefetchData {
+    PrefetchData();
+    explicit PrefetchData(const GURL& main_frame_url);
+    ~PrefetchData();
+
+    GURL main_frame_url;
+    base::Time last_visit;
+    ResourceRows resources;
+  };
+  typedef std::map<GURL, PrefetchData> PrefetchDataMap;
+
+  // DB thread functions.
+  void GetAllData(PrefetchDataMap* data_map);
+  // Adds |data|, or replaces the row for its URL.
+  void UpdateData(const PrefetchData& data);
+  void DeleteData(const std::vector<GURL>& urls);
+  void DeleteAllData();
+
+  // Serializes |resources| into the format of the resources column. Exposed
+  // for testing.
+  static void EncodeResources(const ResourceRows& resources, std::string* out);
+
+  // Returns false if |data| is not a valid encoding.
+  static bool DecodeResources(const std::string& data, ResourceRows* resources);
+
+ private:
+  friend class PredictorDatabaseInternal;
+
+  ResourcePrefetchPredictorTables();
+  virtual ~ResourcePrefetchPredictorTables();
+
+  // PredictorTableBase methods (DB thread).
+  virtual void CreateTableIfNonExistent() OVERRIDE;
+  virtual void LogDatabaseStats() OVERRIDE;
+
+  DISALLOW_COPY_AND_ASSIGN(ResourcePrefetchPredictorTables);
+};
+
+}  // namespace predictors
+
+#endif  // CHROME_BROWSER_PREDICTORS_RESOURCE_PREFETCH_PREDICTOR_TABLES_H_
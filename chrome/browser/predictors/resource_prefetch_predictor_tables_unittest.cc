@@ -0,0 +1,142 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/message_loop.h"
+#include "base/time.h"
+#include "chrome/browser/predictors/predictor_database.h"
+#include "chrome/browser/predictors/resource_prefetch_predictor_tables.h"
+#include "chrome/test/base/testing_profile.h"
+#include "content/test/test_browser_thread.h"
+#include "sql/statement.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using content::BrowserThread;
+
+namespace predictors {
+
+class ResourcePrefetchPredictorTablesTest : public testing::Test {
+ public:
+  ResourcePrefetchPredictorTablesTest();
+  virtual ~ResourcePrefetchPredictorTablesTest();
+
+  virtual void SetUp();
+  virtual void TearDown();
+
+ protected:
+  typedef ResourcePrefetchPredictorTables::ResourceRow ResourceRow;
+  typedef ResourcePrefetchPredictorTables::ResourceRows ResourceRows;
+  typedef ResourcePrefetchPredictorTables::PrefetchData PrefetchData;
+  typedef ResourcePrefetchPredictorTables::PrefetchDataMap PrefetchDataMap;
+
+  ResourcePrefetchPredictorTables* tables() {
+    return db_->resource_prefetch_tables();
+  }
+
+  size_t CountRecords() const;
+
+  PrefetchData google_;
+  PrefetchData reddit_;
+
+ private:
+  TestingProfile profile_;
+  scoped_ptr<PredictorDatabase> db_;
+  MessageLoop loop_;
+  content::TestBrowserThread db_thread_;
+};
+
+ResourcePrefetchPredictorTablesTest::ResourcePrefetchPredictorTablesTest()
+    : loop_(MessageLoop::TYPE_DEFAULT),
+      db_thread_(BrowserThread::DB, &loop_) {
+}
+
+ResourcePrefetchPredictorTablesTest::~ResourcePrefetchPredictorTablesTest() {
+}
+
+void ResourcePrefetchPredictorTablesTest::SetUp() {
+  db_.reset(new PredictorDatabase(&profile_));
+  loop_.RunAllPending();
+
+  google_ = PrefetchData(GURL("http://www.google.com/"));
+  google_.last_visit = base::Time::FromInternalValue(10);
+  google_.resources.push_back(ResourceRow(
+      GURL("http://www.google.com/style.css"), ResourceType::STYLESHEET,
+      5, 2, 1, 1.0));
+  google_.resources.push_back(ResourceRow(
+      GURL("http://www.google.com/script.js"), ResourceType::SCRIPT,
+      4, 0, 0, 2.5));
+
+  reddit_ = PrefetchData(GURL("http://www.reddit.com/"));
+  reddit_.last_visit = base::Time::FromInternalValue(20);
+  reddit_.resources.push_back(ResourceRow(
+      GURL("http://static.reddit.com/logo.png"), ResourceType::IMAGE,
+      1, 0, 0, 1.0));
+}
+
+void ResourcePrefetchPredictorTablesTest::TearDown() {
+  db_.reset(NULL);
+}
+
+size_t ResourcePrefetchPredictorTablesTest::CountRecords() const {
+  sql::Statement s(db_->GetDatabase()->GetUniqueStatement(
+      "SELECT count(*) FROM resource_prefetch_predictor_url"));
+  EXPECT_TRUE(s.Step());
+  return static_cast<size_t>(s.ColumnInt(0));
+}
+
+TEST_F(ResourcePrefetchPredictorTablesTest, EncodeDecode) {
+  std::string encoded;
+  ResourcePrefetchPredictorTables::EncodeResources(google_.resources,
+                                                   &encoded);
+  ResourceRows decoded;
+  EXPECT_TRUE(ResourcePrefetchPredictorTables::DecodeResources(encoded,
+                                                               &decoded));
+  EXPECT_TRUE(google_.resources == decoded);
+
+  // Truncated or garbled data must be rejected.
+  EXPECT_FALSE(ResourcePrefetchPredictorTables::DecodeResources(
+      encoded.substr(0, encoded.size() - 1), &decoded));
+  EXPECT_TRUE(decoded.empty());
+  EXPECT_FALSE(ResourcePrefetchPredictorTables::DecodeResources(
+      std::string("garbage"), &decoded));
+}
+
+TEST_F(ResourcePrefetchPredictorTablesTest, UpdateAndGetData) {
+  tables()->UpdateData(google_);
+  tables()->UpdateData(reddit_);
+  EXPECT_EQ(2U, CountRecords());
+
+  // Updating a page replaces its row.
+  google_.resources.pop_back();
+  google_.last_visit = base::Time::FromInternalValue(30);
+  tables()->UpdateData(google_);
+  EXPECT_EQ(2U, CountRecords());
+
+  PrefetchDataMap data_map;
+  tables()->GetAllData(&data_map);
+  ASSERT_EQ(2U, data_map.size());
+  const PrefetchData& google = data_map[google_.main_frame_url];
+  EXPECT_EQ(google_.last_visit, google.last_visit);
+  EXPECT_TRUE(google_.resources == google.resources);
+  EXPECT_TRUE(reddit_.resources ==
+              data_map[reddit_.main_frame_url].resources);
+}
+
+TEST_F(ResourcePrefetchPredictorTablesTest, DeleteData) {
+  tables()->UpdateData(google_);
+  tables()->UpdateData(reddit_);
+
+  tables()->DeleteData(std::vector<GURL>(1, reddit_.main_frame_url));
+  PrefetchDataMap data_map;
+  tables()->GetAllData(&data_map);
+  ASSERT_EQ(1U, data_map.size());
+  EXPECT_EQ(1U, data_map.count(google_.main_frame_url));
+
+  tables()->DeleteAllData();
+  EXPECT_EQ(0U, CountRecords());
+}
+
+}  // namespace predictors
@@ -0,0 +1,142 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/predictors/resource_prefetch_predictor.h"
+
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "chrome/test/base/testing_profile.h"
+#include "content/test/test_browser_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using content::BrowserThread;
+
+namespace predictors {
+
+class ResourcePrefetchPredictorTest : public testing::Test {
+ public:
+  ResourcePrefetchPredictorTest()
+      : loop_(MessageLoop::TYPE_DEFAULT),
+        ui_thread_(BrowserThread::UI, &loop_),
+        db_thread_(BrowserThread::DB, &loop_) {
+  }
+
+  virtual void SetUp() {
+    predictor_.reset(new ResourcePrefetchPredictor(&profile_));
+    loop_.RunAllPending();
+    ASSERT_TRUE(predictor_->initialized_);
+  }
+
+  virtual void TearDown() {
+    predictor_.reset();
+    loop_.RunAllPending();
+  }
+
+ protected:
+  typedef ResourcePrefetchPredictor::ResourceRow ResourceRow;
+  typedef ResourcePrefetchPredictor::PrefetchData PrefetchData;
+  typedef ResourcePrefetchPredictor::PrefetchDataMap PrefetchDataMap;
+  typedef ResourcePrefetchPredictor::URLRequestSummary URLRequestSummary;
+
+  URLRequestSummary CreateSummary(const std::string& url,
+                                  ResourceType::Type resource_type) {
+    URLRequestSummary summary;
+    summary.resource_url = GURL(url);
+    summary.resource_type = resource_type;
+    return summary;
+  }
+
+  PrefetchDataMap* cache() { return &predictor_->url_table_cache_; }
+
+  MessageLoop loop_;
+  content::TestBrowserThread ui_thread_;
+  content::TestBrowserThread db_thread_;
+  TestingProfile profile_;
+  scoped_ptr<ResourcePrefetchPredictor> predictor_;
+};
+
+TEST_F(ResourcePrefetchPredictorTest, LearnNewPage) {
+  const GURL main_frame_url("http://www.google.com/");
+  std::vector<URLRequestSummary> resources;
+  resources.push_back(CreateSummary("http://www.google.com/style.css",
+                                    ResourceType::STYLESHEET));
+  resources.push_back(CreateSummary("http://www.google.com/script.js",
+                                    ResourceType::SCRIPT));
+  predictor_->LearnNavigation(main_frame_url, resources);
+
+  ASSERT_EQ(1U, cache()->count(main_frame_url));
+  const PrefetchData& data = (*cache())[main_frame_url];
+  ASSERT_EQ(2U, data.resources.size());
+  EXPECT_TRUE(ResourceRow(GURL("http://www.google.com/style.css"),
+                          ResourceType::STYLESHEET, 1, 0, 0, 1.0) ==
+              data.resources[0]);
+  EXPECT_TRUE(ResourceRow(GURL("http://www.google.com/script.js"),
+                          ResourceType::SCRIPT, 1, 0, 0, 2.0) ==
+              data.resources[1]);
+
+  // A page without subresources is not worth remembering.
+  predictor_->LearnNavigation(GURL("http://www.empty.com/"),
+                              std::vector<URLRequestSummary>());
+  EXPECT_EQ(1U, cache()->size());
+}
+
+TEST_F(ResourcePrefetchPredictorTest, LearnKnownPage) {
+  const GURL main_frame_url("http://www.google.com/");
+  PrefetchData data(main_frame_url);
+  data.resources.push_back(ResourceRow(GURL("http://www.google.com/a.css"),
+                                       ResourceType::STYLESHEET, 3, 0, 0, 1.0));
+  data.resources.push_back(ResourceRow(GURL("http://www.google.com/b.js"),
+                                       ResourceType::SCRIPT, 1, 1, 2, 2.0));
+  data.resources.push_back(ResourceRow(GURL("http://www.google.com/c.png"),
+                                       ResourceType::IMAGE, 2, 0, 0, 3.0));
+  (*cache())[main_frame_url] = data;
+
+  std::vector<URLRequestSummary> resources;
+  resources.push_back(CreateSummary("http://www.google.com/d.png",
+                                    ResourceType::IMAGE));
+  resources.push_back(CreateSummary("http://www.google.com/a.css",
+                                    ResourceType::STYLESHEET));
+  predictor_->LearnNavigation(main_frame_url, resources);
+
+  // b.js is dropped after its third consecutive miss, c.png records a miss, and
+  // d.png is added.
+  const PrefetchData& learned = (*cache())[main_frame_url];
+  ASSERT_EQ(3U, learned.resources.size());
+  EXPECT_TRUE(ResourceRow(GURL("http://www.google.com/a.css"),
+                          ResourceType::STYLESHEET, 4, 0, 0, 1.25) ==
+              learned.resources[0]);
+  EXPECT_TRUE(ResourceRow(GURL("http://www.google.com/c.png"),
+                          ResourceType::IMAGE, 2, 1, 1, 3.0) ==
+              learned.resources[1]);
+  EXPECT_TRUE(ResourceRow(GURL("http://www.google.com/d.png"),
+                          ResourceType::IMAGE, 1, 0, 0, 1.0) ==
+              learned.resources[2]);
+}
+
+TEST_F(ResourcePrefetchPredictorTest, Predict) {
+  const GURL main_frame_url("http://www.google.com/");
+  PrefetchData data(main_frame_url);
+  data.resources.push_back(ResourceRow(GURL("http://www.google.com/late.js"),
+                                       ResourceType::SCRIPT, 4, 0, 0, 5.0));
+  data.resources.push_back(ResourceRow(GURL("http://www.google.com/rare.png"),
+                                       ResourceType::IMAGE, 2, 2, 0, 1.0));
+  data.resources.push_back(ResourceRow(GURL("http://www.google.com/new.png"),
+                                       ResourceType::IMAGE, 1, 0, 0, 1.0));
+  data.resources.push_back(ResourceRow(GURL("http://cdn.google.com/early.css"),
+                                       ResourceType::STYLESHEET, 3, 1, 0, 1.5));
+  (*cache())[main_frame_url] = data;
+
+  std::vector<GURL> predicted;
+  predictor_->Predict(main_frame_url, &predicted);
+  ASSERT_EQ(2U, predicted.size());
+  EXPECT_EQ(GURL("http://cdn.google.com/early.css"), predicted[0]);
+  EXPECT_EQ(GURL("http://www.google.com/late.js"), predicted[1]);
+
+  predictor_->Predict(GURL("http://www.unknown.com/"), &predicted);
+  EXPECT_TRUE(predicted.empty());
+}
+
+}  // namespace predictors
@@ -16,8 +16,10 @@
 #include "chrome/browser/net/connect_interceptor.h"
 #include "chrome/browser/net/http_server_properties_manager.h"
 #include "chrome/browser/net/predictor.h"
+#include "chrome/browser/net/sdch_dictionary_persister.h"
 #include "chrome/browser/net/sqlite_persistent_cookie_store.h"
 #include "chrome/browser/net/sqlite_server_bound_cert_store.h"
+#include "chrome/browser/net/ssl_session_store_persister.h"
 #include "chrome/browser/prefs/pref_member.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/common/chrome_constants.h"
@@ -26,6 +28,7 @@
 #include "chrome/common/url_constants.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/resource_context.h"
+#include "net/base/sdch_manager.h"
 #include "net/base/server_bound_cert_service.h"
 #include "net/ftp/ftp_network_layer.h"
 #include "net/http/http_cache.h"
@@ -391,6 +394,24 @@ void ProfileImplIOData::LazyInitializeInternal(
     trusted_spdy_proxy = command_line.GetSwitchValueASCII(
         switches::kTrustedSpdyProxy);
   }
+  std::string ssl_session_cache_shard = GetSSLSessionCacheShard();
+  if (!record_mode && !playback_mode &&
+      command_line.HasSwitch(switches::kEnableSSLSessionDiskCache)) {
+    ssl_session_store_persister_.reset(
+        new SSLSessionStorePersister(ssl_session_cache_shard,
+                                     profile_params->path));
+  }
+
+  // The SdchManager is shared by all profiles, so the dictionaries are saved
+  // with the first profile that asks.
+  if (!record_mode && !playback_mode &&
+      command_line.HasSwitch(switches::kEnableSdchDictionaryDiskCache) &&
+      net::SdchManager::Global() &&
+      !net::SdchManager::Global()->dictionary_store()) {
+    sdch_dictionary_persister_.reset(
+        new SdchDictionaryPersister(profile_params->path, main_context));
+  }
+
   net::HttpCache::DefaultBackend* main_backend =
       new net::HttpCache::DefaultBackend(
           net::DISK_CACHE,
@@ -403,7 +424,7 @@ void ProfileImplIOData::LazyInitializeInternal(
       main_context->server_bound_cert_service(),
       main_context->transport_security_state(),
       main_context->proxy_service(),
-      GetSSLSessionCacheShard(),
+      ssl_session_cache_shard,
       main_context->ssl_config_service(),
       main_context->http_auth_handler_factory(),
       main_context->network_delegate(),
@@ -12,6 +12,9 @@
 #include "base/memory/ref_counted.h"
 #include "chrome/browser/profiles/profile_io_data.h"
 
+class SdchDictionaryPersister;
+class SSLSessionStorePersister;
+
 namespace chrome_browser_net {
 class Predictor;
 }  // namespace chrome_browser_net
@@ -147,6 +150,10 @@ class ProfileImplIOData : public ProfileIOData {
 
   mutable scoped_ptr<chrome_browser_net::Predictor> predictor_;
 
+  mutable scoped_ptr<SSLSessionStorePersister> ssl_session_store_persister_;
+
+  mutable scoped_ptr<SdchDictionaryPersister> sdch_dictionary_persister_;
+
   mutable scoped_ptr<ChromeURLRequestContext> media_request_context_;
 
   // Parameters needed for isolated apps.
@@ -33,9 +33,12 @@
 #include "chrome/browser/net/chrome_network_delegate.h"
 #include "chrome/browser/net/http_server_properties_manager.h"
 #include "chrome/browser/net/proxy_service_factory.h"
+#include "chrome/browser/net/resource_prefetch_predictor_observer.h"
 #include "chrome/browser/net/transport_security_persister.h"
 #include "chrome/browser/notifications/desktop_notification_service_factory.h"
 #include "chrome/browser/policy/url_blacklist_manager.h"
+#include "chrome/browser/predictors/resource_prefetch_predictor.h"
+#include "chrome/browser/predictors/resource_prefetch_predictor_factory.h"
 #include "chrome/browser/prefs/pref_service.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/browser/profiles/profile_manager.h"
@@ -207,6 +210,13 @@ void ProfileIOData::InitializeOnUIThread(Profile* profile) {
 
   params->protocol_handler_registry = profile->GetProtocolHandlerRegistry();
 
+  predictors::ResourcePrefetchPredictor* predictor =
+      predictors::ResourcePrefetchPredictorFactory::GetForProfile(profile);
+  if (predictor) {
+    params->resource_prefetch_predictor_observer.reset(
+        new chrome_browser_net::ResourcePrefetchPredictorObserver(predictor));
+  }
+
   ChromeProxyConfigService* proxy_config_service =
       ProxyServiceFactory::CreateProxyConfigService(true);
   params->proxy_config_service.reset(proxy_config_service);
@@ -549,6 +559,8 @@ void ProfileIOData::LazyInitialize() const {
   notification_service_ = profile_params_->notification_service;
 #endif
   extension_info_map_ = profile_params_->extension_info_map;
+  resource_prefetch_predictor_observer_.reset(
+      profile_params_->resource_prefetch_predictor_observer.release());
 
   resource_context_->host_resolver_ = io_thread_globals->host_resolver.get();
   resource_context_->request_context_ = main_request_context_.get();
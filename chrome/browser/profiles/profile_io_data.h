@@ -31,6 +31,7 @@ class TransportSecurityPersister;
 
 namespace chrome_browser_net {
 class HttpServerPropertiesManager;
+class ResourcePrefetchPredictorObserver;
 }
 
 namespace net {
@@ -168,6 +169,9 @@ class ProfileIOData {
     // because on linux it relies on initializing things through gconf,
     // and needs to be on the main thread.
     scoped_ptr<net::ProxyConfigService> proxy_config_service;
+    // Created on the UI thread as it needs the profile's predictor, if any.
+    scoped_ptr<chrome_browser_net::ResourcePrefetchPredictorObserver>
+        resource_prefetch_predictor_observer;
     // The profile this struct was populated from. It's passed as a void* to
     // ensure it's not accidently used on the IO thread. Before using it on the
     // UI thread, call ProfileManager::IsValidProfile to ensure it's alive.
@@ -228,6 +232,12 @@ class ProfileIOData {
     return main_request_context_.get();
   }
 
+  // NULL unless the resource prefetch predictor is enabled for the profile.
+  chrome_browser_net::ResourcePrefetchPredictorObserver*
+      resource_prefetch_predictor_observer() const {
+    return resource_prefetch_predictor_observer_.get();
+  }
+
   // Destroys the ResourceContext first, to cancel any URLRequests that are
   // using it still, before we destroy the member variables that those
   // URLRequests may be accessing.
@@ -336,6 +346,9 @@ class ProfileIOData {
   mutable DesktopNotificationService* notification_service_;
 #endif
 
+  mutable scoped_ptr<chrome_browser_net::ResourcePrefetchPredictorObserver>
+      resource_prefetch_predictor_observer_;
+
   mutable scoped_ptr<TransportSecurityPersister>
       transport_security_persister_;
 
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 
+#include "base/command_line.h"
 #include "chrome/browser/diagnostics/sqlite_diagnostics.h"
 #include "chrome/browser/webdata/autofill_table.h"
 #include "chrome/browser/webdata/keyword_table.h"
@@ -13,6 +14,7 @@
 #include "chrome/browser/webdata/token_service_table.h"
 #include "chrome/browser/webdata/web_apps_table.h"
 #include "chrome/browser/webdata/web_intents_table.h"
+#include "chrome/common/chrome_switches.h"
 #include "content/public/browser/notification_service.h"
 #include "sql/statement.h"
 #include "sql/transaction.h"
@@ -108,6 +110,16 @@ sql::InitStatus WebDatabase::Init(const FilePath& db_name) {
   // infrequent. So we go with a small cache size.
   db_.set_cache_size(32);
 
+  // Commit to a write-ahead log, which needs fewer syncs per commit.  Keep
+  // syncing every commit though, since saved passwords and form data can't be
+  // recovered.
+  db_.set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kEnableSqlStatementProfiling)) {
+    db_.EnableStatementProfiling("Web");
+  }
+
   // Run the database in exclusive mode. Nobody else should be accessing the
   // database while we're running, and this will give somewhat improved perf.
   db_.set_exclusive_locking();
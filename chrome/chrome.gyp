@@ -369,6 +369,21 @@
         'tools/ipclist/ipclist.cc',
       ],
     },
+    {
+      'target_name': 'net_log_binary_to_json',
+      'type': 'executable',
+      'dependencies': [
+        '../base/base.gyp:base',
+      ],
+      'include_dirs': [
+        '..',
+      ],
+      'sources': [
+        'browser/net/net_log_binary_format.cc',
+        'browser/net/net_log_binary_format.h',
+        'tools/net_log_binary_to_json/net_log_binary_to_json.cc',
+      ],
+    },
   ],
   'conditions': [
     ['OS=="mac"',
@@ -443,6 +443,11 @@ const char kDumpHistogramsOnExit[]          = "dump-histograms-on-exit";
 // Enables the Action Box toolbar UI.
 const char kEnableActionBox[]               = "enable-action-box";
 
+// Lets socket groups whose requests are queued on the per-host connection
+// limit open extra connections while the pool is below its total limit.
+const char kEnableAdaptiveSocketGroupLimits[] =
+    "enable-adaptive-socket-group-limits";
+
 // Enables the experimental asynchronous DNS client.
 const char kEnableAsyncDns[]                = "enable-async-dns";
 
@@ -473,6 +478,10 @@ const char kEnableBenchmarking[]            = "enable-benchmarking";
 // Enables the bundled PPAPI version of Flash.
 const char kEnableBundledPpapiFlash[]       = "enable-bundled-ppapi-flash";
 
+// Persists successful certificate verification results in the user data
+// directory, so that they can be reused after a restart.
+const char kEnableCertVerifierDiskCache[]   = "enable-cert-verifier-disk-cache";
+
 // Enables the new ClientOAuth signin flow for connecting a profile a Google
 // account.  When disabled, Chrome will use the ClientLogin flow instead.
 const char kEnableClientOAuthSignin[]       = "enable-client-oauth-signin";
@@ -489,6 +498,9 @@ const char kEnableCloudPrintProxy[]         = "enable-cloud-print-proxy";
 // exceeded.
 const char kEnableConnectBackupJobs[]       = "enable-connect-backup-jobs";
 
+// Enables keeping idle connections open to the servers used most recently.
+const char kEnableConnectionWarming[]       = "enable-connection-warming";
+
 // Enables web developers to create apps for Chrome without using crx packages.
 const char kEnableCrxlessWebApps[]          = "enable-crxless-web-apps";
 
@@ -597,9 +609,28 @@ const char kEnableProfiling[]               = "enable-profiling";
 // supported server-side for searches on google.com.
 const char kEnableSdch[]                    = "enable-sdch";
 
+// Saves SDCH dictionaries in the profile directory, so that they are available
+// right after a restart.
+const char kEnableSdchDictionaryDiskCache[] =
+    "enable-sdch-dictionary-disk-cache";
+
 // Enable SPDY/3. This is a temporary testing flag.
 const char kEnableSpdy3[]                   = "enable-spdy3";
 
+// Enables learning the subresources of visited pages, and preconnecting to
+// their hosts on subsequent navigations.
+const char kEnableSpeculativeResourcePrefetching[] =
+    "enable-speculative-resource-prefetching";
+
+// Records the execution counts and times of the statements run on the history
+// and web databases, and logs slow statements and full table scans.
+const char kEnableSqlStatementProfiling[] =
+    "enable-sql-statement-profiling";
+
+// Persists TLS sessions in the profile directory, so that connections made
+// after a restart can use abbreviated handshakes.
+const char kEnableSSLSessionDiskCache[]     = "enable-ssl-session-disk-cache";
+
 // Enables the stacked tabstrip.
 const char kEnableStackedTabStrip[]         = "enable-stacked-tab-strip";
 
@@ -811,6 +842,11 @@ const char kLoadOpencryptoki[]              = "load-opencryptoki";
 // to a separate file if a file name is given.
 const char kLogNetLog[]                     = "log-net-log";
 
+// Writes net log events to the given file in a compact binary format, from a
+// dedicated thread.  Cheap enough to leave on for long sessions.  Convert the
+// result for about:net-internals with net_log_binary_to_json.
+const char kLogNetLogBinary[]               = "log-net-log-binary";
+
 // Uninstalls an extension with the specified extension id.
 const char kUninstallExtension[]            = "uninstall-extension";
 
@@ -851,10 +887,16 @@ const char kNaClGdb[]                       = "nacl-gdb";
 // command line. Useful values might be "valgrind" or "xterm -e gdb --args".
 const char kNaClLoaderCmdPrefix[]           = "nacl-loader-cmd-prefix";
 
-// Sets the base logging level for the net log. Log 0 logs the most data.
+// Sets the base logging level for the net log. Log 0 logs the most data, and
+// 3 turns network logging off entirely, along with devtools' load timing.
 // Intended primarily for use with --log-net-log.
 const char kNetLogLevel[]                   = "net-log-level";
 
+// Caps the size, in megabytes, of each file written by --log-net-log-binary.
+// When the cap is reached the file is rotated, and only the most recent few
+// files are kept.  Unlimited by default.
+const char kNetLogMaxFileSize[]             = "net-log-max-file-size";
+
 // Disables the default browser check. Useful for UI/browser tests where we
 // want to avoid having the default browser info-bar displayed.
 const char kNoDefaultBrowserCheck[]         = "no-default-browser-check";
@@ -131,6 +131,7 @@ extern const char kDnsPrefetchDisable[];
 extern const char kDownloadsNewUI[];
 extern const char kDumpHistogramsOnExit[];
 extern const char kEnableActionBox[];
+extern const char kEnableAdaptiveSocketGroupLimits[];
 extern const char kEnableAsyncDns[];
 extern const char kEnableAsynchronousSpellChecking[];
 extern const char kEnableAuthNegotiatePort[];
@@ -138,10 +139,12 @@ extern const char kEnableAutofillFeedback[];
 extern const char kEnableAutologin[];
 extern const char kEnableBenchmarking[];
 extern const char kEnableBundledPpapiFlash[];
+extern const char kEnableCertVerifierDiskCache[];
 extern const char kEnableClientOAuthSignin[];
 extern const char kEnableChromeToMobile[];
 extern const char kEnableCloudPrintProxy[];
 extern const char kEnableConnectBackupJobs[];
+extern const char kEnableConnectionWarming[];
 extern const char kEnableCrxlessWebApps[];
 extern const char kEnableDevToolsExperiments[];
 extern const char kEnableExperimentalExtensionApis[];
@@ -169,8 +172,12 @@ extern const char kEnablePnacl[];
 extern const char kEnableProfiling[];
 extern const char kEnableResourceContentSettings[];
 extern const char kEnableSdch[];
+extern const char kEnableSdchDictionaryDiskCache[];
 extern const char kEnableSpdy3[];
 extern const char kEnableSpdyFlowControl[];
+extern const char kEnableSpeculativeResourcePrefetching[];
+extern const char kEnableSqlStatementProfiling[];
+extern const char kEnableSSLSessionDiskCache[];
 extern const char kEnableStackedTabStrip[];
 extern const char kEnableSuggestionsTabPage[];
 extern const char kEnableSyncSignin[];
@@ -224,6 +231,7 @@ extern const char kLoadExtension[];
 extern const char kLoadOpencryptoki[];
 extern const char kUninstallExtension[];
 extern const char kLogNetLog[];
+extern const char kLogNetLogBinary[];
 extern const char kMakeDefaultBrowser[];
 extern const char kManaged[];
 extern const char kMediaCacheSize[];
@@ -234,6 +242,7 @@ extern const char kMultiProfiles[];
 extern const char kNaClGdb[];
 extern const char kNaClLoaderCmdPrefix[];
 extern const char kNetLogLevel[];
+extern const char kNetLogMaxFileSize[];
 extern const char kNoDefaultBrowserCheck[];
 extern const char kNoDisplayingInsecureContent[];
 extern const char kNoEvents[];
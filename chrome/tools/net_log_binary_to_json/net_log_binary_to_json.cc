@@ -0,0 +1,99 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This tool converts logs written with --log-net-log-binary into the JSON
+// format that about:net-internals can import.
+//
+// When given several files, such as the rotated files from a single session,
+// list them oldest first.  Their events are concatenated, and the constants of
+// the first file are used.
+//
+// See PrintHelp() below for usage.
+
+#include <stdio.h>
+
+#include <string>
+
+#include "base/at_exit.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/format_macros.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/values.h"
+#include "chrome/browser/net/net_log_binary_format.h"
+
+namespace {
+
+int PrintHelp() {
+  printf("Usage: net_log_binary_to_json <output.json> <input> "
+         "[<input>...]\n\n");
+  printf("Example:\n");
+  printf("  net_log_binary_to_json net.json net.bin.2 net.bin.1 net.bin\n"
+         "will write the events of all three logs, oldest first, to "
+         "net.json\n\n");
+  return 1;
+}
+
+}  // namespace
+
+#if defined(OS_WIN)
+int wmain(int argc, wchar_t* argv[]) {
+#else
+int main(int argc, char* argv[]) {
+#endif
+  if (argc < 3)
+    return PrintHelp();
+
+  base::AtExitManager exit_manager;
+
+  FilePath out_path = FilePath(argv[1]);
+  FILE* out_file = file_util::OpenFile(out_path, "wb");
+  if (!out_file) {
+    printf("ERROR opening %" PRFilePath "\n", out_path.value().c_str());
+    return 1;
+  }
+
+  int events = 0;
+  uint64 dropped_events = 0;
+  for (int i = 2; i < argc; ++i) {
+    FilePath in_path = FilePath(argv[i]);
+    printf("Reading %" PRFilePath " ...\n", in_path.value().c_str());
+    std::string data;
+    if (!file_util::ReadFileToString(in_path, &data)) {
+      printf("ERROR reading file\n");
+      return 1;
+    }
+
+    net_log_binary::Reader reader(data);
+    std::string constants_json;
+    if (!reader.ReadHeader(&constants_json)) {
+      printf("ERROR: not a binary net log\n");
+      return 1;
+    }
+    if (i == 2) {
+      fprintf(out_file, "{\"constants\": %s,\n", constants_json.c_str());
+      fprintf(out_file, "\"events\": [\n");
+    }
+
+    scoped_ptr<base::DictionaryValue> event;
+    while (reader.ReadEvent(&event)) {
+      std::string json;
+      base::JSONWriter::Write(event.get(), &json);
+      fprintf(out_file, "%s%s", events ? ",\n" : "", json.c_str());
+      ++events;
+    }
+    dropped_events += reader.dropped_events();
+  }
+  fprintf(out_file, "\n]}\n");
+  file_util::CloseFile(out_file);
+
+  printf("Wrote %d events.\n", events);
+  if (dropped_events) {
+    printf("WARNING: %" PRIu64 " events were dropped while capturing.\n",
+           dropped_events);
+  }
+  return 0;
+}
@@ -38,8 +38,7 @@ void CapturingNetLog::Clear() {
 }
 
 void CapturingNetLog::SetLogLevel(NetLog::LogLevel log_level) {
-  base::AutoLock lock(lock_);
-  log_level_ = log_level;
+  base::subtle::NoBarrier_Store(&log_level_, log_level);
 }
 
 void CapturingNetLog::AddEntry(
@@ -59,8 +58,7 @@ uint32 CapturingNetLog::NextID() {
 }
 
 NetLog::LogLevel CapturingNetLog::GetLogLevel() const {
-  base::AutoLock lock(lock_);
-  return log_level_;
+  return static_cast<LogLevel>(base::subtle::NoBarrier_Load(&log_level_));
 }
 
 void CapturingNetLog::AddThreadSafeObserver(
@@ -79,7 +79,8 @@ class NET_EXPORT CapturingNetLog : public NetLog {
   size_t max_num_entries_;
   EntryList entries_;
 
-  NetLog::LogLevel log_level_;
+  // A NetLog::LogLevel. Atomic so GetLogLevel() does not need |lock_|.
+  base::subtle::Atomic32 log_level_;
 
   DISALLOW_COPY_AND_ASSIGN(CapturingNetLog);
 };
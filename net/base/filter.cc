@@ -5,7 +5,9 @@
 #include "net/base/filter.h"
 
 #include "base/file_path.h"
+#include "base/lazy_instance.h"
 #include "base/string_util.h"
+#include "base/synchronization/lock.h"
 #include "net/base/gzip_filter.h"
 #include "net/base/io_buffer.h"
 #include "net/base/mime_util.h"
@@ -37,14 +39,91 @@ const char kTextHtml[]             = "text/html";
 // Buffer size allocated when de-compressing data.
 const int kFilterBufSize = 32 * 1024;
 
+// The most buffers kept for reuse by later filters.  Every stage of a chain
+// holds one, so this covers a few SDCH chains, or several gzip responses.
+const size_t kMaxPooledBuffers = 8;
+
 }  // namespace
 
 namespace net {
 
+namespace {
+
+// Keeps the stream buffers of destroyed filters so that the next responses
+// decode into already allocated memory, rather than each stage of each
+// response allocating kFilterBufSize bytes.
+class FilterBufferPool {
+ public:
+  FilterBufferPool() {}
+
+  // Returns a buffer of kFilterBufSize bytes.
+  scoped_refptr<IOBuffer> Take() {
+    {
+      base::AutoLock lock(lock_);
+      if (!buffers_.empty()) {
+        scoped_refptr<IOBuffer> buffer;
+        buffer.swap(buffers_.back());
+        buffers_.pop_back();
+        return buffer;
+      }
+    }
+    return new IOBuffer(kFilterBufSize);
+  }
+
+  // Keeps |buffer|, which must be kFilterBufSize bytes, unless the pool is
+  // full.
+  void Return(const scoped_refptr<IOBuffer>& buffer) {
+    base::AutoLock lock(lock_);
+    if (buffers_.size() < kMaxPooledBuffers)
+      buffers_.push_back(buffer);
+  }
+
+ private:
+  base::Lock lock_;
+  std::vector<scoped_refptr<IOBuffer> > buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilterBufferPool);
+};
+
+base::LazyInstance<FilterBufferPool>::Leaky g_buffer_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+struct RegisteredFilterType {
+  std::string encoding;
+  Filter::FilterCreator creator;
+};
+
+// The filters added by Filter::RegisterFilterType().  Entry i is
+// FILTER_TYPE_REGISTERED_FIRST + i.
+class FilterRegistry {
+ public:
+  FilterRegistry() {}
+
+  base::Lock& lock() { return lock_; }
+  std::vector<RegisteredFilterType>& types() { return types_; }
+
+ private:
+  base::Lock lock_;
+  std::vector<RegisteredFilterType> types_;
+
+  DISALLOW_COPY_AND_ASSIGN(FilterRegistry);
+};
+
+base::LazyInstance<FilterRegistry>::Leaky g_filter_registry =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
 FilterContext::~FilterContext() {
 }
 
-Filter::~Filter() {}
+Filter::~Filter() {
+  // A buffer that is still referenced, for instance by a read that was in
+  // progress when the request was cancelled, may yet be written to, so only
+  // unshared buffers are reused.
+  if (stream_buffer_size_ == kFilterBufSize && stream_buffer_->HasOneRef())
+    g_buffer_pool.Get().Return(stream_buffer_);
+}
 
 // static
 Filter* Filter::Factory(const std::vector<FilterType>& filter_types,
@@ -149,6 +228,14 @@ Filter::FilterType Filter::ConvertEncodingToType(
   } else if (LowerCaseEqualsASCII(filter_type, kSdch)) {
     type_id = FILTER_TYPE_SDCH;
   } else {
+    FilterRegistry& registry = g_filter_registry.Get();
+    base::AutoLock lock(registry.lock());
+    const std::vector<RegisteredFilterType>& types = registry.types();
+    for (size_t i = 0; i < types.size(); ++i) {
+      if (LowerCaseEqualsASCII(filter_type, types[i].encoding.c_str()))
+        return static_cast<FilterType>(FILTER_TYPE_REGISTERED_FIRST + i);
+    }
+
     // Note we also consider "identity" and "uncompressed" UNSUPPORTED as
     // filter should be disabled in such cases.
     type_id = FILTER_TYPE_UNSUPPORTED;
@@ -156,6 +243,55 @@ Filter::FilterType Filter::ConvertEncodingToType(
   return type_id;
 }
 
+// static
+Filter::FilterType Filter::RegisterFilterType(const std::string& encoding,
+                                              FilterCreator creator) {
+  DCHECK(creator);
+  std::string lower_encoding = StringToLowerASCII(encoding);
+  if (lower_encoding.empty() ||
+      lower_encoding == kDeflate || lower_encoding == kGZip ||
+      lower_encoding == kXGZip || lower_encoding == kSdch ||
+      lower_encoding == kIdentity || lower_encoding == kUncompressed) {
+    return FILTER_TYPE_UNSUPPORTED;
+  }
+
+  FilterRegistry& registry = g_filter_registry.Get();
+  base::AutoLock lock(registry.lock());
+  std::vector<RegisteredFilterType>& types = registry.types();
+  for (size_t i = 0; i < types.size(); ++i) {
+    if (types[i].encoding == lower_encoding) {
+      types[i].creator = creator;
+      return static_cast<FilterType>(FILTER_TYPE_REGISTERED_FIRST + i);
+    }
+  }
+  if (FILTER_TYPE_REGISTERED_FIRST + static_cast<int>(types.size()) >
+      FILTER_TYPE_REGISTERED_LAST) {
+    return FILTER_TYPE_UNSUPPORTED;
+  }
+  RegisteredFilterType type;
+  type.encoding = lower_encoding;
+  type.creator = creator;
+  types.push_back(type);
+  return static_cast<FilterType>(FILTER_TYPE_REGISTERED_FIRST +
+                                 types.size() - 1);
+}
+
+// static
+void Filter::GetRegisteredEncodings(std::vector<std::string>* encodings) {
+  FilterRegistry& registry = g_filter_registry.Get();
+  base::AutoLock lock(registry.lock());
+  const std::vector<RegisteredFilterType>& types = registry.types();
+  for (size_t i = 0; i < types.size(); ++i)
+    encodings->push_back(types[i].encoding);
+}
+
+// static
+void Filter::ResetRegisteredFilterTypesForTesting() {
+  FilterRegistry& registry = g_filter_registry.Get();
+  base::AutoLock lock(registry.lock());
+  registry.types().clear();
+}
+
 // static
 void Filter::FixupEncodingTypes(
     const FilterContext& filter_context,
@@ -362,6 +498,26 @@ Filter* Filter::InitSdchFilter(FilterType type_id,
   return sdch_filter->InitDecoding(type_id) ? sdch_filter.release() : NULL;
 }
 
+// static
+Filter* Filter::InitRegisteredFilter(FilterType type_id,
+                                     const FilterContext& filter_context,
+                                     int buffer_size) {
+  FilterCreator creator = NULL;
+  {
+    FilterRegistry& registry = g_filter_registry.Get();
+    base::AutoLock lock(registry.lock());
+    size_t index = type_id - FILTER_TYPE_REGISTERED_FIRST;
+    if (index < registry.types().size())
+      creator = registry.types()[index].creator;
+  }
+  if (!creator)
+    return NULL;
+  Filter* filter = creator(filter_context);
+  if (filter)
+    filter->InitBuffer(buffer_size);
+  return filter;
+}
+
 // static
 Filter* Filter::PrependNewFilter(FilterType type_id,
                                  const FilterContext& filter_context,
@@ -379,6 +535,11 @@ Filter* Filter::PrependNewFilter(FilterType type_id,
       first_filter.reset(InitSdchFilter(type_id, filter_context, buffer_size));
       break;
     default:
+      if (type_id >= FILTER_TYPE_REGISTERED_FIRST &&
+          type_id <= FILTER_TYPE_REGISTERED_LAST) {
+        first_filter.reset(
+            InitRegisteredFilter(type_id, filter_context, buffer_size));
+      }
       break;
   }
 
@@ -392,7 +553,10 @@ Filter* Filter::PrependNewFilter(FilterType type_id,
 void Filter::InitBuffer(int buffer_size) {
   DCHECK(!stream_buffer());
   DCHECK_GT(buffer_size, 0);
-  stream_buffer_ = new IOBuffer(buffer_size);
+  if (buffer_size == kFilterBufSize)
+    stream_buffer_ = g_buffer_pool.Get().Take();
+  else
+    stream_buffer_ = new IOBuffer(buffer_size);
   stream_buffer_size_ = buffer_size;
 }
 
@@ -127,8 +127,16 @@ class NET_EXPORT_PRIVATE Filter {
     FILTER_TYPE_SDCH,
     FILTER_TYPE_SDCH_POSSIBLE,  // Sdch possible, but pass through allowed.
     FILTER_TYPE_UNSUPPORTED,
+    // Types handed out by RegisterFilterType().
+    FILTER_TYPE_REGISTERED_FIRST,
+    FILTER_TYPE_REGISTERED_LAST = FILTER_TYPE_REGISTERED_FIRST + 7,
   };
 
+  // Creates an uninitialized filter for a registered content encoding, or
+  // returns NULL if it can't be created.  The filter's stream_buffer_ is set
+  // up by the caller.
+  typedef Filter* (*FilterCreator)(const FilterContext& filter_context);
+
   virtual ~Filter();
 
   // Creates a Filter object.
@@ -187,6 +195,22 @@ class NET_EXPORT_PRIVATE Filter {
   // FilterType.
   static FilterType ConvertEncodingToType(const std::string& filter_type);
 
+  // Adds a decoder for the content encoding |encoding|, such as "bzip2", which
+  // |creator| will be asked to construct.  Returns the FilterType that
+  // ConvertEncodingToType() now maps |encoding| to, or FILTER_TYPE_UNSUPPORTED
+  // if |encoding| is handled by a built in filter or no more types are
+  // available.  Registering an encoding again replaces its creator.
+  // Registration should happen at startup, before any requests are made.
+  static FilterType RegisterFilterType(const std::string& encoding,
+                                       FilterCreator creator);
+
+  // Appends the registered encodings, in registration order, to |encodings|,
+  // so that they can be advertised in Accept-Encoding.
+  static void GetRegisteredEncodings(std::vector<std::string>* encodings);
+
+  // Forgets all registered encodings.
+  static void ResetRegisteredFilterTypesForTesting();
+
   // Given a array of encoding_types, try to do some error recovery adjustment
   // to the list.  This includes handling known bugs in the Apache server (where
   // redundant gzip encoding is specified), as well as issues regarding SDCH
@@ -235,6 +259,8 @@ class NET_EXPORT_PRIVATE Filter {
 
  private:
   // Allocates and initializes stream_buffer_ and stream_buffer_size_.
+  // Buffers of the default size are taken from the pool kept by the buffers
+  // of destroyed filters, if it has any.
   void InitBuffer(int size);
 
   // A factory helper for creating filters for within a chain of potentially
@@ -253,6 +279,9 @@ class NET_EXPORT_PRIVATE Filter {
   static Filter* InitSdchFilter(FilterType type_id,
                                 const FilterContext& filter_context,
                                 int buffer_size);
+  static Filter* InitRegisteredFilter(FilterType type_id,
+                                      const FilterContext& filter_context,
+                                      int buffer_size);
 
   // Helper function to empty our output into the next filter's input.
   void PushDataIntoNextFilter();
@@ -0,0 +1,146 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+#include "base/basictypes.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/path_service.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/base/filter.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mock_filter_context.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Total amount of decoded output for each test.
+const int64 kTotalOutputBytes = 256 * 1024 * 1024;
+
+// The size of the buffer the decoded data is read into, as URLRequestJob's
+// consumers commonly use.
+const int kOutputBufferSize = 32 * 1024;
+
+// Returns the contents of net/data/filter_unittests/google.txt, a saved page.
+std::string ReadCorpus() {
+  FilePath file_path;
+  PathService::Get(base::DIR_SOURCE_ROOT, &file_path);
+  file_path = file_path.AppendASCII("net");
+  file_path = file_path.AppendASCII("data");
+  file_path = file_path.AppendASCII("filter_unittests");
+  file_path = file_path.AppendASCII("google.txt");
+  std::string corpus;
+  EXPECT_TRUE(file_util::ReadFileToString(file_path, &corpus));
+  return corpus;
+}
+
+// Returns |source| compressed with gzip framing.
+std::string GZipEncode(const std::string& source) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // A windowBits of 16 + 15 asks zlib to write a gzip header and trailer.
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY));
+  std::vector<char> output(deflateBound(&stream, source.size()) + 32);
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(source.data()));
+  stream.avail_in = source.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream.avail_out = output.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  std::string encoded(&output[0], stream.total_out);
+  deflateEnd(&stream);
+  return encoded;
+}
+
+// Decodes |encoded| with a new filter chain of |encoding_types| per response,
+// feeding the chain as URLRequestJob does, until |kTotalOutputBytes| have been
+// decoded, and logs the throughput in decoded bytes.
+void RunDecodeTest(const char* name,
+                   const std::vector<Filter::FilterType>& encoding_types,
+                   const std::string& encoded,
+                   size_t decoded_size) {
+  MockFilterContext filter_context;
+  scoped_array<char> output(new char[kOutputBufferSize]);
+  const int64 responses =
+      std::max<int64>(1, kTotalOutputBytes / decoded_size);
+
+  PerfTimer timer;
+  int64 decoded_bytes = 0;
+  for (int64 i = 0; i < responses; ++i) {
+    scoped_ptr<Filter> filter(Filter::Factory(encoding_types, filter_context));
+    ASSERT_TRUE(filter.get());
+    size_t offset = 0;
+    Filter::FilterStatus status = Filter::FILTER_NEED_MORE_DATA;
+    while (status != Filter::FILTER_DONE) {
+      if (!filter->stream_data_len() && offset < encoded.size()) {
+        int length = std::min<int>(filter->stream_buffer_size(),
+                                   encoded.size() - offset);
+        memcpy(filter->stream_buffer()->data(), encoded.data() + offset,
+               length);
+        ASSERT_TRUE(filter->FlushStreamBuffer(length));
+        offset += length;
+      }
+      int output_length = kOutputBufferSize;
+      status = filter->ReadData(output.get(), &output_length);
+      ASSERT_NE(Filter::FILTER_ERROR, status);
+      decoded_bytes += output_length;
+      if (status == Filter::FILTER_NEED_MORE_DATA && offset == encoded.size())
+        break;
+    }
+  }
+  double seconds = timer.Elapsed().InSecondsF();
+  EXPECT_EQ(responses * static_cast<int64>(decoded_size), decoded_bytes);
+
+  LogPerfResult(base::StringPrintf("Filter_%s", name).c_str(),
+                decoded_bytes / seconds / (1024 * 1024), "MB/s");
+}
+
+}  // namespace
+
+TEST(FilterPerfTest, GZipDecode) {
+  std::string corpus = ReadCorpus();
+  ASSERT_FALSE(corpus.empty());
+
+  std::vector<Filter::FilterType> encoding_types;
+  encoding_types.push_back(Filter::FILTER_TYPE_GZIP);
+
+  // One copy of the page, the typical size of a document.
+  RunDecodeTest("GZipDecode_Page", encoding_types, GZipEncode(corpus),
+                corpus.size());
+
+  // Many copies of the page in one response, so that decoding rather than
+  // setting up the filter dominates.
+  std::string large_corpus;
+  while (large_corpus.size() < 1024 * 1024)
+    large_corpus += corpus;
+  RunDecodeTest("GZipDecode_Large", encoding_types, GZipEncode(large_corpus),
+                large_corpus.size());
+}
+
+TEST(FilterPerfTest, GZipHelpingSdchPassThrough) {
+  std::string corpus = ReadCorpus();
+  ASSERT_FALSE(corpus.empty());
+
+  // The tentative gunzip added to SDCH responses passes plain data through
+  // when there is no gzip header.
+  std::vector<Filter::FilterType> encoding_types;
+  encoding_types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  RunDecodeTest("GZipHelpingSdch_PassThrough", encoding_types, corpus,
+                corpus.size());
+}
+
+}  // namespace net
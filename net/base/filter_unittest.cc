@@ -3,11 +3,61 @@
 // found in the LICENSE file.
 
 #include "net/base/filter.h"
+
+#include "base/memory/scoped_ptr.h"
+#include "net/base/io_buffer.h"
 #include "net/base/mock_filter_context.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace net {
 
+namespace {
+
+// A decoder for a made up content encoding that rotates letters by 13.
+class Rot13Filter : public Filter {
+ public:
+  static Filter* Create(const FilterContext& filter_context) {
+    return new Rot13Filter;
+  }
+
+  virtual FilterStatus ReadFilteredData(char* dest_buffer,
+                                        int* dest_len) OVERRIDE {
+    FilterStatus status = CopyOut(dest_buffer, dest_len);
+    for (int i = 0; i < *dest_len; ++i) {
+      char c = dest_buffer[i];
+      if (c >= 'a' && c <= 'z')
+        dest_buffer[i] = 'a' + (c - 'a' + 13) % 26;
+      else if (c >= 'A' && c <= 'Z')
+        dest_buffer[i] = 'A' + (c - 'A' + 13) % 26;
+    }
+    return status;
+  }
+};
+
+Filter* CreateNullFilter(const FilterContext& filter_context) {
+  return NULL;
+}
+
+// Feeds |input| through |filter| and returns everything it outputs.
+std::string FilterAll(Filter* filter, const std::string& input) {
+  CHECK_LE(static_cast<int>(input.size()), filter->stream_buffer_size());
+  memcpy(filter->stream_buffer()->data(), input.data(), input.size());
+  filter->FlushStreamBuffer(input.size());
+
+  std::string output;
+  char buffer[16];
+  Filter::FilterStatus status;
+  do {
+    int length = sizeof(buffer);
+    status = filter->ReadData(buffer, &length);
+    output.append(buffer, length);
+  } while (status == Filter::FILTER_OK);
+  EXPECT_EQ(Filter::FILTER_NEED_MORE_DATA, status);
+  return output;
+}
+
+}  // namespace
+
 class FilterTest : public testing::Test {
 };
 
@@ -347,4 +397,87 @@ TEST(FilterTest, SupportedMimeGzip) {
   EXPECT_TRUE(encoding_types.empty());
 }
 
+TEST(FilterTest, RegisteredFilterType) {
+  Filter::ResetRegisteredFilterTypesForTesting();
+  Filter::FilterType rot13 =
+      Filter::RegisterFilterType("X-Rot13", &Rot13Filter::Create);
+  EXPECT_EQ(Filter::FILTER_TYPE_REGISTERED_FIRST, rot13);
+  EXPECT_EQ(rot13, Filter::ConvertEncodingToType("x-rot13"));
+  EXPECT_EQ(rot13, Filter::ConvertEncodingToType("X-ROT13"));
+  // Registering again keeps the type.
+  EXPECT_EQ(rot13, Filter::RegisterFilterType("x-rot13", &Rot13Filter::Create));
+
+  std::vector<std::string> encodings;
+  Filter::GetRegisteredEncodings(&encodings);
+  ASSERT_EQ(1U, encodings.size());
+  EXPECT_EQ("x-rot13", encodings[0]);
+
+  MockFilterContext filter_context;
+  std::vector<Filter::FilterType> encoding_types;
+  encoding_types.push_back(rot13);
+  scoped_ptr<Filter> filter(Filter::Factory(encoding_types, filter_context));
+  ASSERT_TRUE(filter.get());
+  EXPECT_EQ("Uryyb, jbeyq! Hello, world!",
+            FilterAll(filter.get(), "Hello, world! Uryyb, jbeyq!"));
+
+  // Registered filters chain like the built in ones.
+  encoding_types.push_back(rot13);
+  filter.reset(Filter::Factory(encoding_types, filter_context));
+  ASSERT_TRUE(filter.get());
+  EXPECT_EQ("Hello, world!", FilterAll(filter.get(), "Hello, world!"));
+
+  Filter::ResetRegisteredFilterTypesForTesting();
+  EXPECT_EQ(Filter::FILTER_TYPE_UNSUPPORTED,
+            Filter::ConvertEncodingToType("x-rot13"));
+}
+
+TEST(FilterTest, RegisterFilterTypeRejectsBuiltInsAndOverflow) {
+  Filter::ResetRegisteredFilterTypesForTesting();
+  EXPECT_EQ(Filter::FILTER_TYPE_UNSUPPORTED,
+            Filter::RegisterFilterType("GZIP", &Rot13Filter::Create));
+  EXPECT_EQ(Filter::FILTER_TYPE_UNSUPPORTED,
+            Filter::RegisterFilterType("identity", &Rot13Filter::Create));
+  EXPECT_EQ(Filter::FILTER_TYPE_GZIP, Filter::ConvertEncodingToType("gzip"));
+
+  const int kNumTypes = Filter::FILTER_TYPE_REGISTERED_LAST -
+                        Filter::FILTER_TYPE_REGISTERED_FIRST + 1;
+  for (int i = 0; i < kNumTypes; ++i) {
+    std::string encoding(1, 'a' + i);
+    EXPECT_EQ(Filter::FILTER_TYPE_REGISTERED_FIRST + i,
+              Filter::RegisterFilterType(encoding, &Rot13Filter::Create));
+  }
+  EXPECT_EQ(Filter::FILTER_TYPE_UNSUPPORTED,
+            Filter::RegisterFilterType("too-many", &Rot13Filter::Create));
+  Filter::ResetRegisteredFilterTypesForTesting();
+}
+
+TEST(FilterTest, RegisteredFilterCreationFailure) {
+  Filter::ResetRegisteredFilterTypesForTesting();
+  std::vector<Filter::FilterType> encoding_types;
+  encoding_types.push_back(
+      Filter::RegisterFilterType("x-null", &CreateNullFilter));
+  MockFilterContext filter_context;
+  EXPECT_TRUE(Filter::Factory(encoding_types, filter_context) == NULL);
+  Filter::ResetRegisteredFilterTypesForTesting();
+}
+
+TEST(FilterTest, ReusesStreamBuffers) {
+  scoped_ptr<Filter> filter(Filter::GZipFactory());
+  ASSERT_TRUE(filter.get());
+  IOBuffer* buffer = filter->stream_buffer();
+  filter.reset();
+
+  // The buffer of the filter destroyed last is handed out first.
+  filter.reset(Filter::GZipFactory());
+  ASSERT_TRUE(filter.get());
+  EXPECT_EQ(buffer, filter->stream_buffer());
+
+  // A buffer still referenced elsewhere is not reused.
+  scoped_refptr<IOBuffer> in_use(filter->stream_buffer());
+  filter.reset();
+  filter.reset(Filter::GZipFactory());
+  ASSERT_TRUE(filter.get());
+  EXPECT_NE(in_use.get(), filter->stream_buffer());
+}
+
 }  // namespace net
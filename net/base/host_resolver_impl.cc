@@ -10,6 +10,7 @@
 #include <netdb.h>
 #endif
 
+#include <algorithm>
 #include <cmath>
 #include <utility>
 #include <vector>
@@ -1040,7 +1041,10 @@ class HostResolverImpl::IPv6ProbeJob
 
 //-----------------------------------------------------------------------------
 
-// Resolves the hostname using DnsTransaction.
+// Resolves the hostname using DnsTransaction. For ADDRESS_FAMILY_UNSPECIFIED,
+// the A and AAAA queries are sent concurrently and the results are merged,
+// IPv6 addresses first. The task fails only if neither query yields an
+// address.
 // TODO(szym): This could be moved to separate source file as well.
 class HostResolverImpl::DnsTask {
  public:
@@ -1052,27 +1056,55 @@ class HostResolverImpl::DnsTask {
           const Key& key,
           const Callback& callback,
           const BoundNetLog& job_net_log)
-      : callback_(callback), net_log_(job_net_log) {
+      : callback_(callback),
+        net_log_(job_net_log),
+        num_pending_transactions_(0),
+        net_error_a_(ERR_IO_PENDING),
+        net_error_aaaa_(ERR_IO_PENDING) {
     DCHECK(factory);
     DCHECK(!callback.is_null());
 
-    // For now we treat ADDRESS_FAMILY_UNSPEC as if it was IPV4.
-    uint16 qtype = (key.address_family == ADDRESS_FAMILY_IPV6)
-                   ? dns_protocol::kTypeAAAA
-                   : dns_protocol::kTypeA;
-    // TODO(szym): Implement "happy eyeballs".
-    transaction_ = factory->CreateTransaction(
-        key.hostname,
-        qtype,
-        base::Bind(&DnsTask::OnTransactionComplete, base::Unretained(this),
-                   base::TimeTicks::Now()),
-        net_log_);
-    DCHECK(transaction_.get());
+    if (key.address_family != ADDRESS_FAMILY_IPV6) {
+      transaction_a_ = factory->CreateTransaction(
+          key.hostname,
+          dns_protocol::kTypeA,
+          base::Bind(&DnsTask::OnTransactionComplete, base::Unretained(this),
+                     base::TimeTicks::Now()),
+          net_log_);
+      DCHECK(transaction_a_.get());
+    }
+    if (key.address_family != ADDRESS_FAMILY_IPV4) {
+      transaction_aaaa_ = factory->CreateTransaction(
+          key.hostname,
+          dns_protocol::kTypeAAAA,
+          base::Bind(&DnsTask::OnTransactionComplete, base::Unretained(this),
+                     base::TimeTicks::Now()),
+          net_log_);
+      DCHECK(transaction_aaaa_.get());
+    }
   }
 
   int Start() {
     net_log_.BeginEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_DNS_TASK, NULL);
-    return transaction_->Start();
+    // DnsTransaction::Start never succeeds synchronously, but it may fail.
+    if (transaction_a_.get()) {
+      net_error_a_ = transaction_a_->Start();
+      if (net_error_a_ == ERR_IO_PENDING)
+        ++num_pending_transactions_;
+    }
+    if (transaction_aaaa_.get()) {
+      net_error_aaaa_ = transaction_aaaa_->Start();
+      if (net_error_aaaa_ == ERR_IO_PENDING)
+        ++num_pending_transactions_;
+    }
+    if (num_pending_transactions_ > 0)
+      return ERR_IO_PENDING;
+    int net_error = transaction_a_.get() ? net_error_a_ : net_error_aaaa_;
+    DCHECK_NE(OK, net_error);
+    net_log_.EndEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_DNS_TASK,
+                      new DnsTaskFailedParams(net_error,
+                                              DnsResponse::DNS_SUCCESS));
+    return net_error;
   }
 
   void OnTransactionComplete(const base::TimeTicks& start_time,
@@ -1080,41 +1112,101 @@ class HostResolverImpl::DnsTask {
                              int net_error,
                              const DnsResponse* response) {
     DCHECK(transaction);
-    // Run |callback_| last since the owning Job will then delete this DnsTask.
-    DnsResponse::Result result = DnsResponse::DNS_SUCCESS;
+    DCHECK_GT(num_pending_transactions_, 0);
+    bool is_a = transaction == transaction_a_.get();
+    AddressList* addr_list = is_a ? &addr_list_a_ : &addr_list_aaaa_;
+    base::TimeDelta* ttl = is_a ? &ttl_a_ : &ttl_aaaa_;
+    DnsResponse::Result* result = is_a ? &result_a_ : &result_aaaa_;
+
+    *result = DnsResponse::DNS_SUCCESS;
     if (net_error == OK) {
       CHECK(response);
       DNS_HISTOGRAM("AsyncDNS.TransactionSuccess",
                     base::TimeTicks::Now() - start_time);
-      AddressList addr_list;
-      base::TimeDelta ttl;
-      result = response->ParseToAddressList(&addr_list, &ttl);
+      *result = response->ParseToAddressList(addr_list, ttl);
       UMA_HISTOGRAM_ENUMERATION("AsyncDNS.ParseToAddressList",
-                                result,
+                                *result,
                                 DnsResponse::DNS_PARSE_RESULT_MAX);
-      if (result == DnsResponse::DNS_SUCCESS) {
-        net_log_.EndEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_DNS_TASK,
-                          new AddressListNetLogParam(addr_list));
-        callback_.Run(net_error, addr_list, ttl);
-        return;
-      }
-      net_error = ERR_DNS_MALFORMED_RESPONSE;
+      if (*result != DnsResponse::DNS_SUCCESS)
+        net_error = ERR_DNS_MALFORMED_RESPONSE;
     } else {
       DNS_HISTOGRAM("AsyncDNS.TransactionFailure",
                     base::TimeTicks::Now() - start_time);
     }
+    if (is_a)
+      net_error_a_ = net_error;
+    else
+      net_error_aaaa_ = net_error;
+
+    if (--num_pending_transactions_ > 0)
+      return;
+    OnAllTransactionsComplete();
+  }
+
+ private:
+  // Merges the results of the transactions and reports them to |callback_|.
+  void OnAllTransactionsComplete() {
+    AddressList addr_list;
+    base::TimeDelta ttl;
+    bool have_ttl = false;
+    if (transaction_aaaa_.get() && net_error_aaaa_ == OK) {
+      addr_list.insert(addr_list.end(), addr_list_aaaa_.begin(),
+                       addr_list_aaaa_.end());
+      ttl = ttl_aaaa_;
+      have_ttl = true;
+    }
+    if (transaction_a_.get() && net_error_a_ == OK) {
+      addr_list.insert(addr_list.end(), addr_list_a_.begin(),
+                       addr_list_a_.end());
+      ttl = have_ttl ? std::min(ttl, ttl_a_) : ttl_a_;
+    }
+    // TODO(szym): Remove along with AddressList::canonical_name().
+    // http://crbug.com/126134
+    addr_list.set_canonical_name(net_error_a_ == OK ?
+        addr_list_a_.canonical_name() : addr_list_aaaa_.canonical_name());
+
+    // Run |callback_| last since the owning Job will then delete this DnsTask.
+    if (!addr_list.empty()) {
+      net_log_.EndEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_DNS_TASK,
+                        new AddressListNetLogParam(addr_list));
+      callback_.Run(OK, addr_list, ttl);
+      return;
+    }
+
+    // Neither query produced an address. Report the A failure if there is one,
+    // since that is what would have been reported before AAAA was queried.
+    int net_error = net_error_a_;
+    DnsResponse::Result result = result_a_;
+    if (!transaction_a_.get() || net_error == OK) {
+      net_error = net_error_aaaa_;
+      result = result_aaaa_;
+    }
+    if (net_error == OK)
+      net_error = ERR_NAME_NOT_RESOLVED;
     net_log_.EndEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_DNS_TASK,
                       new DnsTaskFailedParams(net_error, result));
     callback_.Run(net_error, AddressList(), base::TimeDelta());
   }
 
- private:
   // The listener to the results of this DnsTask.
   Callback callback_;
 
   const BoundNetLog net_log_;
 
-  scoped_ptr<DnsTransaction> transaction_;
+  scoped_ptr<DnsTransaction> transaction_a_;
+  scoped_ptr<DnsTransaction> transaction_aaaa_;
+
+  int num_pending_transactions_;
+
+  // Results of each transaction. Only meaningful once it completed.
+  int net_error_a_;
+  int net_error_aaaa_;
+  DnsResponse::Result result_a_;
+  DnsResponse::Result result_aaaa_;
+  AddressList addr_list_a_;
+  AddressList addr_list_aaaa_;
+  base::TimeDelta ttl_a_;
+  base::TimeDelta ttl_aaaa_;
 };
 
 //-----------------------------------------------------------------------------
@@ -1371,6 +1463,9 @@ class HostResolverImpl::Job : public PrioritizedDispatcher::Job {
 
       // TODO(szym): Some net errors indicate lack of connectivity. Starting
       // ProcTask in that case is a waste of time.
+
+      // Even an NXDOMAIN is not final: the system resolver may still find the
+      // name in the hosts file, through NSS or over mDNS (e.g. ".local").
       StartProcTask();
       return;
     }
@@ -1279,8 +1279,10 @@ TEST_F(HostResolverImplTest, DnsTask) {
   }
 
   EXPECT_EQ(OK, requests_[1]->result());
-  // Resolved by MockDnsClient.
-  EXPECT_TRUE(requests_[1]->HasOneAddress("127.0.0.1", 80));
+  // Resolved by MockDnsClient, which answers both A and AAAA queries.
+  EXPECT_EQ(2u, requests_[1]->NumberOfAddresses());
+  EXPECT_TRUE(requests_[1]->HasAddress("127.0.0.1", 80));
+  EXPECT_TRUE(requests_[1]->HasAddress("::1", 80));
   EXPECT_EQ(ERR_NAME_NOT_RESOLVED, requests_[2]->result());
   EXPECT_EQ(ERR_NAME_NOT_RESOLVED, requests_[3]->result());
   EXPECT_EQ(OK, requests_[4]->result());
@@ -1289,6 +1291,33 @@ TEST_F(HostResolverImplTest, DnsTask) {
   EXPECT_TRUE(requests_[5]->HasOneAddress("192.168.1.102", 80));
 }
 
+// Test that DnsTask queries only the requested address family, and that an
+// NXDOMAIN for a multi-label name still falls back to the system resolver.
+TEST_F(HostResolverImplTest, DnsTaskAddressFamilyAndNxdomain) {
+  proc_->AddRuleForAllFamilies("nx.example.com", "192.168.1.103");
+
+  set_dns_client(CreateMockDnsClient(CreateValidDnsConfig()));
+
+  EXPECT_EQ(ERR_IO_PENDING, CreateRequest("ok_ipv4", 80, MEDIUM,
+                                          ADDRESS_FAMILY_IPV4)->Resolve());
+  EXPECT_EQ(ERR_IO_PENDING, CreateRequest("ok_ipv6", 80, MEDIUM,
+                                          ADDRESS_FAMILY_IPV6)->Resolve());
+  EXPECT_EQ(ERR_IO_PENDING, CreateRequest("nx.example.com", 80)->Resolve());
+
+  proc_->SignalMultiple(requests_.size());
+
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    EXPECT_NE(ERR_UNEXPECTED, requests_[i]->WaitForResult()) << i;
+  }
+
+  EXPECT_EQ(OK, requests_[0]->result());
+  EXPECT_TRUE(requests_[0]->HasOneAddress("127.0.0.1", 80));
+  EXPECT_EQ(OK, requests_[1]->result());
+  EXPECT_TRUE(requests_[1]->HasOneAddress("::1", 80));
+  EXPECT_EQ(OK, requests_[2]->result());
+  EXPECT_TRUE(requests_[2]->HasOneAddress("192.168.1.103", 80));
+}
+
 TEST_F(HostResolverImplTest, ServeFromHosts) {
   // Initially, there's DnsConfigService, but no DnsConfig.
   MockDnsConfigService* config_service = new MockDnsConfigService();
@@ -11,6 +11,7 @@
 #include "base/compiler_specific.h"
 #include "base/message_loop.h"
 #include "base/metrics/histogram.h"
+#include "base/pickle.h"
 #include "base/stl_util.h"
 #include "base/synchronization/lock.h"
 #include "base/time.h"
@@ -77,9 +78,28 @@ const unsigned kMaxCacheEntries = 256;
 // The number of seconds for which we'll cache a cache entry.
 const unsigned kTTLSecs = 1800;  // 30 minutes.
 
+// Version of the format written by SerializeCache(). Bump this whenever the
+// format changes; data with a different version is ignored.
+const int kSerializationVersion = 1;
+
+uint32 GetCRLSetSequence(CRLSet* crl_set) {
+  return crl_set ? crl_set->sequence() : 0;
+}
+
+bool ReadFingerprint(PickleIterator* iter, SHA1Fingerprint* fingerprint) {
+  const char* data;
+  if (!iter->ReadBytes(&data, sizeof(fingerprint->data)))
+    return false;
+  memcpy(fingerprint->data, data, sizeof(fingerprint->data));
+  return true;
+}
+
 }  // namespace
 
-MultiThreadedCertVerifier::CachedResult::CachedResult() : error(ERR_FAILED) {}
+MultiThreadedCertVerifier::CachedResult::CachedResult()
+    : error(ERR_FAILED),
+      persisted(false) {
+}
 
 MultiThreadedCertVerifier::CachedResult::~CachedResult() {}
 
@@ -173,8 +193,10 @@ class CertVerifierWorker {
  private:
   void Run() {
     // Runs on a worker thread.
+    base::TimeTicks start_time = base::TimeTicks::Now();
     error_ = verify_proc_->Verify(cert_, hostname_, flags_, crl_set_,
                                   &verify_result_);
+    verify_time_ = base::TimeTicks::Now() - start_time;
 #if defined(USE_NSS)
     // Detach the thread from NSPR.
     // Calling NSS functions attaches the thread to NSPR, which stores
@@ -199,7 +221,8 @@ class CertVerifierWorker {
       base::AutoLock locked(lock_);
       if (!canceled_) {
         cert_verifier_->HandleResult(cert_, hostname_, flags_,
-                                     error_, verify_result_);
+                                     GetCRLSetSequence(crl_set_),
+                                     error_, verify_result_, verify_time_);
       }
     }
     delete this;
@@ -250,6 +273,7 @@ class CertVerifierWorker {
 
   int error_;
   CertVerifyResult verify_result_;
+  base::TimeDelta verify_time_;
 
   DISALLOW_COPY_AND_ASSIGN(CertVerifierWorker);
 };
@@ -332,7 +356,9 @@ MultiThreadedCertVerifier::MultiThreadedCertVerifier()
       requests_(0),
       cache_hits_(0),
       inflight_joins_(0),
-      verify_proc_(CertVerifyProc::CreateDefault()) {
+      persisted_cache_hits_(0),
+      verify_proc_(CertVerifyProc::CreateDefault()),
+      delegate_(NULL) {
   CertDatabase::AddObserver(this);
 }
 
@@ -360,11 +386,22 @@ int MultiThreadedCertVerifier::Verify(X509Certificate* cert,
   requests_++;
 
   const RequestParams key(cert->fingerprint(), cert->ca_fingerprint(),
-                          hostname, flags);
+                          hostname, flags, GetCRLSetSequence(crl_set));
   const CertVerifierCache::value_type* cached_entry =
       cache_.Get(key, base::TimeTicks::Now());
   if (cached_entry) {
     ++cache_hits_;
+    if (cached_entry->persisted) {
+      ++persisted_cache_hits_;
+      verification_time_saved_ += cached_entry->verify_time;
+      UMA_HISTOGRAM_CUSTOM_TIMES("Net.CertVerifier_PersistedCacheHitTimeSaved",
+                                 cached_entry->verify_time,
+                                 base::TimeDelta::FromMilliseconds(1),
+                                 base::TimeDelta::FromMinutes(10),
+                                 100);
+    }
+    UMA_HISTOGRAM_BOOLEAN("Net.CertVerifier_CacheHitWasPersisted",
+                          cached_entry->persisted);
     *out_req = NULL;
     *verify_result = cached_entry->result;
     return cached_entry->error;
@@ -417,19 +454,26 @@ void MultiThreadedCertVerifier::HandleResult(
     X509Certificate* cert,
     const std::string& hostname,
     int flags,
+    uint32 crl_set_sequence,
     int error,
-    const CertVerifyResult& verify_result) {
+    const CertVerifyResult& verify_result,
+    base::TimeDelta verify_time) {
   DCHECK(CalledOnValidThread());
 
   const RequestParams key(cert->fingerprint(), cert->ca_fingerprint(),
-                          hostname, flags);
+                          hostname, flags, crl_set_sequence);
 
   CachedResult cached_result;
   cached_result.error = error;
   cached_result.result = verify_result;
+  cached_result.verify_time = verify_time;
   cache_.Put(key, cached_result, base::TimeTicks::Now(),
              base::TimeDelta::FromSeconds(kTTLSecs));
 
+  // Only successful verifications are persisted.
+  if (error == OK && delegate_)
+    delegate_->CacheIsDirty(this);
+
   std::map<RequestParams, CertVerifierJob*>::iterator j;
   j = inflight_.find(key);
   if (j == inflight_.end()) {
@@ -448,6 +492,158 @@ void MultiThreadedCertVerifier::OnCertTrustChanged(
   DCHECK(CalledOnValidThread());
 
   ClearCache();
+  if (delegate_)
+    delegate_->CacheIsDirty(this);
+}
+
+void MultiThreadedCertVerifier::SetDelegate(Delegate* delegate) {
+  DCHECK(CalledOnValidThread());
+  delegate_ = delegate;
+}
+
+void MultiThreadedCertVerifier::SerializeCache(std::string* output) {
+  DCHECK(CalledOnValidThread());
+
+  // Expirations are tracked with TimeTicks, which are meaningless across
+  // restarts, so they are converted to wall-clock times.
+  const base::TimeTicks now_ticks = base::TimeTicks::Now();
+  const base::Time now = base::Time::Now();
+
+  Pickle pickle;
+  pickle.WriteInt(kSerializationVersion);
+
+  int count = 0;
+  for (CertVerifierCache::Iterator it(cache_); it.HasNext(); it.Advance()) {
+    if (it.value().error == OK && it.expiration() > now_ticks)
+      ++count;
+  }
+  pickle.WriteInt(count);
+
+  for (CertVerifierCache::Iterator it(cache_); it.HasNext(); it.Advance()) {
+    const RequestParams& key = it.key();
+    const CachedResult& value = it.value();
+    if (value.error != OK || it.expiration() <= now_ticks)
+      continue;
+
+    const CertVerifyResult& result = value.result;
+    pickle.WriteBytes(key.cert_fingerprint.data,
+                      sizeof(key.cert_fingerprint.data));
+    pickle.WriteBytes(key.ca_fingerprint.data,
+                      sizeof(key.ca_fingerprint.data));
+    pickle.WriteString(key.hostname);
+    pickle.WriteInt(key.flags);
+    pickle.WriteUInt32(key.crl_set_sequence);
+    pickle.WriteInt64(
+        (now + (it.expiration() - now_ticks)).ToInternalValue());
+    pickle.WriteInt64(value.verify_time.ToInternalValue());
+
+    pickle.WriteBool(result.verified_cert != NULL);
+    if (result.verified_cert)
+      result.verified_cert->Persist(&pickle);
+    pickle.WriteUInt32(result.cert_status);
+    pickle.WriteBool(result.has_md5);
+    pickle.WriteBool(result.has_md2);
+    pickle.WriteBool(result.has_md4);
+    pickle.WriteBool(result.has_md5_ca);
+    pickle.WriteBool(result.has_md2_ca);
+    pickle.WriteInt(static_cast<int>(result.public_key_hashes.size()));
+    for (size_t i = 0; i < result.public_key_hashes.size(); ++i) {
+      pickle.WriteBytes(result.public_key_hashes[i].data,
+                        sizeof(result.public_key_hashes[i].data));
+    }
+    pickle.WriteBool(result.is_issued_by_known_root);
+  }
+
+  output->assign(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+bool MultiThreadedCertVerifier::LoadCache(const std::string& serialized) {
+  DCHECK(CalledOnValidThread());
+
+  Pickle pickle(serialized.data(), serialized.size());
+  PickleIterator iter(pickle);
+
+  int version;
+  int count;
+  if (!iter.ReadInt(&version) || version != kSerializationVersion ||
+      !iter.ReadInt(&count) || count < 0) {
+    return false;
+  }
+
+  const base::TimeTicks now_ticks = base::TimeTicks::Now();
+  const base::Time now = base::Time::Now();
+  const base::TimeDelta max_ttl = base::TimeDelta::FromSeconds(kTTLSecs);
+
+  for (int i = 0; i < count; ++i) {
+    SHA1Fingerprint cert_fingerprint;
+    SHA1Fingerprint ca_fingerprint;
+    std::string hostname;
+    int flags;
+    uint32 crl_set_sequence;
+    int64 expiration;
+    int64 verify_time;
+    bool has_verified_cert;
+    if (!ReadFingerprint(&iter, &cert_fingerprint) ||
+        !ReadFingerprint(&iter, &ca_fingerprint) ||
+        !iter.ReadString(&hostname) ||
+        !iter.ReadInt(&flags) ||
+        !iter.ReadUInt32(&crl_set_sequence) ||
+        !iter.ReadInt64(&expiration) ||
+        !iter.ReadInt64(&verify_time) ||
+        !iter.ReadBool(&has_verified_cert)) {
+      return false;
+    }
+
+    CachedResult cached_result;
+    cached_result.error = OK;
+    cached_result.persisted = true;
+    cached_result.verify_time = base::TimeDelta::FromInternalValue(verify_time);
+
+    CertVerifyResult* result = &cached_result.result;
+    if (has_verified_cert) {
+      result->verified_cert = X509Certificate::CreateFromPickle(
+          pickle, &iter, X509Certificate::PICKLETYPE_CERTIFICATE_CHAIN_V3);
+      if (!result->verified_cert)
+        return false;
+    }
+
+    int num_hashes;
+    if (!iter.ReadUInt32(&result->cert_status) ||
+        !iter.ReadBool(&result->has_md5) ||
+        !iter.ReadBool(&result->has_md2) ||
+        !iter.ReadBool(&result->has_md4) ||
+        !iter.ReadBool(&result->has_md5_ca) ||
+        !iter.ReadBool(&result->has_md2_ca) ||
+        !iter.ReadInt(&num_hashes) || num_hashes < 0) {
+      return false;
+    }
+    for (int j = 0; j < num_hashes; ++j) {
+      SHA1Fingerprint hash;
+      if (!ReadFingerprint(&iter, &hash))
+        return false;
+      result->public_key_hashes.push_back(hash);
+    }
+    if (!iter.ReadBool(&result->is_issued_by_known_root))
+      return false;
+
+    // Never extend the lifetime of a result beyond what it would have had in
+    // memory, even if the clock moved backwards.
+    base::TimeDelta ttl =
+        base::Time::FromInternalValue(expiration) - now;
+    if (ttl <= base::TimeDelta())
+      continue;
+    if (ttl > max_ttl)
+      ttl = max_ttl;
+
+    const RequestParams key(cert_fingerprint, ca_fingerprint, hostname, flags,
+                            crl_set_sequence);
+    // Don't clobber fresher results computed since startup.
+    if (cache_.Get(key, now_ticks))
+      continue;
+    cache_.Put(key, cached_result, now_ticks, ttl);
+  }
+
+  return true;
 }
 
 void MultiThreadedCertVerifier::SetCertVerifyProc(CertVerifyProc* verify_proc) {
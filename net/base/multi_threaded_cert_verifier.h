@@ -13,6 +13,7 @@
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/threading/non_thread_safe.h"
+#include "base/time.h"
 #include "net/base/cert_database.h"
 #include "net/base/cert_verifier.h"
 #include "net/base/cert_verify_result.h"
@@ -30,11 +31,26 @@ class CertVerifyProc;
 
 // MultiThreadedCertVerifier is a CertVerifier implementation that runs
 // synchronous CertVerifier implementations on worker threads.
+//
+// Successful results are cached in memory. Register a Delegate with
+// |SetDelegate| to persist the cache across restarts; see SerializeCache()
+// and LoadCache().
 class NET_EXPORT_PRIVATE MultiThreadedCertVerifier
     : public CertVerifier,
       NON_EXPORTED_BASE(public base::NonThreadSafe),
       public CertDatabase::Observer {
  public:
+  class Delegate {
+   public:
+    // Called when new results have been added to the cache, or the cache
+    // has been cleared. This function may not block and must not reenter the
+    // MultiThreadedCertVerifier.
+    virtual void CacheIsDirty(MultiThreadedCertVerifier* verifier) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
   MultiThreadedCertVerifier();
 
   // When the verifier is destroyed, all certificate verifications requests are
@@ -53,6 +69,28 @@ class NET_EXPORT_PRIVATE MultiThreadedCertVerifier
 
   virtual void CancelRequest(CertVerifier::RequestHandle req) OVERRIDE;
 
+  // Assign a |Delegate| for persisting the cache. If NULL, the cache will not
+  // be persisted. Caller owns |delegate|.
+  void SetDelegate(Delegate* delegate);
+
+  // Serializes the unexpired successful results in the cache into |output|.
+  // Entries are keyed by the certificate chain fingerprints, hostname,
+  // verification flags and the sequence number of the CRLSet that was used,
+  // so results computed against an older CRLSet are never reused.
+  void SerializeCache(std::string* output);
+
+  // Adds the entries in |serialized| (previously produced by SerializeCache())
+  // to the cache, skipping any that have expired. Returns false if
+  // |serialized| could not be parsed.
+  bool LoadCache(const std::string& serialized);
+
+  // Number of Verify() calls answered from entries that were restored by
+  // LoadCache(), and the total verification time those hits avoided.
+  uint64 persisted_cache_hits() const { return persisted_cache_hits_; }
+  base::TimeDelta verification_time_saved() const {
+    return verification_time_saved_;
+  }
+
  private:
   friend class CertVerifierWorker;  // Calls HandleResult.
   friend class CertVerifierRequest;
@@ -64,24 +102,30 @@ class NET_EXPORT_PRIVATE MultiThreadedCertVerifier
   FRIEND_TEST_ALL_PREFIXES(MultiThreadedCertVerifierTest, CancelRequest);
   FRIEND_TEST_ALL_PREFIXES(MultiThreadedCertVerifierTest,
                            RequestParamsComparators);
+  FRIEND_TEST_ALL_PREFIXES(MultiThreadedCertVerifierTest, PersistCache);
 
   // Input parameters of a certificate verification request.
   struct RequestParams {
     RequestParams(const SHA1Fingerprint& cert_fingerprint_arg,
                   const SHA1Fingerprint& ca_fingerprint_arg,
                   const std::string& hostname_arg,
-                  int flags_arg)
+                  int flags_arg,
+                  uint32 crl_set_sequence_arg)
         : cert_fingerprint(cert_fingerprint_arg),
           ca_fingerprint(ca_fingerprint_arg),
           hostname(hostname_arg),
-          flags(flags_arg) {}
+          flags(flags_arg),
+          crl_set_sequence(crl_set_sequence_arg) {}
 
     bool operator<(const RequestParams& other) const {
-      // |flags| is compared before |cert_fingerprint|, |ca_fingerprint|, and
-      // |hostname| under assumption that integer comparisons are faster than
-      // memory and string comparisons.
+      // |flags| and |crl_set_sequence| are compared before
+      // |cert_fingerprint|, |ca_fingerprint|, and |hostname| under assumption
+      // that integer comparisons are faster than memory and string
+      // comparisons.
       if (flags != other.flags)
         return flags < other.flags;
+      if (crl_set_sequence != other.crl_set_sequence)
+        return crl_set_sequence < other.crl_set_sequence;
       int rv = memcmp(cert_fingerprint.data, other.cert_fingerprint.data,
                       sizeof(cert_fingerprint.data));
       if (rv != 0)
@@ -97,6 +141,8 @@ class NET_EXPORT_PRIVATE MultiThreadedCertVerifier
     SHA1Fingerprint ca_fingerprint;
     std::string hostname;
     int flags;
+    // The sequence number of the CRLSet used, or 0 if there was none.
+    uint32 crl_set_sequence;
   };
 
   // CachedResult contains the result of a certificate verification.
@@ -106,13 +152,19 @@ class NET_EXPORT_PRIVATE MultiThreadedCertVerifier
 
     int error;  // The return value of CertVerifier::Verify.
     CertVerifyResult result;  // The output of CertVerifier::Verify.
+    // How long the verification took on the worker thread.
+    base::TimeDelta verify_time;
+    // True if this result was restored by LoadCache().
+    bool persisted;
   };
 
   void HandleResult(X509Certificate* cert,
                     const std::string& hostname,
                     int flags,
+                    uint32 crl_set_sequence,
                     int error,
-                    const CertVerifyResult& verify_result);
+                    const CertVerifyResult& verify_result,
+                    base::TimeDelta verify_time);
 
   // CertDatabase::Observer methods:
   virtual void OnCertTrustChanged(const X509Certificate* cert) OVERRIDE;
@@ -136,9 +188,13 @@ class NET_EXPORT_PRIVATE MultiThreadedCertVerifier
   uint64 requests_;
   uint64 cache_hits_;
   uint64 inflight_joins_;
+  uint64 persisted_cache_hits_;
+  base::TimeDelta verification_time_saved_;
 
   scoped_refptr<CertVerifyProc> verify_proc_;
 
+  Delegate* delegate_;
+
   DISALLOW_COPY_AND_ASSIGN(MultiThreadedCertVerifier);
 };
 
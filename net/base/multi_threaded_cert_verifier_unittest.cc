@@ -45,6 +45,42 @@ class MockCertVerifyProc : public CertVerifyProc {
   }
 };
 
+// A CertVerifyProc which accepts every certificate.
+class MockSuccessCertVerifyProc : public CertVerifyProc {
+ public:
+  MockSuccessCertVerifyProc() {}
+
+ private:
+  virtual ~MockSuccessCertVerifyProc() {}
+
+  // CertVerifyProc implementation
+  virtual int VerifyInternal(X509Certificate* cert,
+                             const std::string& hostname,
+                             int flags,
+                             CRLSet* crl_set,
+                             CertVerifyResult* verify_result) OVERRIDE {
+    verify_result->Reset();
+    verify_result->verified_cert = cert;
+    verify_result->is_issued_by_known_root = true;
+    return OK;
+  }
+};
+
+class MockDelegate : public MultiThreadedCertVerifier::Delegate {
+ public:
+  MockDelegate() : dirty_count_(0) {}
+  virtual ~MockDelegate() {}
+
+  virtual void CacheIsDirty(MultiThreadedCertVerifier* verifier) OVERRIDE {
+    ++dirty_count_;
+  }
+
+  int dirty_count() const { return dirty_count_; }
+
+ private:
+  int dirty_count_;
+};
+
 }  // namespace
 
 class MultiThreadedCertVerifierTest : public ::testing::Test {
@@ -242,6 +278,65 @@ TEST_F(MultiThreadedCertVerifierTest, CancelRequestThenQuit) {
   // Destroy |verifier| by going out of scope.
 }
 
+// Tests that successful results survive a SerializeCache()/LoadCache() round
+// trip into a new verifier, and are counted as persisted hits there.
+TEST_F(MultiThreadedCertVerifierTest, PersistCache) {
+  FilePath certs_dir = GetTestCertsDirectory();
+  scoped_refptr<X509Certificate> test_cert(
+      ImportCertFromFile(certs_dir, "ok_cert.pem"));
+  ASSERT_NE(static_cast<X509Certificate*>(NULL), test_cert);
+
+  MockDelegate delegate;
+  verifier_.SetCertVerifyProc(new MockSuccessCertVerifyProc());
+  verifier_.SetDelegate(&delegate);
+
+  int error;
+  CertVerifyResult verify_result;
+  TestCompletionCallback callback;
+  CertVerifier::RequestHandle request_handle;
+
+  error = verifier_.Verify(test_cert, "www.example.com", 0, NULL,
+                           &verify_result, callback.callback(),
+                           &request_handle, BoundNetLog());
+  ASSERT_EQ(ERR_IO_PENDING, error);
+  ASSERT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ(1, delegate.dirty_count());
+  verifier_.SetDelegate(NULL);
+
+  std::string serialized;
+  verifier_.SerializeCache(&serialized);
+
+  MultiThreadedCertVerifier restored;
+  restored.SetCertVerifyProc(new MockCertVerifyProc());
+  ASSERT_TRUE(restored.LoadCache(serialized));
+  EXPECT_EQ(1u, restored.GetCacheSize());
+
+  // The restored result is returned synchronously, without consulting the
+  // (failing) CertVerifyProc.
+  CertVerifyResult restored_result;
+  error = restored.Verify(test_cert, "www.example.com", 0, NULL,
+                          &restored_result, base::Bind(&FailTest),
+                          &request_handle, BoundNetLog());
+  EXPECT_EQ(OK, error);
+  EXPECT_TRUE(request_handle == NULL);
+  EXPECT_TRUE(restored_result.is_issued_by_known_root);
+  ASSERT_TRUE(restored_result.verified_cert != NULL);
+  EXPECT_TRUE(restored_result.verified_cert->Equals(test_cert));
+  EXPECT_EQ(1u, restored.cache_hits());
+  EXPECT_EQ(1u, restored.persisted_cache_hits());
+
+  // A different hostname is not a hit.
+  error = restored.Verify(test_cert, "www2.example.com", 0, NULL,
+                          &restored_result, callback.callback(),
+                          &request_handle, BoundNetLog());
+  ASSERT_EQ(ERR_IO_PENDING, error);
+  EXPECT_TRUE(IsCertificateError(callback.WaitForResult()));
+  EXPECT_EQ(1u, restored.persisted_cache_hits());
+
+  // Garbage is rejected.
+  EXPECT_FALSE(restored.LoadCache("garbage"));
+}
+
 TEST_F(MultiThreadedCertVerifierTest, RequestParamsComparators) {
   SHA1Fingerprint a_key;
   memset(a_key.data, 'a', sizeof(a_key.data));
@@ -262,42 +357,51 @@ TEST_F(MultiThreadedCertVerifierTest, RequestParamsComparators) {
   } tests[] = {
     {  // Test for basic equivalence.
       MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
-                                               0),
+                                               0, 0),
       MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
-                                               0),
+                                               0, 0),
       0,
     },
     {  // Test that different certificates but with the same CA and for
        // the same host are different validation keys.
       MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
-                                               0),
+                                               0, 0),
       MultiThreadedCertVerifier::RequestParams(z_key, a_key, "www.example.test",
-                                               0),
+                                               0, 0),
       -1,
     },
     {  // Test that the same EE certificate for the same host, but with
        // different chains are different validation keys.
       MultiThreadedCertVerifier::RequestParams(a_key, z_key, "www.example.test",
-                                               0),
+                                               0, 0),
       MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
-                                               0),
+                                               0, 0),
       1,
     },
     {  // The same certificate, with the same chain, but for different
        // hosts are different validation keys.
       MultiThreadedCertVerifier::RequestParams(a_key, a_key,
-                                               "www1.example.test", 0),
+                                               "www1.example.test", 0, 0),
       MultiThreadedCertVerifier::RequestParams(a_key, a_key,
-                                               "www2.example.test", 0),
+                                               "www2.example.test", 0, 0),
       -1,
     },
     {  // The same certificate, chain, and host, but with different flags
        // are different validation keys.
       MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
-                                               X509Certificate::VERIFY_EV_CERT),
-      MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
+                                               X509Certificate::VERIFY_EV_CERT,
                                                0),
+      MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
+                                               0, 0),
       1,
+    },
+    {  // The same certificate, chain, host and flags, but verified against
+       // different CRLSets are different validation keys.
+      MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
+                                               0, 1),
+      MultiThreadedCertVerifier::RequestParams(a_key, a_key, "www.example.test",
+                                               0, 2),
+      -1,
     }
   };
   for (size_t i = 0; i < ARRAYSIZE_UNSAFE(tests); ++i) {
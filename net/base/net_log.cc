@@ -4,6 +4,7 @@
 
 #include "net/base/net_log.h"
 
+#include "base/callback.h"
 #include "base/logging.h"
 #include "base/string_number_conversions.h"
 #include "base/time.h"
@@ -50,6 +51,28 @@ Value* NetLogBytesTransferredParameter::ToValue() const {
   return dict;
 }
 
+// Parameters that defer to a NetLog::ParametersCallback, so no Value is
+// built unless an observer serializes the event.
+class NetLogCallbackParameters : public NetLog::EventParameters {
+ public:
+  NetLogCallbackParameters(const NetLog::ParametersCallback& callback,
+                           NetLog::LogLevel log_level)
+      : callback_(callback),
+        log_level_(log_level) {
+  }
+
+  virtual Value* ToValue() const OVERRIDE {
+    return callback_.Run(log_level_);
+  }
+
+ protected:
+  virtual ~NetLogCallbackParameters() {}
+
+ private:
+  const NetLog::ParametersCallback callback_;
+  const NetLog::LogLevel log_level_;
+};
+
 }  // namespace
 
 Value* NetLog::Source::ToValue() const {
@@ -81,6 +104,8 @@ NetLog* NetLog::ThreadSafeObserver::net_log() const {
 
 void NetLog::AddGlobalEntry(EventType type,
                             const scoped_refptr<EventParameters>& params) {
+  if (GetLogLevel() == LOG_NONE)
+    return;
   AddEntry(type,
            Source(net::NetLog::SOURCE_NONE, this->NextID()),
            net::NetLog::PHASE_NONE,
@@ -208,10 +233,25 @@ void BoundNetLog::AddEntry(
     NetLog::EventType type,
     NetLog::EventPhase phase,
     const scoped_refptr<NetLog::EventParameters>& params) const {
-  if (net_log_)
+  if (net_log_ && net_log_->GetLogLevel() != NetLog::LOG_NONE)
     net_log_->AddEntry(type, source_, phase, params);
 }
 
+void BoundNetLog::AddEntryWithCallback(
+    NetLog::EventType type,
+    NetLog::EventPhase phase,
+    const NetLog::ParametersCallback& callback) const {
+  if (!net_log_)
+    return;
+  NetLog::LogLevel log_level = net_log_->GetLogLevel();
+  if (log_level == NetLog::LOG_NONE)
+    return;
+  scoped_refptr<NetLog::EventParameters> params;
+  if (!callback.is_null())
+    params = new NetLogCallbackParameters(callback, log_level);
+  net_log_->AddEntry(type, source_, phase, params);
+}
+
 void BoundNetLog::AddEvent(
     NetLog::EventType event_type,
     const scoped_refptr<NetLog::EventParameters>& params) const {
@@ -230,6 +270,24 @@ void BoundNetLog::EndEvent(
   AddEntry(event_type, NetLog::PHASE_END, params);
 }
 
+void BoundNetLog::AddEventWithCallback(
+    NetLog::EventType event_type,
+    const NetLog::ParametersCallback& callback) const {
+  AddEntryWithCallback(event_type, NetLog::PHASE_NONE, callback);
+}
+
+void BoundNetLog::BeginEventWithCallback(
+    NetLog::EventType event_type,
+    const NetLog::ParametersCallback& callback) const {
+  AddEntryWithCallback(event_type, NetLog::PHASE_BEGIN, callback);
+}
+
+void BoundNetLog::EndEventWithCallback(
+    NetLog::EventType event_type,
+    const NetLog::ParametersCallback& callback) const {
+  AddEntryWithCallback(event_type, NetLog::PHASE_END, callback);
+}
+
 void BoundNetLog::AddEventWithNetErrorCode(NetLog::EventType event_type,
                                            int net_error) const {
   DCHECK_GT(0, net_error);
@@ -254,8 +312,13 @@ void BoundNetLog::EndEventWithNetErrorCode(NetLog::EventType event_type,
 void BoundNetLog::AddByteTransferEvent(NetLog::EventType event_type,
                                        int byte_count,
                                        const char* bytes) const {
+  if (!net_log_)
+    return;
+  NetLog::LogLevel log_level = net_log_->GetLogLevel();
+  if (log_level == NetLog::LOG_NONE)
+    return;
   scoped_refptr<NetLog::EventParameters> params;
-  if (IsLoggingBytes()) {
+  if (log_level == NetLog::LOG_ALL) {
     params = new NetLogBytesTransferredParameter(byte_count, bytes);
   } else {
     params = new NetLogBytesTransferredParameter(byte_count, NULL);
@@ -9,6 +9,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/callback_forward.h"
 #include "base/compiler_specific.h"
 #include "base/memory/ref_counted.h"
 #include "net/base/net_export.h"
@@ -105,8 +106,18 @@ class NET_EXPORT NetLog {
 
     // Only log events which are cheap, and don't consume much memory.
     LOG_BASIC,
+
+    // Log nothing. BoundNetLog checks for this level, without taking any
+    // locks, before doing any work for an event.
+    LOG_NONE,
   };
 
+  // Builds the parameters of an event as a Value tree, given the log level
+  // the NetLog had when the event was added. It is only run if an observer
+  // actually serializes the event, and may return NULL. Observers may hold
+  // on to an event's parameters, so arguments must be bound by value.
+  typedef base::Callback<base::Value*(LogLevel)> ParametersCallback;
+
   // An observer, that must ensure its own thread safety, for events
   // being added to a NetLog.
   class NET_EXPORT ThreadSafeObserver {
@@ -276,6 +287,19 @@ class NET_EXPORT BoundNetLog {
   void EndEvent(NetLog::EventType event_type,
                 const scoped_refptr<NetLog::EventParameters>& params) const;
 
+  // Just like AddEvent, BeginEvent and EndEvent, except the parameters are
+  // produced by |callback|, which is not run unless an observer needs them.
+  // Nothing at all is allocated when the NetLog's level is LOG_NONE.
+  void AddEventWithCallback(
+      NetLog::EventType event_type,
+      const NetLog::ParametersCallback& callback) const;
+  void BeginEventWithCallback(
+      NetLog::EventType event_type,
+      const NetLog::ParametersCallback& callback) const;
+  void EndEventWithCallback(
+      NetLog::EventType event_type,
+      const NetLog::ParametersCallback& callback) const;
+
   // Just like AddEvent, except |net_error| is a net error code.  A parameter
   // called "net_error" with the indicated value will be recorded for the event.
   // |net_error| must be negative, and not ERR_IO_PENDING, as it's not a true
@@ -315,6 +339,10 @@ class NET_EXPORT BoundNetLog {
       : source_(source), net_log_(net_log) {
   }
 
+  void AddEntryWithCallback(NetLog::EventType type,
+                            NetLog::EventPhase phase,
+                            const NetLog::ParametersCallback& callback) const;
+
   NetLog::Source source_;
   NetLog* net_log_;
 };
@@ -329,6 +329,10 @@ EVENT_TYPE(WAITING_FOR_PROXY_RESOLVER_THREAD)
 //   }
 EVENT_TYPE(SUBMITTED_TO_RESOLVER_THREAD)
 
+// This event is emitted when a proxy resolve request was answered from the
+// MultiThreadedProxyResolver's result cache, without running the PAC script.
+EVENT_TYPE(PROXY_RESOLVER_CACHE_HIT)
+
 // ------------------------------------------------------------------------
 // Socket (Shared by stream and datagram sockets)
 // ------------------------------------------------------------------------
@@ -608,6 +612,15 @@ EVENT_TYPE(SOCKET_POOL_CONNECT_JOB_TIMED_OUT)
 // ------------------------------------------------------------------------
 
 // The start/end of a client socket pool request for a socket.
+//
+// If the request had to wait for a socket slot and got a socket, the END phase
+// has these parameters:
+//
+//   {
+//     "priority": <The priority of the request>,
+//     "queue_ms": <The number of milliseconds since the request first had to
+//                  wait for a socket slot>,
+//   }
 EVENT_TYPE(SOCKET_POOL)
 
 // The request stalled because there are too many sockets in the pool.
@@ -616,6 +629,13 @@ EVENT_TYPE(SOCKET_POOL_STALLED_MAX_SOCKETS)
 // The request stalled because there are too many sockets in the group.
 EVENT_TYPE(SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP)
 
+// The group's socket limit was raised because its requests had been queued
+// for too long. The event parameters are:
+//   {
+//     "extra_socket_slots": <Slots the group now has above the limit>,
+//   }
+EVENT_TYPE(SOCKET_POOL_RAISED_GROUP_LIMIT)
+
 // Indicates that we reused an existing socket. Attached to the event are
 // the parameters:
 //   {
@@ -1340,6 +1360,17 @@ EVENT_TYPE(DNS_TRANSACTION_QUERY)
 //   }
 EVENT_TYPE(DNS_TRANSACTION_ATTEMPT)
 
+// This event is created when DnsTransaction retries a query over TCP because
+// the UDP response was truncated.
+//
+// It has a single parameter:
+//
+//   {
+//     "source_dependency": <Source id of the TCP socket created for the
+//                           attempt>,
+//   }
+EVENT_TYPE(DNS_TRANSACTION_TCP_ATTEMPT)
+
 // This event is created when DnsTransaction receives a matching response.
 //
 // It has the following parameters:
@@ -2,7 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "base/bind.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/values.h"
 #include "net/base/capturing_net_log.h"
 #include "net/base/net_log.h"
 #include "net/base/net_log_unittest.h"
@@ -12,6 +14,14 @@ namespace net {
 
 namespace {
 
+base::Value* CountingParametersCallback(int* calls,
+                                        NetLog::LogLevel* log_level_seen,
+                                        NetLog::LogLevel log_level) {
+  ++*calls;
+  *log_level_seen = log_level;
+  return new base::DictionaryValue();
+}
+
 TEST(NetLog, ScopedNetLogEventTest) {
   CapturingNetLog log(CapturingNetLog::kUnbounded);
   BoundNetLog net_log(BoundNetLog::Make(&log, NetLog::SOURCE_URL_REQUEST));
@@ -30,6 +40,74 @@ TEST(NetLog, ScopedNetLogEventTest) {
   EXPECT_TRUE(LogContainsEndEvent(entries, 1, NetLog::TYPE_REQUEST_ALIVE));
 }
 
+// Parameters built by a callback are only materialized when serialized, and
+// see the log level the event was added at.
+TEST(NetLog, ParametersCallbackIsLazy) {
+  CapturingNetLog log(CapturingNetLog::kUnbounded);
+  log.SetLogLevel(NetLog::LOG_ALL);
+  BoundNetLog net_log(BoundNetLog::Make(&log, NetLog::SOURCE_URL_REQUEST));
+
+  int calls = 0;
+  NetLog::LogLevel log_level_seen = NetLog::LOG_NONE;
+  net_log.BeginEventWithCallback(
+      NetLog::TYPE_REQUEST_ALIVE,
+      base::Bind(&CountingParametersCallback, &calls, &log_level_seen));
+  net_log.EndEventWithCallback(NetLog::TYPE_REQUEST_ALIVE,
+                               NetLog::ParametersCallback());
+
+  CapturingNetLog::EntryList entries;
+  log.GetEntries(&entries);
+  ASSERT_EQ(2u, entries.size());
+  EXPECT_TRUE(LogContainsBeginEvent(entries, 0, NetLog::TYPE_REQUEST_ALIVE));
+  EXPECT_TRUE(LogContainsEndEvent(entries, 1, NetLog::TYPE_REQUEST_ALIVE));
+  EXPECT_EQ(0, calls);
+  EXPECT_FALSE(entries[1].extra_parameters.get());
+
+  ASSERT_TRUE(entries[0].extra_parameters.get());
+  scoped_ptr<base::Value> value(entries[0].extra_parameters->ToValue());
+  EXPECT_TRUE(value.get());
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(NetLog::LOG_ALL, log_level_seen);
+}
+
+// Nothing is logged, and no callbacks are run, at LOG_NONE.
+TEST(NetLog, LogLevelNone) {
+  CapturingNetLog log(CapturingNetLog::kUnbounded);
+  log.SetLogLevel(NetLog::LOG_NONE);
+  BoundNetLog net_log(BoundNetLog::Make(&log, NetLog::SOURCE_URL_REQUEST));
+  EXPECT_FALSE(net_log.IsLoggingAllEvents());
+
+  int calls = 0;
+  NetLog::LogLevel log_level_seen = NetLog::LOG_NONE;
+  net_log.AddEventWithCallback(
+      NetLog::TYPE_REQUEST_ALIVE,
+      base::Bind(&CountingParametersCallback, &calls, &log_level_seen));
+  net_log.AddEvent(NetLog::TYPE_REQUEST_ALIVE, NULL);
+  log.AddGlobalEntry(NetLog::TYPE_CANCELLED, NULL);
+
+  CapturingNetLog::EntryList entries;
+  log.GetEntries(&entries);
+  EXPECT_EQ(0u, entries.size());
+  EXPECT_EQ(0, calls);
+}
+
+// A BoundNetLog without a NetLog reports LOG_BASIC, as it always has, and
+// logs nothing.
+TEST(NetLog, NoNetLog) {
+  BoundNetLog net_log;
+  EXPECT_EQ(NetLog::LOG_BASIC, net_log.GetLogLevel());
+  EXPECT_FALSE(net_log.IsLoggingBytes());
+  EXPECT_FALSE(net_log.IsLoggingAllEvents());
+
+  int calls = 0;
+  NetLog::LogLevel log_level_seen = NetLog::LOG_NONE;
+  net_log.AddEventWithCallback(
+      NetLog::TYPE_REQUEST_ALIVE,
+      base::Bind(&CountingParametersCallback, &calls, &log_level_seen));
+  net_log.AddByteTransferEvent(NetLog::TYPE_SOCKET_BYTES_SENT, 1, "x");
+  EXPECT_EQ(0, calls);
+}
+
 }  // namespace
 
 }  // namespace net
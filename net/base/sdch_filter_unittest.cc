@@ -14,12 +14,15 @@
 #include "third_party/zlib/zlib.h"
 #endif
 
+#include "base/file_util.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/scoped_temp_dir.h"
 #include "net/base/filter.h"
 #include "net/base/io_buffer.h"
 #include "net/base/mock_filter_context.h"
 #include "net/base/sdch_filter.h"
+#include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_http_job.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -1395,4 +1398,145 @@ TEST_F(SdchFilterTest, LatencyTestControls) {
   EXPECT_FALSE(sdch_manager_->AllowLatencyExperiment(url2));
 }
 
+// Accepts the dictionaries the SdchManager asks it to fetch, without fetching.
+class NullSdchFetcher : public SdchFetcher {
+ public:
+  NullSdchFetcher() {}
+
+  virtual void Schedule(const GURL& dictionary_url) OVERRIDE {}
+};
+
+// Records the dictionaries the SdchManager asks it to save.  Only saves
+// dictionaries fetched for |saved_context|.
+class RecordingDictionaryStore : public SdchDictionaryStore {
+ public:
+  explicit RecordingDictionaryStore(const URLRequestContext* saved_context)
+      : saved_context_(saved_context) {
+  }
+
+  virtual bool CanSaveDictionariesFor(
+      const URLRequestContext* context) OVERRIDE {
+    return context == saved_context_;
+  }
+
+  virtual void SaveDictionary(const std::string& dictionary_text,
+                              const GURL& dictionary_url,
+                              const std::string& server_hash,
+                              const base::Time& expiration) OVERRIDE {
+    texts_.push_back(dictionary_text);
+    server_hashes_.push_back(server_hash);
+  }
+
+  virtual void DeleteSavedDictionaries() OVERRIDE {
+    texts_.clear();
+    server_hashes_.clear();
+  }
+
+  const std::vector<std::string>& texts() const { return texts_; }
+  const std::vector<std::string>& server_hashes() const {
+    return server_hashes_;
+  }
+
+ private:
+  const URLRequestContext* saved_context_;
+  std::vector<std::string> texts_;
+  std::vector<std::string> server_hashes_;
+};
+
+TEST_F(SdchFilterTest, DictionaryStoreSavesAddedDictionaries) {
+  const std::string kSampleDomain = "sdchtest.com";
+  std::string dictionary(NewSdchDictionary(kSampleDomain));
+  GURL url("http://" + kSampleDomain);
+
+  URLRequestContext context;
+  RecordingDictionaryStore store(&context);
+  sdch_manager_->set_sdch_fetcher(new NullSdchFetcher);
+  sdch_manager_->set_dictionary_store(&store);
+  sdch_manager_->FetchDictionary(url, url, &context);
+  EXPECT_TRUE(sdch_manager_->AddSdchDictionary(dictionary, url));
+  // Dictionaries that are refused are not saved.
+  EXPECT_FALSE(sdch_manager_->AddSdchDictionary(dictionary, url));
+  sdch_manager_->set_dictionary_store(NULL);
+  sdch_manager_->set_sdch_fetcher(NULL);
+
+  std::string client_hash, server_hash;
+  SdchManager::GenerateHash(dictionary, &client_hash, &server_hash);
+  ASSERT_EQ(1U, store.texts().size());
+  EXPECT_EQ(dictionary, store.texts()[0]);
+  EXPECT_EQ(server_hash, store.server_hashes()[0]);
+}
+
+TEST_F(SdchFilterTest, DictionaryStoreSkipsOtherContexts) {
+  const std::string kSampleDomain = "sdchtest.com";
+  std::string dictionary(NewSdchDictionary(kSampleDomain));
+  GURL url("http://" + kSampleDomain);
+
+  // A dictionary fetched for a context the store doesn't save for, such as an
+  // off the record one, is added but not saved.
+  URLRequestContext saved_context;
+  URLRequestContext other_context;
+  RecordingDictionaryStore store(&saved_context);
+  sdch_manager_->set_sdch_fetcher(new NullSdchFetcher);
+  sdch_manager_->set_dictionary_store(&store);
+  sdch_manager_->FetchDictionary(url, url, &other_context);
+  EXPECT_TRUE(sdch_manager_->AddSdchDictionary(dictionary, url));
+  sdch_manager_->set_dictionary_store(NULL);
+  sdch_manager_->set_sdch_fetcher(NULL);
+
+  EXPECT_TRUE(store.texts().empty());
+  std::string client_hash, server_hash;
+  SdchManager::GenerateHash(dictionary, &client_hash, &server_hash);
+  std::string list;
+  sdch_manager_->GetAvailDictionaryList(url, &list);
+  EXPECT_EQ(client_hash, list);
+}
+
+TEST_F(SdchFilterTest, PersistedDictionary) {
+  const std::string kSampleDomain = "sdchtest.com";
+  std::string dictionary(NewSdchDictionary(kSampleDomain));
+  GURL url("http://" + kSampleDomain);
+
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("dictionary");
+  ASSERT_EQ(static_cast<int>(dictionary.size()),
+            file_util::WriteFile(path, dictionary.data(), dictionary.size()));
+  std::string client_hash, server_hash;
+  SdchManager::GenerateHash(dictionary, &client_hash, &server_hash);
+
+  // An expired dictionary is refused.
+  scoped_ptr<file_util::MemoryMappedFile> mapped_file(
+      new file_util::MemoryMappedFile);
+  ASSERT_TRUE(mapped_file->Initialize(path));
+  EXPECT_FALSE(sdch_manager_->AddPersistedSdchDictionary(
+      mapped_file.release(), url, client_hash, server_hash,
+      base::Time::Now() - base::TimeDelta::FromDays(1)));
+
+  RecordingDictionaryStore store(NULL);
+  sdch_manager_->set_dictionary_store(&store);
+  mapped_file.reset(new file_util::MemoryMappedFile);
+  ASSERT_TRUE(mapped_file->Initialize(path));
+  EXPECT_TRUE(sdch_manager_->AddPersistedSdchDictionary(
+      mapped_file.release(), url, client_hash, server_hash,
+      base::Time::Now() + base::TimeDelta::FromDays(1)));
+  sdch_manager_->set_dictionary_store(NULL);
+  // It was already saved.
+  EXPECT_TRUE(store.texts().empty());
+
+  std::string list;
+  sdch_manager_->GetAvailDictionaryList(url, &list);
+  EXPECT_EQ(client_hash, list);
+
+  // The mapped dictionary decodes like a fetched one.
+  std::vector<Filter::FilterType> filter_types;
+  filter_types.push_back(Filter::FILTER_TYPE_SDCH);
+  MockFilterContext filter_context;
+  filter_context.SetURL(url);
+  scoped_ptr<Filter> filter(Filter::Factory(filter_types, filter_context));
+  std::string output;
+  EXPECT_TRUE(FilterTestData(NewSdchCompressedData(dictionary), 100, 100,
+                             filter.get(), &output));
+  EXPECT_EQ(expanded_, output);
+}
+
 }  // namespace net
@@ -5,6 +5,7 @@
 #include "net/base/sdch_manager.h"
 
 #include "base/base64.h"
+#include "base/file_util.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "base/string_number_conversions.h"
@@ -29,21 +30,29 @@ SdchManager* SdchManager::global_ = NULL;
 bool SdchManager::g_sdch_enabled_ = true;
 
 //------------------------------------------------------------------------------
-SdchManager::Dictionary::Dictionary(const std::string& dictionary_text,
+SdchManager::Dictionary::Dictionary(const base::StringPiece& dictionary_text,
                                     size_t offset,
+                                    file_util::MemoryMappedFile* mapped_file,
                                     const std::string& client_hash,
                                     const GURL& gurl,
                                     const std::string& domain,
                                     const std::string& path,
                                     const base::Time& expiration,
                                     const std::set<int>& ports)
-    : text_(dictionary_text, offset),
+    : mapped_file_(mapped_file),
       client_hash_(client_hash),
       url_(gurl),
       domain_(domain),
       path_(path),
       expiration_(expiration),
       ports_(ports) {
+  base::StringPiece text = dictionary_text.substr(offset);
+  if (mapped_file_.get()) {
+    text_ = text;
+  } else {
+    text.CopyToString(&owned_text_);
+    text_ = owned_text_;
+  }
 }
 
 SdchManager::Dictionary::~Dictionary() {
@@ -204,7 +213,9 @@ bool SdchManager::Dictionary::DomainMatch(const GURL& gurl,
 }
 
 //------------------------------------------------------------------------------
-SdchManager::SdchManager() {
+SdchManager::SdchManager()
+    : dictionary_store_(NULL),
+      first_request_recorded_(false) {
   DCHECK(!global_);
   DCHECK(CalledOnValidThread());
   global_ = this;
@@ -244,6 +255,12 @@ void SdchManager::set_sdch_fetcher(SdchFetcher* fetcher) {
   fetcher_.reset(fetcher);
 }
 
+void SdchManager::set_dictionary_store(SdchDictionaryStore* store) {
+  DCHECK(CalledOnValidThread());
+  dictionary_store_ = store;
+  dictionary_urls_to_save_.clear();
+}
+
 // static
 void SdchManager::EnableSdchSupport(bool enabled) {
   g_sdch_enabled_ = enabled;
@@ -330,11 +347,15 @@ bool SdchManager::IsInSupportedDomain(const GURL& url) {
 }
 
 void SdchManager::FetchDictionary(const GURL& request_url,
-                                  const GURL& dictionary_url) {
+                                  const GURL& dictionary_url,
+                                  const URLRequestContext* context) {
   DCHECK(CalledOnValidThread());
   if (SdchManager::Global()->CanFetchDictionary(request_url, dictionary_url) &&
-      fetcher_.get())
+      fetcher_.get()) {
+    if (dictionary_store_ && dictionary_store_->CanSaveDictionariesFor(context))
+      dictionary_urls_to_save_.insert(dictionary_url);
     fetcher_->Schedule(dictionary_url);
+  }
 }
 
 bool SdchManager::CanFetchDictionary(const GURL& referring_url,
@@ -376,6 +397,42 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
   std::string client_hash;
   std::string server_hash;
   GenerateHash(dictionary_text, &client_hash, &server_hash);
+  bool save = dictionary_urls_to_save_.erase(dictionary_url) > 0;
+  return AddDictionary(dictionary_text, NULL, dictionary_url, client_hash,
+                       server_hash, NULL, save);
+}
+
+bool SdchManager::AddPersistedSdchDictionary(
+    file_util::MemoryMappedFile* mapped_file,
+    const GURL& dictionary_url,
+    const std::string& client_hash,
+    const std::string& server_hash,
+    const base::Time& expiration) {
+  DCHECK(CalledOnValidThread());
+  scoped_ptr<file_util::MemoryMappedFile> file(mapped_file);
+  if (base::Time::Now() > expiration)
+    return false;
+  base::StringPiece dictionary_text(
+      reinterpret_cast<const char*>(file->data()), file->length());
+  size_t length = file->length();
+  if (!AddDictionary(dictionary_text, file.release(), dictionary_url,
+                     client_hash, server_hash, &expiration, false)) {
+    return false;
+  }
+  // The text of a mapped dictionary is paged in from the file as it is used
+  // instead of being kept on the heap.
+  UMA_HISTOGRAM_COUNTS("Sdch3.Dictionary size mapped", length);
+  return true;
+}
+
+bool SdchManager::AddDictionary(const base::StringPiece& dictionary_text,
+                                file_util::MemoryMappedFile* mapped_file,
+                                const GURL& dictionary_url,
+                                const std::string& client_hash,
+                                const std::string& server_hash,
+                                const base::Time* persisted_expiration,
+                                bool save) {
+  scoped_ptr<file_util::MemoryMappedFile> file(mapped_file);
   if (dictionaries_.find(server_hash) != dictionaries_.end()) {
     SdchErrorRecovery(DICTIONARY_ALREADY_LOADED);
     return false;  // Already loaded.
@@ -391,18 +448,18 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
   }
 
   size_t header_end = dictionary_text.find("\n\n");
-  if (std::string::npos == header_end) {
+  if (base::StringPiece::npos == header_end) {
     SdchErrorRecovery(DICTIONARY_HAS_NO_HEADER);
     return false;  // Missing header.
   }
   size_t line_start = 0;  // Start of line being parsed.
   while (1) {
     size_t line_end = dictionary_text.find('\n', line_start);
-    DCHECK(std::string::npos != line_end);
+    DCHECK(base::StringPiece::npos != line_end);
     DCHECK_LE(line_end, header_end);
 
     size_t colon_index = dictionary_text.find(':', line_start);
-    if (std::string::npos == colon_index) {
+    if (base::StringPiece::npos == colon_index) {
       SdchErrorRecovery(DICTIONARY_HEADER_LINE_MISSING_COLON);
       return false;  // Illegal line missing a colon.
     }
@@ -412,11 +469,13 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
 
     size_t value_start = dictionary_text.find_first_not_of(" \t",
                                                            colon_index + 1);
-    if (std::string::npos != value_start) {
+    if (base::StringPiece::npos != value_start) {
       if (value_start >= line_end)
         break;
-      std::string name(dictionary_text, line_start, colon_index - line_start);
-      std::string value(dictionary_text, value_start, line_end - value_start);
+      std::string name = dictionary_text.substr(
+          line_start, colon_index - line_start).as_string();
+      std::string value = dictionary_text.substr(
+          value_start, line_end - value_start).as_string();
       name = StringToLowerASCII(name);
       if (name == "domain") {
         domain = value;
@@ -441,6 +500,8 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
       break;
     line_start = line_end + 1;
   }
+  if (persisted_expiration)
+    expiration = *persisted_expiration;
 
   if (!Dictionary::CanSet(domain, path, ports, dictionary_url))
     return false;
@@ -462,10 +523,16 @@ bool SdchManager::AddSdchDictionary(const std::string& dictionary_text,
   DVLOG(1) << "Loaded dictionary with client hash " << client_hash
            << " and server hash " << server_hash;
   Dictionary* dictionary =
-      new Dictionary(dictionary_text, header_end + 2, client_hash,
-                     dictionary_url, domain, path, expiration, ports);
+      new Dictionary(dictionary_text, header_end + 2, file.release(),
+                     client_hash, dictionary_url, domain, path, expiration,
+                     ports);
   dictionary->AddRef();
   dictionaries_[server_hash] = dictionary;
+
+  if (save && dictionary_store_) {
+    dictionary_store_->SaveDictionary(dictionary_text.as_string(),
+                                      dictionary_url, server_hash, expiration);
+  }
   return true;
 }
 
@@ -489,6 +556,12 @@ void SdchManager::GetVcdiffDictionary(const std::string& server_hash,
 void SdchManager::GetAvailDictionaryList(const GURL& target_url,
                                          std::string* list) {
   DCHECK(CalledOnValidThread());
+  if (!first_request_recorded_) {
+    // Without saved dictionaries, none are available this early in a session.
+    first_request_recorded_ = true;
+    UMA_HISTOGRAM_COUNTS_100("Sdch3.Dictionaries available on first request",
+                             dictionaries_.size());
+  }
   int count = 0;
   for (DictionaryMap::iterator it = dictionaries_.begin();
        it != dictionaries_.end(); ++it) {
@@ -505,7 +578,7 @@ void SdchManager::GetAvailDictionaryList(const GURL& target_url,
 }
 
 // static
-void SdchManager::GenerateHash(const std::string& dictionary_text,
+void SdchManager::GenerateHash(const base::StringPiece& dictionary_text,
     std::string* client_hash, std::string* server_hash) {
   char binary_hash[32];
   crypto::SHA256HashString(dictionary_text, binary_hash, sizeof(binary_hash));
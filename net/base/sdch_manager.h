@@ -11,7 +11,8 @@
 // The SdchManager maintains a collection of memory resident dictionaries.  It
 // can find a dictionary (based on a server specification of a hash), store a
 // dictionary, and make judgements about what URLs can use, set, etc. a
-// dictionary.
+// dictionary.  Dictionaries saved by a browser in an earlier session are
+// memory-mapped rather than copied onto the heap.
 
 // These dictionaries are acquired over the net, and include a header
 // (containing metadata) as well as a VCDIFF dictionary (for use by a VCDIFF
@@ -28,13 +29,20 @@
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/string_piece.h"
 #include "base/time.h"
 #include "base/threading/non_thread_safe.h"
 #include "googleurl/src/gurl.h"
 #include "net/base/net_export.h"
 
+namespace file_util {
+class MemoryMappedFile;
+}
+
 namespace net {
 
+class URLRequestContext;
+
 //------------------------------------------------------------------------------
 // Create a public interface to help us load SDCH dictionaries.
 // The SdchManager class allows registration to support this interface.
@@ -54,6 +62,36 @@ class SdchFetcher {
   DISALLOW_COPY_AND_ASSIGN(SdchFetcher);
 };
 
+//------------------------------------------------------------------------------
+// A browser may also register a store that keeps dictionaries across restarts,
+// so that SDCH is available from the first page loads of a session.  At
+// startup the store hands saved dictionaries back with
+// AddPersistedSdchDictionary().
+class SdchDictionaryStore {
+ public:
+  SdchDictionaryStore() {}
+  virtual ~SdchDictionaryStore() {}
+
+  // Returns true if dictionaries fetched for requests made in |context| may be
+  // saved.  A store should refuse contexts whose browsing must not be written
+  // to disk, such as off the record ones.
+  virtual bool CanSaveDictionariesFor(const URLRequestContext* context) = 0;
+
+  // Called when a dictionary fetched from |dictionary_url| has been added.
+  // |dictionary_text| includes the metadata headers, and the dictionary is
+  // identified by |server_hash|.  It can't be used after |expiration|.
+  virtual void SaveDictionary(const std::string& dictionary_text,
+                              const GURL& dictionary_url,
+                              const std::string& server_hash,
+                              const base::Time& expiration) = 0;
+
+  // Deletes every saved dictionary, as when the user clears their browsing
+  // data.  Dictionaries already added to the SdchManager are kept.
+  virtual void DeleteSavedDictionaries() = 0;
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SdchDictionaryStore);
+};
+
 //------------------------------------------------------------------------------
 
 class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
@@ -166,7 +204,7 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
   class NET_EXPORT_PRIVATE Dictionary : public base::RefCounted<Dictionary> {
    public:
     // Sdch filters can get our text to use in decoding compressed data.
-    const std::string& text() const { return text_; }
+    const base::StringPiece& text() const { return text_; }
 
    private:
     friend class base::RefCounted<Dictionary>;
@@ -176,8 +214,11 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
     // Construct a vc-diff usable dictionary from the dictionary_text starting
     // at the given offset.  The supplied client_hash should be used to
     // advertise the dictionary's availability relative to the suppplied URL.
-    Dictionary(const std::string& dictionary_text,
+    // If |mapped_file| is not NULL it holds |dictionary_text|, and is taken
+    // over, otherwise the text is copied.
+    Dictionary(const base::StringPiece& dictionary_text,
                size_t offset,
+               file_util::MemoryMappedFile* mapped_file,
                const std::string& client_hash,
                const GURL& url,
                const std::string& domain,
@@ -210,8 +251,15 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
     static bool DomainMatch(const GURL& url, const std::string& restriction);
 
 
-    // The actual text of the dictionary.
-    std::string text_;
+    // The actual text of the dictionary, in either |mapped_file_| or
+    // |owned_text_|.
+    base::StringPiece text_;
+
+    // Holds the text of a dictionary loaded from disk.
+    scoped_ptr<file_util::MemoryMappedFile> mapped_file_;
+
+    // Holds the text of a dictionary fetched in this session.
+    std::string owned_text_;
 
     // Part of the hash of text_ that the client uses to advertise the fact that
     // it has a specific dictionary pre-cached.
@@ -247,6 +295,11 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
   // Register a fetcher that this class can use to obtain dictionaries.
   void set_sdch_fetcher(SdchFetcher* fetcher);
 
+  // Register a store to save the dictionaries added from now on.  The store is
+  // not owned, and must be unregistered by setting NULL before it is deleted.
+  void set_dictionary_store(SdchDictionaryStore* store);
+  SdchDictionaryStore* dictionary_store() const { return dictionary_store_; }
+
   // Enables or disables SDCH compression.
   static void EnableSdchSupport(bool enabled);
 
@@ -287,8 +340,11 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
   // Schedule the URL fetching to load a dictionary. This will always return
   // before the dictionary is actually loaded and added.
   // After the implied task does completes, the dictionary will have been
-  // cached in memory.
-  void FetchDictionary(const GURL& request_url, const GURL& dictionary_url);
+  // cached in memory.  It is also saved by the dictionary store, if there is
+  // one and it can save dictionaries for |context|, the context of the request
+  // that asked for the dictionary.
+  void FetchDictionary(const GURL& request_url, const GURL& dictionary_url,
+                       const URLRequestContext* context);
 
   // Security test function used before initiating a FetchDictionary.
   // Return true if fetch is legal.
@@ -298,9 +354,21 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
   // Add an SDCH dictionary to our list of availible dictionaries. This addition
   // will fail (return false) if addition is illegal (data in the dictionary is
   // not acceptable from the dictionary_url; dictionary already added, etc.).
+  // Only dictionaries requested through FetchDictionary() may be saved.
   bool AddSdchDictionary(const std::string& dictionary_text,
                          const GURL& dictionary_url);
 
+  // Add a dictionary saved by the SdchDictionaryStore in an earlier session.
+  // |mapped_file| holds the dictionary text, as passed to SaveDictionary(), and
+  // is taken over.  The hashes were computed from it with GenerateHash(), and
+  // |expiration| is the one the dictionary was saved with.  Fails for the same
+  // reasons as AddSdchDictionary(), or if the dictionary has expired.
+  bool AddPersistedSdchDictionary(file_util::MemoryMappedFile* mapped_file,
+                                  const GURL& dictionary_url,
+                                  const std::string& client_hash,
+                                  const std::string& server_hash,
+                                  const base::Time& expiration);
+
   // Find the vcdiff dictionary (the body of the sdch dictionary that appears
   // after the meta-data headers like Domain:...) with the given |server_hash|
   // to use to decompreses data that arrived as SDCH encoded content.  Check to
@@ -321,7 +389,7 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
   // Construct the pair of hashes for client and server to identify an SDCH
   // dictionary.  This is only made public to facilitate unit testing, but is
   // otherwise private
-  static void GenerateHash(const std::string& dictionary_text,
+  static void GenerateHash(const base::StringPiece& dictionary_text,
                            std::string* client_hash, std::string* server_hash);
 
   // For Latency testing only, we need to know if we've succeeded in doing a
@@ -348,11 +416,33 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
   // A simple implementation of a RFC 3548 "URL safe" base64 encoder.
   static void UrlSafeBase64Encode(const std::string& input,
                                   std::string* output);
+
+  // Parses the metadata headers of |dictionary_text| and adds it.  If
+  // |persisted_expiration| is not NULL it is used instead of the max-age
+  // header.  |mapped_file|, which may be NULL, holds |dictionary_text| and is
+  // taken over.  The dictionary is handed to the dictionary store if |save|.
+  bool AddDictionary(const base::StringPiece& dictionary_text,
+                     file_util::MemoryMappedFile* mapped_file,
+                     const GURL& dictionary_url,
+                     const std::string& client_hash,
+                     const std::string& server_hash,
+                     const base::Time* persisted_expiration,
+                     bool save);
+
   DictionaryMap dictionaries_;
 
   // An instance that can fetch a dictionary given a URL.
   scoped_ptr<SdchFetcher> fetcher_;
 
+  // Saves dictionaries for later sessions, if registered.  Not owned.
+  SdchDictionaryStore* dictionary_store_;
+
+  // The URLs of dictionaries being fetched that the store can save.
+  std::set<GURL> dictionary_urls_to_save_;
+
+  // Whether availability on the first request of the session was recorded.
+  bool first_request_recorded_;
+
   // List domains where decode failures have required disabling sdch, along with
   // count of how many additonal uses should be blacklisted.
   DomainCounter blacklisted_domains_;
@@ -14,7 +14,6 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include "net/base/net_errors.h"
 #endif
 
 #include "base/eintr_wrapper.h"
@@ -24,6 +23,8 @@
 #include "base/sys_byteorder.h"
 #include "base/threading/platform_thread.h"
 #include "build/build_config.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
 #include "net/base/net_util.h"
 
 using std::string;
@@ -115,6 +116,21 @@ void StreamListenSocket::Send(const string& str, bool append_linefeed) {
   Send(str.data(), static_cast<int>(str.length()), append_linefeed);
 }
 
+int StreamListenSocket::GetLocalAddress(IPEndPoint* address) {
+  SockaddrStorage storage;
+  if (getsockname(socket_, storage.addr, &storage.addr_len)) {
+#if defined(OS_WIN)
+    int err = WSAGetLastError();
+#else
+    int err = errno;
+#endif
+    return MapSystemError(err);
+  }
+  if (!address->FromSockAddr(storage.addr, storage.addr_len))
+    return ERR_FAILED;
+  return OK;
+}
+
 SOCKET StreamListenSocket::AcceptSocket() {
   SOCKET conn = HANDLE_EINTR(accept(socket_, NULL, NULL));
   if (conn == kInvalidSocket)
@@ -364,8 +380,16 @@ void StreamListenSocket::SendData() {
   if (!send_buffers_.empty()) {
     DCHECK(!send_timer_.IsRunning());
     send_timer_.Start(FROM_HERE, send_backoff_.GetTimeUntilRelease(),
-                      this, &StreamListenSocket::SendData);
+                      this, &StreamListenSocket::OnSendTimer);
   }
 }
 
+void StreamListenSocket::OnSendTimer() {
+  SendData();
+  // Only ever called from a task, so the delegate is never re-entered from
+  // inside its own Send() call.
+  if (send_buffers_.empty() && !send_error_)
+    socket_delegate_->DidDrainSendBuffer(this);
+}
+
 }  // namespace net
@@ -46,6 +46,8 @@ typedef int SOCKET;
 
 namespace net {
 
+class IPEndPoint;
+
 class NET_EXPORT StreamListenSocket
     : public base::RefCountedThreadSafe<StreamListenSocket>,
 #if defined(OS_WIN)
@@ -71,12 +73,23 @@ class NET_EXPORT StreamListenSocket
                          const char* data,
                          int len) = 0;
     virtual void DidClose(StreamListenSocket* sock) = 0;
+    // Called once data that could not be sent immediately has all been
+    // written to |connection|.  Always called from a task of its own, never
+    // from within Send().
+    virtual void DidDrainSendBuffer(StreamListenSocket* connection) {}
   };
 
   // Send data to the socket.
   void Send(const char* bytes, int len, bool append_linefeed = false);
   void Send(const std::string& str, bool append_linefeed = false);
 
+  // The number of bytes queued by Send() that have not yet been written to the
+  // socket.
+  int send_pending_size() const { return send_pending_size_; }
+
+  // Copies the local address to |address|. Returns a network error code.
+  int GetLocalAddress(IPEndPoint* address);
+
  protected:
   enum WaitState {
     NOT_WAITING      = 0,
@@ -112,6 +125,9 @@ class NET_EXPORT StreamListenSocket
   void SendData();
   void SendInternal(const char* bytes, int len);
 
+  // Retries sending queued data once |send_timer_| fires.
+  void OnSendTimer();
+
 #if defined(OS_WIN)
   // ObjectWatcher delegate.
   virtual void OnObjectSignaled(HANDLE object);
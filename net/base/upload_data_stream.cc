@@ -4,15 +4,105 @@
 
 #include "net/base/upload_data_stream.h"
 
+#include <algorithm>
+
+#include "base/bind.h"
 #include "base/file_util.h"
+#include "base/location.h"
 #include "base/logging.h"
+#include "base/platform_file.h"
 #include "base/threading/thread_restrictions.h"
+#include "base/threading/worker_pool.h"
 #include "net/base/file_stream.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 
 namespace net {
 
+namespace {
+
+// The size of each read of a file element on the worker thread.
+const int kFileReadBufferSize = 1 << 16;  // 64KB
+
+// The number of buffers read ahead of Read() for asynchronous file reads.
+const size_t kNumReadAheadBuffers = 2;
+
+}  // namespace
+
+// Reads the data of one TYPE_FILE element, a buffer at a time, on worker
+// threads. Only one Read() runs at a time.
+class UploadDataStream::FileReader
+    : public base::RefCountedThreadSafe<UploadDataStream::FileReader> {
+ public:
+  FileReader(const FilePath& path, uint64 offset, uint64 length)
+      : path_(path),
+        file_(base::kInvalidPlatformFileValue),
+        opened_(false),
+        next_offset_(offset),
+        bytes_remaining_(length) {
+  }
+
+  // The number of bytes not yet reserved. Used on the origin thread only.
+  uint64 bytes_remaining() const { return bytes_remaining_; }
+
+  // Returns the size of the next read, of up to |max_bytes|, and counts it
+  // as read. Called on the origin thread.
+  int Reserve(int max_bytes) {
+    int bytes = static_cast<int>(
+        std::min(bytes_remaining_, static_cast<uint64>(max_bytes)));
+    bytes_remaining_ -= bytes;
+    return bytes;
+  }
+
+  // Fills |buf| with the next buffer->size() bytes of the file. Runs on a
+  // worker thread. Like UploadData::Element::ReadSync(), pads with zeros if
+  // the file is shorter than when its length was taken.
+  void Read(const scoped_refptr<IOBufferWithSize>& buf) {
+    if (!opened_) {
+      opened_ = true;
+      file_ = base::CreatePlatformFile(
+          path_, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ,
+          NULL, NULL);
+    }
+    int bytes_read = 0;
+    while (file_ != base::kInvalidPlatformFileValue &&
+           bytes_read < buf->size()) {
+      int rv = base::ReadPlatformFile(file_, next_offset_,
+                                      buf->data() + bytes_read,
+                                      buf->size() - bytes_read);
+      if (rv <= 0)
+        break;
+      bytes_read += rv;
+      next_offset_ += rv;
+    }
+    if (bytes_read < buf->size())
+      memset(buf->data() + bytes_read, 0, buf->size() - bytes_read);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<FileReader>;
+
+  ~FileReader() {
+    if (file_ != base::kInvalidPlatformFileValue) {
+      // The last reference may be dropped on the IO thread.
+      base::ThreadRestrictions::ScopedAllowIO allow_io;
+      base::ClosePlatformFile(file_);
+    }
+  }
+
+  const FilePath path_;
+
+  // Used on worker threads only.
+  base::PlatformFile file_;
+  bool opened_;
+  uint64 next_offset_;
+
+  // Used on the origin thread only.
+  uint64 bytes_remaining_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileReader);
+};
+
 bool UploadDataStream::merge_chunks_ = true;
 
 UploadDataStream::UploadDataStream(UploadData* upload_data)
@@ -20,7 +110,12 @@ UploadDataStream::UploadDataStream(UploadData* upload_data)
       element_index_(0),
       total_size_(0),
       current_position_(0),
-      initialized_successfully_(false) {
+      initialized_successfully_(false),
+      async_file_reads_(false),
+      async_read_callback_(NULL),
+      file_read_in_flight_(false),
+      waiting_for_file_data_(false),
+      ALLOW_THIS_IN_INITIALIZER_LIST(weak_ptr_factory_(this)) {
 }
 
 UploadDataStream::~UploadDataStream() {
@@ -67,9 +162,31 @@ int UploadDataStream::Read(IOBuffer* buf, int buf_len) {
   std::vector<UploadData::Element>& elements = *upload_data_->elements();
 
   int bytes_copied = 0;
+  bool waiting_for_file_data = false;
   while (bytes_copied < buf_len && element_index_ < elements.size()) {
     UploadData::Element& element = elements[element_index_];
 
+    if (async_file_reads_ && element.type() == UploadData::TYPE_FILE) {
+      if (!file_reader_)
+        MaybeStartFileRead();
+      if (!IsFileElementDone()) {
+        const int rv = ReadFileAsync(buf->data() + bytes_copied,
+                                     buf_len - bytes_copied);
+        if (rv == ERR_IO_PENDING) {
+          waiting_for_file_data = true;
+          break;
+        }
+        bytes_copied += rv;
+      }
+      if (IsFileElementDone()) {
+        file_reader_ = NULL;
+        ++element_index_;
+        // Start reading ahead the next element if it is a file too.
+        MaybeStartFileRead();
+      }
+      continue;
+    }
+
     bytes_copied += element.ReadSync(buf->data() + bytes_copied,
                                      buf_len - bytes_copied);
 
@@ -84,9 +201,25 @@ int UploadDataStream::Read(IOBuffer* buf, int buf_len) {
   if (is_chunked() && !IsEOF() && bytes_copied == 0)
     return ERR_IO_PENDING;
 
+  if (waiting_for_file_data && bytes_copied == 0) {
+    waiting_for_file_data_ = true;
+    return ERR_IO_PENDING;
+  }
+
   return bytes_copied;
 }
 
+void UploadDataStream::EnableAsyncFileReads(ChunkCallback* callback) {
+  DCHECK(initialized_successfully_);
+  DCHECK(callback);
+  DCHECK_EQ(0U, current_position_);
+
+  async_file_reads_ = true;
+  async_read_callback_ = callback;
+  // Get the first file data ready while the request headers are sent.
+  MaybeStartFileRead();
+}
+
 bool UploadDataStream::IsEOF() const {
   const std::vector<UploadData::Element>& elements = *upload_data_->elements();
 
@@ -108,4 +241,71 @@ bool UploadDataStream::IsInMemory() const {
   return upload_data_->IsInMemory();
 }
 
+bool UploadDataStream::IsFileElementDone() const {
+  return file_reader_ && file_reader_->bytes_remaining() == 0 &&
+      !file_read_in_flight_ && read_ahead_.empty();
+}
+
+int UploadDataStream::ReadFileAsync(char* buf, int buf_len) {
+  if (read_ahead_.empty()) {
+    MaybeStartFileRead();
+    return ERR_IO_PENDING;
+  }
+
+  DrainableIOBuffer* data = read_ahead_.front();
+  const int bytes = std::min(buf_len, data->BytesRemaining());
+  memcpy(buf, data->data(), bytes);
+  data->DidConsume(bytes);
+  if (data->BytesRemaining() == 0)
+    read_ahead_.pop_front();
+
+  MaybeStartFileRead();
+  return bytes;
+}
+
+void UploadDataStream::MaybeStartFileRead() {
+  std::vector<UploadData::Element>& elements = *upload_data_->elements();
+  if (element_index_ >= elements.size() ||
+      elements[element_index_].type() != UploadData::TYPE_FILE) {
+    return;
+  }
+
+  if (!file_reader_) {
+    UploadData::Element& element = elements[element_index_];
+    file_reader_ = new FileReader(element.file_path(),
+                                  element.file_range_offset(),
+                                  element.GetContentLength());
+  }
+
+  if (file_read_in_flight_ || file_reader_->bytes_remaining() == 0 ||
+      read_ahead_.size() >= kNumReadAheadBuffers) {
+    return;
+  }
+
+  scoped_refptr<IOBufferWithSize> buf =
+      new IOBufferWithSize(file_reader_->Reserve(kFileReadBufferSize));
+  file_read_in_flight_ = true;
+  const bool task_is_slow = true;
+  const bool posted = base::WorkerPool::PostTaskAndReply(
+      FROM_HERE,
+      base::Bind(&FileReader::Read, file_reader_, buf),
+      base::Bind(&UploadDataStream::OnFileReadCompleted,
+                 weak_ptr_factory_.GetWeakPtr(), buf),
+      task_is_slow);
+  DCHECK(posted);
+}
+
+void UploadDataStream::OnFileReadCompleted(
+    const scoped_refptr<IOBufferWithSize>& buf) {
+  file_read_in_flight_ = false;
+  read_ahead_.push_back(new DrainableIOBuffer(buf, buf->size()));
+  MaybeStartFileRead();
+
+  if (waiting_for_file_data_) {
+    waiting_for_file_data_ = false;
+    // May delete |this|.
+    async_read_callback_->OnChunkAvailable();
+  }
+}
+
 }  // namespace net
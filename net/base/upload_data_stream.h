@@ -6,14 +6,19 @@
 #define NET_BASE_UPLOAD_DATA_STREAM_H_
 #pragma once
 
+#include <deque>
+
 #include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "net/base/net_export.h"
 #include "net/base/upload_data.h"
 
 namespace net {
 
+class DrainableIOBuffer;
 class FileStream;
 class IOBuffer;
+class IOBufferWithSize;
 
 class NET_EXPORT UploadDataStream {
  public:
@@ -40,10 +45,19 @@ class NET_EXPORT UploadDataStream {
   //
   // If the upload data stream is chunked (i.e. is_chunked() is true),
   // ERR_IO_PENDING is returned to indicate there is nothing to read at the
-  // moment, but more data to come at a later time. If not chunked, reads
-  // won't fail.
+  // moment, but more data to come at a later time. The same happens if
+  // EnableAsyncFileReads() was called and the data of a file has not been
+  // read yet. Otherwise reads won't fail.
   int Read(IOBuffer* buf, int buf_len);
 
+  // Makes Read() read the data of TYPE_FILE elements on a worker thread
+  // instead of the calling thread. The data is read ahead of Read() in two
+  // buffers, so that one is filled while the other is consumed. When Read()
+  // returns ERR_IO_PENDING because neither has been filled yet,
+  // |callback|->OnChunkAvailable() is invoked once one is. Must be called
+  // after Init() and before the first Read().
+  void EnableAsyncFileReads(ChunkCallback* callback);
+
   // Sets the callback to be invoked when new chunks are available to upload.
   void set_chunk_callback(ChunkCallback* callback) {
     upload_data_->set_chunk_callback(callback);
@@ -69,6 +83,21 @@ class NET_EXPORT UploadDataStream {
   static void set_merge_chunks(bool merge) { merge_chunks_ = merge; }
 
  private:
+  class FileReader;
+
+  // Returns true if all the data of the current element, which is a
+  // TYPE_FILE element read by |file_reader_|, has been read by Read().
+  bool IsFileElementDone() const;
+
+  // Copies up to |buf_len| bytes of the current file element from the data
+  // read ahead into |buf|. Returns ERR_IO_PENDING if there is none yet.
+  int ReadFileAsync(char* buf, int buf_len);
+
+  // Starts reading the next buffer of the current file element on a worker
+  // thread, unless enough has been read ahead already.
+  void MaybeStartFileRead();
+  void OnFileReadCompleted(const scoped_refptr<IOBufferWithSize>& buf);
+
   scoped_refptr<UploadData> upload_data_;
 
   // Index of the current upload element (i.e. the element currently being
@@ -83,6 +112,21 @@ class NET_EXPORT UploadDataStream {
   // True if the initialization was successful.
   bool initialized_successfully_;
 
+  // Set by EnableAsyncFileReads().
+  bool async_file_reads_;
+  ChunkCallback* async_read_callback_;
+
+  // Reads the current element on a worker thread, if it is a TYPE_FILE
+  // element and |async_file_reads_| is set.
+  scoped_refptr<FileReader> file_reader_;
+  // Data read by |file_reader_| that Read() has yet to consume, oldest first.
+  std::deque<scoped_refptr<DrainableIOBuffer> > read_ahead_;
+  bool file_read_in_flight_;
+  // True if Read() returned ERR_IO_PENDING waiting for |file_reader_|.
+  bool waiting_for_file_data_;
+
+  base::WeakPtrFactory<UploadDataStream> weak_ptr_factory_;
+
   // TODO(satish): Remove this once we have a better way to unit test POST
   // requests with chunked uploads.
   static bool merge_chunks_;
@@ -0,0 +1,164 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/upload_data.h"
+#include "net/base/upload_data_stream.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Size of the uploaded file.  Large enough to take thousands of reads, small
+// enough to write out quickly before the test.
+const int64 kFileSize = 64 * 1024 * 1024;
+
+// The size of the buffer the body is read into, as HttpStreamParser uses.
+const int kReadBufferSize = 16 * 1024;
+
+// Records the longest task run by the current message loop, which stands in
+// for the IO thread.
+class LongestTaskObserver : public MessageLoop::TaskObserver {
+ public:
+  LongestTaskObserver() {}
+  virtual ~LongestTaskObserver() {}
+
+  virtual void WillProcessTask(base::TimeTicks time_posted) OVERRIDE {
+    task_start_ = base::TimeTicks::Now();
+  }
+
+  virtual void DidProcessTask(base::TimeTicks time_posted) OVERRIDE {
+    longest_task_ =
+        std::max(longest_task_, base::TimeTicks::Now() - task_start_);
+  }
+
+  base::TimeDelta longest_task() const { return longest_task_; }
+
+ private:
+  base::TimeTicks task_start_;
+  base::TimeDelta longest_task_;
+
+  DISALLOW_COPY_AND_ASSIGN(LongestTaskObserver);
+};
+
+// Drains an UploadDataStream one buffer per task, as HttpStreamParser does
+// when each socket write completes, until the stream reaches EOF.
+class UploadReader : public ChunkCallback {
+ public:
+  explicit UploadReader(UploadDataStream* stream)
+      : stream_(stream),
+        buf_(new IOBuffer(kReadBufferSize)),
+        bytes_read_(0) {
+  }
+
+  // Reads the whole stream, running the current message loop meanwhile.
+  void ReadAll() {
+    PostRead();
+    MessageLoop::current()->Run();
+  }
+
+  int64 bytes_read() const { return bytes_read_; }
+
+  // ChunkCallback implementation:
+  virtual void OnChunkAvailable() OVERRIDE {
+    PostRead();
+  }
+
+ private:
+  void PostRead() {
+    MessageLoop::current()->PostTask(
+        FROM_HERE, base::Bind(&UploadReader::DoRead, base::Unretained(this)));
+  }
+
+  void DoRead() {
+    int rv = stream_->Read(buf_, kReadBufferSize);
+    if (rv == ERR_IO_PENDING)
+      return;  // OnChunkAvailable() will be called.
+    ASSERT_LE(0, rv);
+    bytes_read_ += rv;
+    if (stream_->IsEOF()) {
+      MessageLoop::current()->Quit();
+      return;
+    }
+    PostRead();
+  }
+
+  UploadDataStream* stream_;
+  scoped_refptr<IOBuffer> buf_;
+  int64 bytes_read_;
+
+  DISALLOW_COPY_AND_ASSIGN(UploadReader);
+};
+
+// Uploads |file_path| through an UploadDataStream, reading the file on the
+// calling thread or, if |async_file_reads|, on a worker thread, and logs the
+// throughput and the longest task run on the calling thread.
+void RunUploadTest(const char* name,
+                   const FilePath& file_path,
+                   bool async_file_reads) {
+  scoped_refptr<UploadData> upload_data(new UploadData);
+  upload_data->AppendFileRange(file_path, 0, kuint64max, base::Time());
+  UploadDataStream stream(upload_data);
+  ASSERT_EQ(OK, stream.Init());
+  ASSERT_EQ(static_cast<uint64>(kFileSize), stream.size());
+
+  UploadReader reader(&stream);
+  if (async_file_reads)
+    stream.EnableAsyncFileReads(&reader);
+
+  LongestTaskObserver task_observer;
+  MessageLoop::current()->AddTaskObserver(&task_observer);
+  PerfTimer timer;
+  reader.ReadAll();
+  double seconds = timer.Elapsed().InSecondsF();
+  MessageLoop::current()->RemoveTaskObserver(&task_observer);
+
+  EXPECT_EQ(kFileSize, reader.bytes_read());
+  LogPerfResult(base::StringPrintf("UploadDataStream_%s", name).c_str(),
+                reader.bytes_read() / seconds / (1024 * 1024), "MB/s");
+  LogPerfResult(
+      base::StringPrintf("UploadDataStream_%s_LongestTask", name).c_str(),
+      task_observer.longest_task().InMillisecondsF(), "ms");
+}
+
+}  // namespace
+
+// Compares reading a file upload on the IO thread with reading it on a worker
+// thread.  The file was just written, so it is most likely in the page cache
+// and the longest task understates what a cold disk would block for.
+TEST(UploadDataStreamPerfTest, FileUpload) {
+  MessageLoop message_loop(MessageLoop::TYPE_IO);
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath file_path = temp_dir.path().AppendASCII("upload");
+
+  const std::string chunk(1024 * 1024, 'x');
+  const int chunk_size = static_cast<int>(chunk.size());
+  ASSERT_EQ(chunk_size,
+            file_util::WriteFile(file_path, chunk.data(), chunk_size));
+  for (int64 written = chunk_size; written < kFileSize; written += chunk_size) {
+    ASSERT_EQ(chunk_size,
+              file_util::AppendToFile(file_path, chunk.data(), chunk_size));
+  }
+
+  RunUploadTest("SyncFileReads", file_path, false);
+  RunUploadTest("AsyncFileReads", file_path, true);
+}
+
+}  // namespace net
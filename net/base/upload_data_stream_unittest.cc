@@ -8,6 +8,7 @@
 
 #include "base/basictypes.h"
 #include "base/bind.h"
+#include "base/compiler_specific.h"
 #include "base/file_path.h"
 #include "base/file_util.h"
 #include "base/memory/scoped_ptr.h"
@@ -38,6 +39,33 @@ std::string ReadFromUploadDataStream(UploadDataStream* stream) {
   return data_read;
 }
 
+// Quits the current message loop when more upload data is available.
+class QuitOnDataAvailable : public ChunkCallback {
+ public:
+  virtual void OnChunkAvailable() OVERRIDE {
+    MessageLoop::current()->Quit();
+  }
+};
+
+// Like ReadFromUploadDataStream(), for a stream reading files asynchronously.
+std::string ReadFromUploadDataStreamAsync(UploadDataStream* stream,
+                                          int* num_pending_reads) {
+  std::string data_read;
+  scoped_refptr<IOBuffer> buf = new IOBuffer(kTestBufferSize);
+  *num_pending_reads = 0;
+  while (!stream->IsEOF()) {
+    const int bytes_read = stream->Read(buf, kTestBufferSize);
+    if (bytes_read == ERR_IO_PENDING) {
+      ++*num_pending_reads;
+      MessageLoop::current()->Run();
+      continue;
+    }
+    EXPECT_LE(0, bytes_read);
+    data_read.append(buf->data(), bytes_read);
+  }
+  return data_read;
+}
+
 }  // namespace
 
 class UploadDataStreamTest : public PlatformTest {
@@ -155,6 +183,67 @@ TEST_F(UploadDataStreamTest, FileChanged) {
   file_util::Delete(temp_file_path, false);
 }
 
+TEST_F(UploadDataStreamTest, AsyncFileReads) {
+  // Large enough to take several reads on the worker thread.
+  std::string file_data;
+  while (file_data.size() < 200 * 1024)
+    file_data.append(kTestData, kTestDataSize);
+
+  FilePath temp_file_path;
+  ASSERT_TRUE(file_util::CreateTemporaryFile(&temp_file_path));
+  ASSERT_EQ(static_cast<int>(file_data.size()),
+            file_util::WriteFile(temp_file_path, file_data.data(),
+                                 file_data.size()));
+
+  upload_data_->AppendBytes(kTestData, kTestDataSize);
+  upload_data_->AppendFileRange(temp_file_path, 0, kuint64max, base::Time());
+  // Part of the same file, as sliced files are uploaded.
+  upload_data_->AppendFileRange(temp_file_path, 1, 2, base::Time());
+  upload_data_->AppendBytes(kTestData, kTestDataSize);
+
+  UploadDataStream stream(upload_data_);
+  ASSERT_EQ(OK, stream.Init());
+  QuitOnDataAvailable callback;
+  stream.EnableAsyncFileReads(&callback);
+
+  int num_pending_reads = 0;
+  const std::string expected = kTestData + file_data +
+      file_data.substr(1, 2) + kTestData;
+  EXPECT_EQ(expected, ReadFromUploadDataStreamAsync(&stream,
+                                                    &num_pending_reads));
+  EXPECT_EQ(static_cast<uint64>(expected.size()), stream.position());
+  EXPECT_LE(1, num_pending_reads);
+
+  file_util::Delete(temp_file_path, false);
+}
+
+TEST_F(UploadDataStreamTest, AsyncFileReadsFileSmallerThanLength) {
+  FilePath temp_file_path;
+  ASSERT_TRUE(file_util::CreateTemporaryFile(&temp_file_path));
+  ASSERT_EQ(static_cast<int>(kTestDataSize),
+            file_util::WriteFile(temp_file_path, kTestData, kTestDataSize));
+  const uint64 kFakeSize = kTestDataSize*2;
+
+  std::vector<UploadData::Element> elements;
+  UploadData::Element element;
+  element.SetToFilePath(temp_file_path);
+  element.SetContentLength(kFakeSize);
+  elements.push_back(element);
+  upload_data_->SetElements(elements);
+
+  UploadDataStream stream(upload_data_);
+  ASSERT_EQ(OK, stream.Init());
+  QuitOnDataAvailable callback;
+  stream.EnableAsyncFileReads(&callback);
+
+  // The missing data is padded with zeros, as for synchronous reads.
+  int num_pending_reads = 0;
+  EXPECT_EQ(std::string(kTestData) + std::string(kTestDataSize, '\0'),
+            ReadFromUploadDataStreamAsync(&stream, &num_pending_reads));
+
+  file_util::Delete(temp_file_path, false);
+}
+
 TEST_F(UploadDataStreamTest, UploadDataReused) {
   FilePath temp_file_path;
   ASSERT_TRUE(file_util::CreateTemporaryFile(&temp_file_path));
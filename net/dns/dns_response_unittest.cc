@@ -243,6 +243,14 @@ TEST(DnsResponseTest, InitParse) {
   EXPECT_TRUE(parser.ReadRecord(&record));
   EXPECT_TRUE(parser.AtEnd());
   EXPECT_FALSE(parser.ReadRecord(&record));
+
+  // A response read over TCP must fit the buffer it was read into, with the
+  // extra byte to spare.
+  DnsResponse tcp_resp(sizeof(response_data) + 1);
+  memcpy(tcp_resp.io_buffer()->data(), response_data, sizeof(response_data));
+  EXPECT_FALSE(tcp_resp.InitParse(sizeof(response_data) + 1, *query));
+  EXPECT_TRUE(tcp_resp.InitParse(sizeof(response_data), *query));
+  EXPECT_EQ(2u, tcp_resp.answer_count());
 }
 
 void VerifyAddressList(const std::vector<const char*>& ip_addresses,
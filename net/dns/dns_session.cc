@@ -4,8 +4,11 @@
 
 #include "net/dns/dns_session.h"
 
+#include <algorithm>
+
 #include "base/basictypes.h"
 #include "base/bind.h"
+#include "base/logging.h"
 #include "base/time.h"
 #include "net/base/ip_endpoint.h"
 #include "net/dns/dns_config_service.h"
@@ -13,6 +16,14 @@
 
 namespace net {
 
+namespace {
+
+// Lower bound on an RTT-based timeout, so that jitter on a fast link does not
+// cause spurious retransmissions.
+const int kMinTimeoutMs = 10;
+
+}  // namespace
+
 DnsSession::DnsSession(const DnsConfig& config,
                        ClientSocketFactory* factory,
                        const RandIntCallback& rand_int_callback,
@@ -21,7 +32,8 @@ DnsSession::DnsSession(const DnsConfig& config,
       socket_factory_(factory),
       rand_callback_(base::Bind(rand_int_callback, 0, kuint16max)),
       net_log_(net_log),
-      server_index_(0) {
+      server_index_(0),
+      rtt_estimates_(config.nameservers.size()) {
 }
 
 int DnsSession::NextQueryId() const {
@@ -35,12 +47,47 @@ int DnsSession::NextFirstServerIndex() {
   return index;
 }
 
-base::TimeDelta DnsSession::NextTimeout(int attempt) {
-  // The timeout doubles every full round (each nameserver once).
-  // TODO(szym): Adapt timeout to observed RTT. http://crbug.com/110197
+base::TimeDelta DnsSession::NextTimeout(int server_index, int attempt) {
+  DCHECK_GE(server_index, 0);
+  DCHECK_LT(static_cast<size_t>(server_index), rtt_estimates_.size());
+  base::TimeDelta timeout = config_.timeout;
+  const RttEstimate& estimate = rtt_estimates_[server_index];
+  if (estimate.srtt != base::TimeDelta()) {
+    timeout = std::max(estimate.srtt + estimate.rttvar * 4,
+                       base::TimeDelta::FromMilliseconds(kMinTimeoutMs));
+    timeout = std::min(timeout, config_.timeout);
+  }
+  return timeout * (1 << (attempt / config_.nameservers.size()));
+}
+
+base::TimeDelta DnsSession::NextFinalTimeout(int attempt) {
   return config_.timeout * (1 << (attempt / config_.nameservers.size()));
 }
 
+void DnsSession::RecordRTT(int server_index, base::TimeDelta rtt) {
+  DCHECK_LT(static_cast<size_t>(server_index), rtt_estimates_.size());
+  RttEstimate& estimate = rtt_estimates_[server_index];
+  if (estimate.srtt == base::TimeDelta()) {
+    estimate.srtt = rtt;
+    estimate.rttvar = rtt / 2;
+    return;
+  }
+  base::TimeDelta deviation = estimate.srtt - rtt;
+  if (deviation < base::TimeDelta())
+    deviation = -deviation;
+  estimate.rttvar = (estimate.rttvar * 3 + deviation) / 4;
+  estimate.srtt = (estimate.srtt * 7 + rtt) / 8;
+}
+
+void DnsSession::RecordLostPacket(int server_index) {
+  DCHECK_LT(static_cast<size_t>(server_index), rtt_estimates_.size());
+  // Back off, so that a server that stopped answering is given longer before
+  // the next one is tried. Once the estimate reaches |config_.timeout| it has
+  // no further effect.
+  RttEstimate& estimate = rtt_estimates_[server_index];
+  estimate.srtt = std::min(estimate.srtt * 2, config_.timeout);
+}
+
 DnsSession::~DnsSession() {}
 
 }  // namespace net
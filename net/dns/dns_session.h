@@ -6,6 +6,8 @@
 #define NET_DNS_DNS_SESSION_H_
 #pragma once
 
+#include <vector>
+
 #include "base/memory/ref_counted.h"
 #include "base/time.h"
 #include "net/base/net_export.h"
@@ -41,8 +43,22 @@ class NET_EXPORT_PRIVATE DnsSession
   // Return the index of the first configured server to use on first attempt.
   int NextFirstServerIndex();
 
-  // Return the timeout for the next query.
-  base::TimeDelta NextTimeout(int attempt);
+  // Return the timeout for the next query. |attempt| counts from the first
+  // query sent for the current name. Until |server_index| has answered a
+  // query, this is |config().timeout|; afterwards it adapts to the server's
+  // measured round-trip time, but never exceeds |config().timeout|. Either
+  // way, the timeout doubles every full round (each nameserver once).
+  base::TimeDelta NextTimeout(int server_index, int attempt);
+
+  // The timeout for a query that will not be followed by a retransmission.
+  // Not adapted to RTT, so a slow server still gets a full chance to answer.
+  base::TimeDelta NextFinalTimeout(int attempt);
+
+  // Records that |server_index| answered a query in |rtt|.
+  void RecordRTT(int server_index, base::TimeDelta rtt);
+
+  // Records that |server_index| did not answer a query before it timed out.
+  void RecordLostPacket(int server_index);
 
  private:
   friend class base::RefCounted<DnsSession>;
@@ -56,8 +72,15 @@ class NET_EXPORT_PRIVATE DnsSession
   // Current index into |config_.nameservers| to begin resolution with.
   int server_index_;
 
-  // TODO(szym): Add current RTT estimate.
-  // TODO(szym): Add TCP connection pool to support DNS over TCP.
+  // Smoothed round-trip time and its mean deviation, per server, as in TCP
+  // (RFC 6298). A zero |srtt| means the server has not answered yet.
+  struct RttEstimate {
+    RttEstimate() {}
+    base::TimeDelta srtt;
+    base::TimeDelta rttvar;
+  };
+  std::vector<RttEstimate> rtt_estimates_;
+
   // TODO(szym): Add UDP port pool to avoid NAT table overload.
 
   DISALLOW_COPY_AND_ASSIGN(DnsSession);
@@ -4,6 +4,9 @@
 
 #include "net/dns/dns_transaction.h"
 
+#include <utility>
+#include <vector>
+
 #include "base/bind.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/scoped_vector.h"
@@ -12,13 +15,20 @@
 #include "base/test/test_timeouts.h"
 #include "net/base/big_endian.h"
 #include "net/base/dns_util.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 #include "net/dns/dns_protocol.h"
 #include "net/dns/dns_query.h"
 #include "net/dns/dns_response.h"
 #include "net/dns/dns_session.h"
 #include "net/dns/dns_test_util.h"
+#include "net/socket/client_socket_factory.h"
 #include "net/socket/socket_test_util.h"
+#include "net/socket/stream_socket.h"
+#include "net/socket/tcp_server_socket.h"
+#include "net/udp/udp_server_socket.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace net {
@@ -787,6 +797,319 @@ TEST_F(DnsTransactionTest, SyncSearchQuery) {
   EXPECT_TRUE(helper0.Run(transaction_factory_.get()));
 }
 
+// A DNS server on the loopback interface, listening for UDP and TCP on the
+// same port. Answers every A query with 127.0.0.1.
+class DnsStubServer {
+ public:
+  enum Mode {
+    MODE_ANSWER,    // Answer over UDP.
+    MODE_TRUNCATE,  // Truncated answer over UDP, full answer over TCP.
+    MODE_DROP,      // Ignore all queries.
+    MODE_HOLD,      // Answer over UDP once ReleaseHeldAnswers() is called.
+  };
+
+  DnsStubServer()
+      : mode_(MODE_ANSWER),
+        udp_socket_(NULL, NetLog::Source()),
+        tcp_socket_(NULL, NetLog::Source()),
+        udp_read_buffer_(new IOBufferWithSize(dns_protocol::kMaxUDPSize)),
+        tcp_length_buffer_(new IOBufferWithSize(sizeof(uint16))),
+        num_udp_queries_(0),
+        num_tcp_queries_(0) {
+  }
+
+  // Returns false if could not bind to a port.
+  bool Start() {
+    IPAddressNumber loopback;
+    if (!ParseIPLiteralToNumber("127.0.0.1", &loopback))
+      return false;
+    // Retry in case the port picked for UDP is already taken for TCP.
+    for (int i = 0; i < 10; ++i) {
+      udp_socket_.Close();
+      if (udp_socket_.Listen(IPEndPoint(loopback, 0)) != OK ||
+          udp_socket_.GetLocalAddress(&endpoint_) != OK) {
+        return false;
+      }
+      if (tcp_socket_.Listen(endpoint_, 1) == OK) {
+        ReadQuery();
+        AcceptConnection();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const IPEndPoint& endpoint() const { return endpoint_; }
+
+  void set_mode(Mode mode) { mode_ = mode; }
+
+  // |callback| is run whenever a UDP query arrives.
+  void set_query_callback(const base::Closure& callback) {
+    query_callback_ = callback;
+  }
+
+  // Sends the answers held in MODE_HOLD, and answers later queries at once.
+  void ReleaseHeldAnswers() {
+    mode_ = MODE_ANSWER;
+    for (size_t i = 0; i < held_answers_.size(); ++i)
+      SendResponse(held_answers_[i].first, held_answers_[i].second);
+    held_answers_.clear();
+  }
+
+  int num_udp_queries() const { return num_udp_queries_; }
+  int num_tcp_queries() const { return num_tcp_queries_; }
+
+ private:
+  // Builds the answer to |query| of |query_size| bytes.
+  static std::string MakeResponse(const char* query,
+                                  size_t query_size,
+                                  bool truncated) {
+    static const uint8 kLoopback[] = { 127, 0, 0, 1 };
+    std::string response(query, query_size);
+    dns_protocol::Header* header =
+        reinterpret_cast<dns_protocol::Header*>(&response[0]);
+    uint16 flags = dns_protocol::kFlagResponse | dns_protocol::kFlagRD |
+        dns_protocol::kFlagRA;
+    if (truncated) {
+      header->flags = base::HostToNet16(flags | dns_protocol::kFlagTC);
+      return response;
+    }
+    header->flags = base::HostToNet16(flags);
+    header->ancount = base::HostToNet16(1);
+
+    char answer[16];
+    BigEndianWriter writer(answer, sizeof(answer));
+    writer.WriteU16(
+        static_cast<uint16>(0xc000 | sizeof(dns_protocol::Header)));
+    writer.WriteU16(dns_protocol::kTypeA);
+    writer.WriteU16(dns_protocol::kClassIN);
+    writer.WriteU32(60);  // TTL
+    writer.WriteU16(sizeof(kLoopback));
+    writer.WriteBytes(kLoopback, sizeof(kLoopback));
+    response.append(answer, sizeof(answer));
+    return response;
+  }
+
+  void ReadQuery() {
+    int rv = udp_socket_.RecvFrom(
+        udp_read_buffer_, udp_read_buffer_->size(), &udp_peer_,
+        base::Bind(&DnsStubServer::OnQueryRead, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnQueryRead(rv);
+  }
+
+  void OnQueryRead(int rv) {
+    ASSERT_GT(rv, 0);
+    ++num_udp_queries_;
+    if (mode_ != MODE_DROP) {
+      std::string response = MakeResponse(udp_read_buffer_->data(), rv,
+                                          mode_ == MODE_TRUNCATE);
+      if (mode_ == MODE_HOLD)
+        held_answers_.push_back(std::make_pair(response, udp_peer_));
+      else
+        SendResponse(response, udp_peer_);
+    }
+    ReadQuery();
+    if (!query_callback_.is_null())
+      query_callback_.Run();
+  }
+
+  void SendResponse(const std::string& response, const IPEndPoint& peer) {
+    scoped_refptr<IOBuffer> buffer(new StringIOBuffer(response));
+    int rv = udp_socket_.SendTo(buffer, response.size(), peer,
+                                base::Bind(&DnsStubServer::OnResponseSent,
+                                           base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnResponseSent(rv);
+  }
+
+  void OnResponseSent(int rv) {
+    EXPECT_GT(rv, 0);
+  }
+
+  // TCP serves one connection at a time, one query per connection.
+  void AcceptConnection() {
+    int rv = tcp_socket_.Accept(
+        &connection_,
+        base::Bind(&DnsStubServer::OnAccepted, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnAccepted(rv);
+  }
+
+  void OnAccepted(int rv) {
+    ASSERT_EQ(OK, rv);
+    tcp_buffer_ = new DrainableIOBuffer(tcp_length_buffer_,
+                                        tcp_length_buffer_->size());
+    tcp_query_.clear();
+    ReadTCP();
+  }
+
+  void ReadTCP() {
+    int rv = connection_->Read(
+        tcp_buffer_, tcp_buffer_->BytesRemaining(),
+        base::Bind(&DnsStubServer::OnTCPRead, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnTCPRead(rv);
+  }
+
+  void OnTCPRead(int rv) {
+    ASSERT_GT(rv, 0);
+    tcp_buffer_->DidConsume(rv);
+    if (tcp_buffer_->BytesRemaining() > 0) {
+      ReadTCP();
+      return;
+    }
+    if (tcp_query_.empty()) {
+      uint16 length;
+      ReadBigEndian<uint16>(tcp_length_buffer_->data(), &length);
+      tcp_query_.resize(length);
+      tcp_buffer_ = new DrainableIOBuffer(new WrappedIOBuffer(&tcp_query_[0]),
+                                          length);
+      ReadTCP();
+      return;
+    }
+    ++num_tcp_queries_;
+    std::string response = MakeResponse(tcp_query_.data(), tcp_query_.size(),
+                                        false);
+    std::string message(sizeof(uint16), '\0');
+    WriteBigEndian<uint16>(&message[0], response.size());
+    message.append(response);
+    tcp_buffer_ = new DrainableIOBuffer(new StringIOBuffer(message),
+                                        message.size());
+    WriteTCP();
+  }
+
+  void WriteTCP() {
+    int rv = connection_->Write(
+        tcp_buffer_, tcp_buffer_->BytesRemaining(),
+        base::Bind(&DnsStubServer::OnTCPWritten, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnTCPWritten(rv);
+  }
+
+  void OnTCPWritten(int rv) {
+    ASSERT_GT(rv, 0);
+    tcp_buffer_->DidConsume(rv);
+    if (tcp_buffer_->BytesRemaining() > 0) {
+      WriteTCP();
+      return;
+    }
+    connection_->Disconnect();
+    connection_.reset();
+    AcceptConnection();
+  }
+
+  Mode mode_;
+  base::Closure query_callback_;
+  std::vector<std::pair<std::string, IPEndPoint> > held_answers_;
+  IPEndPoint endpoint_;
+
+  UDPServerSocket udp_socket_;
+  TCPServerSocket tcp_socket_;
+
+  scoped_refptr<IOBufferWithSize> udp_read_buffer_;
+  IPEndPoint udp_peer_;
+
+  scoped_ptr<StreamSocket> connection_;
+  scoped_refptr<IOBufferWithSize> tcp_length_buffer_;
+  scoped_refptr<DrainableIOBuffer> tcp_buffer_;
+  std::string tcp_query_;
+
+  int num_udp_queries_;
+  int num_tcp_queries_;
+
+  DISALLOW_COPY_AND_ASSIGN(DnsStubServer);
+};
+
+// Runs DnsTransactions over real sockets against DnsStubServers.
+class DnsTransactionStubServerTest : public testing::Test {
+ protected:
+  // Starts |num_servers| servers and configures a session to use them.
+  void StartServers(unsigned num_servers, base::TimeDelta timeout) {
+    config_.nameservers.clear();
+    for (unsigned i = 0; i < num_servers; ++i) {
+      DnsStubServer* server = new DnsStubServer();
+      servers_.push_back(server);
+      ASSERT_TRUE(server->Start());
+      config_.nameservers.push_back(server->endpoint());
+    }
+    config_.timeout = timeout;
+    session_ = new DnsSession(config_,
+                              ClientSocketFactory::GetDefaultFactory(),
+                              base::Bind(&base::RandInt),
+                              NULL /* NetLog */);
+    transaction_factory_ = DnsTransactionFactory::CreateFactory(session_.get());
+  }
+
+  DnsConfig config_;
+  ScopedVector<DnsStubServer> servers_;
+  scoped_refptr<DnsSession> session_;
+  scoped_ptr<DnsTransactionFactory> transaction_factory_;
+};
+
+TEST_F(DnsTransactionStubServerTest, Lookup) {
+  config_.attempts = 1;
+  StartServers(1, TestTimeouts::action_timeout());
+
+  TransactionHelper helper0(kT0HostName, dns_protocol::kTypeA, 1);
+  EXPECT_TRUE(helper0.RunUntilDone(transaction_factory_.get()));
+  EXPECT_EQ(1, servers_[0]->num_udp_queries());
+  EXPECT_EQ(0, servers_[0]->num_tcp_queries());
+}
+
+TEST_F(DnsTransactionStubServerTest, TruncatedFallsBackToTCP) {
+  config_.attempts = 1;
+  StartServers(1, TestTimeouts::action_timeout());
+  servers_[0]->set_mode(DnsStubServer::MODE_TRUNCATE);
+
+  TransactionHelper helper0(kT0HostName, dns_protocol::kTypeA, 1);
+  EXPECT_TRUE(helper0.RunUntilDone(transaction_factory_.get()));
+  EXPECT_EQ(1, servers_[0]->num_udp_queries());
+  EXPECT_EQ(1, servers_[0]->num_tcp_queries());
+}
+
+// A late answer to an attempt that timed out is still accepted while the
+// next server is being tried.  The first server only answers once the second
+// one has been queried, so nothing depends on how long anything takes.
+TEST_F(DnsTransactionStubServerTest, SlowServerRacesNextServer) {
+  config_.attempts = 1;
+  StartServers(2, TestTimeouts::action_timeout());
+  // A tiny RTT estimate makes the first attempt time out after the minimum
+  // retransmission timeout rather than |config_.timeout|.
+  session_->RecordRTT(0, base::TimeDelta::FromMicroseconds(1));
+  servers_[0]->set_mode(DnsStubServer::MODE_HOLD);
+  servers_[1]->set_mode(DnsStubServer::MODE_DROP);
+  servers_[1]->set_query_callback(
+      base::Bind(&DnsStubServer::ReleaseHeldAnswers,
+                 base::Unretained(servers_[0])));
+
+  TransactionHelper helper0(kT0HostName, dns_protocol::kTypeA, 1);
+  EXPECT_TRUE(helper0.RunUntilDone(transaction_factory_.get()));
+  EXPECT_EQ(1, servers_[0]->num_udp_queries());
+  EXPECT_EQ(1, servers_[1]->num_udp_queries());
+}
+
+// Once a server has answered, the timeout before trying the next server
+// adapts to its round-trip time rather than waiting for |config_.timeout|.
+TEST_F(DnsTransactionStubServerTest, AdaptsTimeoutToRTT) {
+  config_.attempts = 1;
+  StartServers(2, TestTimeouts::action_timeout());
+
+  TransactionHelper helper0(kT0HostName, dns_protocol::kTypeA, 1);
+  EXPECT_TRUE(helper0.RunUntilDone(transaction_factory_.get()));
+  EXPECT_EQ(1, servers_[0]->num_udp_queries());
+  EXPECT_LT(session_->NextTimeout(0, 0), config_.timeout);
+  EXPECT_EQ(config_.timeout, session_->NextTimeout(1, 0));
+
+  servers_[0]->set_mode(DnsStubServer::MODE_DROP);
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  TransactionHelper helper1(kT1HostName, dns_protocol::kTypeA, 1);
+  EXPECT_TRUE(helper1.RunUntilDone(transaction_factory_.get()));
+  EXPECT_LT(base::TimeTicks::Now() - start_time, config_.timeout);
+  EXPECT_EQ(2, servers_[0]->num_udp_queries());
+  EXPECT_EQ(1, servers_[1]->num_udp_queries());
+}
+
 }  // namespace
 
 }  // namespace net
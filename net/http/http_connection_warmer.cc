@@ -0,0 +1,145 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_connection_warmer.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "base/metrics/histogram.h"
+#include "base/stringprintf.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/ssl_config_service.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_server_properties.h"
+#include "net/http/http_stream_factory.h"
+#include "net/socket/client_socket_pool.h"
+#include "net/socket/ssl_client_socket_pool.h"
+#include "net/socket/transport_client_socket_pool.h"
+
+namespace net {
+
+namespace {
+
+// How often the warm connections are topped up. Idle sockets that were never
+// used are kept by the pools for longer than this.
+const int kWarmIntervalSeconds = 10;
+
+}  // namespace
+
+const double HttpConnectionWarmer::kMinRequestRate = 3.0;
+const double HttpConnectionWarmer::kBusyRequestRate = 20.0;
+const size_t HttpConnectionWarmer::kMaxWarmServers = 8;
+
+HttpConnectionWarmer::HttpConnectionWarmer(HttpNetworkSession* session)
+    : session_(session),
+      warm_hits_(0),
+      warm_misses_(0) {
+}
+
+HttpConnectionWarmer::~HttpConnectionWarmer() {
+}
+
+void HttpConnectionWarmer::OnRequestStream(
+    const HttpRequestInfo& request_info) {
+  const GURL& url = request_info.url;
+  if (!url.SchemeIs("http") && !url.SchemeIs("https"))
+    return;
+  session_->http_server_properties()->RecordServerUsage(
+      HostPortPair::FromURL(url), url.SchemeIs("https"));
+
+  if (!timer_.IsRunning()) {
+    timer_.Start(FROM_HERE,
+                 base::TimeDelta::FromSeconds(kWarmIntervalSeconds),
+                 this, &HttpConnectionWarmer::WarmConnections);
+  }
+}
+
+void HttpConnectionWarmer::OnSocketAssigned(
+    const HostPortPair& origin,
+    ClientSocketHandle::SocketReuseType reuse_type) {
+  if (warm_servers_.find(origin) == warm_servers_.end())
+    return;
+
+  // A socket that was connected ahead of the request and left idle is a
+  // warm connection. Sockets reused after an earlier request would have been
+  // there without warming.
+  bool hit = reuse_type == ClientSocketHandle::UNUSED_IDLE;
+  if (hit)
+    ++warm_hits_;
+  else
+    ++warm_misses_;
+  // Recorded per request rather than once per session, which would be lost
+  // whenever the browser does not shut down cleanly. The hit ratio is the
+  // histogram's mean.
+  UMA_HISTOGRAM_BOOLEAN("Net.ConnectionWarmer.WarmHit", hit);
+  UMA_HISTOGRAM_ENUMERATION("Net.ConnectionWarmer.SocketReuseType",
+                            reuse_type, ClientSocketHandle::NUM_TYPES);
+}
+
+void HttpConnectionWarmer::WarmConnections() {
+  warm_servers_.clear();
+
+  HttpServerProperties* server_properties =
+      session_->http_server_properties();
+  ServerUsageMap usage_map = server_properties->GetServerUsageMap();
+
+  std::vector<std::pair<double, HostPortPair> > candidates;
+  for (ServerUsageMap::const_iterator it = usage_map.begin();
+       it != usage_map.end(); ++it) {
+    if (it->second.request_rate >= kMinRequestRate)
+      candidates.push_back(std::make_pair(it->second.request_rate, it->first));
+  }
+  if (candidates.empty()) {
+    // Nothing is busy enough any more. The next request restarts the timer.
+    timer_.Stop();
+    return;
+  }
+  if (IsPoolStalled())
+    return;
+
+  std::sort(candidates.begin(), candidates.end(),
+            std::greater<std::pair<double, HostPortPair> >());
+  if (candidates.size() > kMaxWarmServers)
+    candidates.resize(kMaxWarmServers);
+
+  SSLConfig ssl_config;
+  session_->ssl_config_service()->GetSSLConfig(&ssl_config);
+
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const HostPortPair& server = candidates[i].second;
+    const ServerUsage& usage = usage_map[server];
+
+    HttpRequestInfo request_info;
+    request_info.method = "GET";
+    request_info.url = GURL(base::StringPrintf(
+        "%s://%s/", usage.is_secure ? "https" : "http",
+        server.ToString().c_str()));
+    request_info.load_flags = 0;
+    request_info.motivation = HttpRequestInfo::PRECONNECT_MOTIVATED;
+
+    // The pools count sockets in use towards |num_streams|, so this opens a
+    // new connection only when the warm ones have been taken. A single
+    // connection carries all the streams to a SPDY server.
+    int num_streams = usage.request_rate >= kBusyRequestRate ? 2 : 1;
+    if (server_properties->SupportsSpdy(server))
+      num_streams = 1;
+
+    session_->http_stream_factory()->PreconnectStreams(
+        num_streams, request_info, ssl_config, ssl_config);
+    warm_servers_.insert(server);
+  }
+}
+
+bool HttpConnectionWarmer::IsPoolStalled() {
+  return session_->GetTransportSocketPool(
+             HttpNetworkSession::NORMAL_SOCKET_POOL)->IsStalled() ||
+         session_->GetSSLSocketPool(
+             HttpNetworkSession::NORMAL_SOCKET_POOL)->IsStalled();
+}
+
+}  // namespace net
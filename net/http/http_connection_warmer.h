@@ -0,0 +1,84 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_CONNECTION_WARMER_H_
+#define NET_HTTP_HTTP_CONNECTION_WARMER_H_
+#pragma once
+
+#include <set>
+
+#include "base/basictypes.h"
+#include "base/timer.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_export.h"
+#include "net/socket/client_socket_handle.h"
+
+namespace net {
+
+class HttpNetworkSession;
+struct HttpRequestInfo;
+
+// HttpConnectionWarmer keeps connections open to the servers an
+// HttpNetworkSession has used the most recently, so that requests to them
+// find a connected, and for https already handshaked, socket in the pool
+// instead of waiting on TCP and TLS setup.
+//
+// The servers to warm are chosen from the ServerUsage kept by
+// HttpServerProperties. Periodically, while requests are being made, the
+// busiest servers are topped up through HttpStreamFactory::PreconnectStreams,
+// so warm connections go through the same proxy resolution and socket pools
+// as real requests and are bounded by the pools' per-group and per-pool
+// limits. Nothing is warmed while a pool is stalled on its limit.
+class NET_EXPORT_PRIVATE HttpConnectionWarmer {
+ public:
+  // Servers used less than this often are not warmed. The rate is a decayed
+  // request count, see HttpServerPropertiesImpl.
+  static const double kMinRequestRate;
+  // Servers used at least this often get two warm connections rather than
+  // one.
+  static const double kBusyRequestRate;
+  // At most this many servers are warmed at a time.
+  static const size_t kMaxWarmServers;
+
+  explicit HttpConnectionWarmer(HttpNetworkSession* session);
+  ~HttpConnectionWarmer();
+
+  // Called for every stream requested from the session.
+  void OnRequestStream(const HttpRequestInfo& request_info);
+
+  // Called when a requested stream to |origin| was given a socket from a
+  // pool. Records whether a warm connection was waiting for it.
+  void OnSocketAssigned(const HostPortPair& origin,
+                        ClientSocketHandle::SocketReuseType reuse_type);
+
+  // Requests to warmed servers that found a preconnected socket, and those
+  // that had to connect.
+  int warm_hits() const { return warm_hits_; }
+  int warm_misses() const { return warm_misses_; }
+
+ private:
+  friend class HttpConnectionWarmerTest;
+
+  // Preconnects to the busiest servers. Stops the timer when there are none.
+  void WarmConnections();
+
+  // Returns true if a request is waiting for a socket because a pool has
+  // reached its limit.
+  bool IsPoolStalled();
+
+  HttpNetworkSession* const session_;
+  base::RepeatingTimer<HttpConnectionWarmer> timer_;
+
+  // The servers warmed by the last WarmConnections().
+  std::set<HostPortPair> warm_servers_;
+
+  int warm_hits_;
+  int warm_misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpConnectionWarmer);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_CONNECTION_WARMER_H_
@@ -0,0 +1,162 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_connection_warmer.h"
+
+#include <map>
+#include <string>
+
+#include "base/compiler_specific.h"
+#include "base/stringprintf.h"
+#include "net/base/ssl_config_service.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_network_session_peer.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_stream_factory.h"
+#include "net/spdy/spdy_test_util_spdy2.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using namespace net::test_spdy2;
+
+namespace net {
+
+namespace {
+
+// Records the preconnects it is asked for instead of making them.
+class RecordingHttpStreamFactory : public HttpStreamFactory {
+ public:
+  RecordingHttpStreamFactory() {}
+  virtual ~RecordingHttpStreamFactory() {}
+
+  virtual HttpStreamRequest* RequestStream(
+      const HttpRequestInfo& info,
+      const SSLConfig& server_ssl_config,
+      const SSLConfig& proxy_ssl_config,
+      HttpStreamRequest::Delegate* delegate,
+      const BoundNetLog& net_log) OVERRIDE {
+    ADD_FAILURE();
+    return NULL;
+  }
+
+  virtual void PreconnectStreams(int num_streams,
+                                 const HttpRequestInfo& info,
+                                 const SSLConfig& server_ssl_config,
+                                 const SSLConfig& proxy_ssl_config) OVERRIDE {
+    EXPECT_EQ(HttpRequestInfo::PRECONNECT_MOTIVATED, info.motivation);
+    preconnects_[info.url.spec()] = num_streams;
+  }
+
+  virtual base::Value* PipelineInfoToValue() const OVERRIDE {
+    return NULL;
+  }
+
+  // Maps the URLs preconnected to the number of streams.
+  std::map<std::string, int>& preconnects() { return preconnects_; }
+
+ private:
+  std::map<std::string, int> preconnects_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingHttpStreamFactory);
+};
+
+}  // namespace
+
+class HttpConnectionWarmerTest : public testing::Test {
+ protected:
+  HttpConnectionWarmerTest()
+      : session_(SpdySessionDependencies::SpdyCreateSession(&session_deps_)),
+        factory_(new RecordingHttpStreamFactory),
+        warmer_(session_.get()) {
+    HttpNetworkSessionPeer peer(session_);
+    peer.SetHttpStreamFactory(factory_);
+  }
+
+  void MakeRequests(const std::string& url, int count) {
+    HttpRequestInfo request_info;
+    request_info.method = "GET";
+    request_info.url = GURL(url);
+    for (int i = 0; i < count; ++i)
+      warmer_.OnRequestStream(request_info);
+  }
+
+  void WarmConnections() {
+    warmer_.WarmConnections();
+  }
+
+  bool IsTimerRunning() const {
+    return warmer_.timer_.IsRunning();
+  }
+
+  SpdySessionDependencies session_deps_;
+  scoped_refptr<HttpNetworkSession> session_;
+  // Owned by |session_|.
+  RecordingHttpStreamFactory* factory_;
+  HttpConnectionWarmer warmer_;
+};
+
+TEST_F(HttpConnectionWarmerTest, WarmsBusyServers) {
+  MakeRequests("https://www.google.com/", 5);
+  MakeRequests("http://busy.example.com:8080/a", 30);
+  MakeRequests("http://quiet.example.com/", 1);
+  EXPECT_TRUE(IsTimerRunning());
+
+  WarmConnections();
+
+  std::map<std::string, int>& preconnects = factory_->preconnects();
+  ASSERT_EQ(2u, preconnects.size());
+  EXPECT_EQ(1, preconnects["https://www.google.com/"]);
+  EXPECT_EQ(2, preconnects["http://busy.example.com:8080/"]);
+  EXPECT_TRUE(IsTimerRunning());
+}
+
+TEST_F(HttpConnectionWarmerTest, OneConnectionForSpdyServers) {
+  session_deps_.http_server_properties.SetSupportsSpdy(
+      HostPortPair("www.google.com", 443), true);
+  MakeRequests("https://www.google.com/", 30);
+
+  WarmConnections();
+
+  EXPECT_EQ(1, factory_->preconnects()["https://www.google.com/"]);
+}
+
+TEST_F(HttpConnectionWarmerTest, LimitsWarmServers) {
+  for (size_t i = 0; i < HttpConnectionWarmer::kMaxWarmServers + 2; ++i) {
+    MakeRequests(base::StringPrintf("http://host%d.example.com/",
+                                    static_cast<int>(i)),
+                 5);
+  }
+
+  WarmConnections();
+
+  EXPECT_EQ(HttpConnectionWarmer::kMaxWarmServers,
+            factory_->preconnects().size());
+}
+
+TEST_F(HttpConnectionWarmerTest, StopsWhenIdle) {
+  MakeRequests("http://quiet.example.com/", 1);
+  EXPECT_TRUE(IsTimerRunning());
+
+  WarmConnections();
+
+  EXPECT_TRUE(factory_->preconnects().empty());
+  EXPECT_FALSE(IsTimerRunning());
+}
+
+TEST_F(HttpConnectionWarmerTest, CountsWarmHits) {
+  HostPortPair google("www.google.com", 443);
+  HostPortPair other("www.example.com", 80);
+  MakeRequests("https://www.google.com/", 5);
+  WarmConnections();
+
+  warmer_.OnSocketAssigned(google, ClientSocketHandle::UNUSED_IDLE);
+  warmer_.OnSocketAssigned(google, ClientSocketHandle::UNUSED);
+  warmer_.OnSocketAssigned(google, ClientSocketHandle::REUSED_IDLE);
+  // Servers that are not warmed are not counted.
+  warmer_.OnSocketAssigned(other, ClientSocketHandle::UNUSED_IDLE);
+
+  EXPECT_EQ(1, warmer_.warm_hits());
+  EXPECT_EQ(2, warmer_.warm_misses());
+}
+
+}  // namespace net
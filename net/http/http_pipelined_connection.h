@@ -73,6 +73,15 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnection {
   // requests.
   virtual bool active() const = 0;
 
+  // The number of response body bytes still to be read for the response at
+  // the head of this pipeline. 0 if there is none, or if its length isn't
+  // known yet.
+  virtual int64 GetActiveResponseBytesRemaining() const = 0;
+
+  // The number of requests sent on this pipeline whose responses haven't been
+  // read yet, including the response being read.
+  virtual int GetNumRequestsInFlight() const = 0;
+
   // The SSLConfig used to establish this connection.
   virtual const SSLConfig& used_ssl_config() const = 0;
 
@@ -801,6 +801,22 @@ bool HttpPipelinedConnectionImpl::active() const {
   return active_;
 }
 
+int64 HttpPipelinedConnectionImpl::GetActiveResponseBytesRemaining() const {
+  if (!active_read_id_) {
+    return 0;
+  }
+  StreamInfoMap::const_iterator it = stream_info_map_.find(active_read_id_);
+  if (it == stream_info_map_.end() || !it->second.parser.get()) {
+    return 0;
+  }
+  int64 bytes_remaining = it->second.parser->GetResponseBodyBytesRemaining();
+  return bytes_remaining > 0 ? bytes_remaining : 0;
+}
+
+int HttpPipelinedConnectionImpl::GetNumRequestsInFlight() const {
+  return request_order_.size() + (active_read_id_ ? 1 : 0);
+}
+
 const SSLConfig& HttpPipelinedConnectionImpl::used_ssl_config() const {
   return used_ssl_config_;
 }
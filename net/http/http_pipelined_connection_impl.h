@@ -83,6 +83,8 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnectionImpl
   virtual int depth() const OVERRIDE;
   virtual bool usable() const OVERRIDE;
   virtual bool active() const OVERRIDE;
+  virtual int64 GetActiveResponseBytesRemaining() const OVERRIDE;
+  virtual int GetNumRequestsInFlight() const OVERRIDE;
 
   // Used by HttpStreamFactoryImpl.
   virtual const SSLConfig& used_ssl_config() const OVERRIDE;
@@ -56,17 +56,24 @@ class NET_EXPORT_PRIVATE HttpPipelinedHost {
     virtual void OnHostDeterminedCapability(
         HttpPipelinedHost* host,
         HttpPipelinedHostCapability capability) = 0;
+
+    // Called when a host answers a pipeline |depth| requests deep, if that is
+    // deeper than any it was known to answer before.
+    virtual void OnHostObservedPipelineDepth(HttpPipelinedHost* host,
+                                             int depth) = 0;
   };
 
   class Factory {
    public:
     virtual ~Factory() {}
 
-    // Returns a new HttpPipelinedHost.
+    // Returns a new HttpPipelinedHost. |max_depth| is the deepest pipeline
+    // the host is known to have answered, or 0 if that isn't known.
     virtual HttpPipelinedHost* CreateNewHost(
         Delegate* delegate, const Key& key,
         HttpPipelinedConnection::Factory* factory,
         HttpPipelinedHostCapability capability,
+        int max_depth,
         bool force_pipelining) = 0;
   };
 
@@ -4,6 +4,8 @@
 
 #include "net/http/http_pipelined_host_impl.h"
 
+#include <algorithm>
+
 #include "base/stl_util.h"
 #include "base/values.h"
 #include "net/http/http_pipelined_connection_impl.h"
@@ -19,15 +21,26 @@ namespace net {
 // costing too much performance. Until then, this is just a bad guess.
 static const int kNumKnownSuccessesThreshold = 3;
 
+// Hosts known to be capable never pipeline deeper than this, however deep a
+// pipeline they've answered.
+static const int kMaxLearnedPipelineDepth = 6;
+
+// The response size expected from a host before any of its responses have been
+// seen. Roughly the median size of a subresource.
+static const int64 kDefaultExpectedResponseBytes = 16 * 1024;
+
 HttpPipelinedHostImpl::HttpPipelinedHostImpl(
     HttpPipelinedHost::Delegate* delegate,
     const HttpPipelinedHost::Key& key,
     HttpPipelinedConnection::Factory* factory,
-    HttpPipelinedHostCapability capability)
+    HttpPipelinedHostCapability capability,
+    int max_depth)
     : delegate_(delegate),
       key_(key),
       factory_(factory),
-      capability_(capability) {
+      capability_(capability),
+      max_depth_(max_depth),
+      expected_response_bytes_(kDefaultExpectedResponseBytes) {
   if (!factory) {
     factory_.reset(new HttpPipelinedConnectionImpl::Factory());
   }
@@ -57,12 +70,16 @@ HttpPipelinedStream* HttpPipelinedHostImpl::CreateStreamOnNewPipeline(
 
 HttpPipelinedStream* HttpPipelinedHostImpl::CreateStreamOnExistingPipeline() {
   HttpPipelinedConnection* available_pipeline = NULL;
+  int64 available_bytes_ahead = 0;
   for (PipelineInfoMap::iterator it = pipelines_.begin();
        it != pipelines_.end(); ++it) {
-    if (CanPipelineAcceptRequests(it->first) &&
-        (!available_pipeline ||
-         it->first->depth() < available_pipeline->depth())) {
+    if (!CanPipelineAcceptRequests(it->first)) {
+      continue;
+    }
+    int64 bytes_ahead = GetExpectedBytesAhead(it->first);
+    if (!available_pipeline || bytes_ahead < available_bytes_ahead) {
       available_pipeline = it->first;
+      available_bytes_ahead = bytes_ahead;
     }
   }
   if (!available_pipeline) {
@@ -112,8 +129,20 @@ void HttpPipelinedHostImpl::OnPipelineFeedback(
     HttpPipelinedConnection::Feedback feedback) {
   CHECK(ContainsKey(pipelines_, pipeline));
   switch (feedback) {
-    case HttpPipelinedConnection::OK:
+    case HttpPipelinedConnection::OK: {
       ++pipelines_[pipeline].num_successes;
+      int64 response_bytes = pipeline->GetActiveResponseBytesRemaining();
+      if (response_bytes > 0) {
+        expected_response_bytes_ =
+            (expected_response_bytes_ * 7 + response_bytes) / 8;
+      }
+      // The requests in flight were all sent before this response arrived
+      // intact, so the host answers a pipeline that deep.
+      int requests_in_flight = pipeline->GetNumRequestsInFlight();
+      if (requests_in_flight > 1 && requests_in_flight > max_depth_) {
+        max_depth_ = requests_in_flight;
+        delegate_->OnHostObservedPipelineDepth(this, max_depth_);
+      }
       if (capability_ == PIPELINE_UNKNOWN) {
         capability_ = PIPELINE_PROBABLY_CAPABLE;
         NotifyAllPipelinesHaveCapacity();
@@ -124,6 +153,7 @@ void HttpPipelinedHostImpl::OnPipelineFeedback(
         delegate_->OnHostDeterminedCapability(this, PIPELINE_CAPABLE);
       }
       break;
+    }
 
     case HttpPipelinedConnection::PIPELINE_SOCKET_ERROR:
       // Socket errors on the initial request - when no other requests are
@@ -153,6 +183,10 @@ int HttpPipelinedHostImpl::GetPipelineCapacity() const {
   int capacity = 0;
   switch (capability_) {
     case PIPELINE_CAPABLE:
+      capacity = std::max(max_pipeline_depth(),
+                          std::min(max_depth_ + 1, kMaxLearnedPipelineDepth));
+      break;
+
     case PIPELINE_PROBABLY_CAPABLE:
       capacity = max_pipeline_depth();
       break;
@@ -170,6 +204,16 @@ int HttpPipelinedHostImpl::GetPipelineCapacity() const {
   return capacity;
 }
 
+int64 HttpPipelinedHostImpl::GetExpectedBytesAhead(
+    HttpPipelinedConnection* pipeline) const {
+  int64 bytes_ahead = pipeline->GetActiveResponseBytesRemaining();
+  int unknown_responses = pipeline->depth();
+  if (bytes_ahead > 0) {
+    --unknown_responses;
+  }
+  return bytes_ahead + unknown_responses * expected_response_bytes_;
+}
+
 bool HttpPipelinedHostImpl::CanPipelineAcceptRequests(
     HttpPipelinedConnection* pipeline) const {
   return capability_ != PIPELINE_INCAPABLE &&
@@ -199,6 +243,9 @@ Value* HttpPipelinedHostImpl::PipelineInfoToValue() const {
     pipeline_dict->SetBoolean("forced", false);
     pipeline_dict->SetInteger("depth", it->first->depth());
     pipeline_dict->SetInteger("capacity", GetPipelineCapacity());
+    pipeline_dict->SetDouble(
+        "expected_bytes_ahead",
+        static_cast<double>(GetExpectedBytesAhead(it->first)));
     pipeline_dict->SetBoolean("usable", it->first->usable());
     pipeline_dict->SetBoolean("active", it->first->active());
     pipeline_dict->SetInteger("source_id", it->first->net_log().source().id);
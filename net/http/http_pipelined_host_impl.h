@@ -31,7 +31,14 @@ struct SSLConfig;
 
 // Manages all of the pipelining state for specific host with active pipelined
 // HTTP requests. Manages connection jobs, constructs pipelined streams, and
-// assigns requests to the least loaded pipelined connection.
+// assigns requests to the pipelined connection expected to reach them first.
+//
+// A request waits behind the responses queued ahead of it on its pipeline, so
+// pipelines are weighed by the response bytes expected ahead of a new request:
+// what is left of the response being read, plus the host's average response
+// size for each request queued behind it. Hosts known to be capable may
+// pipeline deeper than max_pipeline_depth(), one request deeper than the
+// deepest pipeline they've answered.
 class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
     : public HttpPipelinedHost,
       public HttpPipelinedConnection::Delegate {
@@ -39,7 +46,8 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
   HttpPipelinedHostImpl(HttpPipelinedHost::Delegate* delegate,
                         const HttpPipelinedHost::Key& key,
                         HttpPipelinedConnection::Factory* factory,
-                        HttpPipelinedHostCapability capability);
+                        HttpPipelinedHostCapability capability,
+                        int max_depth);
   virtual ~HttpPipelinedHostImpl();
 
   // HttpPipelinedHost interface
@@ -95,6 +103,10 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
   // not be called if |capability_| is INCAPABLE.
   int GetPipelineCapacity() const;
 
+  // Returns the number of response bytes |pipeline| is expected to read
+  // before it reaches a request added to it now.
+  int64 GetExpectedBytesAhead(HttpPipelinedConnection* pipeline) const;
+
   // Returns true if |pipeline| can handle a new request. This is true if the
   // |pipeline| is active, usable, has capacity, and |capability_| is
   // sufficient.
@@ -109,6 +121,10 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
   PipelineInfoMap pipelines_;
   scoped_ptr<HttpPipelinedConnection::Factory> factory_;
   HttpPipelinedHostCapability capability_;
+  // The deepest pipeline this host has answered without error.
+  int max_depth_;
+  // A running average of the response sizes seen from this host.
+  int64 expected_response_bytes_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpPipelinedHostImpl);
 };
@@ -33,13 +33,18 @@ class HttpPipelinedHostImplTest : public testing::Test {
       : key_(HostPortPair("host", 123)),
         factory_(new MockPipelineFactory),  // Owned by host_.
         host_(new HttpPipelinedHostImpl(&delegate_, key_, factory_,
-                                        PIPELINE_CAPABLE)) {
+                                        PIPELINE_CAPABLE, 0)) {
   }
 
   void SetCapability(HttpPipelinedHostCapability capability) {
+    SetCapabilityAndMaxDepth(capability, 0);
+  }
+
+  void SetCapabilityAndMaxDepth(HttpPipelinedHostCapability capability,
+                                int max_depth) {
     factory_ = new MockPipelineFactory;
     host_.reset(new HttpPipelinedHostImpl(
-        &delegate_, key_, factory_, capability));
+        &delegate_, key_, factory_, capability, max_depth));
   }
 
   MockPipeline* AddTestPipeline(int depth, bool usable, bool active) {
@@ -152,6 +157,71 @@ TEST_F(HttpPipelinedHostImplTest, PicksLeastLoadedPipeline) {
   ClearTestPipeline(empty_pipeline);
 }
 
+TEST_F(HttpPipelinedHostImplTest, AvoidsPipelineBehindLargeResponse) {
+  MockPipeline* large_pipeline = AddTestPipeline(1, true, true);
+  large_pipeline->set_active_response_bytes_remaining(1024 * 1024);
+  MockPipeline* deeper_pipeline = AddTestPipeline(2, true, true);
+  deeper_pipeline->set_active_response_bytes_remaining(100);
+
+  EXPECT_CALL(*deeper_pipeline, CreateNewStream())
+      .Times(1)
+      .WillOnce(Return(kDummyStream));
+  EXPECT_EQ(kDummyStream, host_->CreateStreamOnExistingPipeline());
+
+  ClearTestPipeline(large_pipeline);
+  ClearTestPipeline(deeper_pipeline);
+}
+
+TEST_F(HttpPipelinedHostImplTest, LearnsDeeperPipelines) {
+  MockPipeline* pipeline = AddTestPipeline(
+      HttpPipelinedHostImpl::max_pipeline_depth(), true, true);
+  pipeline->set_requests_in_flight(HttpPipelinedHostImpl::max_pipeline_depth());
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable());
+
+  EXPECT_CALL(delegate_,
+              OnHostObservedPipelineDepth(
+                  host_.get(), HttpPipelinedHostImpl::max_pipeline_depth()))
+      .Times(1);
+  host_->OnPipelineFeedback(pipeline, HttpPipelinedConnection::OK);
+  EXPECT_TRUE(host_->IsExistingPipelineAvailable());
+
+  // Shallower pipelines teach nothing new.
+  EXPECT_CALL(delegate_, OnHostObservedPipelineDepth(host_.get(), _))
+      .Times(0);
+  pipeline->set_requests_in_flight(2);
+  host_->OnPipelineFeedback(pipeline, HttpPipelinedConnection::OK);
+
+  ClearTestPipeline(pipeline);
+}
+
+TEST_F(HttpPipelinedHostImplTest, StartsWithRememberedDepth) {
+  SetCapabilityAndMaxDepth(PIPELINE_CAPABLE, 4);
+  MockPipeline* pipeline = AddTestPipeline(4, true, true);
+  EXPECT_TRUE(host_->IsExistingPipelineAvailable());
+
+  pipeline->SetState(5, true, true);
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable());
+
+  ClearTestPipeline(pipeline);
+}
+
+TEST_F(HttpPipelinedHostImplTest, LearnedDepthIsCapped) {
+  SetCapabilityAndMaxDepth(PIPELINE_CAPABLE, 100);
+  MockPipeline* pipeline = AddTestPipeline(6, true, true);
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable());
+
+  ClearTestPipeline(pipeline);
+}
+
+TEST_F(HttpPipelinedHostImplTest, IgnoresRememberedDepthUntilCapable) {
+  SetCapabilityAndMaxDepth(PIPELINE_PROBABLY_CAPABLE, 4);
+  MockPipeline* pipeline = AddTestPipeline(
+      HttpPipelinedHostImpl::max_pipeline_depth(), true, true);
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable());
+
+  ClearTestPipeline(pipeline);
+}
+
 TEST_F(HttpPipelinedHostImplTest, OpensUpOnPipelineSuccess) {
   SetCapability(PIPELINE_UNKNOWN);
   MockPipeline* pipeline = AddTestPipeline(1, true, true);
@@ -24,11 +24,13 @@ class HttpPipelinedHostImplFactory : public HttpPipelinedHost::Factory {
       const HttpPipelinedHost::Key& key,
       HttpPipelinedConnection::Factory* factory,
       HttpPipelinedHostCapability capability,
+      int max_depth,
       bool force_pipelining) OVERRIDE {
     if (force_pipelining) {
       return new HttpPipelinedHostForced(delegate, key, factory);
     } else {
-      return new HttpPipelinedHostImpl(delegate, key, factory, capability);
+      return new HttpPipelinedHostImpl(delegate, key, factory, capability,
+                                       max_depth);
     }
   }
 };
@@ -110,8 +112,9 @@ HttpPipelinedHost* HttpPipelinedHostPool::GetPipelinedHost(
     return NULL;
   }
 
+  int max_depth = http_server_properties_->GetPipelineMaxDepth(key.origin());
   HttpPipelinedHost* host = factory_->CreateNewHost(
-      this, key, NULL, capability, force_pipelining_);
+      this, key, NULL, capability, max_depth, force_pipelining_);
   host_map_[key] = host;
   return host;
 }
@@ -135,6 +138,12 @@ void HttpPipelinedHostPool::OnHostDeterminedCapability(
                                                  capability);
 }
 
+void HttpPipelinedHostPool::OnHostObservedPipelineDepth(
+    HttpPipelinedHost* host,
+    int depth) {
+  http_server_properties_->SetPipelineMaxDepth(host->GetKey().origin(), depth);
+}
+
 Value* HttpPipelinedHostPool::PipelineInfoToValue() const {
   ListValue* list = new ListValue();
   for (HostMap::const_iterator it = host_map_.begin();
@@ -77,6 +77,9 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostPool
       HttpPipelinedHost* host,
       HttpPipelinedHostCapability capability) OVERRIDE;
 
+  virtual void OnHostObservedPipelineDepth(HttpPipelinedHost* host,
+                                           int depth) OVERRIDE;
+
   // Creates a Value summary of this pool's |host_map_|. Caller assumes
   // ownership of the returned Value.
   base::Value* PipelineInfoToValue() const;
@@ -36,11 +36,12 @@ class MockPoolDelegate : public HttpPipelinedHostPool::Delegate {
 
 class MockHostFactory : public HttpPipelinedHost::Factory {
  public:
-  MOCK_METHOD5(CreateNewHost, HttpPipelinedHost*(
+  MOCK_METHOD6(CreateNewHost, HttpPipelinedHost*(
       HttpPipelinedHost::Delegate* delegate,
       const HttpPipelinedHost::Key& key,
       HttpPipelinedConnection::Factory* factory,
       HttpPipelinedHostCapability capability,
+      int max_depth,
       bool force_pipelining));
 };
 
@@ -102,7 +103,7 @@ class HttpPipelinedHostPoolTest : public testing::Test {
   MockHost* CreateDummyHost(const HttpPipelinedHost::Key& key) {
     MockHost* mock_host = new MockHost(key);
     EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key), _,
-                                         PIPELINE_UNKNOWN, false))
+                                         PIPELINE_UNKNOWN, 0, false))
         .Times(1)
         .WillOnce(Return(mock_host));
     ClientSocketHandle* dummy_connection =
@@ -130,7 +131,7 @@ class HttpPipelinedHostPoolTest : public testing::Test {
 TEST_F(HttpPipelinedHostPoolTest, DefaultUnknown) {
   EXPECT_TRUE(pool_->IsKeyEligibleForPipelining(key_));
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_UNKNOWN, false))
+                                       PIPELINE_UNKNOWN, 0, false))
       .Times(1)
       .WillOnce(Return(host_));
 
@@ -140,7 +141,7 @@ TEST_F(HttpPipelinedHostPoolTest, DefaultUnknown) {
 
 TEST_F(HttpPipelinedHostPoolTest, RemembersIncapable) {
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_UNKNOWN, false))
+                                       PIPELINE_UNKNOWN, 0, false))
       .Times(1)
       .WillOnce(Return(host_));
 
@@ -149,7 +150,7 @@ TEST_F(HttpPipelinedHostPoolTest, RemembersIncapable) {
   pool_->OnHostIdle(host_);
   EXPECT_FALSE(pool_->IsKeyEligibleForPipelining(key_));
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_INCAPABLE, false))
+                                       PIPELINE_INCAPABLE, 0, false))
       .Times(0);
   EXPECT_EQ(NULL,
             pool_->CreateStreamOnNewPipeline(key_, kDummyConnection,
@@ -160,7 +161,7 @@ TEST_F(HttpPipelinedHostPoolTest, RemembersIncapable) {
 
 TEST_F(HttpPipelinedHostPoolTest, RemembersCapable) {
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_UNKNOWN, false))
+                                       PIPELINE_UNKNOWN, 0, false))
       .Times(1)
       .WillOnce(Return(host_));
 
@@ -171,7 +172,7 @@ TEST_F(HttpPipelinedHostPoolTest, RemembersCapable) {
 
   host_ = new MockHost(key_);
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_CAPABLE, false))
+                                       PIPELINE_CAPABLE, 0, false))
       .Times(1)
       .WillOnce(Return(host_));
   CreateDummyStream(key_, kDummyConnection, kDummyStream, host_);
@@ -180,7 +181,7 @@ TEST_F(HttpPipelinedHostPoolTest, RemembersCapable) {
 
 TEST_F(HttpPipelinedHostPoolTest, IncapableIsSticky) {
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_UNKNOWN, false))
+                                       PIPELINE_UNKNOWN, 0, false))
       .Times(1)
       .WillOnce(Return(host_));
 
@@ -194,7 +195,7 @@ TEST_F(HttpPipelinedHostPoolTest, IncapableIsSticky) {
 
 TEST_F(HttpPipelinedHostPoolTest, RemainsUnknownWithoutFeedback) {
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_UNKNOWN, false))
+                                       PIPELINE_UNKNOWN, 0, false))
       .Times(1)
       .WillOnce(Return(host_));
 
@@ -204,7 +205,7 @@ TEST_F(HttpPipelinedHostPoolTest, RemainsUnknownWithoutFeedback) {
 
   host_ = new MockHost(key_);
   EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
-                                       PIPELINE_UNKNOWN, false))
+                                       PIPELINE_UNKNOWN, 0, false))
       .Times(1)
       .WillOnce(Return(host_));
 
@@ -223,6 +224,27 @@ TEST_F(HttpPipelinedHostPoolTest, PopulatesServerProperties) {
   delete host_;  // Must manually delete, because it's never added to |pool_|.
 }
 
+TEST_F(HttpPipelinedHostPoolTest, RemembersMaxDepth) {
+  EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
+                                       PIPELINE_UNKNOWN, 0, false))
+      .Times(1)
+      .WillOnce(Return(host_));
+
+  CreateDummyStream(key_, kDummyConnection, kDummyStream, host_);
+  pool_->OnHostDeterminedCapability(host_, PIPELINE_CAPABLE);
+  pool_->OnHostObservedPipelineDepth(host_, 4);
+  pool_->OnHostIdle(host_);
+  EXPECT_EQ(4, http_server_properties_->GetPipelineMaxDepth(key_.origin()));
+
+  host_ = new MockHost(key_);
+  EXPECT_CALL(*factory_, CreateNewHost(pool_.get(), Ref(key_), _,
+                                       PIPELINE_CAPABLE, 4, false))
+      .Times(1)
+      .WillOnce(Return(host_));
+  CreateDummyStream(key_, kDummyConnection, kDummyStream, host_);
+  pool_->OnHostIdle(host_);
+}
+
 TEST_F(HttpPipelinedHostPoolTest, MultipleKeys) {
   HttpPipelinedHost::Key key1(HostPortPair("host", 123));
   HttpPipelinedHost::Key key2(HostPortPair("host", 456));
@@ -24,7 +24,9 @@ MockPipelineFactory::~MockPipelineFactory() {
 MockPipeline::MockPipeline(int depth, bool usable, bool active)
     : depth_(depth),
       usable_(usable),
-      active_(active) {
+      active_(active),
+      active_response_bytes_remaining_(0),
+      requests_in_flight_(0) {
 }
 
 MockPipeline::~MockPipeline() {
@@ -18,6 +18,8 @@ class MockHostDelegate : public HttpPipelinedHost::Delegate {
   MOCK_METHOD2(OnHostDeterminedCapability,
                void(HttpPipelinedHost* host,
                     HttpPipelinedHostCapability capability));
+  MOCK_METHOD2(OnHostObservedPipelineDepth,
+               void(HttpPipelinedHost* host, int depth));
 };
 
 class MockPipelineFactory : public HttpPipelinedConnection::Factory {
@@ -50,6 +52,20 @@ class MockPipeline : public HttpPipelinedConnection {
   virtual int depth() const OVERRIDE { return depth_; }
   virtual bool usable() const OVERRIDE { return usable_; }
   virtual bool active() const OVERRIDE { return active_; }
+  virtual int64 GetActiveResponseBytesRemaining() const OVERRIDE {
+    return active_response_bytes_remaining_;
+  }
+
+  virtual int GetNumRequestsInFlight() const OVERRIDE {
+    return requests_in_flight_;
+  }
+
+  void set_active_response_bytes_remaining(int64 bytes) {
+    active_response_bytes_remaining_ = bytes;
+  }
+  void set_requests_in_flight(int requests) {
+    requests_in_flight_ = requests;
+  }
 
   MOCK_METHOD0(CreateNewStream, HttpPipelinedStream*());
   MOCK_METHOD1(OnStreamDeleted, void(int pipeline_id));
@@ -63,6 +79,8 @@ class MockPipeline : public HttpPipelinedConnection {
   int depth_;
   bool usable_;
   bool active_;
+  int64 active_response_bytes_remaining_;
+  int requests_in_flight_;
 };
 
 MATCHER_P(MatchesOrigin, expected, "") { return expected.Equals(arg); }
@@ -747,6 +747,97 @@ TEST_F(HttpPipelinedNetworkTransactionTest, PipelinesImmediatelyIfKnownGood) {
   ExpectResponse("second-pipeline-two.html", second_two_transaction,
                  SYNCHRONOUS);
 
+  // Both requests on the second pipeline were sent before the first response
+  // arrived.
+  EXPECT_EQ(2, http_server_properties_.GetPipelineMaxDepth(
+      HostPortPair("localhost", 80)));
+
+  ClientSocketPoolManager::set_max_sockets_per_group(
+      HttpNetworkSession::NORMAL_SOCKET_POOL, old_max_sockets);
+}
+
+TEST_F(HttpPipelinedNetworkTransactionTest, PipelinesDeeperIfKnownDeep) {
+  // The host is remembered to have answered a pipeline 3 deep, so a page's
+  // 4 requests all go out on the first connection before any response is
+  // read, one more than max_pipeline_depth() allows.
+  int old_max_sockets = ClientSocketPoolManager::max_sockets_per_group(
+      HttpNetworkSession::NORMAL_SOCKET_POOL);
+  ClientSocketPoolManager::set_max_sockets_per_group(
+      HttpNetworkSession::NORMAL_SOCKET_POOL, 1);
+  Initialize(false);
+  HostPortPair origin("localhost", 80);
+  http_server_properties_.SetPipelineCapability(origin, PIPELINE_CAPABLE);
+  http_server_properties_.SetPipelineMaxDepth(origin, 3);
+
+  MockWrite writes[] = {
+    MockWrite(SYNCHRONOUS, 0, "GET /one.html HTTP/1.1\r\n"
+              "Host: localhost\r\n"
+              "Connection: keep-alive\r\n\r\n"),
+    MockWrite(SYNCHRONOUS, 1, "GET /two.html HTTP/1.1\r\n"
+              "Host: localhost\r\n"
+              "Connection: keep-alive\r\n\r\n"),
+    MockWrite(SYNCHRONOUS, 2, "GET /three.html HTTP/1.1\r\n"
+              "Host: localhost\r\n"
+              "Connection: keep-alive\r\n\r\n"),
+    MockWrite(SYNCHRONOUS, 3, "GET /four.html HTTP/1.1\r\n"
+              "Host: localhost\r\n"
+              "Connection: keep-alive\r\n\r\n"),
+  };
+  MockRead reads[] = {
+    MockRead(ASYNC, 4, "HTTP/1.1 200 OK\r\n"),
+    MockRead(ASYNC, 5, "Content-Length: 8\r\n\r\n"),
+    MockRead(SYNCHRONOUS, 6, "one.html"),
+    MockRead(SYNCHRONOUS, 7, "HTTP/1.1 200 OK\r\n"),
+    MockRead(SYNCHRONOUS, 8, "Content-Length: 8\r\n\r\n"),
+    MockRead(SYNCHRONOUS, 9, "two.html"),
+    MockRead(SYNCHRONOUS, 10, "HTTP/1.1 200 OK\r\n"),
+    MockRead(SYNCHRONOUS, 11, "Content-Length: 10\r\n\r\n"),
+    MockRead(SYNCHRONOUS, 12, "three.html"),
+    MockRead(SYNCHRONOUS, 13, "HTTP/1.1 200 OK\r\n"),
+    MockRead(SYNCHRONOUS, 14, "Content-Length: 9\r\n\r\n"),
+    MockRead(SYNCHRONOUS, 15, "four.html"),
+  };
+  AddExpectedConnection(reads, arraysize(reads), writes, arraysize(writes));
+
+  HttpNetworkTransaction one_transaction(session_.get());
+  TestCompletionCallback one_callback;
+  EXPECT_EQ(ERR_IO_PENDING,
+            one_transaction.Start(GetRequestInfo("one.html"),
+                                  one_callback.callback(), BoundNetLog()));
+  MessageLoop::current()->RunAllPending();
+
+  HttpNetworkTransaction two_transaction(session_.get());
+  TestCompletionCallback two_callback;
+  EXPECT_EQ(ERR_IO_PENDING,
+            two_transaction.Start(GetRequestInfo("two.html"),
+                                  two_callback.callback(), BoundNetLog()));
+
+  HttpNetworkTransaction three_transaction(session_.get());
+  TestCompletionCallback three_callback;
+  EXPECT_EQ(ERR_IO_PENDING,
+            three_transaction.Start(GetRequestInfo("three.html"),
+                                    three_callback.callback(), BoundNetLog()));
+
+  HttpNetworkTransaction four_transaction(session_.get());
+  TestCompletionCallback four_callback;
+  EXPECT_EQ(ERR_IO_PENDING,
+            four_transaction.Start(GetRequestInfo("four.html"),
+                                   four_callback.callback(), BoundNetLog()));
+
+  data_vector_[0]->RunFor(3);
+  EXPECT_EQ(OK, one_callback.WaitForResult());
+  data_vector_[0]->StopAfter(100);
+  ExpectResponse("one.html", one_transaction, SYNCHRONOUS);
+  EXPECT_EQ(OK, two_callback.WaitForResult());
+  ExpectResponse("two.html", two_transaction, SYNCHRONOUS);
+  EXPECT_EQ(OK, three_callback.WaitForResult());
+  ExpectResponse("three.html", three_transaction, SYNCHRONOUS);
+  EXPECT_EQ(OK, four_callback.WaitForResult());
+  ExpectResponse("four.html", four_transaction, SYNCHRONOUS);
+
+  // The host answered all 4 at once, which is remembered for next time.
+  EXPECT_EQ(4, http_server_properties_.GetPipelineMaxDepth(origin));
+
   ClientSocketPoolManager::set_max_sockets_per_group(
       HttpNetworkSession::NORMAL_SOCKET_POOL, old_max_sockets);
 }
@@ -42,6 +42,8 @@ AlternateProtocol AlternateProtocolFromString(const std::string& protocol) {
   return UNINITIALIZED_ALTERNATE_PROTOCOL;
 }
 
+ServerUsage::ServerUsage() : request_rate(0.0), is_secure(false) {
+}
 
 std::string PortAlternateProtocolPair::ToString() const {
   return base::StringPrintf("%d:%s", port,
@@ -8,6 +8,7 @@
 #include <map>
 #include <string>
 #include "base/basictypes.h"
+#include "base/time.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/net_export.h"
 #include "net/http/http_pipelined_host_capability.h"
@@ -39,10 +40,25 @@ struct NET_EXPORT PortAlternateProtocolPair {
   AlternateProtocol protocol;
 };
 
+// Recent request activity to a server.
+struct NET_EXPORT ServerUsage {
+  ServerUsage();
+
+  // The number of requests made to the server, decayed over time so that
+  // older requests count for less.
+  double request_rate;
+  // When |request_rate| was last brought up to date.
+  base::TimeTicks last_update_time;
+  // True if the last request to the server used https.
+  bool is_secure;
+};
+
 typedef std::map<HostPortPair, PortAlternateProtocolPair> AlternateProtocolMap;
 typedef std::map<HostPortPair, SettingsMap> SpdySettingsMap;
 typedef std::map<HostPortPair,
         HttpPipelinedHostCapability> PipelineCapabilityMap;
+typedef std::map<HostPortPair, int> PipelineDepthMap;
+typedef std::map<HostPortPair, ServerUsage> ServerUsageMap;
 
 extern const char kAlternateProtocolHeader[];
 extern const char* const kAlternateProtocolStrings[NUM_ALTERNATE_PROTOCOLS];
@@ -52,6 +68,8 @@ extern const char* const kAlternateProtocolStrings[NUM_ALTERNATE_PROTOCOLS];
 // * SPDY support (based on NPN results)
 // * Alternate-Protocol support
 // * Spdy Settings (like CWND ID field)
+// * HTTP pipelining capability and the deepest pipeline seen to work
+// * How often the server has been used recently
 class NET_EXPORT HttpServerProperties {
  public:
   HttpServerProperties() {}
@@ -116,6 +134,27 @@ class NET_EXPORT HttpServerProperties {
 
   virtual PipelineCapabilityMap GetPipelineCapabilityMap() const = 0;
 
+  // Returns the deepest pipeline |origin| has answered without error, or 0 if
+  // none has been seen.
+  virtual int GetPipelineMaxDepth(const HostPortPair& origin) = 0;
+
+  // Records that |origin| answered a pipeline |depth| requests deep. Depths
+  // no deeper than the one already known are ignored.
+  virtual void SetPipelineMaxDepth(const HostPortPair& origin, int depth) = 0;
+
+  // Returns the known pipeline depths. ClearPipelineCapabilities() clears
+  // these too.
+  virtual PipelineDepthMap GetPipelineMaxDepthMap() const = 0;
+
+  // Records a request to |server|. |is_secure| is true for https requests.
+  // Should only be called from IO thread.
+  virtual void RecordServerUsage(const HostPortPair& server,
+                                 bool is_secure) = 0;
+
+  // Returns the usage of the recently requested servers, with request rates
+  // decayed to the current time.
+  virtual ServerUsageMap GetServerUsageMap() const = 0;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(HttpServerProperties);
 };
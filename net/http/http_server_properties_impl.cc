@@ -4,6 +4,8 @@
 
 #include "net/http/http_server_properties_impl.h"
 
+#include <math.h>
+
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stl_util.h"
@@ -17,9 +19,27 @@ namespace net {
 // then, this is just a bad guess.
 static const int kDefaultNumHostsToRemember = 200;
 
+// A request counts for half as much in the server usage after this long.
+static const int kServerUsageHalfLifeSeconds = 5 * 60;
+
+// Returns |usage| with its request rate decayed to |now|.
+static ServerUsage DecayServerUsage(const ServerUsage& usage,
+                                    base::TimeTicks now) {
+  ServerUsage decayed = usage;
+  double elapsed = (now - usage.last_update_time).InSecondsF();
+  if (elapsed > 0) {
+    decayed.request_rate *= pow(0.5, elapsed / kServerUsageHalfLifeSeconds);
+    decayed.last_update_time = now;
+  }
+  return decayed;
+}
+
 HttpServerPropertiesImpl::HttpServerPropertiesImpl()
     : pipeline_capability_map_(
-        new CachedPipelineCapabilityMap(kDefaultNumHostsToRemember)) {
+        new CachedPipelineCapabilityMap(kDefaultNumHostsToRemember)),
+      pipeline_depth_map_(
+        new CachedPipelineDepthMap(kDefaultNumHostsToRemember)),
+      server_usage_map_(kDefaultNumHostsToRemember) {
 }
 
 HttpServerPropertiesImpl::~HttpServerPropertiesImpl() {
@@ -66,9 +86,21 @@ void HttpServerPropertiesImpl::InitializePipelineCapabilities(
   }
 }
 
+void HttpServerPropertiesImpl::InitializePipelineMaxDepths(
+    const PipelineDepthMap* pipeline_depth_map) {
+  PipelineDepthMap::const_iterator it;
+  pipeline_depth_map_->Clear();
+  for (it = pipeline_depth_map->begin();
+       it != pipeline_depth_map->end(); ++it) {
+    pipeline_depth_map_->Put(it->first, it->second);
+  }
+}
+
 void HttpServerPropertiesImpl::SetNumPipelinedHostsToRemember(int max_size) {
   DCHECK(pipeline_capability_map_->empty());
+  DCHECK(pipeline_depth_map_->empty());
   pipeline_capability_map_.reset(new CachedPipelineCapabilityMap(max_size));
+  pipeline_depth_map_.reset(new CachedPipelineDepthMap(max_size));
 }
 
 void HttpServerPropertiesImpl::GetSpdyServerList(
@@ -118,6 +150,8 @@ void HttpServerPropertiesImpl::Clear() {
   alternate_protocol_map_.clear();
   spdy_settings_map_.clear();
   pipeline_capability_map_->Clear();
+  pipeline_depth_map_->Clear();
+  server_usage_map_.Clear();
 }
 
 bool HttpServerPropertiesImpl::SupportsSpdy(
@@ -273,10 +307,17 @@ void HttpServerPropertiesImpl::SetPipelineCapability(
       it->second != PIPELINE_INCAPABLE) {
     pipeline_capability_map_->Put(origin, capability);
   }
+  if (capability == PIPELINE_INCAPABLE) {
+    CachedPipelineDepthMap::iterator depth_it =
+        pipeline_depth_map_->Peek(origin);
+    if (depth_it != pipeline_depth_map_->end())
+      pipeline_depth_map_->Erase(depth_it);
+  }
 }
 
 void HttpServerPropertiesImpl::ClearPipelineCapabilities() {
   pipeline_capability_map_->Clear();
+  pipeline_depth_map_->Clear();
 }
 
 PipelineCapabilityMap
@@ -290,4 +331,53 @@ HttpServerPropertiesImpl::GetPipelineCapabilityMap() const {
   return result;
 }
 
+int HttpServerPropertiesImpl::GetPipelineMaxDepth(const HostPortPair& origin) {
+  CachedPipelineDepthMap::const_iterator it = pipeline_depth_map_->Get(origin);
+  if (it == pipeline_depth_map_->end())
+    return 0;
+  return it->second;
+}
+
+void HttpServerPropertiesImpl::SetPipelineMaxDepth(const HostPortPair& origin,
+                                                   int depth) {
+  CachedPipelineDepthMap::iterator it = pipeline_depth_map_->Peek(origin);
+  if (it == pipeline_depth_map_->end() || it->second < depth)
+    pipeline_depth_map_->Put(origin, depth);
+}
+
+PipelineDepthMap HttpServerPropertiesImpl::GetPipelineMaxDepthMap() const {
+  PipelineDepthMap result;
+  CachedPipelineDepthMap::const_iterator it;
+  for (it = pipeline_depth_map_->begin();
+       it != pipeline_depth_map_->end(); ++it) {
+    result[it->first] = it->second;
+  }
+  return result;
+}
+
+void HttpServerPropertiesImpl::RecordServerUsage(const HostPortPair& server,
+                                                 bool is_secure) {
+  DCHECK(CalledOnValidThread());
+  base::TimeTicks now = base::TimeTicks::Now();
+  ServerUsage usage;
+  usage.last_update_time = now;
+  CachedServerUsageMap::iterator it = server_usage_map_.Get(server);
+  if (it != server_usage_map_.end())
+    usage = DecayServerUsage(it->second, now);
+  usage.request_rate += 1.0;
+  usage.is_secure = is_secure;
+  server_usage_map_.Put(server, usage);
+}
+
+ServerUsageMap HttpServerPropertiesImpl::GetServerUsageMap() const {
+  DCHECK(CalledOnValidThread());
+  base::TimeTicks now = base::TimeTicks::Now();
+  ServerUsageMap result;
+  for (CachedServerUsageMap::const_iterator it = server_usage_map_.begin();
+       it != server_usage_map_.end(); ++it) {
+    result[it->first] = DecayServerUsage(it->second, now);
+  }
+  return result;
+}
+
 }  // namespace net
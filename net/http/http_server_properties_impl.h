@@ -49,6 +49,10 @@ class NET_EXPORT HttpServerPropertiesImpl
   void InitializePipelineCapabilities(
       const PipelineCapabilityMap* pipeline_capability_map);
 
+  // Initializes |pipeline_depth_map_| with the deepest pipelines known to work
+  // from |pipeline_depth_map|.
+  void InitializePipelineMaxDepths(const PipelineDepthMap* pipeline_depth_map);
+
   // Get the list of servers (host/port) that support SPDY.
   void GetSpdyServerList(base::ListValue* spdy_server_list) const;
 
@@ -66,7 +70,8 @@ class NET_EXPORT HttpServerPropertiesImpl
   // Changes the number of host/port pairs we remember pipelining capability
   // for. A larger number means we're more likely to be able to pipeline
   // immediately if a host is known good, but uses more memory. This function
-  // can only be called if |pipeline_capability_map_| is empty.
+  // can only be called if |pipeline_capability_map_| and |pipeline_depth_map_|
+  // are empty.
   void SetNumPipelinedHostsToRemember(int max_size);
 
   // -----------------------------
@@ -132,9 +137,23 @@ class NET_EXPORT HttpServerPropertiesImpl
 
   virtual PipelineCapabilityMap GetPipelineCapabilityMap() const OVERRIDE;
 
+  virtual int GetPipelineMaxDepth(const HostPortPair& origin) OVERRIDE;
+
+  virtual void SetPipelineMaxDepth(const HostPortPair& origin,
+                                   int depth) OVERRIDE;
+
+  virtual PipelineDepthMap GetPipelineMaxDepthMap() const OVERRIDE;
+
+  virtual void RecordServerUsage(const HostPortPair& server,
+                                 bool is_secure) OVERRIDE;
+
+  virtual ServerUsageMap GetServerUsageMap() const OVERRIDE;
+
  private:
   typedef base::MRUCache<
       HostPortPair, HttpPipelinedHostCapability> CachedPipelineCapabilityMap;
+  typedef base::MRUCache<HostPortPair, int> CachedPipelineDepthMap;
+  typedef base::MRUCache<HostPortPair, ServerUsage> CachedServerUsageMap;
   // |spdy_servers_table_| has flattened representation of servers (host/port
   // pair) that either support or not support SPDY protocol.
   typedef base::hash_map<std::string, bool> SpdyServerHostPortTable;
@@ -143,6 +162,8 @@ class NET_EXPORT HttpServerPropertiesImpl
   AlternateProtocolMap alternate_protocol_map_;
   SpdySettingsMap spdy_settings_map_;
   scoped_ptr<CachedPipelineCapabilityMap> pipeline_capability_map_;
+  scoped_ptr<CachedPipelineDepthMap> pipeline_depth_map_;
+  CachedServerUsageMap server_usage_map_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpServerPropertiesImpl);
 };
@@ -399,6 +399,67 @@ TEST_F(SpdySettingsServerPropertiesTest, Clear) {
   EXPECT_EQ(0U, impl_.GetSpdySettings(spdy_server_docs).size());
 }
 
+typedef HttpServerPropertiesImplTest ServerUsagePropertiesTest;
+
+TEST_F(ServerUsagePropertiesTest, RecordServerUsage) {
+  EXPECT_TRUE(impl_.GetServerUsageMap().empty());
+
+  HostPortPair server_google("www.google.com", 443);
+  HostPortPair server_mail("mail.google.com", 80);
+  impl_.RecordServerUsage(server_google, true);
+  impl_.RecordServerUsage(server_google, true);
+  impl_.RecordServerUsage(server_mail, false);
+
+  ServerUsageMap usage_map = impl_.GetServerUsageMap();
+  ASSERT_EQ(2U, usage_map.size());
+  // Requests decay over minutes, so the rates are barely below the counts.
+  EXPECT_NEAR(2.0, usage_map[server_google].request_rate, 0.01);
+  EXPECT_LE(usage_map[server_google].request_rate, 2.0);
+  EXPECT_TRUE(usage_map[server_google].is_secure);
+  EXPECT_NEAR(1.0, usage_map[server_mail].request_rate, 0.01);
+  EXPECT_FALSE(usage_map[server_mail].is_secure);
+
+  impl_.Clear();
+  EXPECT_TRUE(impl_.GetServerUsageMap().empty());
+}
+
+typedef HttpServerPropertiesImplTest PipelineDepthPropertiesTest;
+
+TEST_F(PipelineDepthPropertiesTest, SetPipelineMaxDepth) {
+  HostPortPair pipeliner("www.google.com", 80);
+  EXPECT_EQ(0, impl_.GetPipelineMaxDepth(pipeliner));
+
+  impl_.SetPipelineMaxDepth(pipeliner, 3);
+  EXPECT_EQ(3, impl_.GetPipelineMaxDepth(pipeliner));
+  // Shallower depths don't replace a deeper one.
+  impl_.SetPipelineMaxDepth(pipeliner, 2);
+  EXPECT_EQ(3, impl_.GetPipelineMaxDepth(pipeliner));
+  impl_.SetPipelineMaxDepth(pipeliner, 5);
+  EXPECT_EQ(5, impl_.GetPipelineMaxDepth(pipeliner));
+
+  PipelineDepthMap depth_map = impl_.GetPipelineMaxDepthMap();
+  ASSERT_EQ(1U, depth_map.size());
+  EXPECT_EQ(5, depth_map[pipeliner]);
+
+  // A host that can't pipeline forgets its depth.
+  impl_.SetPipelineCapability(pipeliner, PIPELINE_INCAPABLE);
+  EXPECT_EQ(0, impl_.GetPipelineMaxDepth(pipeliner));
+}
+
+TEST_F(PipelineDepthPropertiesTest, Initialize) {
+  HostPortPair pipeliner("www.google.com", 80);
+  impl_.SetPipelineMaxDepth(HostPortPair("mail.google.com", 80), 2);
+
+  PipelineDepthMap depth_map;
+  depth_map[pipeliner] = 4;
+  impl_.InitializePipelineMaxDepths(&depth_map);
+  EXPECT_EQ(4, impl_.GetPipelineMaxDepth(pipeliner));
+  EXPECT_EQ(0, impl_.GetPipelineMaxDepth(HostPortPair("mail.google.com", 80)));
+
+  impl_.ClearPipelineCapabilities();
+  EXPECT_EQ(0, impl_.GetPipelineMaxDepth(pipeliner));
+}
+
 }  // namespace
 
 }  // namespace net
@@ -37,6 +37,8 @@ bool HttpStreamFactory::ignore_certificate_errors_ = false;
 // static
 bool HttpStreamFactory::http_pipelining_enabled_ = false;
 // static
+bool HttpStreamFactory::connection_warming_enabled_ = false;
+// static
 uint16 HttpStreamFactory::testing_fixed_http_port_ = 0;
 // static
 uint16 HttpStreamFactory::testing_fixed_https_port_ = 0;
@@ -57,6 +59,7 @@ void HttpStreamFactory::ResetStaticSettingsToInit() {
   force_spdy_always_ = false;
   forced_spdy_exclusions_ = NULL;
   ignore_certificate_errors_ = false;
+  connection_warming_enabled_ = false;
   for (int i = 0; i < NUM_ALTERNATE_PROTOCOLS; ++i)
     enabled_protocols_[i] = false;
 }
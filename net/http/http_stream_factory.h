@@ -261,6 +261,15 @@ class NET_EXPORT HttpStreamFactory {
   }
   static bool http_pipelining_enabled() { return http_pipelining_enabled_; }
 
+  // Controls whether connections are kept open to the busiest servers ahead
+  // of requests. See HttpConnectionWarmer.
+  static void set_connection_warming_enabled(bool value) {
+    connection_warming_enabled_ = value;
+  }
+  static bool connection_warming_enabled() {
+    return connection_warming_enabled_;
+  }
+
   static void set_testing_fixed_http_port(int port) {
     testing_fixed_http_port_ = port;
   }
@@ -287,6 +296,7 @@ class NET_EXPORT HttpStreamFactory {
   static std::list<HostPortPair>* forced_spdy_exclusions_;
   static bool ignore_certificate_errors_;
   static bool http_pipelining_enabled_;
+  static bool connection_warming_enabled_;
   static uint16 testing_fixed_http_port_;
   static uint16 testing_fixed_https_port_;
 
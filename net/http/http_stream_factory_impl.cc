@@ -9,6 +9,7 @@
 #include "googleurl/src/gurl.h"
 #include "net/base/net_log.h"
 #include "net/base/net_util.h"
+#include "net/http/http_connection_warmer.h"
 #include "net/http/http_network_session.h"
 #include "net/http/http_pipelined_connection.h"
 #include "net/http/http_pipelined_host.h"
@@ -39,7 +40,10 @@ HttpStreamFactoryImpl::HttpStreamFactoryImpl(HttpNetworkSession* session)
     : session_(session),
       http_pipelined_host_pool_(this, NULL,
                                 session_->http_server_properties(),
-                                session_->force_http_pipelining()) {}
+                                session_->force_http_pipelining()) {
+  if (connection_warming_enabled())
+    connection_warmer_.reset(new HttpConnectionWarmer(session_));
+}
 
 HttpStreamFactoryImpl::~HttpStreamFactoryImpl() {
   DCHECK(request_map_.empty());
@@ -63,7 +67,11 @@ HttpStreamRequest* HttpStreamFactoryImpl::RequestStream(
     const SSLConfig& proxy_ssl_config,
     HttpStreamRequest::Delegate* delegate,
     const BoundNetLog& net_log) {
-  Request* request = new Request(request_info.url, this, delegate, net_log);
+  if (connection_warmer_.get())
+    connection_warmer_->OnRequestStream(request_info);
+
+  Request* request = new Request(request_info.url, request_info.priority,
+                                 this, delegate, net_log);
 
   GURL alternate_url;
   bool has_alternate_protocol =
@@ -224,6 +232,13 @@ void HttpStreamFactoryImpl::OnPreconnectsComplete(const Job* job) {
   OnPreconnectsCompleteInternal();
 }
 
+void HttpStreamFactoryImpl::OnSocketAssigned(
+    const HostPortPair& origin,
+    ClientSocketHandle::SocketReuseType reuse_type) {
+  if (connection_warmer_.get())
+    connection_warmer_->OnSocketAssigned(origin, reuse_type);
+}
+
 void HttpStreamFactoryImpl::OnHttpPipelinedHostHasAdditionalCapacity(
     HttpPipelinedHost* host) {
   while (ContainsKey(http_pipelining_request_map_, host->GetKey())) {
@@ -234,7 +249,16 @@ void HttpStreamFactoryImpl::OnHttpPipelinedHostHasAdditionalCapacity(
       break;
     }
 
-    Request* request = *http_pipelining_request_map_[host->GetKey()].begin();
+    // Pipelined responses come back in order, so the most important request
+    // waiting goes first. Requests of equal priority go in the order made.
+    const RequestVector& requests =
+        http_pipelining_request_map_[host->GetKey()];
+    Request* request = requests.front();
+    for (RequestVector::const_iterator it = requests.begin();
+         it != requests.end(); ++it) {
+      if ((*it)->priority() > request->priority())
+        request = *it;
+    }
     request->Complete(stream->was_npn_negotiated(),
                       stream->protocol_negotiated(),
                       false,  // not using_spdy
@@ -10,15 +10,18 @@
 #include <vector>
 
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/net_log.h"
 #include "net/http/http_pipelined_host_pool.h"
 #include "net/http/http_stream_factory.h"
 #include "net/proxy/proxy_server.h"
+#include "net/socket/client_socket_handle.h"
 #include "net/socket/ssl_client_socket.h"
 
 namespace net {
 
+class HttpConnectionWarmer;
 class HttpNetworkSession;
 class HttpPipelinedHost;
 class SpdySession;
@@ -90,6 +93,10 @@ class NET_EXPORT_PRIVATE HttpStreamFactoryImpl :
   // Called when the Preconnect completes. Used for testing.
   virtual void OnPreconnectsCompleteInternal() {}
 
+  // Invoked when a Job for a request is given a socket from a pool.
+  void OnSocketAssigned(const HostPortPair& origin,
+                        ClientSocketHandle::SocketReuseType reuse_type);
+
   void AbortPipelinedRequestsWithKey(const Job* job,
                                      const HttpPipelinedHost::Key& key,
                                      int status,
@@ -119,6 +126,9 @@ class NET_EXPORT_PRIVATE HttpStreamFactoryImpl :
   // deleted when the factory is destroyed.
   std::set<const Job*> preconnect_job_set_;
 
+  // NULL unless connection warming is enabled.
+  scoped_ptr<HttpConnectionWarmer> connection_warmer_;
+
   DISALLOW_COPY_AND_ASSIGN(HttpStreamFactoryImpl);
 };
 
@@ -851,6 +851,7 @@ int HttpStreamFactoryImpl::Job::DoInitConnectionComplete(int result) {
 
   if (connection_->socket()) {
     LogHttpConnectedMetrics(*connection_);
+    stream_factory_->OnSocketAssigned(origin_, connection_->reuse_type());
 
     // We officially have a new connection.  Record the type.
     if (!connection_->is_reused()) {
@@ -9,6 +9,7 @@
 #include "base/memory/scoped_ptr.h"
 #include "googleurl/src/gurl.h"
 #include "net/base/net_log.h"
+#include "net/base/request_priority.h"
 #include "net/http/http_stream_factory_impl.h"
 #include "net/socket/ssl_client_socket.h"
 
@@ -17,6 +18,7 @@ namespace net {
 class HttpStreamFactoryImpl::Request : public HttpStreamRequest {
  public:
   Request(const GURL& url,
+          RequestPriority priority,
           HttpStreamFactoryImpl* factory,
           HttpStreamRequest::Delegate* delegate,
           const BoundNetLog& net_log);
@@ -25,6 +27,9 @@ class HttpStreamFactoryImpl::Request : public HttpStreamRequest {
   // The GURL from the HttpRequestInfo the started the Request.
   const GURL& url() const { return url_; }
 
+  // The priority from the HttpRequestInfo that started the Request.
+  RequestPriority priority() const { return priority_; }
+
   // Called when the Job determines the appropriate |spdy_session_key| for the
   // Request. Note that this does not mean that SPDY is necessarily supported
   // for this HostPortProxyPair, since we may need to wait for NPN to complete
@@ -106,6 +111,7 @@ class HttpStreamFactoryImpl::Request : public HttpStreamRequest {
   void OrphanJobs();
 
   const GURL url_;
+  const RequestPriority priority_;
   HttpStreamFactoryImpl* const factory_;
   HttpStreamRequest::Delegate* const delegate_;
   const BoundNetLog net_log_;
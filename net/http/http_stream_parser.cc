@@ -225,6 +225,9 @@ int HttpStreamParser::SendRequest(const std::string& request_line,
       // is large enough to hold the encoded chunk.
       chunk_buf_ = new IOBufferWithSize(kRequestBodyBufferSize -
                                         kChunkHeaderFooterSize);
+    } else if (!request_body_->IsInMemory()) {
+      // Read files on a worker thread rather than blocking this one.
+      request_body_->EnableAsyncFileReads(this);
     }
   }
 
@@ -345,11 +348,15 @@ void HttpStreamParser::OnChunkAvailable() {
   // This method may get called while sending the headers or body, so check
   // before processing the new data. If we were still initializing or sending
   // headers, we will automatically start reading the chunks once we get into
-  // STATE_SENDING_CHUNKED_BODY so nothing to do here.
+  // STATE_SENDING_CHUNKED_BODY so nothing to do here. For a non-chunked body,
+  // this is called when file data the body was waiting for has been read.
   DCHECK(io_state_ == STATE_SENDING_HEADERS ||
-         io_state_ == STATE_SENDING_CHUNKED_BODY);
-  if (io_state_ == STATE_SENDING_CHUNKED_BODY)
+         io_state_ == STATE_SENDING_CHUNKED_BODY ||
+         io_state_ == STATE_SENDING_NON_CHUNKED_BODY);
+  if (io_state_ == STATE_SENDING_CHUNKED_BODY ||
+      io_state_ == STATE_SENDING_NON_CHUNKED_BODY) {
     OnIOComplete(0);
+  }
 }
 
 int HttpStreamParser::DoLoop(int result) {
@@ -507,8 +514,11 @@ int HttpStreamParser::DoSendNonChunkedBody(int result) {
     result = connection_->socket()->Write(request_body_buf_,
                                           request_body_buf_->BytesRemaining(),
                                           io_callback_);
+  } else if (consumed == ERR_IO_PENDING) {
+    // File data is being read. OnChunkAvailable() is called once it is.
+    result = ERR_IO_PENDING;
   } else {
-    // UploadDataStream::Read() won't fail if not chunked.
+    // There won't be other errors.
     NOTREACHED();
   }
   return result;
@@ -884,6 +894,14 @@ bool HttpStreamParser::CanFindEndOfResponse() const {
   return chunked_decoder_.get() || response_body_length_ >= 0;
 }
 
+int64 HttpStreamParser::GetResponseBodyBytesRemaining() const {
+  if (response_body_length_ < 0)
+    return -1;
+  if (response_body_read_ >= response_body_length_)
+    return 0;
+  return response_body_length_ - response_body_read_;
+}
+
 bool HttpStreamParser::IsMoreDataBuffered() const {
   return read_buf_->offset() > read_buf_unused_offset_;
 }
@@ -65,6 +65,10 @@ class NET_EXPORT_PRIVATE HttpStreamParser  : public ChunkCallback {
 
   bool CanFindEndOfResponse() const;
 
+  // Returns the number of response body bytes still to be read, or -1 if the
+  // length of the body isn't known.
+  int64 GetResponseBodyBytesRemaining() const;
+
   bool IsMoreDataBuffered() const;
 
   bool IsConnectionReused() const;
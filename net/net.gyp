@@ -459,6 +459,8 @@
         'http/http_content_disposition.h',
         'http/http_chunked_decoder.cc',
         'http/http_chunked_decoder.h',
+        'http/http_connection_warmer.cc',
+        'http/http_connection_warmer.h',
         'http/http_net_log_params.cc',
         'http/http_net_log_params.h',
         'http/http_network_layer.cc',
@@ -641,6 +643,8 @@
         'socket/ssl_server_socket_nss.cc',
         'socket/ssl_server_socket_nss.h',
         'socket/ssl_server_socket_openssl.cc',
+        'socket/ssl_session_store.cc',
+        'socket/ssl_session_store.h',
         'socket/ssl_socket.h',
         'socket/stream_socket.cc',
         'socket/stream_socket.h',
@@ -1032,6 +1036,7 @@
       'target_name': 'net_unittests',
       'type': 'executable',
       'dependencies': [
+        'http_server',
         'net',
         'net_test_support',
         '../base/base.gyp:base',
@@ -1151,6 +1156,7 @@
         'http/http_byte_range_unittest.cc',
         'http/http_cache_unittest.cc',
         'http/http_chunked_decoder_unittest.cc',
+        'http/http_connection_warmer_unittest.cc',
         'http/http_content_disposition_unittest.cc',
         'http/http_network_layer_unittest.cc',
         'http/http_network_transaction_spdy3_unittest.cc',
@@ -1200,6 +1206,7 @@
         'proxy/proxy_server_unittest.cc',
         'proxy/proxy_service_unittest.cc',
         'proxy/sync_host_resolver_bridge_unittest.cc',
+        'server/http_server_unittest.cc',
         'socket/buffered_write_stream_socket_unittest.cc',
         'socket/client_socket_pool_base_unittest.cc',
         'socket/deterministic_socket_data_unittest.cc',
@@ -1211,6 +1218,7 @@
         'socket/ssl_client_socket_pool_unittest.cc',
         'socket/ssl_client_socket_unittest.cc',
         'socket/ssl_server_socket_unittest.cc',
+        'socket/ssl_session_store_unittest.cc',
         'socket/tcp_client_socket_unittest.cc',
         'socket/tcp_server_socket_unittest.cc',
         'socket/transport_client_socket_pool_unittest.cc',
@@ -1263,6 +1271,7 @@
         'url_request/url_request_unittest.cc',
         'url_request/view_cache_helper_unittest.cc',
         'websockets/websocket_frame_parser_unittest.cc',
+        'websockets/websocket_frame_unittest.cc',
         'websockets/websocket_handshake_handler_unittest.cc',
         'websockets/websocket_job_spdy2_unittest.cc',
         'websockets/websocket_job_spdy3_unittest.cc',
@@ -1417,11 +1426,15 @@
         '../base/base.gyp:test_support_perf',
         '../build/temp_gyp/googleurl.gyp:googleurl',
         '../testing/gtest.gyp:gtest',
+        '../third_party/zlib/zlib.gyp:zlib',
       ],
       'sources': [
+        'base/filter_perftest.cc',
+        'base/upload_data_stream_perftest.cc',
         'cookies/cookie_monster_perftest.cc',
         'disk_cache/disk_cache_perftest.cc',
         'proxy/proxy_resolver_perftest.cc',
+        'websockets/websocket_frame_perftest.cc',
       ],
       'conditions': [
         # This is needed to trigger the dll copy step on windows.
@@ -1698,6 +1711,7 @@
              '../base/base.gyp:base',
              'net',
              '../third_party/openssl/openssl.gyp:openssl',
+             '../third_party/zlib/zlib.gyp:zlib',
            ],
            'sources': [
              'tools/dump_cache/url_to_filename_encoder.cc',
@@ -1731,6 +1745,8 @@
              'tools/flip_server/loadtime_measurement.h',
              'tools/flip_server/mem_cache.h',
              'tools/flip_server/mem_cache.cc',
+             'tools/flip_server/mem_cache_archive.cc',
+             'tools/flip_server/mem_cache_archive.h',
              'tools/flip_server/output_ordering.cc',
              'tools/flip_server/output_ordering.h',
              'tools/flip_server/ring_buffer.cc',
@@ -1753,6 +1769,27 @@
              'tools/flip_server/string_piece_utils.h',
            ],
          },
+         {
+           'target_name': 'flip_load_generator',
+           'type': 'executable',
+           'dependencies': [
+             '../base/base.gyp:base',
+           ],
+           'sources': [
+             'tools/flip_server/flip_load_generator.cc',
+           ],
+         },
+         {
+           'target_name': 'http_server_bench',
+           'type': 'executable',
+           'dependencies': [
+             '../base/base.gyp:base',
+             'http_server',
+           ],
+           'sources': [
+             'tools/http_server_bench/http_server_bench.cc',
+           ],
+         },
          {
            'target_name': 'curvecp',
            'type': 'static_library',
@@ -66,6 +66,9 @@ class MultiThreadedProxyResolver::Executor
 
   ProxyResolver* resolver() { return resolver_.get(); }
 
+  // Returns the resolver which owns this executor, or NULL after Destroy().
+  MultiThreadedProxyResolver* coordinator() { return coordinator_; }
+
   int thread_number() const { return thread_number_; }
 
  private:
@@ -223,12 +226,16 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
  public:
   // |url|         -- the URL of the query.
   // |results|     -- the structure to fill with proxy resolve results.
+  // |cache_key|   -- key to cache a successful result under, or empty if the
+  //                  result should not be cached.
   GetProxyForURLJob(const GURL& url,
                     ProxyInfo* results,
+                    const std::string& cache_key,
                     const CompletionCallback& callback,
                     const BoundNetLog& net_log)
       : Job(TYPE_GET_PROXY_FOR_URL, callback),
         results_(results),
+        cache_key_(cache_key),
         net_log_(net_log),
         url_(url),
         was_waiting_for_thread_(false) {
@@ -275,6 +282,15 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
  private:
   // Runs the completion callback on the origin thread.
   void QueryComplete(int result_code) {
+    // Record the result before running the user callback, since the callback
+    // may delete the resolver. |executor()| is NULL if the script has changed
+    // since the job was started, in which case the result is stale.
+    if (result_code == OK && !cache_key_.empty() && executor() &&
+        executor()->coordinator()) {
+      executor()->coordinator()->OnResultAvailable(
+          cache_key_, results_buf_.ToPacString());
+    }
+
     // The Job may have been cancelled after it was started.
     if (!was_cancelled()) {
       if (result_code >= OK) {  // Note: unit-tests use values > 0.
@@ -287,6 +303,7 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
 
   // Must only be used on the "origin" thread.
   ProxyInfo* results_;
+  const std::string cache_key_;
 
   // Can be used on either "origin" or worker thread.
   BoundNetLog net_log_;
@@ -392,7 +409,9 @@ MultiThreadedProxyResolver::MultiThreadedProxyResolver(
     size_t max_num_threads)
     : ProxyResolver(resolver_factory->resolvers_expect_pac_bytes()),
       resolver_factory_(resolver_factory),
-      max_num_threads_(max_num_threads) {
+      max_num_threads_(max_num_threads),
+      result_cache_key_type_(RESULT_CACHE_KEY_URL),
+      result_cache_hits_(0) {
   DCHECK_GE(max_num_threads, 1u);
 }
 
@@ -402,6 +421,16 @@ MultiThreadedProxyResolver::~MultiThreadedProxyResolver() {
   ReleaseAllExecutors();
 }
 
+void MultiThreadedProxyResolver::EnableResultCache(ResultCacheKey key_type,
+                                                   size_t max_entries,
+                                                   base::TimeDelta ttl) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_GT(max_entries, 0u);
+  result_cache_.reset(new ResultCache(max_entries));
+  result_cache_key_type_ = key_type;
+  result_cache_ttl_ = ttl;
+}
+
 int MultiThreadedProxyResolver::GetProxyForURL(
     const GURL& url, ProxyInfo* results, const CompletionCallback& callback,
     RequestHandle* request, const BoundNetLog& net_log) {
@@ -410,8 +439,21 @@ int MultiThreadedProxyResolver::GetProxyForURL(
   DCHECK(current_script_data_.get())
       << "Resolver is un-initialized. Must call SetPacScript() first!";
 
+  std::string cache_key;
+  if (result_cache_.get()) {
+    cache_key = GetResultCacheKey(url);
+    const std::string* pac_string =
+        result_cache_->Get(cache_key, base::TimeTicks::Now());
+    if (pac_string) {
+      ++result_cache_hits_;
+      results->UsePacString(*pac_string);
+      net_log.AddEvent(NetLog::TYPE_PROXY_RESOLVER_CACHE_HIT, NULL);
+      return OK;
+    }
+  }
+
   scoped_refptr<GetProxyForURLJob> job(
-      new GetProxyForURLJob(url, results, callback, net_log));
+      new GetProxyForURLJob(url, results, cache_key, callback, net_log));
 
   // Completion will be notified through |callback|, unless the caller cancels
   // the request using |request|.
@@ -499,6 +541,8 @@ void MultiThreadedProxyResolver::PurgeMemory() {
     Executor* executor = *it;
     executor->PurgeMemory();
   }
+  if (result_cache_.get())
+    result_cache_->Clear();
 }
 
 int MultiThreadedProxyResolver::SetPacScript(
@@ -510,6 +554,10 @@ int MultiThreadedProxyResolver::SetPacScript(
   // Save the script details, so we can provision new executors later.
   current_script_data_ = script_data;
 
+  // Results computed by the previous script are no longer valid.
+  if (result_cache_.get())
+    result_cache_->Clear();
+
   // The user should not have any outstanding requests when they call
   // SetPacScript().
   CheckNoOutstandingUserRequests();
@@ -589,4 +637,21 @@ void MultiThreadedProxyResolver::OnExecutorReady(Executor* executor) {
   executor->StartJob(job);
 }
 
+std::string MultiThreadedProxyResolver::GetResultCacheKey(
+    const GURL& url) const {
+  if (result_cache_key_type_ == RESULT_CACHE_KEY_URL)
+    return url.spec();
+  return url.GetOrigin().spec();
+}
+
+void MultiThreadedProxyResolver::OnResultAvailable(
+    const std::string& cache_key,
+    const std::string& pac_string) {
+  DCHECK(CalledOnValidThread());
+  if (!result_cache_.get())
+    return;
+  result_cache_->Put(cache_key, pac_string, base::TimeTicks::Now(),
+                     result_cache_ttl_);
+}
+
 }  // namespace net
@@ -7,12 +7,15 @@
 #pragma once
 
 #include <deque>
+#include <string>
 #include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/threading/non_thread_safe.h"
+#include "base/time.h"
+#include "net/base/expiring_cache.h"
 #include "net/base/net_export.h"
 #include "net/proxy/proxy_resolver.h"
 
@@ -72,10 +75,27 @@ class ProxyResolverFactory {
 //     a global counter and using that to make a decision. In the
 //     multi-threaded model, each thread may have a different value for this
 //     counter, so it won't globally be seen as monotonically increasing!
+//
+// Optionally, successful results can be cached on the origin thread (see
+// EnableResultCache()). Cache hits complete synchronously without hopping to
+// a worker thread. The cache is dropped whenever a new script is set, so
+// results from one script generation are never served for another.
 class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
     : public ProxyResolver,
       NON_EXPORTED_BASE(public base::NonThreadSafe) {
  public:
+  // Controls what part of the query URL is used to key cached results.
+  enum ResultCacheKey {
+    // The complete URL (as passed to GetProxyForURL()). This is always safe,
+    // since the PAC script sees exactly the same inputs on a hit.
+    RESULT_CACHE_KEY_URL,
+
+    // Only the scheme, host and port of the URL. This is only correct for
+    // PAC scripts whose FindProxyForURL() ignores the URL path, which is the
+    // case for most corporate scripts.
+    RESULT_CACHE_KEY_HOST,
+  };
+
   // Creates an asynchronous ProxyResolver that runs requests on up to
   // |max_num_threads|.
   //
@@ -91,6 +111,17 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
 
   virtual ~MultiThreadedProxyResolver();
 
+  // Enables caching of successful GetProxyForURL() results. Up to
+  // |max_entries| results are kept, each for at most |ttl| (PAC scripts may
+  // depend on DNS or the local IP address, so this should be short). The
+  // cache is disabled by default.
+  void EnableResultCache(ResultCacheKey key_type,
+                         size_t max_entries,
+                         base::TimeDelta ttl);
+
+  // Number of GetProxyForURL() calls answered from the result cache.
+  int result_cache_hits() const { return result_cache_hits_; }
+
   // ProxyResolver implementation:
   virtual int GetProxyForURL(const GURL& url,
                              ProxyInfo* results,
@@ -134,11 +165,27 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
   // Starts the next job from |pending_jobs_| if possible.
   void OnExecutorReady(Executor* executor);
 
+  // Returns the key under which the result for |url| is cached.
+  std::string GetResultCacheKey(const GURL& url) const;
+
+  // Called by GetProxyForURLJob on the origin thread to record the
+  // successful result |pac_string| for |cache_key|.
+  void OnResultAvailable(const std::string& cache_key,
+                         const std::string& pac_string);
+
+  // Maps cache keys to the PAC string result. NULL when caching is disabled.
+  typedef ExpiringCache<std::string, std::string> ResultCache;
+
   const scoped_ptr<ProxyResolverFactory> resolver_factory_;
   const size_t max_num_threads_;
   PendingJobsQueue pending_jobs_;
   ExecutorList executors_;
   scoped_refptr<ProxyResolverScriptData> current_script_data_;
+
+  scoped_ptr<ResultCache> result_cache_;
+  ResultCacheKey result_cache_key_type_;
+  base::TimeDelta result_cache_ttl_;
+  int result_cache_hits_;
 };
 
 }  // namespace net
@@ -614,6 +614,66 @@ TEST(MultiThreadedProxyResolverTest, SingleThread_CancelSetPacScript) {
   EXPECT_FALSE(set_pac_script_callback.have_result());
 }
 
+// Tests that successful results are served from the result cache, keyed by
+// host, and that the cache is dropped when a new PAC script is set.
+TEST(MultiThreadedProxyResolverTest, SingleThread_ResultCache) {
+  const size_t kNumThreads = 1u;
+  scoped_ptr<MockProxyResolver> mock(new MockProxyResolver);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), kNumThreads);
+  resolver.EnableResultCache(MultiThreadedProxyResolver::RESULT_CACHE_KEY_HOST,
+                             10, base::TimeDelta::FromHours(1));
+
+  int rv;
+
+  TestCompletionCallback set_script_callback;
+  rv = resolver.SetPacScript(ProxyResolverScriptData::FromUTF8("pac script"),
+                             set_script_callback.callback());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, set_script_callback.WaitForResult());
+
+  // The first request for a host goes to the worker thread.
+  TestCompletionCallback callback0;
+  ProxyInfo results0;
+  rv = resolver.GetProxyForURL(GURL("http://request0/path0"), &results0,
+                               callback0.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback0.WaitForResult());
+  EXPECT_EQ("PROXY request0:80", results0.ToPacString());
+
+  // A different URL on the same host completes synchronously from the cache.
+  TestCompletionCallback callback1;
+  CapturingBoundNetLog log1(CapturingNetLog::kUnbounded);
+  ProxyInfo results1;
+  rv = resolver.GetProxyForURL(GURL("http://request0/path1"), &results1,
+                               callback1.callback(), NULL, log1.bound());
+  EXPECT_EQ(OK, rv);
+  EXPECT_EQ("PROXY request0:80", results1.ToPacString());
+  EXPECT_EQ(1, resolver.result_cache_hits());
+  EXPECT_EQ(1, mock->request_count());
+
+  net::CapturingNetLog::EntryList entries1;
+  log1.GetEntries(&entries1);
+  ASSERT_EQ(1u, entries1.size());
+  EXPECT_EQ(NetLog::TYPE_PROXY_RESOLVER_CACHE_HIT, entries1[0].type);
+
+  // Setting a new script invalidates the cached results.
+  TestCompletionCallback set_script_callback2;
+  rv = resolver.SetPacScript(ProxyResolverScriptData::FromUTF8("pac script2"),
+                             set_script_callback2.callback());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, set_script_callback2.WaitForResult());
+
+  TestCompletionCallback callback2;
+  ProxyInfo results2;
+  rv = resolver.GetProxyForURL(GURL("http://request0/path0"), &results2,
+                               callback2.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(1, callback2.WaitForResult());
+  EXPECT_EQ(1, resolver.result_cache_hits());
+  EXPECT_EQ(2, mock->request_count());
+}
+
 // Tests setting the PAC script once, lazily creating new threads, and
 // cancelling requests.
 TEST(MultiThreadedProxyResolverTest, ThreeThreads_Basic) {
@@ -5,11 +5,16 @@
 #include "base/base_paths.h"
 #include "base/compiler_specific.h"
 #include "base/file_util.h"
+#include "base/message_loop.h"
 #include "base/path_service.h"
 #include "base/perftimer.h"
+#include "base/stl_util.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "net/base/mock_host_resolver.h"
 #include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/proxy/multi_threaded_proxy_resolver.h"
 #include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver_js_bindings.h"
 #include "net/proxy/proxy_resolver_v8.h"
@@ -217,3 +222,119 @@ TEST(ProxyResolverPerfTest, ProxyResolverV8) {
   runner.RunAllTests();
 }
 
+
+// Builds a PAC script of the shape commonly deployed in large corporate
+// networks: a long list of internal domains that go DIRECT, followed by
+// per-site proxy overrides and a default proxy. Every query that falls through
+// to the default evaluates all |num_rules| rules.
+std::string MakeCorporatePacScript(int num_rules) {
+  std::string script = "function FindProxyForURL(url, host) {\n"
+                       "  if (isPlainHostName(host))\n"
+                       "    return \"DIRECT\";\n";
+  for (int i = 0; i < num_rules; ++i) {
+    base::StringAppendF(
+        &script,
+        "  if (dnsDomainIs(host, \".division%d.corp.example\"))\n"
+        "    return \"DIRECT\";\n"
+        "  if (shExpMatch(url, \"*://*.partner%d.example/*\"))\n"
+        "    return \"PROXY partner-proxy%d.corp.example:3128\";\n",
+        i, i, i % 16);
+  }
+  script += "  return \"PROXY proxy.corp.example:8080\";\n}\n";
+  return script;
+}
+
+// Creates ProxyResolverV8 instances for MultiThreadedProxyResolver.
+class ProxyResolverV8PerfFactory : public net::ProxyResolverFactory {
+ public:
+  ProxyResolverV8PerfFactory()
+      : net::ProxyResolverFactory(true /*expects_pac_bytes*/),
+        preparse_data_(new net::ProxyResolverV8::SharedPreparseData) {}
+
+  virtual net::ProxyResolver* CreateProxyResolver() OVERRIDE {
+    net::ProxyResolverV8* resolver = new net::ProxyResolverV8(
+        net::ProxyResolverJSBindings::CreateDefault(
+            new MockSyncHostResolver, NULL, NULL));
+    resolver->set_shared_preparse_data(preparse_data_);
+    return resolver;
+  }
+
+ private:
+  // Shared as ProxyService shares it between the PAC threads.
+  scoped_refptr<net::ProxyResolverV8::SharedPreparseData> preparse_data_;
+};
+
+// Number of rules in the generated corporate PAC script (~1MB of source).
+const int kNumCorporatePacRules = 5000;
+
+// Number of distinct hosts queried. Real browsing revisits a small set of
+// hosts, which is what the result cache exploits.
+const int kNumCorporateHosts = 50;
+
+// Resolves |num_queries| URLs against a corporate-sized PAC script using
+// MultiThreadedProxyResolver with |num_threads|, keeping |num_threads|
+// requests in flight at once, and logs the achieved requests/sec.
+void RunMultiThreadedCorporatePacTest(const std::string& test_name,
+                                      size_t num_threads,
+                                      bool use_result_cache,
+                                      int num_queries) {
+  MessageLoop message_loop(MessageLoop::TYPE_IO);
+  net::MultiThreadedProxyResolver resolver(new ProxyResolverV8PerfFactory,
+                                           num_threads);
+  if (use_result_cache) {
+    resolver.EnableResultCache(
+        net::MultiThreadedProxyResolver::RESULT_CACHE_KEY_HOST,
+        1000, base::TimeDelta::FromMinutes(1));
+  }
+
+  // Time the initialization separately, since it includes compiling the
+  // script.
+  {
+    PerfTimeLogger timer((test_name + "_SetPacScript").c_str());
+    net::TestCompletionCallback callback;
+    int rv = resolver.SetPacScript(
+        net::ProxyResolverScriptData::FromUTF8(
+            MakeCorporatePacScript(kNumCorporatePacRules)),
+        callback.callback());
+    ASSERT_EQ(net::OK, callback.GetResult(rv));
+  }
+
+  PerfTimer timer;
+  int query = 0;
+  while (query < num_queries) {
+    // Issue a batch of requests so that every PAC thread has work.
+    std::vector<net::TestCompletionCallback*> callbacks;
+    std::vector<net::ProxyInfo> results(num_threads);
+    std::vector<int> rvs;
+    for (size_t i = 0; i < num_threads && query < num_queries; ++i, ++query) {
+      GURL url(base::StringPrintf("http://www%d.example.com/page%d.html",
+                                  query % kNumCorporateHosts, query));
+      callbacks.push_back(new net::TestCompletionCallback);
+      rvs.push_back(resolver.GetProxyForURL(
+          url, &results[i], callbacks.back()->callback(), NULL,
+          net::BoundNetLog()));
+    }
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+      EXPECT_EQ(net::OK, callbacks[i]->GetResult(rvs[i]));
+      EXPECT_EQ("PROXY proxy.corp.example:8080", results[i].ToPacString());
+    }
+    STLDeleteElements(&callbacks);
+  }
+
+  double seconds = timer.Elapsed().InSecondsF();
+  LogPerfResult(test_name.c_str(), num_queries / seconds, "requests/sec");
+  if (use_result_cache) {
+    LogPerfResult((test_name + "_cache_hits").c_str(),
+                  resolver.result_cache_hits(), "requests");
+  }
+}
+
+TEST(ProxyResolverPerfTest, MultiThreadedV8CorporatePac) {
+  RunMultiThreadedCorporatePacTest(
+      "MultiThreadedV8_CorporatePac", 4, false, kNumIterations);
+}
+
+TEST(ProxyResolverPerfTest, MultiThreadedV8CorporatePacWithResultCache) {
+  RunMultiThreadedCorporatePacTest(
+      "MultiThreadedV8_CorporatePac_ResultCache", 4, true, kNumIterations);
+}
@@ -137,6 +137,10 @@ class V8ExternalASCIILiteral : public v8::String::ExternalAsciiStringResource {
 // the cutoff length for when to start wrapping rather than creating copies.
 const size_t kMaxStringBytesForCopy = 256;
 
+// PAC scripts at least this big get pre-parse data. Smaller ones, like the
+// typical few-line script, compile faster than the pre-parse data is built.
+const size_t kMinPacBytesForPreparse = 4096;
+
 // Converts a V8 String to a UTF8 std::string.
 std::string V8StringToUTF8(v8::Handle<v8::String> s) {
   int len = s->Length();
@@ -184,6 +188,27 @@ v8::Local<v8::String> ASCIILiteralToV8String(const char* ascii) {
   return v8::String::NewExternal(new V8ExternalASCIILiteral(ascii, length));
 }
 
+// Returns pre-parse data for |script_data|, taking it from |shared_data| or
+// computing it (under the V8 lock which the caller must hold) and storing it
+// there. The caller takes ownership of the result. Returns NULL if V8 could
+// not pre-parse the script, in which case it is compiled without the hint.
+v8::ScriptData* GetPreparseData(
+    ProxyResolverV8::SharedPreparseData* shared_data,
+    const scoped_refptr<ProxyResolverScriptData>& script_data,
+    v8::Handle<v8::String> script) {
+  std::string data;
+  if (shared_data->Get(script_data, &data))
+    return v8::ScriptData::New(data.data(), data.size());
+
+  scoped_ptr<v8::ScriptData> preparse(v8::ScriptData::PreCompile(script));
+  if (!preparse.get() || preparse->HasError())
+    return NULL;
+
+  shared_data->Set(script_data,
+                   std::string(preparse->Data(), preparse->Length()));
+  return preparse.release();
+}
+
 // Stringizes a V8 object by calling its toString() method. Returns true
 // on success. This may fail if the toString() throws an exception.
 bool V8ObjectToUTF16String(v8::Handle<v8::Value> object,
@@ -335,9 +360,12 @@ bool IsInNetEx(const std::string& ip_address, const std::string& ip_prefix) {
 
 class ProxyResolverV8::Context {
  public:
-  explicit Context(ProxyResolverJSBindings* js_bindings)
+  // |shared_preparse_data| may be NULL.
+  Context(ProxyResolverJSBindings* js_bindings,
+          SharedPreparseData* shared_preparse_data)
       : is_resolving_host_(false),
-        js_bindings_(js_bindings) {
+        js_bindings_(js_bindings),
+        shared_preparse_data_(shared_preparse_data) {
     DCHECK(js_bindings != NULL);
   }
 
@@ -460,14 +488,23 @@ class ProxyResolverV8::Context {
         ASCIILiteralToV8String(
             PROXY_RESOLVER_SCRIPT
             PROXY_RESOLVER_SCRIPT_EX),
-        kPacUtilityResourceName);
+        kPacUtilityResourceName,
+        NULL);
     if (rv != OK) {
       NOTREACHED();
       return rv;
     }
 
-    // Add the user's PAC code to the environment.
-    rv = RunScript(ScriptDataToV8String(pac_script), kPacResourceName);
+    // Add the user's PAC code to the environment. Large PAC scripts are
+    // compiled with pre-parse data shared between all the PAC threads.
+    v8::Local<v8::String> pac_source = ScriptDataToV8String(pac_script);
+    scoped_ptr<v8::ScriptData> preparse;
+    if (shared_preparse_data_ &&
+        pac_script->utf16().size() * 2 >= kMinPacBytesForPreparse) {
+      preparse.reset(
+          GetPreparseData(shared_preparse_data_, pac_script, pac_source));
+    }
+    rv = RunScript(pac_source, kPacResourceName, preparse.get());
     if (rv != OK)
       return rv;
 
@@ -544,15 +581,19 @@ class ProxyResolverV8::Context {
     js_bindings_->OnError(line_number, error_message);
   }
 
-  // Compiles and runs |script| in the current V8 context.
+  // Compiles and runs |script| in the current V8 context. |preparse| is
+  // optional pre-parse data for |script| (may be NULL).
   // Returns OK on success, otherwise an error code.
-  int RunScript(v8::Handle<v8::String> script, const char* script_name) {
+  int RunScript(v8::Handle<v8::String> script,
+                const char* script_name,
+                v8::ScriptData* preparse) {
     v8::TryCatch try_catch;
 
     // Compile the script.
     v8::ScriptOrigin origin =
         v8::ScriptOrigin(ASCIILiteralToV8String(script_name));
-    v8::Local<v8::Script> code = v8::Script::Compile(script, &origin);
+    v8::Local<v8::Script> code =
+        v8::Script::Compile(script, &origin, preparse);
 
     // Execute.
     if (!code.IsEmpty())
@@ -714,10 +755,35 @@ class ProxyResolverV8::Context {
   mutable base::Lock lock_;
   bool is_resolving_host_;
   ProxyResolverJSBindings* js_bindings_;
+  SharedPreparseData* shared_preparse_data_;
   v8::Persistent<v8::External> v8_this_;
   v8::Persistent<v8::Context> v8_context_;
 };
 
+// ProxyResolverV8::SharedPreparseData ----------------------------------------
+
+ProxyResolverV8::SharedPreparseData::SharedPreparseData() {}
+
+bool ProxyResolverV8::SharedPreparseData::Get(
+    const scoped_refptr<ProxyResolverScriptData>& script_data,
+    std::string* data) const {
+  base::AutoLock auto_lock(lock_);
+  if (!script_data_.get() || !script_data_->Equals(script_data.get()))
+    return false;
+  *data = data_;
+  return true;
+}
+
+void ProxyResolverV8::SharedPreparseData::Set(
+    const scoped_refptr<ProxyResolverScriptData>& script_data,
+    const std::string& data) {
+  base::AutoLock auto_lock(lock_);
+  script_data_ = script_data;
+  data_ = data;
+}
+
+ProxyResolverV8::SharedPreparseData::~SharedPreparseData() {}
+
 // ProxyResolverV8 ------------------------------------------------------------
 
 ProxyResolverV8::ProxyResolverV8(
@@ -794,7 +860,8 @@ int ProxyResolverV8::SetPacScript(
     return ERR_PAC_SCRIPT_FAILED;
 
   // Try parsing the PAC script.
-  scoped_ptr<Context> context(new Context(js_bindings_.get()));
+  scoped_ptr<Context> context(
+      new Context(js_bindings_.get(), shared_preparse_data_.get()));
   int rv = context->InitV8(script_data);
   if (rv == OK)
     context_.reset(context.release());
@@ -6,8 +6,12 @@
 #define NET_PROXY_PROXY_RESOLVER_V8_H_
 #pragma once
 
+#include <string>
+
 #include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
 #include "net/base/net_export.h"
 #include "net/proxy/proxy_resolver.h"
 
@@ -35,6 +39,38 @@ class ProxyResolverJSBindings;
 // and does not use locking since it expects to be alone.
 class NET_EXPORT_PRIVATE ProxyResolverV8 : public ProxyResolver {
  public:
+  // V8 pre-parse data for the PAC script most recently loaded by any of the
+  // ProxyResolverV8s sharing it. MultiThreadedProxyResolver provisions one
+  // ProxyResolverV8 per thread from the same script, so a factory that gives
+  // all of them one SharedPreparseData lets every thread but the first skip
+  // pre-parsing a large script. The data is freed along with the last
+  // resolver holding it.
+  class NET_EXPORT_PRIVATE SharedPreparseData
+      : public base::RefCountedThreadSafe<SharedPreparseData> {
+   public:
+    SharedPreparseData();
+
+    // Copies the stored pre-parse data into |data| and returns true if it was
+    // stored for a script equal to |script_data|.
+    bool Get(const scoped_refptr<ProxyResolverScriptData>& script_data,
+             std::string* data) const;
+
+    // Stores |data| as the pre-parse data of |script_data|, replacing the data
+    // of any other script.
+    void Set(const scoped_refptr<ProxyResolverScriptData>& script_data,
+             const std::string& data);
+
+   private:
+    friend class base::RefCountedThreadSafe<SharedPreparseData>;
+    ~SharedPreparseData();
+
+    mutable base::Lock lock_;
+    scoped_refptr<ProxyResolverScriptData> script_data_;
+    std::string data_;
+
+    DISALLOW_COPY_AND_ASSIGN(SharedPreparseData);
+  };
+
   // Constructs a ProxyResolverV8 with custom bindings. ProxyResolverV8 takes
   // ownership of |custom_js_bindings| and deletes it when ProxyResolverV8
   // is destroyed.
@@ -44,6 +80,14 @@ class NET_EXPORT_PRIVATE ProxyResolverV8 : public ProxyResolver {
 
   ProxyResolverJSBindings* js_bindings() const { return js_bindings_.get(); }
 
+  // Makes large PAC scripts compile with pre-parse data shared with the other
+  // resolvers given the same |preparse_data|. Without it, scripts are
+  // compiled without pre-parse data, as computing it only pays off when it is
+  // reused. Must be called before SetPacScript().
+  void set_shared_preparse_data(SharedPreparseData* preparse_data) {
+    shared_preparse_data_ = preparse_data;
+  }
+
   // ProxyResolver implementation:
   virtual int GetProxyForURL(const GURL& url,
                              ProxyInfo* results,
@@ -70,6 +114,8 @@ class NET_EXPORT_PRIVATE ProxyResolverV8 : public ProxyResolver {
 
   scoped_ptr<ProxyResolverJSBindings> js_bindings_;
 
+  scoped_refptr<SharedPreparseData> shared_preparse_data_;
+
   DISALLOW_COPY_AND_ASSIGN(ProxyResolverV8);
 };
 
@@ -569,5 +569,52 @@ TEST(ProxyResolverV8Test, IPv6HostnamesNotBracketed) {
   EXPECT_EQ("abcd::efff", resolver.mock_js_bindings()->dns_resolves_ex[0]);
 }
 
+// Test that resolvers given the same SharedPreparseData pre-parse a large
+// script once between them, and that resolvers without it still load the
+// script.
+TEST(ProxyResolverV8Test, SharedPreparseData) {
+  // Large enough to be pre-parsed.
+  std::string script = "function FindProxyForURL(url, host) {\n";
+  for (int i = 0; script.size() < 64 * 1024; ++i) {
+    script += base::StringPrintf(
+        "  if (host == 'host%d.example.com') return 'PROXY proxy%d:80';\n",
+        i, i);
+  }
+  script += "  return 'DIRECT';\n}\n";
+  scoped_refptr<ProxyResolverScriptData> script_data =
+      ProxyResolverScriptData::FromUTF8(script);
+
+  scoped_refptr<ProxyResolverV8::SharedPreparseData> preparse_data(
+      new ProxyResolverV8::SharedPreparseData);
+  std::string data;
+  EXPECT_FALSE(preparse_data->Get(script_data, &data));
+
+  ProxyResolverV8WithMockBindings resolver1;
+  resolver1.set_shared_preparse_data(preparse_data);
+  EXPECT_EQ(OK, resolver1.SetPacScript(script_data, CompletionCallback()));
+  ASSERT_TRUE(preparse_data->Get(script_data, &data));
+  EXPECT_FALSE(data.empty());
+
+  // An equal script loaded from separate data reuses the stored data.
+  ProxyResolverV8WithMockBindings resolver2;
+  resolver2.set_shared_preparse_data(preparse_data);
+  EXPECT_EQ(OK, resolver2.SetPacScript(
+      ProxyResolverScriptData::FromUTF8(script), CompletionCallback()));
+
+  ProxyResolverV8WithMockBindings resolver3;
+  EXPECT_EQ(OK, resolver3.SetPacScript(script_data, CompletionCallback()));
+
+  ProxyResolverV8WithMockBindings* resolvers[] = {
+    &resolver1, &resolver2, &resolver3
+  };
+  for (size_t i = 0; i < arraysize(resolvers); ++i) {
+    ProxyInfo proxy_info;
+    EXPECT_EQ(OK, resolvers[i]->GetProxyForURL(
+        GURL("http://host7.example.com/"), &proxy_info,
+        CompletionCallback(), NULL, BoundNetLog()));
+    EXPECT_EQ("proxy7:80", proxy_info.proxy_server().ToURI());
+  }
+}
+
 }  // namespace
 }  // namespace net
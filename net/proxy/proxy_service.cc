@@ -52,6 +52,13 @@ namespace {
 const size_t kMaxNumNetLogEntries = 100;
 const size_t kDefaultNumPacThreads = 4;
 
+// Successful PAC results are cached by URL, so that a URL that is resolved
+// again (a redirect, a retry, the same subresource on another page) does not
+// wait for a PAC thread. Scripts may depend on DNS or the time of day, so the
+// entries expire quickly. Loading a new script drops them all.
+const size_t kMaxPacResultCacheEntries = 256;
+const int kPacResultCacheTTLSeconds = 10;
+
 // When the IP address changes we don't immediately re-run proxy auto-config.
 // Instead, we  wait for |kDelayAfterNetworkChangesMs| before
 // attempting to re-valuate proxy auto-config.
@@ -271,7 +278,8 @@ class ProxyResolverFactoryForV8 : public ProxyResolverFactory {
         io_loop_(io_loop),
         origin_loop_(origin_loop),
         net_log_(net_log),
-        network_delegate_(network_delegate) {
+        network_delegate_(network_delegate),
+        preparse_data_(new ProxyResolverV8::SharedPreparseData) {
   }
 
   virtual ProxyResolver* CreateProxyResolver() OVERRIDE {
@@ -291,7 +299,9 @@ class ProxyResolverFactoryForV8 : public ProxyResolverFactory {
             sync_host_resolver, net_log_, error_observer);
 
     // ProxyResolverV8 takes ownership of |js_bindings|.
-    return new ProxyResolverV8(js_bindings);
+    ProxyResolverV8* resolver = new ProxyResolverV8(js_bindings);
+    resolver->set_shared_preparse_data(preparse_data_);
+    return resolver;
   }
 
  private:
@@ -300,8 +310,27 @@ class ProxyResolverFactoryForV8 : public ProxyResolverFactory {
   scoped_refptr<base::MessageLoopProxy> origin_loop_;
   NetLog* net_log_;
   NetworkDelegate* network_delegate_;
+
+  // Shared by the resolvers of all the PAC threads, so that a large script is
+  // pre-parsed once per load rather than once per thread.
+  scoped_refptr<ProxyResolverV8::SharedPreparseData> preparse_data_;
 };
 
+// Creates a MultiThreadedProxyResolver running the resolvers of
+// |resolver_factory| on up to |num_pac_threads| threads, with the PAC result
+// cache enabled.
+MultiThreadedProxyResolver* CreateMultiThreadedProxyResolver(
+    ProxyResolverFactory* resolver_factory,
+    size_t num_pac_threads) {
+  MultiThreadedProxyResolver* resolver =
+      new MultiThreadedProxyResolver(resolver_factory, num_pac_threads);
+  resolver->EnableResultCache(
+      MultiThreadedProxyResolver::RESULT_CACHE_KEY_URL,
+      kMaxPacResultCacheEntries,
+      TimeDelta::FromSeconds(kPacResultCacheTTLSeconds));
+  return resolver;
+}
+
 // Creates ProxyResolvers using a platform-specific implementation.
 class ProxyResolverFactoryForSystem : public ProxyResolverFactory {
  public:
@@ -955,7 +984,7 @@ ProxyService* ProxyService::CreateUsingV8ProxyResolver(
           network_delegate);
 
   ProxyResolver* proxy_resolver =
-      new MultiThreadedProxyResolver(sync_resolver_factory, num_pac_threads);
+      CreateMultiThreadedProxyResolver(sync_resolver_factory, num_pac_threads);
 
   ProxyService* proxy_service =
       new ProxyService(proxy_config_service, proxy_resolver, net_log);
@@ -983,7 +1012,7 @@ ProxyService* ProxyService::CreateUsingSystemProxyResolver(
   if (num_pac_threads == 0)
     num_pac_threads = kDefaultNumPacThreads;
 
-  ProxyResolver* proxy_resolver = new MultiThreadedProxyResolver(
+  ProxyResolver* proxy_resolver = CreateMultiThreadedProxyResolver(
       new ProxyResolverFactoryForSystem(), num_pac_threads);
 
   return new ProxyService(proxy_config_service, proxy_resolver, net_log);
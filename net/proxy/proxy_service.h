@@ -212,6 +212,9 @@ class NET_EXPORT ProxyService : public NetworkChangeNotifier::IPAddressObserver,
   //       between runs (such scripts should not be common though).
   //   (b) increases the memory used by proxy resolving, as each thread will
   //       duplicate its own script context.
+  //
+  // Successful PAC results are cached by URL for a few seconds (see
+  // MultiThreadedProxyResolver::EnableResultCache()).
 
   // |proxy_script_fetcher| specifies the dependency to use for downloading
   // any PAC scripts. The resulting ProxyService will take ownership of it.
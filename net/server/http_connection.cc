@@ -4,6 +4,7 @@
 
 #include "net/server/http_connection.h"
 
+#include "base/logging.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "net/base/stream_listen_socket.h"
@@ -12,6 +13,13 @@
 
 namespace net {
 
+namespace {
+
+// SendChunk() reports backpressure once this much data is queued on the socket.
+const int kMaxPendingStreamingBytes = 256 * 1024;
+
+}  // namespace
+
 int HttpConnection::last_id_ = 0;
 
 void HttpConnection::Send(const std::string& data) {
@@ -62,9 +70,50 @@ void HttpConnection::Send500(const std::string& message) {
       message.c_str()));
 }
 
+void HttpConnection::StartStreamingResponse(const std::string& content_type) {
+  DCHECK(!streaming_);
+  streaming_ = true;
+  if (!socket_)
+    return;
+  socket_->Send(base::StringPrintf(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type:%s\r\n"
+      "Transfer-Encoding:chunked\r\n"
+      "\r\n",
+      content_type.c_str()));
+}
+
+bool HttpConnection::SendChunk(const std::string& data) {
+  DCHECK(streaming_);
+  if (!socket_)
+    return true;
+  // An empty chunk would terminate the response.
+  if (!data.empty()) {
+    socket_->Send(base::StringPrintf("%X\r\n", static_cast<int>(data.size())));
+    socket_->Send(data);
+    socket_->Send("\r\n", 2);
+  }
+  if (socket_->send_pending_size() > kMaxPendingStreamingBytes) {
+    waiting_for_drain_ = true;
+    return false;
+  }
+  return true;
+}
+
+void HttpConnection::FinishStreamingResponse() {
+  DCHECK(streaming_);
+  streaming_ = false;
+  waiting_for_drain_ = false;
+  if (!socket_)
+    return;
+  socket_->Send("0\r\n\r\n", 5);
+}
+
 HttpConnection::HttpConnection(HttpServer* server, StreamListenSocket* sock)
     : server_(server),
-      socket_(sock) {
+      socket_(sock),
+      streaming_(false),
+      waiting_for_drain_(false) {
   id_ = last_id_++;
 }
 
@@ -78,7 +127,7 @@ void HttpConnection::DetachSocket() {
 }
 
 void HttpConnection::Shift(int num_bytes) {
-  recv_data_ = recv_data_.substr(num_bytes);
+  recv_data_.erase(0, num_bytes);
 }
 
 }  // namespace net
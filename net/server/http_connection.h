@@ -26,6 +26,11 @@ class HttpConnection {
   void Send404();
   void Send500(const std::string& message);
 
+  void StartStreamingResponse(const std::string& content_type);
+  // Returns false if more than a few hundred KB are waiting to be written.
+  bool SendChunk(const std::string& data);
+  void FinishStreamingResponse();
+
   void Shift(int num_bytes);
 
   const std::string& recv_data() const { return recv_data_; }
@@ -45,6 +50,10 @@ class HttpConnection {
   scoped_ptr<WebSocket> web_socket_;
   std::string recv_data_;
   int id_;
+  // True between StartStreamingResponse() and FinishStreamingResponse().
+  bool streaming_;
+  // True if SendChunk() returned false and the socket has not drained since.
+  bool waiting_for_drain_;
   DISALLOW_COPY_AND_ASSIGN(HttpConnection);
 };
 
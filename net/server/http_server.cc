@@ -6,10 +6,12 @@
 
 #include "base/compiler_specific.h"
 #include "base/logging.h"
+#include "base/string_number_conversions.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "base/sys_byteorder.h"
 #include "build/build_config.h"
+#include "net/base/net_errors.h"
 #include "net/base/tcp_listen_socket.h"
 #include "net/server/http_connection.h"
 #include "net/server/http_server_request_info.h"
@@ -17,10 +19,18 @@
 
 namespace net {
 
+namespace {
+
+// Request bodies larger than this are refused.
+const int64 kMaxRequestBodySize = 10 * 1024 * 1024;
+
+}  // namespace
+
 HttpServer::HttpServer(const std::string& host,
                        int port,
                        HttpServer::Delegate* del)
-    : delegate_(del) {
+    : delegate_(del),
+      max_connections_(0) {
   server_ = TCPListenSocket::CreateAndListen(host, port, this);
 }
 
@@ -93,8 +103,47 @@ void HttpServer::Close(int connection_id)
   DidClose(connection->socket_);
 }
 
+int HttpServer::GetLocalAddress(IPEndPoint* address) {
+  if (!server_)
+    return ERR_SOCKET_NOT_CONNECTED;
+  return server_->GetLocalAddress(address);
+}
+
+void HttpServer::StartStreamingResponse(int connection_id,
+                                        const std::string& content_type) {
+  HttpConnection* connection = FindConnection(connection_id);
+  if (connection == NULL)
+    return;
+  connection->StartStreamingResponse(content_type);
+}
+
+bool HttpServer::SendChunk(int connection_id, const std::string& data) {
+  HttpConnection* connection = FindConnection(connection_id);
+  if (connection == NULL)
+    return true;
+  return connection->SendChunk(data);
+}
+
+void HttpServer::FinishStreamingResponse(int connection_id) {
+  HttpConnection* connection = FindConnection(connection_id);
+  if (connection == NULL)
+    return;
+  connection->FinishStreamingResponse();
+  // Deliver the requests that were pipelined behind the response.
+  ProcessReceivedData(connection);
+}
+
 void HttpServer::DidAccept(StreamListenSocket* server,
                            StreamListenSocket* socket) {
+  if (max_connections_ && id_to_connection_.size() >= max_connections_) {
+    // Not keeping a reference closes the socket.
+    socket->Send(
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Connection: close\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n");
+    return;
+  }
   HttpConnection* connection = new HttpConnection(this, socket);
   id_to_connection_[connection->id()] = connection;
   socket_to_connection_[socket] = connection;
@@ -109,6 +158,31 @@ void HttpServer::DidRead(StreamListenSocket* socket,
     return;
 
   connection->recv_data_.append(data, len);
+  ProcessReceivedData(connection);
+}
+
+void HttpServer::DidClose(StreamListenSocket* socket) {
+  HttpConnection* connection = FindConnection(socket);
+  DCHECK(connection != NULL);
+  id_to_connection_.erase(connection->id());
+  socket_to_connection_.erase(connection->socket_);
+  delete connection;
+}
+
+void HttpServer::DidDrainSendBuffer(StreamListenSocket* socket) {
+  HttpConnection* connection = FindConnection(socket);
+  if (connection == NULL || !connection->waiting_for_drain_)
+    return;
+  connection->waiting_for_drain_ = false;
+  delegate_->OnStreamingResponseWritable(connection->id());
+}
+
+void HttpServer::ProcessReceivedData(HttpConnection* connection) {
+  const int connection_id = connection->id();
+  // The delegate may close the connection, or finish a streaming response and
+  // so re-enter this method, from any of its callbacks. Each request is
+  // removed from recv_data_ before it is dispatched, and the connection looked
+  // up again afterwards.
   while (connection->recv_data_.length()) {
     if (connection->web_socket_.get()) {
       std::string message;
@@ -118,42 +192,47 @@ void HttpServer::DidRead(StreamListenSocket* socket,
 
       if (result == WebSocket::FRAME_CLOSE ||
           result == WebSocket::FRAME_ERROR) {
-        Close(connection->id());
+        Close(connection_id);
         break;
       }
-      delegate_->OnWebSocketMessage(connection->id(), message);
-      continue;
-    }
+      delegate_->OnWebSocketMessage(connection_id, message);
+    } else {
+      // Responses to pipelined requests have to go out in order, so hold
+      // them back while a response is being streamed.
+      if (connection->streaming_)
+        break;
 
-    HttpServerRequestInfo request;
-    size_t pos = 0;
-    if (!ParseHeaders(connection, &request, &pos))
-      break;
+      HttpServerRequestInfo request;
+      size_t pos = 0;
+      if (!ParseHeaders(connection, &request, &pos))
+        break;
 
-    std::string connection_header = request.GetHeaderValue("Connection");
-    if (connection_header == "Upgrade") {
-      connection->web_socket_.reset(WebSocket::CreateWebSocket(connection,
-                                                               request,
-                                                               &pos));
+      std::string connection_header = request.GetHeaderValue("Connection");
+      if (connection_header == "Upgrade") {
+        connection->web_socket_.reset(WebSocket::CreateWebSocket(connection,
+                                                                 request,
+                                                                 &pos));
 
-      if (!connection->web_socket_.get())  // Not enought data was received.
-        break;
-      delegate_->OnWebSocketRequest(connection->id(), request);
-      connection->Shift(pos);
-      continue;
+        if (!connection->web_socket_.get())  // Not enought data was received.
+          break;
+        connection->Shift(pos);
+        delegate_->OnWebSocketRequest(connection_id, request);
+      } else {
+        bool error = false;
+        if (!ParseBody(connection, &request, &pos, &error)) {
+          if (error)
+            Close(connection_id);
+          break;
+        }
+        connection->Shift(pos);
+        delegate_->OnHttpRequest(connection_id, request);
+      }
     }
-    // Request body is not supported. It is always empty.
-    delegate_->OnHttpRequest(connection->id(), request);
-    connection->Shift(pos);
-  }
-}
 
-void HttpServer::DidClose(StreamListenSocket* socket) {
-  HttpConnection* connection = FindConnection(socket);
-  DCHECK(connection != NULL);
-  id_to_connection_.erase(connection->id());
-  socket_to_connection_.erase(connection->socket_);
-  delete connection;
+    connection = FindConnection(connection_id);
+    if (connection == NULL)
+      return;
+  }
 }
 
 HttpServer::~HttpServer() {
@@ -295,6 +374,28 @@ bool HttpServer::ParseHeaders(HttpConnection* connection,
   return false;
 }
 
+bool HttpServer::ParseBody(HttpConnection* connection,
+                           HttpServerRequestInfo* info,
+                           size_t* pos,
+                           bool* error) {
+  std::string content_length = info->GetHeaderValue("Content-Length");
+  if (content_length.empty())
+    return true;
+
+  int64 length;
+  if (!base::StringToInt64(content_length, &length) || length < 0 ||
+      length > kMaxRequestBodySize) {
+    *error = true;
+    return false;
+  }
+  if (connection->recv_data_.length() - *pos < static_cast<size_t>(length))
+    return false;
+
+  info->data = connection->recv_data_.substr(*pos, length);
+  *pos += length;
+  return true;
+}
+
 HttpConnection* HttpServer::FindConnection(int connection_id) {
   IdToConnectionMap::iterator it = id_to_connection_.find(connection_id);
   if (it == id_to_connection_.end())
@@ -17,6 +17,7 @@ namespace net {
 
 class HttpConnection;
 class HttpServerRequestInfo;
+class IPEndPoint;
 class WebSocket;
 
 class HttpServer : public StreamListenSocket::Delegate,
@@ -35,6 +36,10 @@ class HttpServer : public StreamListenSocket::Delegate,
 
     virtual void OnClose(int connection_id) = 0;
 
+    // Called when a streaming response that SendChunk() reported as backed up
+    // can accept more data.
+    virtual void OnStreamingResponseWritable(int connection_id) {}
+
    protected:
     virtual ~Delegate() {}
   };
@@ -53,6 +58,27 @@ class HttpServer : public StreamListenSocket::Delegate,
   void Send500(int connection_id, const std::string& message);
   void Close(int connection_id);
 
+  // Copies the address the server is listening on to |address|. Returns a
+  // network error code.
+  int GetLocalAddress(IPEndPoint* address);
+
+  // Streams a response body of unknown length using chunked transfer
+  // encoding. While a response is streaming, pipelined requests on the same
+  // connection are held back, and delivered once it is finished.
+  void StartStreamingResponse(int connection_id,
+                              const std::string& content_type);
+  // Returns false if the connection is not keeping up. The chunk is still
+  // sent, but the delegate should stop producing data until
+  // OnStreamingResponseWritable() is called.
+  bool SendChunk(int connection_id, const std::string& data);
+  void FinishStreamingResponse(int connection_id);
+
+  // Connections accepted beyond |max_connections| are sent a 503 and closed.
+  // 0, the default, means no limit.
+  void set_max_connections(size_t max_connections) {
+    max_connections_ = max_connections;
+  }
+
   // ListenSocketDelegate
   virtual void DidAccept(StreamListenSocket* server,
                          StreamListenSocket* socket) OVERRIDE;
@@ -60,6 +86,7 @@ class HttpServer : public StreamListenSocket::Delegate,
                        const char* data,
                        int len) OVERRIDE;
   virtual void DidClose(StreamListenSocket* socket) OVERRIDE;
+  virtual void DidDrainSendBuffer(StreamListenSocket* socket) OVERRIDE;
 
  protected:
   virtual ~HttpServer();
@@ -68,6 +95,10 @@ class HttpServer : public StreamListenSocket::Delegate,
   friend class base::RefCountedThreadSafe<HttpServer>;
   friend class HttpConnection;
 
+  // Dispatches the complete requests and WebSocket frames buffered in
+  // |connection|. May delete |connection|.
+  void ProcessReceivedData(HttpConnection* connection);
+
   // Expects the raw data to be stored in recv_data_. If parsing is successful,
   // will remove the data parsed from recv_data_, leaving only the unused
   // recv data.
@@ -75,11 +106,20 @@ class HttpServer : public StreamListenSocket::Delegate,
                     HttpServerRequestInfo* info,
                     size_t* pos);
 
+  // Reads the body of |info| from recv_data_ at |pos|, per its
+  // Content-Length. Returns false if the body has not been fully received
+  // yet; sets |*error| if the Content-Length is invalid.
+  bool ParseBody(HttpConnection* connection,
+                 HttpServerRequestInfo* info,
+                 size_t* pos,
+                 bool* error);
+
   HttpConnection* FindConnection(int connection_id);
   HttpConnection* FindConnection(StreamListenSocket* socket);
 
   HttpServer::Delegate* delegate_;
   scoped_refptr<StreamListenSocket> server_;
+  size_t max_connections_;
   typedef std::map<int, HttpConnection*> IdToConnectionMap;
   IdToConnectionMap id_to_connection_;
   typedef std::map<StreamListenSocket*, HttpConnection*> SocketToConnectionMap;
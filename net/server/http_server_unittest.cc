@@ -0,0 +1,285 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/stringprintf.h"
+#include "net/base/address_list.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/base/test_completion_callback.h"
+#include "net/server/http_server.h"
+#include "net/server/http_server_request_info.h"
+#include "net/socket/tcp_client_socket.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// A blocking client for the server under test.  Each call runs the message
+// loop until its operation completes.
+class TestHttpClient {
+ public:
+  TestHttpClient() {}
+
+  int ConnectAndWait(const IPEndPoint& address) {
+    socket_.reset(new TCPClientSocket(AddressList(address), NULL,
+                                      NetLog::Source()));
+    TestCompletionCallback callback;
+    return callback.GetResult(socket_->Connect(callback.callback()));
+  }
+
+  void Send(const std::string& data) {
+    scoped_refptr<DrainableIOBuffer> buffer(
+        new DrainableIOBuffer(new StringIOBuffer(data), data.size()));
+    while (buffer->BytesRemaining() > 0) {
+      TestCompletionCallback callback;
+      int rv = callback.GetResult(socket_->Write(
+          buffer, buffer->BytesRemaining(), callback.callback()));
+      ASSERT_GT(rv, 0);
+      buffer->DidConsume(rv);
+    }
+  }
+
+  // Appends to |message| until it holds at least |num_bytes|.  Returns false
+  // if the server closes the connection first.
+  bool Read(size_t num_bytes, std::string* message) {
+    scoped_refptr<IOBufferWithSize> buffer(new IOBufferWithSize(4096));
+    while (message->size() < num_bytes) {
+      TestCompletionCallback callback;
+      int rv = callback.GetResult(socket_->Read(buffer, buffer->size(),
+                                                callback.callback()));
+      if (rv <= 0)
+        return false;
+      message->append(buffer->data(), rv);
+    }
+    return true;
+  }
+
+ private:
+  scoped_ptr<TCPClientSocket> socket_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestHttpClient);
+};
+
+class HttpServerTest : public testing::Test,
+                       public HttpServer::Delegate {
+ public:
+  HttpServerTest() : quit_after_requests_(0), stream_responses_(false) {}
+
+  virtual void SetUp() OVERRIDE {
+    server_ = new HttpServer("127.0.0.1", 0, this);
+    ASSERT_EQ(OK, server_->GetLocalAddress(&server_address_));
+  }
+
+  // HttpServer::Delegate implementation:
+  virtual void OnHttpRequest(int connection_id,
+                             const HttpServerRequestInfo& info) OVERRIDE {
+    requests_.push_back(info);
+    connection_ids_.push_back(connection_id);
+    if (stream_responses_)
+      server_->StartStreamingResponse(connection_id, "text/plain");
+    if (requests_.size() == quit_after_requests_)
+      MessageLoop::current()->Quit();
+  }
+
+  virtual void OnWebSocketRequest(int connection_id,
+                                  const HttpServerRequestInfo& info) OVERRIDE {
+    NOTREACHED();
+  }
+
+  virtual void OnWebSocketMessage(int connection_id,
+                                  const std::string& data) OVERRIDE {
+    NOTREACHED();
+  }
+
+  virtual void OnClose(int connection_id) OVERRIDE {}
+
+ protected:
+  // Runs the message loop until |count| requests have arrived in total.
+  void WaitForRequests(size_t count) {
+    quit_after_requests_ = count;
+    if (requests_.size() < count)
+      MessageLoop::current()->Run();
+  }
+
+  // Sends a request with the given Content-Length and checks that the server
+  // closes the connection without dispatching it.
+  void ExpectRejectedContentLength(const std::string& content_length) {
+    TestHttpClient client;
+    ASSERT_EQ(OK, client.ConnectAndWait(server_address_));
+    client.Send("POST /test HTTP/1.1\r\n"
+                "Content-Length: " + content_length + "\r\n"
+                "\r\n"
+                "hello");
+    std::string response;
+    EXPECT_FALSE(client.Read(1, &response)) << content_length;
+    EXPECT_TRUE(response.empty()) << content_length;
+    EXPECT_TRUE(requests_.empty()) << content_length;
+  }
+
+  MessageLoopForIO message_loop_;
+  scoped_refptr<HttpServer> server_;
+  IPEndPoint server_address_;
+  std::vector<HttpServerRequestInfo> requests_;
+  std::vector<int> connection_ids_;
+  size_t quit_after_requests_;
+  // If true, OnHttpRequest() starts a streaming response to every request.
+  bool stream_responses_;
+};
+
+TEST_F(HttpServerTest, Request) {
+  TestHttpClient client;
+  ASSERT_EQ(OK, client.ConnectAndWait(server_address_));
+  client.Send("GET /test HTTP/1.1\r\n"
+              "Host: localhost\r\n"
+              "\r\n");
+  WaitForRequests(1);
+  EXPECT_EQ("GET", requests_[0].method);
+  EXPECT_EQ("/test", requests_[0].path);
+  EXPECT_EQ("localhost", requests_[0].GetHeaderValue("Host"));
+  EXPECT_EQ("", requests_[0].data);
+}
+
+// The body is read according to Content-Length, and not taken for the start
+// of another request.
+TEST_F(HttpServerTest, RequestWithBody) {
+  TestHttpClient client;
+  ASSERT_EQ(OK, client.ConnectAndWait(server_address_));
+  client.Send("POST /test HTTP/1.1\r\n"
+              "Content-Length: 17\r\n"
+              "\r\n"
+              "GET /x HTTP/1.1\r");
+  // The last byte of the body arrives on its own.
+  client.Send("\n");
+  client.Send("GET /next HTTP/1.1\r\n"
+              "\r\n");
+  WaitForRequests(2);
+  EXPECT_EQ("POST", requests_[0].method);
+  EXPECT_EQ("GET /x HTTP/1.1\r\n", requests_[0].data);
+  EXPECT_EQ("/next", requests_[1].path);
+  EXPECT_EQ("", requests_[1].data);
+}
+
+TEST_F(HttpServerTest, MalformedContentLength) {
+  ExpectRejectedContentLength("abc");
+  ExpectRejectedContentLength("5abc");
+  ExpectRejectedContentLength("-1");
+}
+
+TEST_F(HttpServerTest, OversizedContentLength) {
+  // One byte over the 10MB limit.
+  ExpectRejectedContentLength("10485761");
+  ExpectRejectedContentLength("99999999999999999999999");
+}
+
+// Pipelined requests are all dispatched, in order, and so are the responses.
+TEST_F(HttpServerTest, PipelinedRequests) {
+  TestHttpClient client;
+  ASSERT_EQ(OK, client.ConnectAndWait(server_address_));
+  client.Send("GET /1 HTTP/1.1\r\n"
+              "\r\n"
+              "POST /2 HTTP/1.1\r\n"
+              "Content-Length: 3\r\n"
+              "\r\n"
+              "abc"
+              "GET /3 HTTP/1.1\r\n"
+              "\r\n");
+  WaitForRequests(3);
+  ASSERT_EQ(3u, requests_.size());
+  EXPECT_EQ("/1", requests_[0].path);
+  EXPECT_EQ("/2", requests_[1].path);
+  EXPECT_EQ("abc", requests_[1].data);
+  EXPECT_EQ("/3", requests_[2].path);
+  EXPECT_EQ(connection_ids_[0], connection_ids_[1]);
+  EXPECT_EQ(connection_ids_[0], connection_ids_[2]);
+
+  std::string expected;
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    server_->Send200(connection_ids_[i], requests_[i].path, "text/plain");
+    expected += base::StringPrintf("HTTP/1.1 200 OK\r\n"
+                                   "Content-Type:text/plain\r\n"
+                                   "Content-Length:2\r\n"
+                                   "\r\n"
+                                   "%s",
+                                   requests_[i].path.c_str());
+  }
+  std::string response;
+  ASSERT_TRUE(client.Read(expected.size(), &response));
+  EXPECT_EQ(expected, response);
+}
+
+TEST_F(HttpServerTest, StreamingResponse) {
+  stream_responses_ = true;
+  TestHttpClient client;
+  ASSERT_EQ(OK, client.ConnectAndWait(server_address_));
+  client.Send("GET /stream HTTP/1.1\r\n"
+              "\r\n");
+  WaitForRequests(1);
+
+  EXPECT_TRUE(server_->SendChunk(connection_ids_[0], "hello"));
+  // Empty chunks would end the response, so they are not sent at all.
+  EXPECT_TRUE(server_->SendChunk(connection_ids_[0], ""));
+  EXPECT_TRUE(server_->SendChunk(connection_ids_[0], "0123456789abcdef!"));
+  server_->FinishStreamingResponse(connection_ids_[0]);
+
+  const std::string expected =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type:text/plain\r\n"
+      "Transfer-Encoding:chunked\r\n"
+      "\r\n"
+      "5\r\nhello\r\n"
+      "11\r\n0123456789abcdef!\r\n"
+      "0\r\n\r\n";
+  std::string response;
+  ASSERT_TRUE(client.Read(expected.size(), &response));
+  EXPECT_EQ(expected, response);
+}
+
+// A request pipelined behind one that gets a streaming response is only
+// dispatched once that response is finished.
+TEST_F(HttpServerTest, PipelinedRequestWaitsForStreamingResponse) {
+  stream_responses_ = true;
+  TestHttpClient client;
+  ASSERT_EQ(OK, client.ConnectAndWait(server_address_));
+  client.Send("GET /1 HTTP/1.1\r\n"
+              "\r\n"
+              "GET /2 HTTP/1.1\r\n"
+              "\r\n");
+  WaitForRequests(1);
+  MessageLoop::current()->RunAllPending();
+  ASSERT_EQ(1u, requests_.size());
+
+  server_->SendChunk(connection_ids_[0], "one");
+  server_->FinishStreamingResponse(connection_ids_[0]);
+  ASSERT_EQ(2u, requests_.size());
+  EXPECT_EQ("/2", requests_[1].path);
+  server_->SendChunk(connection_ids_[1], "two");
+  server_->FinishStreamingResponse(connection_ids_[1]);
+
+  const std::string headers =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type:text/plain\r\n"
+      "Transfer-Encoding:chunked\r\n"
+      "\r\n";
+  const std::string expected =
+      headers + "3\r\none\r\n0\r\n\r\n" + headers + "3\r\ntwo\r\n0\r\n\r\n";
+  std::string response;
+  ASSERT_TRUE(client.Read(expected.size(), &response));
+  EXPECT_EQ(expected, response);
+}
+
+}  // namespace
+
+}  // namespace net
@@ -5,10 +5,13 @@
 #include "net/socket/client_socket_pool_base.h"
 
 #include <math.h>
+#include <algorithm>
+
 #include "base/compiler_specific.h"
 #include "base/format_macros.h"
 #include "base/logging.h"
 #include "base/message_loop.h"
+#include "base/metrics/histogram.h"
 #include "base/metrics/stats_counters.h"
 #include "base/stl_util.h"
 #include "base/string_number_conversions.h"
@@ -39,6 +42,11 @@ const int kCleanupInterval = 10;  // DO NOT INCREASE THIS TIMEOUT.
 // after a certain timeout has passed without receiving an ACK.
 bool g_connect_backup_jobs_enabled = true;
 
+// Indicate whether groups whose requests wait on the per-group limit for
+// longer than |g_adaptive_group_limit_queue_time_ms| may open extra sockets.
+bool g_adaptive_group_limits_enabled = false;
+int64 g_adaptive_group_limit_queue_time_ms = 500;
+
 double g_socket_reuse_policy_penalty_exponent = -1;
 int g_socket_reuse_policy = -1;
 
@@ -46,6 +54,33 @@ int g_socket_reuse_policy = -1;
 
 namespace net {
 
+namespace {
+
+// NetLog parameters for the time a request spent in its group's queue.
+class QueueTimeParameters : public NetLog::EventParameters {
+ public:
+  QueueTimeParameters(RequestPriority priority, base::TimeDelta queue_time)
+      : priority_(priority), queue_time_(queue_time) {
+  }
+
+  virtual Value* ToValue() const {
+    DictionaryValue* dict = new DictionaryValue();
+    dict->SetInteger("priority", priority_);
+    dict->SetInteger("queue_ms",
+                     static_cast<int>(queue_time_.InMilliseconds()));
+    return dict;
+  }
+
+ protected:
+  virtual ~QueueTimeParameters() {}
+
+ private:
+  const RequestPriority priority_;
+  const base::TimeDelta queue_time_;
+};
+
+}  // namespace
+
 int GetSocketReusePolicy() {
   return g_socket_reuse_policy;
 }
@@ -175,6 +210,11 @@ ClientSocketPoolBaseHelper::Request::Request(
 
 ClientSocketPoolBaseHelper::Request::~Request() {}
 
+void ClientSocketPoolBaseHelper::Request::MarkQueued() const {
+  if (queue_start_time_.is_null())
+    queue_start_time_ = base::TimeTicks::Now();
+}
+
 ClientSocketPoolBaseHelper::ClientSocketPoolBaseHelper(
     int max_sockets,
     int max_sockets_per_group,
@@ -348,13 +388,22 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
   // Can we make another active socket now?
   if (!group->HasAvailableSocketSlot(max_sockets_per_group_) &&
       !request->ignore_limits()) {
-    // TODO(willchan): Consider whether or not we need to close a socket in a
-    // higher layered group. I don't think this makes sense since we would just
-    // reuse that socket then if we needed one and wouldn't make it down to this
-    // layer.
+    if (preconnecting || !ShouldRaiseGroupLimit(*group)) {
+      // TODO(willchan): Consider whether or not we need to close a socket in a
+      // higher layered group. I don't think this makes sense since we would
+      // just reuse that socket then if we needed one and wouldn't make it down
+      // to this layer.
+      request->net_log().AddEvent(
+          NetLog::TYPE_SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP, NULL);
+      if (!preconnecting)
+        request->MarkQueued();
+      return ERR_IO_PENDING;
+    }
+    group->IncrementExtraSocketSlots();
     request->net_log().AddEvent(
-        NetLog::TYPE_SOCKET_POOL_STALLED_MAX_SOCKETS_PER_GROUP, NULL);
-    return ERR_IO_PENDING;
+        NetLog::TYPE_SOCKET_POOL_RAISED_GROUP_LIMIT,
+        make_scoped_refptr(new NetLogIntegerParameter(
+            "extra_socket_slots", group->extra_socket_slots())));
   }
 
   if (ReachedMaxSocketsLimit() && !request->ignore_limits()) {
@@ -372,6 +421,8 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
       // a scan of all groups, so just flip a flag here, and do the check later.
       request->net_log().AddEvent(
           NetLog::TYPE_SOCKET_POOL_STALLED_MAX_SOCKETS, NULL);
+      if (!preconnecting)
+        request->MarkQueued();
       return ERR_IO_PENDING;
     }
   }
@@ -539,6 +590,18 @@ bool ClientSocketPoolBaseHelper::HasGroup(const std::string& group_name) const {
   return ContainsKey(group_map_, group_name);
 }
 
+void ClientSocketPoolBaseHelper::AgeIdleSocketsInGroupForTesting(
+    const std::string& group_name,
+    base::TimeDelta age) {
+  GroupMap::iterator it = group_map_.find(group_name);
+  CHECK(it != group_map_.end());
+  std::list<IdleSocket>* idle_sockets = it->second->mutable_idle_sockets();
+  for (std::list<IdleSocket>::iterator i = idle_sockets->begin();
+       i != idle_sockets->end(); ++i) {
+    i->start_time -= age;
+  }
+}
+
 void ClientSocketPoolBaseHelper::CloseIdleSockets() {
   CleanupIdleSockets(true);
   DCHECK_EQ(0, idle_socket_count_);
@@ -619,6 +682,7 @@ DictionaryValue* ClientSocketPoolBaseHelper::GetInfoAsValue(
     }
 
     group_dict->SetInteger("active_socket_count", group->active_socket_count());
+    group_dict->SetInteger("extra_socket_slots", group->extra_socket_slots());
 
     ListValue* idle_socket_list = new ListValue();
     std::list<IdleSocket>::const_iterator idle_socket;
@@ -733,6 +797,96 @@ void ClientSocketPoolBaseHelper::EnableConnectBackupJobs() {
   connect_backup_jobs_enabled_ = g_connect_backup_jobs_enabled;
 }
 
+// static
+bool ClientSocketPoolBaseHelper::adaptive_group_limits_enabled() {
+  return g_adaptive_group_limits_enabled;
+}
+
+// static
+bool ClientSocketPoolBaseHelper::set_adaptive_group_limits_enabled(
+    bool enabled) {
+  bool old_value = g_adaptive_group_limits_enabled;
+  g_adaptive_group_limits_enabled = enabled;
+  return old_value;
+}
+
+// static
+base::TimeDelta ClientSocketPoolBaseHelper::adaptive_group_limit_queue_time() {
+  return TimeDelta::FromMilliseconds(g_adaptive_group_limit_queue_time_ms);
+}
+
+// static
+base::TimeDelta ClientSocketPoolBaseHelper::set_adaptive_group_limit_queue_time(
+    base::TimeDelta queue_time) {
+  base::TimeDelta old_value = adaptive_group_limit_queue_time();
+  g_adaptive_group_limit_queue_time_ms = queue_time.InMilliseconds();
+  return old_value;
+}
+
+bool ClientSocketPoolBaseHelper::ShouldRaiseGroupLimit(
+    const Group& group) const {
+  if (!g_adaptive_group_limits_enabled)
+    return false;
+  // At most double the group's limit, and never at the expense of other
+  // groups: once the pool is full, slots are handed out by priority instead.
+  if (group.extra_socket_slots() >= max_sockets_per_group_ ||
+      ReachedMaxSocketsLimit()) {
+    return false;
+  }
+  // Only requests that are not waiting on a ConnectJob are stalled.
+  if (group.pending_requests().size() <= group.jobs().size())
+    return false;
+  return group.LongestQueueTime(base::TimeTicks::Now()) >=
+      adaptive_group_limit_queue_time();
+}
+
+// static
+void ClientSocketPoolBaseHelper::LogQueuedRequestEnd(const Request& request,
+                                                     int result) {
+  // Requests that never waited for a socket slot only waited on their own
+  // ConnectJob, which the connect time histograms already cover.
+  if (result != OK || request.queue_start_time().is_null()) {
+    request.net_log().EndEventWithNetErrorCode(NetLog::TYPE_SOCKET_POOL,
+                                               result);
+    return;
+  }
+
+  base::TimeDelta queue_time =
+      base::TimeTicks::Now() - request.queue_start_time();
+  request.net_log().EndEvent(
+      NetLog::TYPE_SOCKET_POOL,
+      make_scoped_refptr(new QueueTimeParameters(request.priority(),
+                                                 queue_time)));
+
+#define QUEUE_TIME_HISTOGRAM(name) \
+    UMA_HISTOGRAM_CUSTOM_TIMES(name, queue_time, \
+                               base::TimeDelta::FromMilliseconds(1), \
+                               base::TimeDelta::FromMinutes(10), 100)
+
+  switch (request.priority()) {
+    case IDLE:
+      QUEUE_TIME_HISTOGRAM("Net.SocketPoolQueueTime_Idle");
+      break;
+    case LOWEST:
+      QUEUE_TIME_HISTOGRAM("Net.SocketPoolQueueTime_Lowest");
+      break;
+    case LOW:
+      QUEUE_TIME_HISTOGRAM("Net.SocketPoolQueueTime_Low");
+      break;
+    case MEDIUM:
+      QUEUE_TIME_HISTOGRAM("Net.SocketPoolQueueTime_Medium");
+      break;
+    case HIGHEST:
+      QUEUE_TIME_HISTOGRAM("Net.SocketPoolQueueTime_Highest");
+      break;
+    default:
+      NOTREACHED();
+      break;
+  }
+
+#undef QUEUE_TIME_HISTOGRAM
+}
+
 void ClientSocketPoolBaseHelper::IncrementIdleCount() {
   if (++idle_socket_count_ == 1 && use_cleanup_timer_)
     StartIdleSocketTimer();
@@ -774,6 +928,10 @@ void ClientSocketPoolBaseHelper::ReleaseSocket(const std::string& group_name,
   CHECK_GT(group->active_socket_count(), 0);
   group->DecrementActiveSocketCount();
 
+  // The group no longer needs the extra slot it was given for its queue.
+  if (group->extra_socket_slots() > 0 && group->pending_requests().empty())
+    group->DecrementExtraSocketSlots();
+
   const bool can_reuse = socket->IsConnectedAndIdle() &&
       id == pool_generation_number_;
   if (can_reuse) {
@@ -873,7 +1031,7 @@ void ClientSocketPoolBaseHelper::OnConnectJobComplete(
       HandOutSocket(
           socket.release(), false /* unused socket */, r->handle(),
           base::TimeDelta(), group, r->net_log());
-      r->net_log().EndEvent(NetLog::TYPE_SOCKET_POOL, NULL);
+      LogQueuedRequestEnd(*r, result);
       InvokeUserCallbackLater(r->handle(), r->callback(), result);
     } else {
       AddIdleSocket(socket.release(), group);
@@ -895,8 +1053,7 @@ void ClientSocketPoolBaseHelper::OnConnectJobComplete(
         HandOutSocket(socket.release(), false /* unused socket */, r->handle(),
                       base::TimeDelta(), group, r->net_log());
       }
-      r->net_log().EndEventWithNetErrorCode(NetLog::TYPE_SOCKET_POOL,
-                                            result);
+      LogQueuedRequestEnd(*r, result);
       InvokeUserCallbackLater(r->handle(), r->callback(), result);
     } else {
       RemoveConnectJob(job, group);
@@ -975,7 +1132,7 @@ void ClientSocketPoolBaseHelper::ProcessPendingRequest(
     if (group->IsEmpty())
       RemoveGroup(group_name);
 
-    request->net_log().EndEventWithNetErrorCode(NetLog::TYPE_SOCKET_POOL, rv);
+    LogQueuedRequestEnd(*request, rv);
     InvokeUserCallbackLater(request->handle(), request->callback(), rv);
   }
 }
@@ -1084,24 +1241,31 @@ bool ClientSocketPoolBaseHelper::CloseOneIdleSocketExceptInGroup(
     const Group* exception_group) {
   CHECK_GT(idle_socket_count(), 0);
 
+  // Each group's idle sockets are ordered oldest first, so the least recently
+  // used idle socket is at the front of one of the groups.
+  GroupMap::iterator oldest = group_map_.end();
   for (GroupMap::iterator i = group_map_.begin(); i != group_map_.end(); ++i) {
     Group* group = i->second;
-    if (exception_group == group)
+    if (exception_group == group || group->idle_sockets().empty())
       continue;
-    std::list<IdleSocket>* idle_sockets = group->mutable_idle_sockets();
-
-    if (!idle_sockets->empty()) {
-      delete idle_sockets->front().socket;
-      idle_sockets->pop_front();
-      DecrementIdleCount();
-      if (group->IsEmpty())
-        RemoveGroup(i);
-
-      return true;
+    if (oldest == group_map_.end() ||
+        group->idle_sockets().front().start_time <
+            oldest->second->idle_sockets().front().start_time) {
+      oldest = i;
     }
   }
+  if (oldest == group_map_.end())
+    return false;
 
-  return false;
+  Group* group = oldest->second;
+  std::list<IdleSocket>* idle_sockets = group->mutable_idle_sockets();
+  delete idle_sockets->front().socket;
+  idle_sockets->pop_front();
+  DecrementIdleCount();
+  if (group->IsEmpty())
+    RemoveGroup(oldest);
+
+  return true;
 }
 
 bool ClientSocketPoolBaseHelper::CloseOneIdleConnectionInLayeredPool() {
@@ -1143,6 +1307,7 @@ void ClientSocketPoolBaseHelper::InvokeUserCallback(
 
 ClientSocketPoolBaseHelper::Group::Group()
     : active_socket_count_(0),
+      extra_socket_slots_(0),
       ALLOW_THIS_IN_INITIALIZER_LIST(weak_factory_(this)) {}
 
 ClientSocketPoolBaseHelper::Group::~Group() {
@@ -1163,6 +1328,17 @@ void ClientSocketPoolBaseHelper::Group::StartBackupSocketTimer(
       pool->ConnectRetryInterval());
 }
 
+base::TimeDelta ClientSocketPoolBaseHelper::Group::LongestQueueTime(
+    base::TimeTicks now) const {
+  base::TimeTicks oldest = now;
+  for (RequestQueue::const_iterator it = pending_requests_.begin();
+       it != pending_requests_.end(); ++it) {
+    if (!(*it)->queue_start_time().is_null())
+      oldest = std::min(oldest, (*it)->queue_start_time());
+  }
+  return now - oldest;
+}
+
 bool ClientSocketPoolBaseHelper::Group::TryToUsePreconnectConnectJob() {
   for (std::set<ConnectJob*>::iterator it = jobs_.begin();
        it != jobs_.end(); ++it) {
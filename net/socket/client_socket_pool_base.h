@@ -204,6 +204,13 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
     Flags flags() const { return flags_; }
     const BoundNetLog& net_log() const { return net_log_; }
 
+    // The time the request first had to wait for a socket slot, either in its
+    // group or in the pool.  Null if it never did.
+    base::TimeTicks queue_start_time() const { return queue_start_time_; }
+    // The pool only holds const Requests, so this is const as well.  Only the
+    // first call has an effect.
+    void MarkQueued() const;
+
    private:
     ClientSocketHandle* const handle_;
     CompletionCallback callback_;
@@ -211,6 +218,7 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
     bool ignore_limits_;
     const Flags flags_;
     BoundNetLog net_log_;
+    mutable base::TimeTicks queue_start_time_;
 
     DISALLOW_COPY_AND_ASSIGN(Request);
   };
@@ -303,6 +311,11 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
 
   bool HasGroup(const std::string& group_name) const;
 
+  // Makes the idle sockets of |group_name| look idle for |age| longer than
+  // they have been, so tests need not sleep to order them.
+  void AgeIdleSocketsInGroupForTesting(const std::string& group_name,
+                                       base::TimeDelta age);
+
   // Called to enable/disable cleaning up idle sockets. When enabled,
   // idle sockets that have been around for longer than a period defined
   // by kCleanupInterval are cleaned up using a timer. Otherwise they are
@@ -315,11 +328,8 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
   // sockets that timed out or can't be reused.  Made public for testing.
   void CleanupIdleSockets(bool force);
 
-  // Closes one idle socket.  Picks the first one encountered.
-  // TODO(willchan): Consider a better algorithm for doing this.  Perhaps we
-  // should keep an ordered list of idle sockets, and close them in order.
-  // Requires maintaining more state.  It's not clear if it's worth it since
-  // I'm not sure if we hit this situation often.
+  // Closes one idle socket, the one that has been idle the longest across all
+  // groups.
   bool CloseOneIdleSocket();
 
   // Checks layered pools to see if they can close an idle connection.
@@ -336,6 +346,17 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
   static bool connect_backup_jobs_enabled();
   static bool set_connect_backup_jobs_enabled(bool enabled);
 
+  // Called to enable/disable adaptive per-group limits. When enabled, a group
+  // whose requests have been queued on its socket limit for longer than
+  // |adaptive_group_limit_queue_time| may open up to |max_sockets_per_group|
+  // more sockets, as long as the pool is below its total limit. The extra
+  // slots are given back once the group has no more pending requests.
+  static bool adaptive_group_limits_enabled();
+  static bool set_adaptive_group_limits_enabled(bool enabled);
+  static base::TimeDelta adaptive_group_limit_queue_time();
+  static base::TimeDelta set_adaptive_group_limit_queue_time(
+      base::TimeDelta queue_time);
+
   void EnableConnectBackupJobs();
 
   // ConnectJob::Delegate methods:
@@ -382,7 +403,8 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
     }
 
     bool HasAvailableSocketSlot(int max_sockets_per_group) const {
-      return NumActiveSocketSlots() < max_sockets_per_group;
+      return NumActiveSocketSlots() <
+          max_sockets_per_group + extra_socket_slots_;
     }
 
     int NumActiveSocketSlots() const {
@@ -420,6 +442,16 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
     void IncrementActiveSocketCount() { active_socket_count_++; }
     void DecrementActiveSocketCount() { active_socket_count_--; }
 
+    // Slots allowed above the pool's |max_sockets_per_group_|, see
+    // set_adaptive_group_limits_enabled().
+    void IncrementExtraSocketSlots() { extra_socket_slots_++; }
+    void DecrementExtraSocketSlots() { extra_socket_slots_--; }
+    int extra_socket_slots() const { return extra_socket_slots_; }
+
+    // Returns the time the longest queued pending request has been waiting for
+    // a socket slot.
+    base::TimeDelta LongestQueueTime(base::TimeTicks now) const;
+
     const std::set<ConnectJob*>& jobs() const { return jobs_; }
     const std::list<IdleSocket>& idle_sockets() const { return idle_sockets_; }
     const RequestQueue& pending_requests() const { return pending_requests_; }
@@ -437,6 +469,7 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
     std::set<ConnectJob*> jobs_;
     RequestQueue pending_requests_;
     int active_socket_count_;  // number of active sockets used by clients
+    int extra_socket_slots_;
     // A factory to pin the backup_job tasks.
     base::WeakPtrFactory<Group> weak_factory_;
   };
@@ -480,6 +513,14 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
   // and |group_name| with data of the stalled group having highest priority.
   bool FindTopStalledGroup(Group** group, std::string* group_name) const;
 
+  // Returns true if |group|, which has no available socket slot, should be
+  // given an extra one because its requests have been queued for too long.
+  bool ShouldRaiseGroupLimit(const Group& group) const;
+
+  // Ends the NetLog event of |request|, which was queued and completed with
+  // |result|, and records how long it waited in the queue, by priority.
+  static void LogQueuedRequestEnd(const Request& request, int result);
+
   // Called when timer_ fires.  This method scans the idle sockets removing
   // sockets that timed out or can't be reused.
   void OnCleanupTimerFired() {
@@ -531,8 +572,9 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
       const NetLog::Source& connect_job_source, const Request* request);
 
   // Same as CloseOneIdleSocket() except it won't close an idle socket in
-  // |group|.  If |group| is NULL, it is ignored.  Returns true if it closed a
-  // socket.
+  // |group|.  If |group| is NULL, it is ignored.  Closes the socket that has
+  // been idle the longest, so under socket pressure the sockets of recently
+  // used groups are kept.  Returns true if it closed a socket.
   bool CloseOneIdleSocketExceptInGroup(const Group* group);
 
   // Checks if there are stalled socket groups that should be notified
@@ -750,6 +792,11 @@ class ClientSocketPoolBase {
     return helper_.CleanupIdleSockets(force);
   }
 
+  void AgeIdleSocketsInGroupForTesting(const std::string& group_name,
+                                       base::TimeDelta age) {
+    helper_.AgeIdleSocketsInGroupForTesting(group_name, age);
+  }
+
   base::DictionaryValue* GetInfoAsValue(const std::string& name,
                                         const std::string& type) const {
     return helper_.GetInfoAsValue(name, type);
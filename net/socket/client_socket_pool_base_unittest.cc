@@ -539,6 +539,11 @@ class TestClientSocketPool : public ClientSocketPool {
 
   void CleanupTimedOutIdleSockets() { base_.CleanupIdleSockets(false); }
 
+  void AgeIdleSocketsInGroup(const std::string& group_name,
+                             base::TimeDelta age) {
+    base_.AgeIdleSocketsInGroupForTesting(group_name, age);
+  }
+
   void EnableConnectBackupJobs() { base_.EnableConnectBackupJobs(); }
 
   bool CloseOneIdleConnectionInLayeredPool() {
@@ -609,6 +614,10 @@ class ClientSocketPoolBaseTest : public testing::Test {
     internal::ClientSocketPoolBaseHelper::set_connect_backup_jobs_enabled(true);
     cleanup_timer_enabled_ =
         internal::ClientSocketPoolBaseHelper::cleanup_timer_enabled();
+    adaptive_group_limits_enabled_ =
+        internal::ClientSocketPoolBaseHelper::adaptive_group_limits_enabled();
+    adaptive_group_limit_queue_time_ =
+        internal::ClientSocketPoolBaseHelper::adaptive_group_limit_queue_time();
   }
 
   virtual ~ClientSocketPoolBaseTest() {
@@ -616,6 +625,10 @@ class ClientSocketPoolBaseTest : public testing::Test {
         connect_backup_jobs_enabled_);
     internal::ClientSocketPoolBaseHelper::set_cleanup_timer_enabled(
         cleanup_timer_enabled_);
+    internal::ClientSocketPoolBaseHelper::set_adaptive_group_limits_enabled(
+        adaptive_group_limits_enabled_);
+    internal::ClientSocketPoolBaseHelper::set_adaptive_group_limit_queue_time(
+        adaptive_group_limit_queue_time_);
   }
 
   void CreatePool(int max_sockets, int max_sockets_per_group) {
@@ -666,6 +679,8 @@ class ClientSocketPoolBaseTest : public testing::Test {
 
   bool connect_backup_jobs_enabled_;
   bool cleanup_timer_enabled_;
+  bool adaptive_group_limits_enabled_;
+  base::TimeDelta adaptive_group_limit_queue_time_;
   MockClientSocketFactory client_socket_factory_;
   TestConnectJobFactory* connect_job_factory_;
   scoped_refptr<TestSocketParams> params_;
@@ -1287,6 +1302,79 @@ TEST_F(ClientSocketPoolBaseTest, CloseIdleSocketAtSocketLimitDeleteGroup) {
   EXPECT_EQ(kDefaultMaxSockets - 1, pool_->IdleSocketCount());
 }
 
+// Make sure that at the socket limit, the idle socket closed is the one that
+// has been idle the longest, whichever group it is in.
+TEST_F(ClientSocketPoolBaseTest, CloseIdleSocketAtSocketLimitClosesOldest) {
+  // Long enough that aging "b" below does not time its socket out.
+  CreatePoolWithIdleTimeouts(2, 2,
+                             base::TimeDelta::FromHours(1),
+                             base::TimeDelta::FromHours(1));
+  connect_job_factory_->set_job_type(TestConnectJob::kMockJob);
+
+  // "b" goes idle before "a", although "a" is first in the sorted map.
+  ClientSocketHandle handle;
+  TestCompletionCallback callback;
+  EXPECT_EQ(OK, handle.Init("b",
+                            params_,
+                            kDefaultPriority,
+                            callback.callback(),
+                            pool_.get(),
+                            BoundNetLog()));
+  handle.Reset();
+  EXPECT_EQ(OK, handle.Init("a",
+                            params_,
+                            kDefaultPriority,
+                            callback.callback(),
+                            pool_.get(),
+                            BoundNetLog()));
+  handle.Reset();
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(2, pool_->IdleSocketCount());
+  pool_->AgeIdleSocketsInGroup("b", base::TimeDelta::FromMinutes(1));
+
+  EXPECT_EQ(OK, handle.Init("c",
+                            params_,
+                            kDefaultPriority,
+                            callback.callback(),
+                            pool_.get(),
+                            BoundNetLog()));
+
+  EXPECT_FALSE(pool_->HasGroup("b"));
+  EXPECT_EQ(1, pool_->IdleSocketCountInGroup("a"));
+  EXPECT_EQ(3, client_socket_factory_.allocation_count());
+}
+
+// Make sure that a group whose requests wait on its limit gets extra sockets
+// when adaptive group limits are enabled.
+TEST_F(ClientSocketPoolBaseTest, AdaptiveGroupLimit) {
+  internal::ClientSocketPoolBaseHelper::set_adaptive_group_limits_enabled(
+      true);
+  internal::ClientSocketPoolBaseHelper::set_adaptive_group_limit_queue_time(
+      base::TimeDelta());
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+  connect_job_factory_->set_job_type(TestConnectJob::kMockPendingJob);
+
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", kDefaultPriority));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", kDefaultPriority));
+  // The third request is the first to wait on the group's limit.
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", kDefaultPriority));
+  EXPECT_EQ(kDefaultMaxSocketsPerGroup, pool_->NumConnectJobsInGroup("a"));
+
+  // It has now been queued long enough to raise the limit.
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("a", kDefaultPriority));
+  EXPECT_EQ(kDefaultMaxSocketsPerGroup + 1,
+            pool_->NumConnectJobsInGroup("a"));
+
+  ReleaseAllConnections(ClientSocketPoolTest::NO_KEEP_ALIVE);
+
+  // Sockets still go to the requests in the order they were queued.
+  EXPECT_EQ(1, GetOrderOfRequest(1));
+  EXPECT_EQ(2, GetOrderOfRequest(2));
+  EXPECT_EQ(3, GetOrderOfRequest(3));
+  EXPECT_EQ(4, GetOrderOfRequest(4));
+  EXPECT_EQ(ClientSocketPoolTest::kIndexOutOfBounds, GetOrderOfRequest(5));
+}
+
 TEST_F(ClientSocketPoolBaseTest, PendingRequests) {
   CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
 
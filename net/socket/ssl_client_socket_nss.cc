@@ -570,6 +570,7 @@ int SSLClientSocketNSS::Connect(const CompletionCallback& callback) {
   EnsureThreadIdAssigned();
 
   net_log_.BeginEvent(NetLog::TYPE_SSL_CONNECT, NULL);
+  handshake_start_time_ = base::TimeTicks::Now();
 
   int rv = Init();
   if (rv != OK) {
@@ -2556,6 +2557,21 @@ void SSLClientSocketNSS::RecordDomainBoundCertSupport() const {
                             DOMAIN_BOUND_CERT_USAGE_MAX);
 }
 
+void SSLClientSocketNSS::RecordHandshakeMetrics() const {
+  PRBool last_handshake_resumed;
+  SECStatus ok = SSL_HandshakeResumedSession(nss_fd_, &last_handshake_resumed);
+  if (ok != SECSuccess)
+    return;
+
+  UMA_HISTOGRAM_BOOLEAN("Net.SSLSessionResumed", !!last_handshake_resumed);
+  base::TimeDelta handshake_time =
+      base::TimeTicks::Now() - handshake_start_time_;
+  if (last_handshake_resumed)
+    UMA_HISTOGRAM_TIMES("Net.SSLHandshakeTime.Resumed", handshake_time);
+  else
+    UMA_HISTOGRAM_TIMES("Net.SSLHandshakeTime.Full", handshake_time);
+}
+
 // static
 // NSS calls this when handshake is completed.
 // After the SSL handshake is finished, use CertVerifier to verify
@@ -2567,6 +2583,7 @@ void SSLClientSocketNSS::HandshakeCallback(PRFileDesc* socket,
   that->handshake_callback_called_ = true;
 
   that->RecordDomainBoundCertSupport();
+  that->RecordHandshakeMetrics();
   that->UpdateServerCert();
   that->UpdateConnectionStatus();
 }
@@ -194,6 +194,8 @@ class SSLClientSocketNSS : public SSLClientSocket {
   // Record histograms for DBC support.  The histogram will only be updated if
   // this socket did a full handshake.
   void RecordDomainBoundCertSupport() const;
+  // Record histograms for session resumption and handshake latency.
+  void RecordHandshakeMetrics() const;
 
   // NSS calls this when handshake is completed.  We pass 'this' as the second
   // argument.
@@ -264,6 +266,7 @@ class SSLClientSocketNSS : public SSLClientSocket {
 
   // True if NSS has called HandshakeCallback.
   bool handshake_callback_called_;
+  base::TimeTicks handshake_start_time_;
 
   // True if the SSL handshake has been completed.
   bool completed_handshake_;
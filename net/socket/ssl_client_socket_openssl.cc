@@ -24,6 +24,7 @@
 #include "net/base/ssl_info.h"
 #include "net/base/x509_certificate_net_log_param.h"
 #include "net/socket/ssl_error_params.h"
+#include "net/socket/ssl_session_store.h"
 
 namespace net {
 
@@ -351,9 +352,27 @@ class SSLContext {
     session_cache_.OnSessionAdded(socket->host_and_port(),
                                   socket->ssl_session_cache_shard(),
                                   session);
+    StoreSession(socket, session);
     return 1;  // 1 => We took ownership of |session|.
   }
 
+  // Keeps a serialized copy of |session| in the SSLSessionStore, from which it
+  // can be resumed after it has left the SSL_CTX cache, or after a restart.
+  void StoreSession(SSLClientSocketOpenSSL* socket, SSL_SESSION* session) {
+    int length = i2d_SSL_SESSION(session, NULL);
+    if (length <= 0)
+      return;
+    std::string serialized(length, '\0');
+    unsigned char* p = reinterpret_cast<unsigned char*>(&serialized[0]);
+    if (i2d_SSL_SESSION(session, &p) != length)
+      return;
+    base::Time expiry = base::Time::FromTimeT(
+        SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session));
+    SSLSessionStore::GetInstance()->Add(socket->ssl_session_cache_shard(),
+                                        socket->host_and_port(),
+                                        serialized, expiry);
+  }
+
   static void RemoveSessionCallbackStatic(SSL_CTX* ctx, SSL_SESSION* session) {
     return GetInstance()->RemoveSessionCallback(ctx, session);
   }
@@ -407,6 +426,7 @@ struct SslSetClearMask {
 void SSLClientSocket::ClearSessionCache() {
   SSLContext* context = SSLContext::GetInstance();
   context->session_cache()->Flush();
+  SSLSessionStore::GetInstance()->Clear();
 }
 
 SSLClientSocketOpenSSL::SSLClientSocketOpenSSL(
@@ -427,6 +447,7 @@ SSLClientSocketOpenSSL::SSLClientSocketOpenSSL(
       ssl_config_(ssl_config),
       ssl_session_cache_shard_(context.ssl_session_cache_shard),
       trying_cached_session_(false),
+      trying_stored_session_(false),
       next_handshake_state_(STATE_NONE),
       npn_status_(kNextProtoUnsupported),
       net_log_(transport_socket->socket()->NetLog()) {
@@ -453,6 +474,8 @@ bool SSLClientSocketOpenSSL::Init() {
   trying_cached_session_ =
       context->session_cache()->SetSSLSession(ssl_, host_and_port_,
                                               ssl_session_cache_shard_);
+  if (!trying_cached_session_)
+    trying_stored_session_ = SetStoredSession();
 
   BIO* ssl_bio = NULL;
   // 0 => use default buffer sizes.
@@ -536,6 +559,39 @@ bool SSLClientSocketOpenSSL::Init() {
   return true;
 }
 
+bool SSLClientSocketOpenSSL::SetStoredSession() {
+  std::string serialized;
+  if (!SSLSessionStore::GetInstance()->Lookup(ssl_session_cache_shard_,
+                                              host_and_port_, &serialized)) {
+    return false;
+  }
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(serialized.data());
+  crypto::ScopedOpenSSL<SSL_SESSION, SSL_SESSION_free> session(
+      d2i_SSL_SESSION(NULL, &p, serialized.size()));
+  if (!session.get()) {
+    SSLSessionStore::GetInstance()->Remove(ssl_session_cache_shard_,
+                                           host_and_port_);
+    return false;
+  }
+  // SSL_set_session takes its own reference.
+  return SSL_set_session(ssl_, session.get()) == 1;
+}
+
+void SSLClientSocketOpenSSL::RecordHandshakeMetrics() {
+  bool resumed = !!SSL_session_reused(ssl_);
+  UMA_HISTOGRAM_BOOLEAN("Net.SSLSessionResumed", resumed);
+  if (trying_stored_session_)
+    UMA_HISTOGRAM_BOOLEAN("Net.SSLSessionResumedFromStore", resumed);
+
+  base::TimeDelta handshake_time =
+      base::TimeTicks::Now() - handshake_start_time_;
+  if (resumed)
+    UMA_HISTOGRAM_TIMES("Net.SSLHandshakeTime.Resumed", handshake_time);
+  else
+    UMA_HISTOGRAM_TIMES("Net.SSLHandshakeTime.Full", handshake_time);
+}
+
 int SSLClientSocketOpenSSL::ClientCertRequestCallback(SSL* ssl,
                                                       X509** x509,
                                                       EVP_PKEY** pkey) {
@@ -684,6 +740,8 @@ int SSLClientSocketOpenSSL::Connect(const CompletionCallback& callback) {
     return result;
   }
 
+  handshake_start_time_ = base::TimeTicks::Now();
+
   // Set SSL to client mode. Handshake happens in the loop below.
   SSL_set_connect_state(ssl_);
 
@@ -795,12 +853,15 @@ int SSLClientSocketOpenSSL::DoHandshake() {
         int rv = SSL_CTX_remove_session(SSL_get_SSL_CTX(ssl_), session);
         LOG_IF(WARNING, !rv) << "Couldn't invalidate SSL session: " << session;
       }
+      SSLSessionStore::GetInstance()->Remove(ssl_session_cache_shard_,
+                                             host_and_port_);
     }
   } else if (rv == 1) {
     if (trying_cached_session_ && logging::DEBUG_MODE) {
       DVLOG(2) << "Result of session reuse for " << host_and_port_.ToString()
                << " is: " << (SSL_session_reused(ssl_) ? "Success" : "Fail");
     }
+    RecordHandshakeMetrics();
     // SSL handshake is completed.  Let's verify the certificate.
     const bool got_cert = !!UpdateServerCert();
     DCHECK(got_cert);
@@ -10,6 +10,7 @@
 
 #include "base/compiler_specific.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/time.h"
 #include "net/base/cert_verify_result.h"
 #include "net/base/completion_callback.h"
 #include "net/base/io_buffer.h"
@@ -93,6 +94,10 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
 
  private:
   bool Init();
+  // Offers the session the SSLSessionStore holds for the server, if any.
+  // Returns true if one was set on |ssl_|.
+  bool SetStoredSession();
+  void RecordHandshakeMetrics();
   void DoReadCallback(int result);
   void DoWriteCallback(int result);
 
@@ -165,6 +170,10 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
 
   // Used for session cache diagnostics.
   bool trying_cached_session_;
+  // True if the offered session came from the SSLSessionStore rather than
+  // the SSL_CTX cache.
+  bool trying_stored_session_;
+  base::TimeTicks handshake_start_time_;
 
   enum State {
     STATE_NONE,
@@ -0,0 +1,201 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/ssl_session_store.h"
+
+#include <vector>
+
+#include "base/logging.h"
+#include "base/memory/singleton.h"
+#include "base/pickle.h"
+
+namespace net {
+
+namespace {
+
+// Bump whenever the serialization format changes.
+const int kSerializationVersion = 1;
+
+}  // namespace
+
+const size_t SSLSessionStore::kMaxSessionsPerShard = 1024;
+
+SSLSessionStore::Entry::Entry() : sequence(0) {
+}
+
+SSLSessionStore::Entry::~Entry() {
+}
+
+// static
+SSLSessionStore* SSLSessionStore::GetInstance() {
+  return Singleton<SSLSessionStore>::get();
+}
+
+void SSLSessionStore::Add(const std::string& shard,
+                          const HostPortPair& host_and_port,
+                          const std::string& session,
+                          base::Time expiry) {
+  {
+    base::AutoLock lock(lock_);
+    AddLocked(&shards_[shard], host_and_port.ToString(), session, expiry);
+  }
+  NotifyDirty(shard);
+}
+
+bool SSLSessionStore::Lookup(const std::string& shard,
+                             const HostPortPair& host_and_port,
+                             std::string* session) {
+  base::AutoLock lock(lock_);
+  ShardMap::iterator shard_it = shards_.find(shard);
+  if (shard_it == shards_.end())
+    return false;
+  EntryMap::iterator it = shard_it->second.find(host_and_port.ToString());
+  if (it == shard_it->second.end())
+    return false;
+  if (it->second.expiry <= base::Time::Now()) {
+    shard_it->second.erase(it);
+    return false;
+  }
+  *session = it->second.session;
+  return true;
+}
+
+void SSLSessionStore::Remove(const std::string& shard,
+                             const HostPortPair& host_and_port) {
+  {
+    base::AutoLock lock(lock_);
+    ShardMap::iterator shard_it = shards_.find(shard);
+    if (shard_it == shards_.end() ||
+        !shard_it->second.erase(host_and_port.ToString())) {
+      return;
+    }
+  }
+  NotifyDirty(shard);
+}
+
+void SSLSessionStore::Clear() {
+  std::vector<std::string> cleared_shards;
+  {
+    base::AutoLock lock(lock_);
+    for (ShardMap::const_iterator it = shards_.begin(); it != shards_.end();
+         ++it) {
+      cleared_shards.push_back(it->first);
+    }
+    shards_.clear();
+  }
+  for (size_t i = 0; i < cleared_shards.size(); ++i)
+    NotifyDirty(cleared_shards[i]);
+}
+
+void SSLSessionStore::SetDelegate(const std::string& shard,
+                                  Delegate* delegate) {
+  base::AutoLock lock(lock_);
+  if (delegate)
+    delegates_[shard] = delegate;
+  else
+    delegates_.erase(shard);
+}
+
+void SSLSessionStore::Serialize(const std::string& shard,
+                                std::string* output) {
+  Pickle pickle;
+  pickle.WriteInt(kSerializationVersion);
+
+  base::AutoLock lock(lock_);
+  const EntryMap& entries = shards_[shard];
+  base::Time now = base::Time::Now();
+  int count = 0;
+  for (EntryMap::const_iterator it = entries.begin(); it != entries.end();
+       ++it) {
+    if (it->second.expiry > now)
+      ++count;
+  }
+  pickle.WriteInt(count);
+  for (EntryMap::const_iterator it = entries.begin(); it != entries.end();
+       ++it) {
+    if (it->second.expiry <= now)
+      continue;
+    pickle.WriteString(it->first);
+    pickle.WriteString(it->second.session);
+    pickle.WriteInt64(it->second.expiry.ToInternalValue());
+  }
+  output->assign(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+bool SSLSessionStore::Load(const std::string& shard,
+                           const std::string& serialized) {
+  Pickle pickle(serialized.data(), serialized.size());
+  PickleIterator iter(pickle);
+  int version;
+  int count;
+  if (!pickle.ReadInt(&iter, &version) ||
+      version != kSerializationVersion ||
+      !pickle.ReadLength(&iter, &count)) {
+    return false;
+  }
+
+  {
+    base::AutoLock lock(lock_);
+    EntryMap* entries = &shards_[shard];
+    base::Time now = base::Time::Now();
+    for (int i = 0; i < count; ++i) {
+      std::string key;
+      std::string session;
+      int64 expiry;
+      if (!pickle.ReadString(&iter, &key) ||
+          !pickle.ReadString(&iter, &session) ||
+          !pickle.ReadInt64(&iter, &expiry)) {
+        return false;
+      }
+      base::Time expiry_time = base::Time::FromInternalValue(expiry);
+      // Sessions negotiated since startup are fresher than persisted ones.
+      if (expiry_time <= now || entries->count(key))
+        continue;
+      AddLocked(entries, key, session, expiry_time);
+    }
+  }
+  return true;
+}
+
+SSLSessionStore::SSLSessionStore() : next_sequence_(0) {
+}
+
+SSLSessionStore::~SSLSessionStore() {
+}
+
+void SSLSessionStore::AddLocked(EntryMap* entries,
+                                const std::string& key,
+                                const std::string& session,
+                                base::Time expiry) {
+  lock_.AssertAcquired();
+
+  Entry& entry = (*entries)[key];
+  entry.session = session;
+  entry.expiry = expiry;
+  entry.sequence = next_sequence_++;
+
+  if (entries->size() <= kMaxSessionsPerShard)
+    return;
+  EntryMap::iterator oldest = entries->begin();
+  for (EntryMap::iterator it = entries->begin(); it != entries->end(); ++it) {
+    if (it->second.sequence < oldest->second.sequence)
+      oldest = it;
+  }
+  entries->erase(oldest);
+}
+
+void SSLSessionStore::NotifyDirty(const std::string& shard) {
+  Delegate* delegate = NULL;
+  {
+    base::AutoLock lock(lock_);
+    std::map<std::string, Delegate*>::const_iterator it =
+        delegates_.find(shard);
+    if (it != delegates_.end())
+      delegate = it->second;
+  }
+  if (delegate)
+    delegate->SessionStoreIsDirty(shard);
+}
+
+}  // namespace net
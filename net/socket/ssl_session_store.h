@@ -0,0 +1,119 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SOCKET_SSL_SESSION_STORE_H_
+#define NET_SOCKET_SSL_SESSION_STORE_H_
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_export.h"
+
+template <typename T> struct DefaultSingletonTraits;
+
+namespace net {
+
+// SSLSessionStore holds serialized TLS sessions (session IDs or tickets, with
+// their master secrets) that SSL client sockets may resume from. It sits
+// behind the SSL library's own in-memory cache: sockets add every new session
+// here, and fall back to it when the library has nothing for a server, which
+// is the case for every server after a restart.
+//
+// Sessions are partitioned by the ssl_session_cache_shard of the
+// SSLClientSocketContext, as the library caches are. A Delegate registered for
+// a shard can persist it with Serialize() and Load().
+//
+// This class is thread safe.
+class NET_EXPORT SSLSessionStore {
+ public:
+  class Delegate {
+   public:
+    // Called when sessions have been added to or removed from |shard|. Must
+    // not block, and must not reenter the SSLSessionStore.
+    virtual void SessionStoreIsDirty(const std::string& shard) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
+  // Sessions kept per shard. The least recently added ones are evicted first.
+  static const size_t kMaxSessionsPerShard;
+
+  static SSLSessionStore* GetInstance();
+
+  // Stores |session| for |host_and_port|, replacing any earlier session. It
+  // will not be returned by Lookup() after |expiry|.
+  void Add(const std::string& shard,
+           const HostPortPair& host_and_port,
+           const std::string& session,
+           base::Time expiry);
+
+  // Returns true and fills |session| if an unexpired session is cached for
+  // |host_and_port|.
+  bool Lookup(const std::string& shard,
+              const HostPortPair& host_and_port,
+              std::string* session);
+
+  void Remove(const std::string& shard, const HostPortPair& host_and_port);
+
+  // Removes every session, e.g. when client certificates change.
+  void Clear();
+
+  // Sets the Delegate notified of changes to |shard|, or removes it if
+  // |delegate| is NULL. Caller owns |delegate|.
+  void SetDelegate(const std::string& shard, Delegate* delegate);
+
+  // Serializes the unexpired sessions of |shard| into |output|. Sessions are
+  // keyed by host and port only, so that they can be loaded into a different
+  // shard after a restart.
+  void Serialize(const std::string& shard, std::string* output);
+
+  // Adds the unexpired sessions in |serialized| (produced by Serialize()) to
+  // |shard|. Returns false if |serialized| could not be parsed.
+  bool Load(const std::string& shard, const std::string& serialized);
+
+ private:
+  friend struct DefaultSingletonTraits<SSLSessionStore>;
+  friend class SSLSessionStoreTest;
+
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    std::string session;
+    base::Time expiry;
+    // Orders entries for eviction.
+    uint64 sequence;
+  };
+  typedef std::map<std::string, Entry> EntryMap;
+  typedef std::map<std::string, EntryMap> ShardMap;
+
+  SSLSessionStore();
+  ~SSLSessionStore();
+
+  // Adds an entry and evicts the oldest if |entries| is full. |lock_| must be
+  // held.
+  void AddLocked(EntryMap* entries,
+                 const std::string& key,
+                 const std::string& session,
+                 base::Time expiry);
+
+  void NotifyDirty(const std::string& shard);
+
+  base::Lock lock_;
+  ShardMap shards_;
+  std::map<std::string, Delegate*> delegates_;
+  uint64 next_sequence_;
+
+  DISALLOW_COPY_AND_ASSIGN(SSLSessionStore);
+};
+
+}  // namespace net
+
+#endif  // NET_SOCKET_SSL_SESSION_STORE_H_
@@ -0,0 +1,158 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/ssl_session_store.h"
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/string_number_conversions.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+class CountingDelegate : public SSLSessionStore::Delegate {
+ public:
+  CountingDelegate() : dirty_count_(0) {}
+  virtual ~CountingDelegate() {}
+
+  virtual void SessionStoreIsDirty(const std::string& shard) OVERRIDE {
+    last_shard_ = shard;
+    ++dirty_count_;
+  }
+
+  int dirty_count() const { return dirty_count_; }
+  const std::string& last_shard() const { return last_shard_; }
+
+ private:
+  int dirty_count_;
+  std::string last_shard_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingDelegate);
+};
+
+}  // namespace
+
+class SSLSessionStoreTest : public testing::Test {
+ protected:
+  base::Time Later() const {
+    return base::Time::Now() + base::TimeDelta::FromHours(1);
+  }
+
+  SSLSessionStore store_;
+};
+
+TEST_F(SSLSessionStoreTest, AddAndLookup) {
+  HostPortPair server("www.example.com", 443);
+  std::string session;
+  EXPECT_FALSE(store_.Lookup("shard", server, &session));
+
+  store_.Add("shard", server, "session1", Later());
+  EXPECT_TRUE(store_.Lookup("shard", server, &session));
+  EXPECT_EQ("session1", session);
+
+  // Sessions are not shared across shards or ports.
+  EXPECT_FALSE(store_.Lookup("other", server, &session));
+  EXPECT_FALSE(store_.Lookup("shard", HostPortPair("www.example.com", 8443),
+                             &session));
+
+  store_.Add("shard", server, "session2", Later());
+  EXPECT_TRUE(store_.Lookup("shard", server, &session));
+  EXPECT_EQ("session2", session);
+
+  store_.Remove("shard", server);
+  EXPECT_FALSE(store_.Lookup("shard", server, &session));
+}
+
+TEST_F(SSLSessionStoreTest, Expiry) {
+  HostPortPair server("www.example.com", 443);
+  store_.Add("shard", server, "session",
+             base::Time::Now() - base::TimeDelta::FromSeconds(1));
+  std::string session;
+  EXPECT_FALSE(store_.Lookup("shard", server, &session));
+}
+
+TEST_F(SSLSessionStoreTest, EvictsOldest) {
+  for (size_t i = 0; i <= SSLSessionStore::kMaxSessionsPerShard; ++i) {
+    store_.Add("shard", HostPortPair("host" + base::Uint64ToString(i), 443),
+               "session", Later());
+  }
+  std::string session;
+  EXPECT_FALSE(store_.Lookup("shard", HostPortPair("host0", 443), &session));
+  EXPECT_TRUE(store_.Lookup("shard", HostPortPair("host1", 443), &session));
+  EXPECT_TRUE(store_.Lookup(
+      "shard",
+      HostPortPair("host" + base::Uint64ToString(
+          SSLSessionStore::kMaxSessionsPerShard), 443),
+      &session));
+}
+
+TEST_F(SSLSessionStoreTest, SerializeAndLoad) {
+  HostPortPair server1("www.example.com", 443);
+  HostPortPair server2("mail.example.com", 443);
+  HostPortPair expired("old.example.com", 443);
+  store_.Add("profile/1", server1, "session1", Later());
+  store_.Add("profile/1", server2, "session2", Later());
+  store_.Add("profile/1", expired, "session3",
+             base::Time::Now() - base::TimeDelta::FromSeconds(1));
+
+  std::string serialized;
+  store_.Serialize("profile/1", &serialized);
+
+  // Load into a different shard, as happens after a restart.
+  HostPortPair server3("news.example.com", 443);
+  store_.Add("profile/2", server1, "fresh", Later());
+  EXPECT_TRUE(store_.Load("profile/2", serialized));
+
+  std::string session;
+  EXPECT_TRUE(store_.Lookup("profile/2", server1, &session));
+  EXPECT_EQ("fresh", session);
+  EXPECT_TRUE(store_.Lookup("profile/2", server2, &session));
+  EXPECT_EQ("session2", session);
+  EXPECT_FALSE(store_.Lookup("profile/2", expired, &session));
+  EXPECT_FALSE(store_.Lookup("profile/2", server3, &session));
+}
+
+TEST_F(SSLSessionStoreTest, LoadCorrupt) {
+  store_.Add("shard", HostPortPair("www.example.com", 443), "session",
+             Later());
+  std::string serialized;
+  store_.Serialize("shard", &serialized);
+
+  EXPECT_FALSE(store_.Load("other", std::string()));
+  EXPECT_FALSE(store_.Load("other", "garbage"));
+  EXPECT_FALSE(store_.Load("other",
+                           serialized.substr(0, serialized.size() - 1)));
+}
+
+TEST_F(SSLSessionStoreTest, Delegate) {
+  CountingDelegate delegate;
+  store_.SetDelegate("shard", &delegate);
+
+  HostPortPair server("www.example.com", 443);
+  store_.Add("shard", server, "session", Later());
+  EXPECT_EQ(1, delegate.dirty_count());
+  EXPECT_EQ("shard", delegate.last_shard());
+
+  store_.Add("other", server, "session", Later());
+  EXPECT_EQ(1, delegate.dirty_count());
+
+  store_.Remove("shard", server);
+  EXPECT_EQ(2, delegate.dirty_count());
+  // Removing a missing session changes nothing.
+  store_.Remove("shard", server);
+  EXPECT_EQ(2, delegate.dirty_count());
+
+  store_.Add("shard", server, "session", Later());
+  store_.Clear();
+  EXPECT_EQ(4, delegate.dirty_count());
+
+  store_.SetDelegate("shard", NULL);
+  store_.Add("shard", server, "session", Later());
+  EXPECT_EQ(4, delegate.dirty_count());
+}
+
+}  // namespace net
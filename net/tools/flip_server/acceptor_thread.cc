@@ -6,6 +6,7 @@
 
 #include <netinet/in.h>
 #include <netinet/tcp.h>  // For TCP_NODELAY
+#include <sched.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
@@ -24,6 +25,9 @@ SMAcceptorThread::SMAcceptorThread(FlipAcceptor *acceptor,
                                    MemoryCache* memory_cache)
     : SimpleThread("SMAcceptorThread"),
       acceptor_(acceptor),
+      listen_fd_(acceptor->listen_fd_),
+      owns_listen_fd_(false),
+      cpu_affinity_(-1),
       ssl_state_(NULL),
       use_ssl_(false),
       idle_socket_timeout_s_(acceptor->idle_socket_timeout_s_),
@@ -54,6 +58,8 @@ SMAcceptorThread::~SMAcceptorThread() {
     delete *i;
   }
   delete ssl_state_;
+  if (owns_listen_fd_)
+    close(listen_fd_);
 }
 
 SMConnection* SMAcceptorThread::NewConnection() {
@@ -76,8 +82,18 @@ SMConnection* SMAcceptorThread::FindOrMakeNewSMConnection() {
   return server;
 }
 
-void SMAcceptorThread::InitWorker() {
-  epoll_server_.RegisterFD(acceptor_->listen_fd_, this, EPOLLIN | EPOLLET);
+void SMAcceptorThread::InitWorker(bool own_listen_fd) {
+  if (own_listen_fd) {
+    int fd = acceptor_->CreateReusePortListenFD();
+    if (fd >= 0) {
+      listen_fd_ = fd;
+      owns_listen_fd_ = true;
+    } else if (acceptor_->reuseport_) {
+      LOG(WARNING) << "Acceptor thread falling back to shared listening "
+                   << "socket " << listen_fd_;
+    }
+  }
+  epoll_server_.RegisterFD(listen_fd_, this, EPOLLIN | EPOLLET);
 }
 
 void SMAcceptorThread::HandleConnection(int server_fd,
@@ -116,11 +132,11 @@ void SMAcceptorThread::AcceptFromListenFD() {
     for (int i = 0; i < acceptor_->accepts_per_wake_; ++i) {
       struct sockaddr address;
       socklen_t socklen = sizeof(address);
-      int fd = accept(acceptor_->listen_fd_, &address, &socklen);
+      int fd = accept(listen_fd_, &address, &socklen);
       if (fd == -1) {
         if (errno != 11) {
           VLOG(1) << ACCEPTOR_CLIENT_IDENT << "Acceptor: accept fail("
-                  << acceptor_->listen_fd_ << "): " << errno << ": "
+                  << listen_fd_ << "): " << errno << ": "
                   << strerror(errno);
         }
         break;
@@ -132,11 +148,11 @@ void SMAcceptorThread::AcceptFromListenFD() {
     while (true) {
       struct sockaddr address;
       socklen_t socklen = sizeof(address);
-      int fd = accept(acceptor_->listen_fd_, &address, &socklen);
+      int fd = accept(listen_fd_, &address, &socklen);
       if (fd == -1) {
         if (errno != 11) {
           VLOG(1) << ACCEPTOR_CLIENT_IDENT << "Acceptor: accept fail("
-                  << acceptor_->listen_fd_ << "): " << errno << ": "
+                  << listen_fd_ << "): " << errno << ": "
                   << strerror(errno);
         }
         break;
@@ -176,6 +192,18 @@ void SMAcceptorThread::HandleConnectionIdleTimeout() {
 }
 
 void SMAcceptorThread::Run() {
+  if (cpu_affinity_ >= 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_affinity_, &cpu_set);
+    // A pid of 0 applies the mask to the calling thread only.
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+      LOG(ERROR) << "Unable to pin acceptor thread to cpu " << cpu_affinity_
+                 << ": " << strerror(errno);
+    } else {
+      VLOG(1) << "Acceptor thread pinned to cpu " << cpu_affinity_;
+    }
+  }
   while (!quitting_.HasBeenNotified()) {
     epoll_server_.set_timeout_in_us(10 * 1000);  // 10 ms
     epoll_server_.WaitForEventsAndExecuteCallbacks();
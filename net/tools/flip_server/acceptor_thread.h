@@ -64,7 +64,12 @@ class SMAcceptorThread : public base::SimpleThread,
   // TODO(mbelshe): figure out if we can move these to private functions.
   SMConnection* NewConnection();
   SMConnection* FindOrMakeNewSMConnection();
-  void InitWorker();
+  // Registers the listening socket with this thread's EpollServer. If
+  // |own_listen_fd| is true and the acceptor was configured with reuseport,
+  // the thread binds a private SO_REUSEPORT socket so that the kernel spreads
+  // incoming connections across threads; otherwise the acceptor's shared
+  // listening socket is used.
+  void InitWorker(bool own_listen_fd);
   void HandleConnection(int server_fd, struct sockaddr_in *remote_addr);
   void AcceptFromListenFD();
 
@@ -75,11 +80,18 @@ class SMAcceptorThread : public base::SimpleThread,
   // idle longer than the configured timeout.
   void HandleConnectionIdleTimeout();
 
+  // Pins the thread to |cpu| once it starts running. A negative value leaves
+  // scheduling up to the kernel.
+  void set_cpu_affinity(int cpu) { cpu_affinity_ = cpu; }
+
   virtual void Run() OVERRIDE;
 
  private:
   EpollServer epoll_server_;
   FlipAcceptor* acceptor_;
+  int listen_fd_;
+  bool owns_listen_fd_;
+  int cpu_affinity_;
   SSLState* ssl_state_;
   bool use_ssl_;
   int idle_socket_timeout_s_;
@@ -162,14 +162,18 @@ int CreateListeningSocket(const std::string& host,
 #define SO_REUSEPORT 15
 #endif
   if (reuseport) {
-    // set SO_REUSEADDR on the listening socket.
+    // set SO_REUSEPORT on the listening socket. Older kernels reject the
+    // option; report that separately so callers can fall back to sharing a
+    // single listening socket between acceptor threads.
     int on = 1;
     int rc;
     rc = setsockopt(sock, SOL_SOCKET,  SO_REUSEPORT,
                     reinterpret_cast<char *>(&on), sizeof(on));
     if (rc < 0) {
+      LOG(ERROR) << "setsockopt() SO_REUSEPORT failed for (" << host << ":"
+                 << port << "): " << strerror(errno) << "\n";
       close(sock);
-      LOG(FATAL) << "setsockopt() failed fd=" << listen_fd << "\n";
+      return -4;
     }
   }
 
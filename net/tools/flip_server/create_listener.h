@@ -37,6 +37,10 @@ void SetNonBlocking(int fd);
 //   disable_nagle - if true sets TCP_NODELAY on the listening socket.
 //   listen_fd - this will be assigned a positive value if the socket is
 //               successfully created, else it will be assigned -1.
+// Returns:
+//   0 on success, -3 if the address is not (yet) available, -4 if reuseport
+//   was requested but the kernel does not support SO_REUSEPORT, and another
+//   negative value on any other failure.
 int CreateListeningSocket(const std::string& host,
                           const std::string& port,
                           bool is_numeric_host_address,
@@ -35,6 +35,8 @@ FlipAcceptor::FlipAcceptor(enum FlipHandlerType flip_handler_type,
       accept_backlog_size_(accept_backlog_size),
       disable_nagle_(disable_nagle),
       accepts_per_wake_(accepts_per_wake),
+      reuseport_(reuseport),
+      listen_fd_(-1),
       memory_cache_(memory_cache),
       ssl_session_expiry_(300),  // TODO(mbelshe):  Hook these up!
       ssl_disable_compression_(false),
@@ -52,12 +54,18 @@ FlipAcceptor::FlipAcceptor(enum FlipHandlerType flip_handler_type,
                                     true,
                                     accept_backlog_size_,
                                     true,
-                                    reuseport,
+                                    reuseport_,
                                     wait_for_iface,
                                     disable_nagle_,
                                     &listen_fd_);
     if ( ret == 0 ) {
       break;
+    } else if ( ret == -4 && reuseport_ ) {
+      // SO_REUSEPORT is not supported by this kernel. Fall back to a single
+      // listening socket shared by all acceptor threads.
+      LOG(WARNING) << "SO_REUSEPORT unavailable, sharing one listening "
+                   << "socket between acceptor threads.";
+      reuseport_ = false;
     } else if ( ret == -3 && wait_for_iface ) {
       // Binding error EADDRNOTAVAIL was encounted. We need
       // to wait for the interfaces to raised. try again.
@@ -93,6 +101,30 @@ FlipAcceptor::FlipAcceptor(enum FlipHandlerType flip_handler_type,
 
 FlipAcceptor::~FlipAcceptor() {}
 
+int FlipAcceptor::CreateReusePortListenFD() {
+  if (!reuseport_ || listen_fd_ < 0)
+    return -1;
+  int fd = -1;
+  // The interface is known to be up at this point since |listen_fd_| has
+  // already been bound, so there is no need to wait for it.
+  int ret = CreateListeningSocket(listen_ip_,
+                                  listen_port_,
+                                  true,
+                                  accept_backlog_size_,
+                                  true,
+                                  true,
+                                  false,
+                                  disable_nagle_,
+                                  &fd);
+  if (ret != 0) {
+    LOG(ERROR) << "Unable to create SO_REUSEPORT listening socket: ret = "
+               << ret << ": " << listen_ip_ << ":" << listen_port_;
+    return -1;
+  }
+  SetNonBlocking(fd);
+  return fd;
+}
+
 FlipConfig::FlipConfig()
     : server_think_time_in_s_(0),
       log_destination_(logging::LOG_ONLY_TO_SYSTEM_DEBUG_LOG),
@@ -42,6 +42,12 @@ class FlipAcceptor {
                void *memory_cache);
   ~FlipAcceptor();
 
+  // Creates an additional non-blocking listening socket bound to the same
+  // address as |listen_fd_| using SO_REUSEPORT, so that each acceptor thread
+  // can own its own accept queue. Returns -1 if |reuseport_| is not set or
+  // the socket could not be created; callers should then share |listen_fd_|.
+  int CreateReusePortListenFD();
+
   enum FlipHandlerType flip_handler_type_;
   std::string listen_ip_;
   std::string listen_port_;
@@ -55,6 +61,7 @@ class FlipAcceptor {
   int accept_backlog_size_;
   bool disable_nagle_;
   int accepts_per_wake_;
+  bool reuseport_;
   int listen_fd_;
   void* memory_cache_;
   int ssl_session_expiry_;
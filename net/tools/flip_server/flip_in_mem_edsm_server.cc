@@ -6,6 +6,7 @@
 #include <signal.h>
 #include <sys/file.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <iostream>
 #include <string>
@@ -46,6 +47,14 @@ int32 FLAGS_accept_backlog_size = 1024;
 //  SO_REUSEPORT);
 bool FLAGS_reuseport = false;
 
+// The number of acceptor threads, each with its own EpollServer, spawned for
+//  every configured acceptor. Combine with reuseport to give each thread its
+//  own accept queue.
+int32 FLAGS_acceptor_threads = 1;
+
+// If true, acceptor threads are pinned round-robin to the online CPUs.
+bool FLAGS_cpu_affinity = false;
+
 // Flag to force spdy, even if NPN is not negotiated.
 bool FLAGS_force_spdy = false;
 
@@ -53,6 +62,11 @@ bool FLAGS_force_spdy = false;
 //  reply);
 double FLAGS_server_think_time_in_s = 0;
 
+// Path of a cache archive written by --write-cache-archive. When set, the
+//  spdy and http servers serve out of the memory-mapped archive instead of
+//  loading every file into memory.
+std::string FLAGS_cache_archive;
+
 net::FlipConfig g_proxy_config;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -112,6 +126,17 @@ void SignalHandler(int signum)
   }
 }
 
+static void LoadMemoryCache(net::MemoryCache* memory_cache) {
+  if (FLAGS_cache_archive.empty()) {
+    memory_cache->AddFiles();
+    return;
+  }
+  if (!memory_cache->LoadArchive(FLAGS_cache_archive)) {
+    cerr << "Unable to load cache archive '" << FLAGS_cache_archive << "'\n";
+    exit(1);
+  }
+}
+
 static int OpenPidFile(const char *pidfile)
 {
   int fd;
@@ -205,6 +230,21 @@ int main (int argc, char**argv)
     cout << "\t--ssl-disable-compression\n";
     cout << "\t--idle-timeout=<seconds> (default is 300)\n";
     cout << "\t--pidfile=<filepath> (default /var/run/flip-server.pid)\n";
+    cout << "\t--cache-archive=<path>\n";
+    cout << "\t  * Serve the spdy and http servers out of a memory-mapped"
+         << " archive.\n";
+    cout << "\t--write-cache-archive=<path>\n";
+    cout << "\t  * Pack the cache directory into an archive for"
+         << " --cache-archive and exit.\n";
+    cout << "\t--acceptor-threads=<count> (default is 1)\n";
+    cout << "\t  * Number of epoll threads spawned per listen ip:port.\n";
+    cout << "\t--reuseport\n";
+    cout << "\t  * Give every acceptor thread its own SO_REUSEPORT listening"
+         << " socket.\n"
+         << "\t    Falls back to a shared socket if the kernel lacks"
+         << " support.\n";
+    cout << "\t--cpu-affinity\n";
+    cout << "\t  * Pin acceptor threads round-robin to the online cpus.\n";
     cout << "\t--help\n";
     exit(0);
   }
@@ -269,6 +309,19 @@ int main (int argc, char**argv)
       atoi(cl.GetSwitchValueASCII("idle-timeout").c_str());
   }
 
+  if (cl.HasSwitch("acceptor-threads")) {
+    FLAGS_acceptor_threads =
+      atoi(cl.GetSwitchValueASCII("acceptor-threads").c_str());
+    if (FLAGS_acceptor_threads < 1)
+      FLAGS_acceptor_threads = 1;
+  }
+
+  if (cl.HasSwitch("reuseport"))
+    FLAGS_reuseport = true;
+
+  if (cl.HasSwitch("cpu-affinity"))
+    FLAGS_cpu_affinity = true;
+
   if (cl.HasSwitch("force_spdy"))
     net::SMConnection::set_force_spdy(true);
 
@@ -278,6 +331,22 @@ int main (int argc, char**argv)
               logging::APPEND_TO_OLD_LOG_FILE,
               logging::DISABLE_DCHECK_FOR_NON_OFFICIAL_RELEASE_BUILDS);
 
+  if (cl.HasSwitch("write-cache-archive")) {
+    std::string path = cl.GetSwitchValueASCII("write-cache-archive");
+    net::MemoryCache memory_cache;
+    memory_cache.AddFiles();
+    if (!memory_cache.WriteArchive(path)) {
+      cerr << "Unable to write cache archive '" << path << "'\n";
+      exit(1);
+    }
+    cout << "Wrote " << memory_cache.files_.size() << " files to " << path
+         << "\n";
+    exit(0);
+  }
+
+  if (cl.HasSwitch("cache-archive"))
+    FLAGS_cache_archive = cl.GetSwitchValueASCII("cache-archive");
+
   LOG(INFO) << "Flip SPDY proxy started with configuration:";
   LOG(INFO) << "Logging destination     : " << g_proxy_config.log_destination_;
   LOG(INFO) << "Log file                : " << g_proxy_config.log_filename_;
@@ -291,6 +360,12 @@ int main (int argc, char**argv)
             << (FLAGS_disable_nagle?"true":"false");
   LOG(INFO) << "Reuseport               : "
             << (FLAGS_reuseport?"true":"false");
+  LOG(INFO) << "Acceptor threads        : " << FLAGS_acceptor_threads;
+  LOG(INFO) << "CPU affinity            : "
+            << (FLAGS_cpu_affinity?"true":"false");
+  LOG(INFO) << "Cache archive           : "
+            << (FLAGS_cache_archive.empty() ? "<disabled>"
+                                            : FLAGS_cache_archive);
   LOG(INFO) << "Force SPDY              : "
             << (FLAGS_force_spdy?"true":"false");
   LOG(INFO) << "SSL session expiry      : "
@@ -331,7 +406,7 @@ int main (int argc, char**argv)
   // Spdy Server Acceptor
   net::MemoryCache spdy_memory_cache;
   if (cl.HasSwitch("spdy-server")) {
-    spdy_memory_cache.AddFiles();
+    LoadMemoryCache(&spdy_memory_cache);
     std::string value = cl.GetSwitchValueASCII("spdy-server");
     std::vector<std::string> valueArgs = split(value, ',');
     while (valueArgs.size() < 4)
@@ -352,7 +427,7 @@ int main (int argc, char**argv)
   // Spdy Server Acceptor
   net::MemoryCache http_memory_cache;
   if (cl.HasSwitch("http-server")) {
-    http_memory_cache.AddFiles();
+    LoadMemoryCache(&http_memory_cache);
     std::string value = cl.GetSwitchValueASCII("http-server");
     std::vector<std::string> valueArgs = split(value, ',');
     while (valueArgs.size() < 4)
@@ -371,23 +446,41 @@ int main (int argc, char**argv)
   }
 
   std::vector<net::SMAcceptorThread*> sm_worker_threads_;
+  std::vector<net::MemoryCache*> cloned_memory_caches;
+  long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
 
   for (i = 0; i < g_proxy_config.acceptors_.size(); i++) {
     net::FlipAcceptor *acceptor = g_proxy_config.acceptors_[i];
 
-    sm_worker_threads_.push_back(
-        new net::SMAcceptorThread(acceptor,
-                                  (net::MemoryCache *)acceptor->memory_cache_));
-    // Note that spdy_memory_cache is not threadsafe, it is merely
-    // thread compatible. Thus, if ever we are to spawn multiple threads,
-    // we either must make the MemoryCache threadsafe, or use
-    // a separate MemoryCache for each thread.
-    //
-    // The latter is what is currently being done as we spawn
-    // a separate thread for each http and spdy server acceptor.
-
-    sm_worker_threads_.back()->InitWorker();
-    sm_worker_threads_.back()->Start();
+    for (int thread = 0; thread < FLAGS_acceptor_threads; ++thread) {
+      // Note that spdy_memory_cache is not threadsafe, it is merely
+      // thread compatible. Thus, if ever we are to spawn multiple threads,
+      // we either must make the MemoryCache threadsafe, or use
+      // a separate MemoryCache for each thread.
+      //
+      // The latter is what is currently being done: the first thread for an
+      // acceptor uses the cache loaded above and every additional thread
+      // gets its own clone.
+      net::MemoryCache* memory_cache =
+          (net::MemoryCache *)acceptor->memory_cache_;
+      if (memory_cache && thread > 0) {
+        net::MemoryCache* clone = new net::MemoryCache;
+        clone->CloneFrom(*memory_cache);
+        cloned_memory_caches.push_back(clone);
+        memory_cache = clone;
+      }
+
+      net::SMAcceptorThread* worker =
+          new net::SMAcceptorThread(acceptor, memory_cache);
+      if (FLAGS_cpu_affinity && num_cpus > 0)
+        worker->set_cpu_affinity(sm_worker_threads_.size() % num_cpus);
+      sm_worker_threads_.push_back(worker);
+
+      // The first thread always listens on the acceptor's socket, so
+      // reuseport only needs extra sockets for the remaining threads.
+      worker->InitWorker(FLAGS_reuseport && thread > 0);
+      worker->Start();
+    }
   }
 
   while (!wantExit) {
@@ -405,6 +498,9 @@ int main (int argc, char**argv)
       for (unsigned int i = 0; i < sm_worker_threads_.size(); ++i) {
         sm_worker_threads_[i]->Join();
       }
+      for (unsigned int i = 0; i < cloned_memory_caches.size(); ++i) {
+        delete cloned_memory_caches[i];
+      }
       break;
     }
     usleep(1000*10);  // 10 ms
@@ -0,0 +1,227 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A simple closed-loop HTTP load generator used to measure the accept path
+// of the flip server. Every client thread repeatedly opens a connection,
+// issues a single GET with "Connection: close", and reads the response until
+// the server closes the socket. The time from connect() to EOF is recorded
+// for every successful connection, and connections/sec together with latency
+// percentiles are reported once the run completes.
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/command_line.h"
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+
+using std::cout;
+
+namespace {
+
+class LoadGeneratorThread : public base::SimpleThread {
+ public:
+  LoadGeneratorThread(const struct addrinfo* address,
+                      const std::string& request,
+                      base::TimeTicks end_time)
+      : SimpleThread("LoadGeneratorThread"),
+        address_(address),
+        request_(request),
+        end_time_(end_time),
+        errors_(0) {
+  }
+
+  virtual void Run() OVERRIDE {
+    while (base::TimeTicks::Now() < end_time_) {
+      base::TimeTicks start = base::TimeTicks::Now();
+      if (FetchOnce()) {
+        latencies_us_.push_back(
+            (base::TimeTicks::Now() - start).InMicroseconds());
+      } else {
+        ++errors_;
+      }
+    }
+  }
+
+  const std::vector<int64>& latencies_us() const { return latencies_us_; }
+  int errors() const { return errors_; }
+
+ private:
+  // Performs one connect/request/response cycle. Returns false on any error.
+  bool FetchOnce() {
+    int fd = socket(address_->ai_family, address_->ai_socktype,
+                    address_->ai_protocol);
+    if (fd < 0)
+      return false;
+
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY,
+               reinterpret_cast<char*>(&on), sizeof(on));
+
+    bool ok = connect(fd, address_->ai_addr, address_->ai_addrlen) == 0;
+    size_t written = 0;
+    while (ok && written < request_.size()) {
+      ssize_t rv = write(fd, request_.data() + written,
+                         request_.size() - written);
+      if (rv < 0 && errno == EINTR)
+        continue;
+      ok = rv > 0;
+      if (ok)
+        written += rv;
+    }
+
+    size_t total_read = 0;
+    char buf[16 * 1024];
+    while (ok) {
+      ssize_t rv = read(fd, buf, sizeof(buf));
+      if (rv < 0 && errno == EINTR)
+        continue;
+      if (rv <= 0) {
+        // A clean EOF only counts as success if a response was received.
+        ok = rv == 0 && total_read > 0;
+        break;
+      }
+      total_read += rv;
+    }
+    close(fd);
+    return ok;
+  }
+
+  const struct addrinfo* address_;
+  const std::string request_;
+  const base::TimeTicks end_time_;
+  std::vector<int64> latencies_us_;
+  int errors_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadGeneratorThread);
+};
+
+// Returns the |percentile| (0-100) entry of the sorted |values|.
+int64 Percentile(const std::vector<int64>& values, double percentile) {
+  if (values.empty())
+    return 0;
+  size_t index = static_cast<size_t>(percentile / 100 * values.size());
+  return values[std::min(index, values.size() - 1)];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  CommandLine::Init(argc, argv);
+  const CommandLine& cl = *CommandLine::ForCurrentProcess();
+
+  if (cl.HasSwitch("help") || !cl.HasSwitch("server")) {
+    cout << argv[0] << " <options>\n";
+    cout << "\t--server=<ip>:<port>\n";
+    cout << "\t--host=<Host header> (default is the server ip)\n";
+    cout << "\t--path=<request path> (default is /)\n";
+    cout << "\t--concurrency=<client threads> (default is 16)\n";
+    cout << "\t--duration=<seconds> (default is 10)\n";
+    cout << "\t--help\n";
+    return cl.HasSwitch("help") ? 0 : 1;
+  }
+
+  std::string server = cl.GetSwitchValueASCII("server");
+  size_t colon = server.rfind(':');
+  if (colon == std::string::npos) {
+    LOG(ERROR) << "--server must be of the form <ip>:<port>";
+    return 1;
+  }
+  std::string ip = server.substr(0, colon);
+  std::string port = server.substr(colon + 1);
+
+  std::string host = ip;
+  if (cl.HasSwitch("host"))
+    host = cl.GetSwitchValueASCII("host");
+  std::string path = "/";
+  if (cl.HasSwitch("path"))
+    path = cl.GetSwitchValueASCII("path");
+  int concurrency = 16;
+  if (cl.HasSwitch("concurrency") &&
+      !base::StringToInt(cl.GetSwitchValueASCII("concurrency"),
+                         &concurrency)) {
+    LOG(ERROR) << "Invalid --concurrency";
+    return 1;
+  }
+  int duration_s = 10;
+  if (cl.HasSwitch("duration") &&
+      !base::StringToInt(cl.GetSwitchValueASCII("duration"), &duration_s)) {
+    LOG(ERROR) << "Invalid --duration";
+    return 1;
+  }
+  concurrency = std::max(concurrency, 1);
+  duration_s = std::max(duration_s, 1);
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_flags = AI_NUMERICHOST;
+  hints.ai_family = PF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* address = NULL;
+  int err = getaddrinfo(ip.c_str(), port.c_str(), &hints, &address);
+  if (err) {
+    LOG(ERROR) << "getaddrinfo for (" << server << "): " << gai_strerror(err);
+    return 1;
+  }
+
+  std::string request = base::StringPrintf(
+      "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+      path.c_str(), host.c_str());
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::TimeTicks end_time =
+      start + base::TimeDelta::FromSeconds(duration_s);
+  std::vector<LoadGeneratorThread*> threads;
+  for (int i = 0; i < concurrency; ++i) {
+    threads.push_back(new LoadGeneratorThread(address, request, end_time));
+    threads.back()->Start();
+  }
+
+  std::vector<int64> latencies_us;
+  int errors = 0;
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->Join();
+    latencies_us.insert(latencies_us.end(),
+                        threads[i]->latencies_us().begin(),
+                        threads[i]->latencies_us().end());
+    errors += threads[i]->errors();
+    delete threads[i];
+  }
+  double elapsed_s = (base::TimeTicks::Now() - start).InSecondsF();
+  freeaddrinfo(address);
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  int64 total_us = 0;
+  for (size_t i = 0; i < latencies_us.size(); ++i)
+    total_us += latencies_us[i];
+
+  cout << "Connections        : " << latencies_us.size() << "\n";
+  cout << "Errors             : " << errors << "\n";
+  cout << "Elapsed (s)        : " << elapsed_s << "\n";
+  cout << "Connections/sec    : " << latencies_us.size() / elapsed_s << "\n";
+  if (!latencies_us.empty()) {
+    cout << "Mean latency (us)  : " << total_us / latencies_us.size() << "\n";
+    cout << "p50 latency (us)   : " << Percentile(latencies_us, 50) << "\n";
+    cout << "p90 latency (us)   : " << Percentile(latencies_us, 90) << "\n";
+    cout << "p99 latency (us)   : " << Percentile(latencies_us, 99) << "\n";
+    cout << "Max latency (us)   : " << latencies_us.back() << "\n";
+  }
+  return errors && latencies_us.empty() ? 1 : 0;
+}
@@ -21,6 +21,7 @@ HttpSM::HttpSM(SMConnection* connection,
       http_framer_(new BalsaFrame),
       stream_id_(0),
       server_idx_(-1),
+      accept_gzip_(false),
       connection_(connection),
       sm_spdy_interface_(sm_spdy_interface),
       output_list_(connection->output_list()),
@@ -54,6 +55,8 @@ void HttpSM::ProcessHeaders(const BalsaHeaders& headers) {
             << headers.request_uri().as_string() << " " << method;
     std::string filename = EncodeURL(headers.request_uri().as_string(),
                                 host, method);
+    accept_gzip_ = headers.GetHeader("Accept-Encoding").find("gzip") !=
+        base::StringPiece::npos;
     NewStream(stream_id_, 0, filename);
     stream_id_ += 2;
   } else {
@@ -207,6 +210,7 @@ void HttpSM::NewStream(uint32 stream_id, uint32 priority,
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "Sending ErrorNotFound";
     SendErrorNotFound(stream_id);
   } else {
+    mci.use_gzip = accept_gzip_ && !mci.file_data->gzip_body.empty();
     AddToOutputOrder(mci);
   }
 }
@@ -317,6 +321,32 @@ void HttpSM::SendDataFrameImpl(uint32 stream_id, const char* data, int64 len,
   EnqueueDataFrame(df);
 }
 
+void HttpSM::SendMappedDataFrame(const char* data, size_t len) {
+  char chunk_buf[128];
+  int chunk_len = snprintf(chunk_buf, sizeof(chunk_buf), "%x\r\n",
+                           (unsigned int)len);
+  DataFrame* df = new DataFrame;
+  char* buffer = new char[chunk_len];
+  memcpy(buffer, chunk_buf, chunk_len);
+  df->data = buffer;
+  df->size = chunk_len;
+  df->delete_when_done = true;
+  EnqueueDataFrame(df);
+
+  // The body is written to the socket straight out of the mapping.
+  df = new DataFrame;
+  df->data = data;
+  df->size = len;
+  df->delete_when_done = false;
+  EnqueueDataFrame(df);
+
+  df = new DataFrame;
+  df->data = "\r\n";
+  df->size = 2;
+  df->delete_when_done = false;
+  EnqueueDataFrame(df);
+}
+
 void HttpSM::EnqueueDataFrame(DataFrame* df) {
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: Enqueue data frame: stream "
           << stream_id_;
@@ -331,28 +361,44 @@ void HttpSM::GetOutput() {
     return;
   }
   if (!mci->transformed_header) {
-    mci->bytes_sent = SendSynReply(mci->stream_id,
-                                   *(mci->file_data->headers));
+    if (!mci->file_data->gzip_body.empty()) {
+      // The body sent depends on the request's Accept-Encoding, so caches
+      // have to be told, whichever variant this is.
+      BalsaHeaders headers;
+      headers.CopyFrom(*(mci->file_data->headers));
+      headers.AppendToHeader("vary", "Accept-Encoding");
+      if (mci->use_gzip)
+        headers.ReplaceOrAppendHeader("content-encoding", "gzip");
+      mci->bytes_sent = SendSynReply(mci->stream_id, headers);
+    } else {
+      mci->bytes_sent = SendSynReply(mci->stream_id,
+                                     *(mci->file_data->headers));
+    }
     mci->transformed_header = true;
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: GetOutput transformed "
             << "header stream_id: [" << mci->stream_id << "]";
     return;
   }
-  if (mci->body_bytes_consumed >= mci->file_data->body.size()) {
+  base::StringPiece body = mci->Body();
+  if (mci->body_bytes_consumed >= body.size()) {
     SendEOF(mci->stream_id);
     output_ordering_.RemoveStreamId(mci->stream_id);
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "GetOutput remove_stream_id: ["
             << mci->stream_id << "]";
     return;
   }
-  size_t num_to_write =
-    mci->file_data->body.size() - mci->body_bytes_consumed;
+  size_t num_to_write = body.size() - mci->body_bytes_consumed;
   if (num_to_write > mci->max_segment_size)
     num_to_write = mci->max_segment_size;
 
-  SendDataFrame(mci->stream_id,
-                mci->file_data->body.data() + mci->body_bytes_consumed,
-                num_to_write, 0, true);
+  if (mci->file_data->mapped) {
+    SendMappedDataFrame(body.data() + mci->body_bytes_consumed,
+                        num_to_write);
+  } else {
+    SendDataFrame(mci->stream_id,
+                  body.data() + mci->body_bytes_consumed,
+                  num_to_write, 0, true);
+  }
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: GetOutput SendDataFrame["
           << mci->stream_id << "]: " << num_to_write;
   mci->body_bytes_consumed += num_to_write;
@@ -115,6 +115,9 @@ class HttpSM : public BalsaVisitorInterface,
   size_t SendSynStreamImpl(uint32 stream_id, const BalsaHeaders& headers);
   void SendDataFrameImpl(uint32 stream_id, const char* data, int64 len,
                          uint32 flags, bool compress);
+  // Like SendDataFrameImpl(), but enqueues |data| itself rather than a copy.
+  // |data| must outlive the connection, as memory-mapped bodies do.
+  void SendMappedDataFrame(const char* data, size_t len);
   void EnqueueDataFrame(DataFrame* df);
   virtual void GetOutput() OVERRIDE;
 
@@ -124,6 +127,8 @@ class HttpSM : public BalsaVisitorInterface,
   BalsaHeaders headers_;
   uint32 stream_id_;
   int32 server_idx_;
+  // Whether the request being processed advertised gzip support.
+  bool accept_gzip_;
 
   SMConnection* connection_;
   SMInterface* sm_spdy_interface_;
@@ -18,6 +18,7 @@
 #include "net/tools/dump_cache/url_utilities.h"
 #include "net/tools/flip_server/balsa_frame.h"
 #include "net/tools/flip_server/balsa_headers.h"
+#include "net/tools/flip_server/mem_cache_archive.h"
 
 // The directory where cache locates);
 std::string FLAGS_cache_base_dir = ".";
@@ -46,10 +47,10 @@ void StoreBodyAndHeadersVisitor::HandleBodyError(BalsaFrame* framer) {
 }
 
 FileData::FileData(BalsaHeaders* h, const std::string& b)
-    : headers(h), body(b) {
+    : headers(h), body(b), mapped(false) {
 }
 
-FileData::FileData() {}
+FileData::FileData() : headers(NULL), mapped(false) {}
 
 FileData::~FileData() {}
 
@@ -59,8 +60,17 @@ void FileData::CopyFrom(const FileData& file_data) {
     filename = file_data.filename;
     related_files = file_data.related_files;
     body = file_data.body;
+    mapped = file_data.mapped;
+    mapped_body = file_data.mapped_body;
+    gzip_body = file_data.gzip_body;
   }
 
+base::StringPiece FileData::GetBody() const {
+  if (mapped)
+    return mapped_body;
+  return body;
+}
+
 MemoryCache::MemoryCache() {}
 
 MemoryCache::~MemoryCache() {}
@@ -74,6 +84,8 @@ void MemoryCache::CloneFrom(const MemoryCache& mc) {
     out_i->second.CopyFrom(i->second);
     cwd_ = mc.cwd_;
   }
+  // The archive is immutable, so clones can share the mapping.
+  archive_ = mc.archive_;
 }
 
 void MemoryCache::AddFiles() {
@@ -203,20 +215,85 @@ void MemoryCache::ReadAndStoreFileContents(const char* filename) {
                             filename_stripped.find_first_of('/'));
 }
 
+bool MemoryCache::LoadArchive(const std::string& path) {
+  scoped_refptr<MemoryCacheArchive> archive(new MemoryCacheArchive);
+  if (!archive->Open(path))
+    return false;
+  LOG(INFO) << "Serving " << archive->entry_count() << " files ("
+            << archive->mapped_size() << " bytes) from archive " << path;
+  archive_ = archive;
+  return true;
+}
+
+bool MemoryCache::WriteArchive(const std::string& path) const {
+  std::vector<MemoryCacheArchive::Entry> entries;
+  // Owns the serialized headers and compressed bodies |entries| points at.
+  std::vector<std::string> headers(files_.size());
+  std::vector<std::string> gzip_bodies(files_.size());
+  size_t i = 0;
+  for (Files::const_iterator fi = files_.begin(); fi != files_.end();
+       ++fi, ++i) {
+    const FileData& file_data = fi->second;
+    MemoryCacheArchive::Entry entry;
+    entry.key = fi->first;
+    MemoryCacheArchive::SerializeHeaders(*file_data.headers, &headers[i]);
+    entry.headers = headers[i];
+    entry.body = file_data.GetBody();
+
+    // Same heuristic the SPDY server uses to decide whether to compress.
+    bool compressible =
+        !file_data.headers->HasHeader("content-encoding") &&
+        file_data.headers->HasHeader("content-type") &&
+        file_data.headers->GetHeader("content-type").find("image") ==
+            base::StringPiece::npos;
+    if (compressible &&
+        MemoryCacheArchive::GzipCompress(entry.body, &gzip_bodies[i]) &&
+        gzip_bodies[i].size() < entry.body.size()) {
+      entry.gzip_body = gzip_bodies[i];
+    }
+    entries.push_back(entry);
+  }
+  return MemoryCacheArchive::Write(path, entries);
+}
+
+FileData* MemoryCache::FindFileData(const std::string& filename) {
+  Files::iterator fi = files_.find(filename);
+  if (fi != files_.end())
+    return &(fi->second);
+  if (!archive_)
+    return NULL;
+
+  MemoryCacheArchive::Entry entry;
+  if (!archive_->Lookup(filename, &entry))
+    return NULL;
+  BalsaHeaders* headers = new BalsaHeaders;
+  if (!MemoryCacheArchive::DeserializeHeaders(entry.headers, headers)) {
+    LOG(ERROR) << "Corrupt headers in cache archive for " << filename;
+    delete headers;
+    return NULL;
+  }
+  // Remember the parsed headers; the body stays in the mapping.
+  FileData& fd = files_[filename];
+  fd.headers = headers;
+  size_t slash = filename.find_first_of('/');
+  if (slash != std::string::npos)
+    fd.filename = filename.substr(slash);
+  fd.mapped = true;
+  fd.mapped_body = entry.body;
+  fd.gzip_body = entry.gzip_body;
+  return &fd;
+}
+
 FileData* MemoryCache::GetFileData(const std::string& filename) {
-  Files::iterator fi = files_.end();
+  FileData* file_data = NULL;
   if (filename.compare(filename.length() - 5, 5, ".html", 5) == 0) {
     std::string new_filename(filename.data(), filename.size() - 5);
     new_filename += ".http";
-    fi = files_.find(new_filename);
-  }
-  if (fi == files_.end())
-    fi = files_.find(filename);
-
-  if (fi == files_.end()) {
-    return NULL;
+    file_data = FindFileData(new_filename);
   }
-  return &(fi->second);
+  if (file_data == NULL)
+    file_data = FindFileData(filename);
+  return file_data;
 }
 
 bool MemoryCache::AssignFileData(const std::string& filename,
@@ -10,12 +10,16 @@
 #include <vector>
 
 #include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/string_piece.h"
 #include "net/tools/flip_server/balsa_headers.h"
 #include "net/tools/flip_server/balsa_visitor_interface.h"
 #include "net/tools/flip_server/constants.h"
 
 namespace net {
 
+class MemoryCacheArchive;
+
 class StoreBodyAndHeadersVisitor: public BalsaVisitorInterface {
  public:
   void HandleError() { error_ = true; }
@@ -68,11 +72,20 @@ struct FileData {
   ~FileData();
   void CopyFrom(const FileData& file_data);
 
+  // Returns the uncompressed response body, wherever it is stored.
+  base::StringPiece GetBody() const;
+
   BalsaHeaders* headers;
   std::string filename;
   // priority, filename
   std::vector< std::pair<int, std::string> > related_files;
   std::string body;
+  // Set for entries served out of a MemoryCacheArchive, in which case |body|
+  // is empty and |mapped_body| points into the memory-mapped archive.
+  bool mapped;
+  base::StringPiece mapped_body;
+  // Precompressed gzip variant of the body; empty if there is none.
+  base::StringPiece gzip_body;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -86,7 +99,8 @@ class MemCacheIter {
       body_bytes_consumed(0),
       stream_id(0),
       max_segment_size(kInitialDataSendersThreshold),
-      bytes_sent(0) {}
+      bytes_sent(0),
+      use_gzip(false) {}
   explicit MemCacheIter(FileData* fd) :
       file_data(fd),
       priority(0),
@@ -94,7 +108,14 @@ class MemCacheIter {
       body_bytes_consumed(0),
       stream_id(0),
       max_segment_size(kInitialDataSendersThreshold),
-      bytes_sent(0) {}
+      bytes_sent(0),
+      use_gzip(false) {}
+
+  // Returns the body to send for this stream, honoring |use_gzip|.
+  base::StringPiece Body() const {
+    return use_gzip ? file_data->gzip_body : file_data->GetBody();
+  }
+
   FileData* file_data;
   int priority;
   bool transformed_header;
@@ -102,6 +123,8 @@ class MemCacheIter {
   uint32 stream_id;
   uint32 max_segment_size;
   size_t bytes_sent;
+  // True if the precompressed |file_data->gzip_body| is being sent.
+  bool use_gzip;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -118,6 +141,15 @@ class MemoryCache {
 
   void AddFiles();
 
+  // Serves responses out of the archive at |path| instead of loading every
+  // file into memory with AddFiles(). Entries are looked up lazily and their
+  // bodies stay in the memory-mapped archive.
+  bool LoadArchive(const std::string& path);
+
+  // Writes every file loaded by AddFiles() to an archive at |path|, along
+  // with a gzip variant of each compressible body.
+  bool WriteArchive(const std::string& path) const;
+
   void ReadToString(const char* filename, std::string* output);
 
   void ReadAndStoreFileContents(const char* filename);
@@ -128,6 +160,12 @@ class MemoryCache {
 
   Files files_;
   std::string cwd_;
+
+ private:
+  // Finds |filename| in |files_|, falling back to |archive_| if set.
+  FileData* FindFileData(const std::string& filename);
+
+  scoped_refptr<MemoryCacheArchive> archive_;
 };
 
 class NotifierInterface {
@@ -0,0 +1,317 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/flip_server/mem_cache_archive.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "net/tools/flip_server/balsa_headers.h"
+#include "third_party/zlib/zlib.h"
+
+namespace net {
+
+namespace {
+
+const char kArchiveMagic[8] = { 'F', 'L', 'I', 'P', 'C', 'A', 'C', 'H' };
+const uint32 kArchiveVersion = 1;
+
+struct ArchiveHeader {
+  char magic[8];
+  uint32 version;
+  uint32 bucket_count;
+  uint64 entry_count;
+  uint64 index_offset;
+};
+
+struct IndexBucket {
+  uint64 key_hash;
+  uint64 record_offset;
+};
+
+// uint32 key_len, uint32 headers_len, uint64 body_len, uint64 gzip_len.
+const size_t kRecordHeaderSize = 24;
+
+uint64 HashKey(const base::StringPiece& key) {
+  uint64 hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < key.size(); ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// The mapping carries no alignment guarantees, so read fields with memcpy.
+template <typename T>
+T ReadField(const char* p) {
+  T value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+bool WriteAll(FILE* file, const void* data, size_t size) {
+  return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+}  // namespace
+
+MemoryCacheArchive::Entry::Entry() {}
+
+MemoryCacheArchive::Entry::~Entry() {}
+
+MemoryCacheArchive::MemoryCacheArchive() : data_(NULL), size_(0) {}
+
+MemoryCacheArchive::~MemoryCacheArchive() {
+  if (data_)
+    munmap(const_cast<char*>(data_), size_);
+}
+
+bool MemoryCacheArchive::Open(const std::string& path) {
+  DCHECK(!data_);
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    LOG(ERROR) << "Unable to open cache archive " << path << ": "
+               << strerror(errno);
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1 ||
+      static_cast<size_t>(file_stat.st_size) < sizeof(ArchiveHeader)) {
+    LOG(ERROR) << "Cache archive " << path << " is truncated";
+    close(fd);
+    return false;
+  }
+  size_t size = file_stat.st_size;
+  void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG(ERROR) << "Unable to mmap cache archive " << path << ": "
+               << strerror(errno);
+    return false;
+  }
+  data_ = static_cast<const char*>(data);
+  size_ = size;
+
+  ArchiveHeader header = ReadField<ArchiveHeader>(data_);
+  uint64 index_size =
+      static_cast<uint64>(header.bucket_count) * sizeof(IndexBucket);
+  if (memcmp(header.magic, kArchiveMagic, sizeof(kArchiveMagic)) != 0 ||
+      header.version != kArchiveVersion ||
+      header.bucket_count == 0 ||
+      (header.bucket_count & (header.bucket_count - 1)) != 0 ||
+      header.index_offset > size_ ||
+      index_size > size_ - header.index_offset) {
+    LOG(ERROR) << "Cache archive " << path << " is not a valid archive";
+    munmap(const_cast<char*>(data_), size_);
+    data_ = NULL;
+    size_ = 0;
+    return false;
+  }
+  // Response bodies are streamed out sequentially.
+  madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+  return true;
+}
+
+uint64 MemoryCacheArchive::entry_count() const {
+  if (!data_)
+    return 0;
+  return ReadField<ArchiveHeader>(data_).entry_count;
+}
+
+bool MemoryCacheArchive::Lookup(const base::StringPiece& key,
+                                Entry* entry) const {
+  if (!data_)
+    return false;
+  ArchiveHeader header = ReadField<ArchiveHeader>(data_);
+  const char* index = data_ + header.index_offset;
+  uint64 hash = HashKey(key);
+  uint32 mask = header.bucket_count - 1;
+  for (uint32 probe = 0; probe < header.bucket_count; ++probe) {
+    IndexBucket bucket = ReadField<IndexBucket>(
+        index + ((hash + probe) & mask) * sizeof(IndexBucket));
+    if (bucket.record_offset == 0)
+      return false;
+    if (bucket.key_hash != hash)
+      continue;
+    Entry candidate;
+    if (!ReadRecord(bucket.record_offset, &candidate))
+      return false;
+    if (candidate.key == key) {
+      *entry = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MemoryCacheArchive::ReadRecord(uint64 offset, Entry* entry) const {
+  if (offset > size_ || size_ - offset < kRecordHeaderSize)
+    return false;
+  const char* p = data_ + offset;
+  uint64 key_len = ReadField<uint32>(p);
+  uint64 headers_len = ReadField<uint32>(p + 4);
+  uint64 body_len = ReadField<uint64>(p + 8);
+  uint64 gzip_len = ReadField<uint64>(p + 16);
+  uint64 available = size_ - offset - kRecordHeaderSize;
+  if (body_len > available || gzip_len > available - body_len ||
+      key_len + headers_len > available - body_len - gzip_len) {
+    return false;
+  }
+  p += kRecordHeaderSize;
+  entry->key.set(p, key_len);
+  p += key_len;
+  entry->headers.set(p, headers_len);
+  p += headers_len;
+  entry->body.set(p, body_len);
+  p += body_len;
+  entry->gzip_body.set(p, gzip_len);
+  return true;
+}
+
+// static
+bool MemoryCacheArchive::Write(const std::string& path,
+                               const std::vector<Entry>& entries) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) {
+    LOG(ERROR) << "Unable to create cache archive " << path << ": "
+               << strerror(errno);
+    return false;
+  }
+
+  // Keep the table at most half full so probe sequences stay short.
+  uint32 bucket_count = 16;
+  while (bucket_count < entries.size() * 2)
+    bucket_count *= 2;
+  std::vector<IndexBucket> index(bucket_count);
+  memset(&index[0], 0, index.size() * sizeof(IndexBucket));
+
+  ArchiveHeader header;
+  memset(&header, 0, sizeof(header));
+  bool ok = WriteAll(file, &header, sizeof(header));
+  uint64 offset = sizeof(header);
+  for (size_t i = 0; ok && i < entries.size(); ++i) {
+    const Entry& entry = entries[i];
+    char record_header[kRecordHeaderSize];
+    uint32 key_len = entry.key.size();
+    uint32 headers_len = entry.headers.size();
+    uint64 body_len = entry.body.size();
+    uint64 gzip_len = entry.gzip_body.size();
+    memcpy(record_header, &key_len, 4);
+    memcpy(record_header + 4, &headers_len, 4);
+    memcpy(record_header + 8, &body_len, 8);
+    memcpy(record_header + 16, &gzip_len, 8);
+    ok = WriteAll(file, record_header, sizeof(record_header)) &&
+         WriteAll(file, entry.key.data(), entry.key.size()) &&
+         WriteAll(file, entry.headers.data(), entry.headers.size()) &&
+         WriteAll(file, entry.body.data(), entry.body.size()) &&
+         WriteAll(file, entry.gzip_body.data(), entry.gzip_body.size());
+
+    uint64 hash = HashKey(entry.key);
+    uint32 slot = hash & (bucket_count - 1);
+    while (index[slot].record_offset != 0)
+      slot = (slot + 1) & (bucket_count - 1);
+    index[slot].key_hash = hash;
+    index[slot].record_offset = offset;
+    offset += sizeof(record_header) + key_len + headers_len + body_len +
+              gzip_len;
+  }
+
+  memcpy(header.magic, kArchiveMagic, sizeof(kArchiveMagic));
+  header.version = kArchiveVersion;
+  header.bucket_count = bucket_count;
+  header.entry_count = entries.size();
+  header.index_offset = offset;
+  ok = ok && WriteAll(file, &index[0], index.size() * sizeof(IndexBucket)) &&
+       fseek(file, 0, SEEK_SET) == 0 &&
+       WriteAll(file, &header, sizeof(header));
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) {
+    LOG(ERROR) << "Failed writing cache archive " << path;
+    unlink(path.c_str());
+  }
+  return ok;
+}
+
+// static
+void MemoryCacheArchive::SerializeHeaders(const BalsaHeaders& headers,
+                                          std::string* out) {
+  Pickle pickle;
+  pickle.WriteString(headers.response_version().as_string());
+  pickle.WriteString(headers.response_code().as_string());
+  pickle.WriteString(headers.response_reason_phrase().as_string());
+  int count = 0;
+  for (BalsaHeaders::const_header_lines_iterator it =
+           headers.header_lines_begin();
+       it != headers.header_lines_end(); ++it) {
+    ++count;
+  }
+  pickle.WriteInt(count);
+  for (BalsaHeaders::const_header_lines_iterator it =
+           headers.header_lines_begin();
+       it != headers.header_lines_end(); ++it) {
+    pickle.WriteString(it->first.as_string());
+    pickle.WriteString(it->second.as_string());
+  }
+  out->assign(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+// static
+bool MemoryCacheArchive::DeserializeHeaders(const base::StringPiece& data,
+                                            BalsaHeaders* headers) {
+  // Copy out of the mapping: Pickle expects its buffer to be aligned.
+  std::string aligned_data = data.as_string();
+  Pickle pickle(aligned_data.data(), aligned_data.size());
+  PickleIterator iter(pickle);
+  std::string version, code, reason;
+  int count = 0;
+  if (!pickle.ReadString(&iter, &version) ||
+      !pickle.ReadString(&iter, &code) ||
+      !pickle.ReadString(&iter, &reason) ||
+      !pickle.ReadInt(&iter, &count)) {
+    return false;
+  }
+  headers->SetResponseFirstlineFromStringPieces(version, code, reason);
+  for (int i = 0; i < count; ++i) {
+    std::string key, value;
+    if (!pickle.ReadString(&iter, &key) || !pickle.ReadString(&iter, &value))
+      return false;
+    headers->AppendHeader(key, value);
+  }
+  return true;
+}
+
+// static
+bool MemoryCacheArchive::GzipCompress(const base::StringPiece& input,
+                                      std::string* output) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // A window of 15 bits plus 16 selects the gzip wrapper.
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  output->resize(deflateBound(&stream, input.size()));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+  stream.avail_out = output->size();
+  int rv = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (rv != Z_STREAM_END)
+    return false;
+  output->resize(stream.total_out);
+  return true;
+}
+
+}  // namespace net
@@ -0,0 +1,91 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_TOOLS_FLIP_SERVER_MEM_CACHE_ARCHIVE_H_
+#define NET_TOOLS_FLIP_SERVER_MEM_CACHE_ARCHIVE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/string_piece.h"
+
+namespace net {
+
+class BalsaHeaders;
+
+// A read-only, memory-mapped archive of cached responses. Serving a large
+// replay corpus out of an archive keeps response bodies in file-backed pages
+// that the kernel can share between acceptor threads and evict under memory
+// pressure, instead of holding a private heap copy of every body.
+//
+// Layout (host byte order):
+//   ArchiveHeader
+//   records, each: uint32 key_len, uint32 headers_len, uint64 body_len,
+//                  uint64 gzip_len, followed by the key, the pickled headers
+//                  (see SerializeHeaders()), the body and an optional
+//                  precompressed gzip body.
+//   index: |bucket_count| IndexBuckets forming an open-addressed hash table
+//          (linear probing) keyed by a 64-bit FNV-1a hash of the key. A
+//          record offset of 0 marks an empty bucket.
+//
+// Lookups are const and the mapping is immutable, so a single archive may be
+// shared by any number of threads.
+class MemoryCacheArchive
+    : public base::RefCountedThreadSafe<MemoryCacheArchive> {
+ public:
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    base::StringPiece key;
+    base::StringPiece headers;
+    base::StringPiece body;
+    // Empty if the archive has no precompressed variant of |body|.
+    base::StringPiece gzip_body;
+  };
+
+  MemoryCacheArchive();
+
+  // Maps |path| and validates its header. Returns false if the file cannot
+  // be mapped or is not a valid archive.
+  bool Open(const std::string& path);
+
+  // Finds |key| in the index. On success, the StringPieces in |entry| point
+  // into the mapping and stay valid for the lifetime of this object.
+  bool Lookup(const base::StringPiece& key, Entry* entry) const;
+
+  uint64 entry_count() const;
+  size_t mapped_size() const { return size_; }
+
+  // Writes an archive containing |entries| to |path|. The StringPieces in
+  // |entries| are only read during the call.
+  static bool Write(const std::string& path, const std::vector<Entry>& entries);
+
+  // Encodes |headers| into the compact form stored in the archive.
+  static void SerializeHeaders(const BalsaHeaders& headers, std::string* out);
+  static bool DeserializeHeaders(const base::StringPiece& data,
+                                 BalsaHeaders* headers);
+
+  // Gzip-compresses |input| into |output|. Returns false on zlib failure.
+  static bool GzipCompress(const base::StringPiece& input, std::string* output);
+
+ private:
+  friend class base::RefCountedThreadSafe<MemoryCacheArchive>;
+
+  ~MemoryCacheArchive();
+
+  // Parses the record at |offset|. Returns false if it runs past the mapping.
+  bool ReadRecord(uint64 offset, Entry* entry) const;
+
+  const char* data_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryCacheArchive);
+};
+
+}  // namespace net
+
+#endif  // NET_TOOLS_FLIP_SERVER_MEM_CACHE_ARCHIVE_H_
@@ -0,0 +1,346 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the request throughput of net::HttpServer. An in-process server is
+// run on its own IO thread, and the main thread drives a number of keep-alive
+// client connections with poll(), each keeping a fixed number of pipelined
+// GET requests in flight. Requests/sec and response latency percentiles are
+// reported once the run completes.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop.h"
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+#include "net/server/http_server.h"
+#include "net/server/http_server_request_info.h"
+
+using std::cout;
+
+namespace {
+
+// Answers every request with the same body, either in one piece or streamed
+// in chunks.
+class BenchDelegate : public net::HttpServer::Delegate {
+ public:
+  BenchDelegate(const std::string& body, int chunk_size)
+      : body_(body),
+        chunk_size_(chunk_size) {
+  }
+
+  void set_server(net::HttpServer* server) { server_ = server; }
+
+  virtual void OnHttpRequest(int connection_id,
+                             const net::HttpServerRequestInfo& info) OVERRIDE {
+    if (!chunk_size_) {
+      server_->Send200(connection_id, body_, "text/plain");
+      return;
+    }
+    server_->StartStreamingResponse(connection_id, "text/plain");
+    for (size_t pos = 0; pos < body_.size(); pos += chunk_size_)
+      server_->SendChunk(connection_id, body_.substr(pos, chunk_size_));
+    server_->FinishStreamingResponse(connection_id);
+  }
+
+  virtual void OnWebSocketRequest(
+      int connection_id,
+      const net::HttpServerRequestInfo& info) OVERRIDE {
+    server_->Send404(connection_id);
+  }
+
+  virtual void OnWebSocketMessage(int connection_id,
+                                  const std::string& data) OVERRIDE {
+  }
+
+  virtual void OnClose(int connection_id) OVERRIDE {
+  }
+
+ private:
+  const std::string body_;
+  const size_t chunk_size_;
+  scoped_refptr<net::HttpServer> server_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchDelegate);
+};
+
+void StartServer(BenchDelegate* delegate, int port,
+                 base::WaitableEvent* started) {
+  delegate->set_server(new net::HttpServer("127.0.0.1", port, delegate));
+  started->Signal();
+}
+
+void StopServer(BenchDelegate* delegate) {
+  delegate->set_server(NULL);
+}
+
+// Returns the length of the complete response at the start of |data|, or 0
+// if it has not been fully received yet. Only understands the responses
+// net::HttpServer writes.
+size_t CompleteResponseLength(const std::string& data) {
+  size_t header_end = data.find("\r\n\r\n");
+  if (header_end == std::string::npos)
+    return 0;
+  const std::string headers = data.substr(0, header_end);
+  size_t pos = header_end + 4;
+
+  size_t length_header = headers.find("Content-Length:");
+  if (length_header != std::string::npos) {
+    size_t value = length_header + strlen("Content-Length:");
+    size_t value_end = headers.find("\r\n", value);
+    int length = 0;
+    base::StringToInt(headers.substr(value, value_end - value), &length);
+    return data.size() >= pos + length ? pos + length : 0;
+  }
+
+  // Chunked: walk the chunks up to the terminating empty one.
+  while (true) {
+    size_t size_end = data.find("\r\n", pos);
+    if (size_end == std::string::npos)
+      return 0;
+    int size = 0;
+    base::HexStringToInt(data.substr(pos, size_end - pos), &size);
+    pos = size_end + 2 + size + 2;
+    if (data.size() < pos)
+      return 0;
+    if (size == 0)
+      return pos;
+  }
+}
+
+struct Client {
+  Client() : fd(-1), written(0) {}
+
+  int fd;
+  std::string send_data;
+  size_t written;
+  std::string recv_data;
+  // Send times of the requests awaiting a response.
+  std::deque<base::TimeTicks> outstanding;
+};
+
+int Connect(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+              sizeof(addr)) != 0 ||
+      fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Returns the |percentile| (0-100) entry of the sorted |values|.
+int64 Percentile(const std::vector<int64>& values, double percentile) {
+  if (values.empty())
+    return 0;
+  size_t index = static_cast<size_t>(percentile / 100 * values.size());
+  return values[std::min(index, values.size() - 1)];
+}
+
+bool GetIntSwitch(const CommandLine& cl, const char* name, int* value) {
+  if (!cl.HasSwitch(name))
+    return true;
+  if (base::StringToInt(cl.GetSwitchValueASCII(name), value) && *value >= 0)
+    return true;
+  LOG(ERROR) << "Invalid --" << name;
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  base::AtExitManager exit_manager;
+  CommandLine::Init(argc, argv);
+  const CommandLine& cl = *CommandLine::ForCurrentProcess();
+
+  if (cl.HasSwitch("help")) {
+    cout << argv[0] << " <options>\n";
+    cout << "\t--port=<port> (default is 9780)\n";
+    cout << "\t--clients=<keep-alive connections> (default is 1000)\n";
+    cout << "\t--pipeline=<requests in flight per connection> (default is 1)\n";
+    cout << "\t--body-size=<response bytes> (default is 128)\n";
+    cout << "\t--chunk-size=<bytes> stream responses in chunks of this size\n";
+    cout << "\t--duration=<seconds> (default is 10)\n";
+    cout << "\t--help\n";
+    return 0;
+  }
+
+  int port = 9780;
+  int num_clients = 1000;
+  int pipeline = 1;
+  int body_size = 128;
+  int chunk_size = 0;
+  int duration_s = 10;
+  if (!GetIntSwitch(cl, "port", &port) ||
+      !GetIntSwitch(cl, "clients", &num_clients) ||
+      !GetIntSwitch(cl, "pipeline", &pipeline) ||
+      !GetIntSwitch(cl, "body-size", &body_size) ||
+      !GetIntSwitch(cl, "chunk-size", &chunk_size) ||
+      !GetIntSwitch(cl, "duration", &duration_s)) {
+    return 1;
+  }
+  num_clients = std::max(num_clients, 1);
+  pipeline = std::max(pipeline, 1);
+  duration_s = std::max(duration_s, 1);
+
+  // Both ends of every connection live in this process.
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < static_cast<rlim_t>(2 * num_clients + 64)) {
+    limit.rlim_cur = std::min(limit.rlim_max,
+                              static_cast<rlim_t>(2 * num_clients + 64));
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  BenchDelegate delegate(std::string(body_size, 'x'), chunk_size);
+  base::Thread server_thread("HttpServerBench");
+  server_thread.StartWithOptions(
+      base::Thread::Options(MessageLoop::TYPE_IO, 0));
+  base::WaitableEvent started(false, false);
+  server_thread.message_loop()->PostTask(
+      FROM_HERE,
+      base::Bind(&StartServer, &delegate, port, &started));
+  started.Wait();
+
+  const std::string request(
+      "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n");
+
+  std::vector<Client> clients(num_clients);
+  std::vector<struct pollfd> poll_fds(num_clients);
+  for (int i = 0; i < num_clients; ++i) {
+    clients[i].fd = Connect(port);
+    if (clients[i].fd < 0) {
+      LOG(ERROR) << "Unable to open connection " << i << ": "
+                 << strerror(errno);
+      return 1;
+    }
+    poll_fds[i].fd = clients[i].fd;
+  }
+
+  std::vector<int64> latencies_us;
+  int64 errors = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  base::TimeTicks end_time = start + base::TimeDelta::FromSeconds(duration_s);
+  char buf[16 * 1024];
+  while (base::TimeTicks::Now() < end_time) {
+    for (int i = 0; i < num_clients; ++i) {
+      Client& client = clients[i];
+      while (client.fd >= 0 &&
+             client.outstanding.size() < static_cast<size_t>(pipeline)) {
+        client.send_data.append(request);
+        client.outstanding.push_back(base::TimeTicks::Now());
+      }
+      poll_fds[i].fd = client.fd;
+      poll_fds[i].events = POLLIN;
+      if (client.written < client.send_data.size())
+        poll_fds[i].events |= POLLOUT;
+      poll_fds[i].revents = 0;
+    }
+
+    if (poll(&poll_fds[0], poll_fds.size(), 100) < 0 && errno != EINTR) {
+      LOG(ERROR) << "poll failed: " << strerror(errno);
+      return 1;
+    }
+
+    for (int i = 0; i < num_clients; ++i) {
+      Client& client = clients[i];
+      if (client.fd < 0 || !poll_fds[i].revents)
+        continue;
+
+      if (poll_fds[i].revents & POLLOUT) {
+        ssize_t rv = write(client.fd, client.send_data.data() + client.written,
+                           client.send_data.size() - client.written);
+        if (rv > 0) {
+          client.written += rv;
+          if (client.written == client.send_data.size()) {
+            client.send_data.clear();
+            client.written = 0;
+          }
+        }
+      }
+
+      if (!(poll_fds[i].revents & (POLLIN | POLLERR | POLLHUP)))
+        continue;
+      ssize_t rv = read(client.fd, buf, sizeof(buf));
+      if (rv < 0 && (errno == EAGAIN || errno == EINTR))
+        continue;
+      if (rv <= 0) {
+        // The server should never close a keep-alive connection.
+        ++errors;
+        close(client.fd);
+        client.fd = -1;
+        continue;
+      }
+      client.recv_data.append(buf, rv);
+      base::TimeTicks now = base::TimeTicks::Now();
+      size_t length;
+      while ((length = CompleteResponseLength(client.recv_data)) > 0) {
+        client.recv_data.erase(0, length);
+        if (client.outstanding.empty()) {
+          ++errors;
+          break;
+        }
+        latencies_us.push_back(
+            (now - client.outstanding.front()).InMicroseconds());
+        client.outstanding.pop_front();
+      }
+    }
+  }
+  double elapsed_s = (base::TimeTicks::Now() - start).InSecondsF();
+
+  for (int i = 0; i < num_clients; ++i) {
+    if (clients[i].fd >= 0)
+      close(clients[i].fd);
+  }
+  server_thread.message_loop()->PostTask(
+      FROM_HERE, base::Bind(&StopServer, &delegate));
+  server_thread.Stop();
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  cout << "clients:      " << num_clients << "\n";
+  cout << "pipeline:     " << pipeline << "\n";
+  cout << "requests:     " << latencies_us.size() << "\n";
+  cout << "errors:       " << errors << "\n";
+  cout << "requests/sec: "
+       << base::StringPrintf("%.1f", latencies_us.size() / elapsed_s) << "\n";
+  cout << "latency (us): p50 " << Percentile(latencies_us, 50)
+       << " p90 " << Percentile(latencies_us, 90)
+       << " p99 " << Percentile(latencies_us, 99)
+       << " max " << (latencies_us.empty() ? 0 : latencies_us.back())
+       << "\n";
+  return 0;
+}
@@ -160,6 +160,7 @@ URLRequestHttpJob::URLRequestHttpJob(URLRequest* request)
           base::Bind(&URLRequestHttpJob::NotifyBeforeSendHeadersCallback,
                      base::Unretained(this)))),
       read_in_progress_(false),
+      sdch_dictionary_context_(NULL),
       transaction_(NULL),
       throttling_entry_(NULL),
       sdch_dictionary_advertised_(false),
@@ -222,6 +223,7 @@ void URLRequestHttpJob::NotifyHeadersComplete() {
       DCHECK_EQ(request_->url(), request_info_.url);
       // Resolve suggested URL relative to request url.
       sdch_dictionary_url_ = request_info_.url.Resolve(url_text);
+      sdch_dictionary_context_ = request_->context();
     }
   }
 
@@ -381,14 +383,20 @@ void URLRequestHttpJob::AddExtraHeaders() {
     // easier to filter and analyze the streams to assure that a proxy has not
     // damaged these headers.  Some proxies deliberately corrupt Accept-Encoding
     // headers.
+    // Tell the server what compression formats we support, including any
+    // decoders registered with Filter.
+    std::string accept_encoding("gzip,deflate");
+    std::vector<std::string> registered_encodings;
+    Filter::GetRegisteredEncodings(&registered_encodings);
+    for (size_t i = 0; i < registered_encodings.size(); ++i)
+      accept_encoding += "," + registered_encodings[i];
     if (!advertise_sdch) {
-      // Tell the server what compression formats we support (other than SDCH).
       request_info_.extra_headers.SetHeader(
-          HttpRequestHeaders::kAcceptEncoding, "gzip,deflate");
+          HttpRequestHeaders::kAcceptEncoding, accept_encoding);
     } else {
       // Include SDCH in acceptable list.
       request_info_.extra_headers.SetHeader(
-          HttpRequestHeaders::kAcceptEncoding, "gzip,deflate,sdch");
+          HttpRequestHeaders::kAcceptEncoding, accept_encoding + ",sdch");
       if (!avail_dictionaries.empty()) {
         request_info_.extra_headers.SetHeader(
             kAvailDictionaryHeader,
@@ -1168,7 +1176,8 @@ URLRequestHttpJob::~URLRequestHttpJob() {
     // coding to assure that IF the system is shutting down, we don't have any
     // problem if the manager was deleted ahead of time.
     if (manager)  // Defensive programming.
-      manager->FetchDictionary(request_info_.url, sdch_dictionary_url_);
+      manager->FetchDictionary(request_info_.url, sdch_dictionary_url_,
+                               sdch_dictionary_context_);
   }
   DoneWithRequest(ABORTED);
 }
@@ -112,6 +112,11 @@ class URLRequestHttpJob : public URLRequestJob {
   // An URL for an SDCH dictionary as suggested in a Get-Dictionary HTTP header.
   GURL sdch_dictionary_url_;
 
+  // The context of the request that suggested |sdch_dictionary_url_|, which
+  // decides whether the dictionary may be saved.  It is only compared, never
+  // dereferenced.
+  const URLRequestContext* sdch_dictionary_context_;
+
   scoped_ptr<HttpTransaction> transaction_;
 
   // This is used to supervise traffic and enforce exponential
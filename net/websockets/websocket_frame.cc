@@ -4,6 +4,39 @@
 
 #include "net/websockets/websocket_frame.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif  // defined(__SSE2__)
+
+#include "base/logging.h"
+
+namespace {
+
+// The widest unit that the payload is masked in. The mask is applied a whole
+// unit at a time once |data| has been aligned to it.
+#if defined(__SSE2__)
+typedef __m128i PackedMaskType;
+#else
+typedef size_t PackedMaskType;
+#endif  // defined(__SSE2__)
+
+// Since the size of PackedMaskType is a multiple of the key length, the key
+// offset does not change from one unit to the next.
+COMPILE_ASSERT(
+    sizeof(PackedMaskType) % net::WebSocketFrameHeader::kMaskingKeyLength == 0,
+    packed_mask_type_must_be_multiple_of_key_length);
+
+inline void XorPacked(char* data, const PackedMaskType& packed_mask) {
+  PackedMaskType* unit = reinterpret_cast<PackedMaskType*>(data);
+#if defined(__SSE2__)
+  _mm_store_si128(unit, _mm_xor_si128(_mm_load_si128(unit), packed_mask));
+#else
+  *unit ^= packed_mask;
+#endif  // defined(__SSE2__)
+}
+
+}  // namespace
+
 namespace net {
 
 // Definitions for in-struct constants.
@@ -21,4 +54,45 @@ WebSocketFrameChunk::WebSocketFrameChunk() : final_chunk(false) {
 WebSocketFrameChunk::~WebSocketFrameChunk() {
 }
 
+void MaskWebSocketFramePayload(const char* masking_key,
+                               uint64 frame_offset,
+                               char* data,
+                               size_t data_size) {
+  static const size_t kMaskingKeyLength =
+      WebSocketFrameHeader::kMaskingKeyLength;
+
+  DCHECK(masking_key);
+  DCHECK(data || !data_size);
+
+  char* const end = data + data_size;
+  size_t key_offset = frame_offset % kMaskingKeyLength;
+
+  // Mask byte by byte until |data| is aligned for PackedMaskType.
+  while (data != end &&
+         reinterpret_cast<uintptr_t>(data) % sizeof(PackedMaskType) != 0) {
+    *data++ ^= masking_key[key_offset];
+    key_offset = (key_offset + 1) % kMaskingKeyLength;
+  }
+
+  if (static_cast<size_t>(end - data) >= sizeof(PackedMaskType)) {
+    // Replicate the key, rotated to |key_offset|, across a whole unit.
+    PackedMaskType packed_mask;
+    char* packed_mask_bytes = reinterpret_cast<char*>(&packed_mask);
+    for (size_t i = 0; i < sizeof(packed_mask); ++i) {
+      packed_mask_bytes[i] =
+          masking_key[(key_offset + i) % kMaskingKeyLength];
+    }
+    char* const packed_end =
+        end - (end - data) % sizeof(PackedMaskType);
+    for (; data != packed_end; data += sizeof(PackedMaskType))
+      XorPacked(data, packed_mask);
+  }
+
+  // Mask the remaining tail.
+  for (; data != end; ++data) {
+    *data ^= masking_key[key_offset];
+    key_offset = (key_offset + 1) % kMaskingKeyLength;
+  }
+}
+
 }  // namespace net
@@ -75,6 +75,16 @@ struct NET_EXPORT_PRIVATE WebSocketFrameChunk {
   std::vector<char> data;
 };
 
+// Masks or unmasks |data_size| bytes of |data| in place using the 4-byte
+// |masking_key| (see http://tools.ietf.org/html/rfc6455#section-5.3).
+// |frame_offset| is the offset of |data[0]| within the frame payload, which
+// allows a payload to be processed in several pieces. Masking and unmasking
+// are the same operation.
+NET_EXPORT_PRIVATE void MaskWebSocketFramePayload(const char* masking_key,
+                                                  uint64 frame_offset,
+                                                  char* data,
+                                                  size_t data_size);
+
 }  // namespace net
 
 #endif  // NET_WEBSOCKETS_WEBSOCKET_FRAME_H_
@@ -27,6 +27,12 @@ const uint64 kMaxPayloadLengthWithoutExtendedLengthField = 125;
 const uint64 kPayloadLengthWithTwoByteExtendedLengthField = 126;
 const uint64 kPayloadLengthWithEightByteExtendedLengthField = 127;
 
+// The maximum possible length of a frame header.
+const size_t kMaximumFrameHeaderSize =
+    net::WebSocketFrameHeader::kBaseHeaderSize +
+    net::WebSocketFrameHeader::kMaximumExtendedLengthSize +
+    net::WebSocketFrameHeader::kMaskingKeyLength;
+
 }  // Unnamed namespace.
 
 namespace net {
@@ -52,45 +58,47 @@ bool WebSocketFrameParser::Decode(
   if (!length)
     return true;
 
-  // TODO(yutak): Remove copy.
-  buffer_.insert(buffer_.end(), data, data + length);
-
-  while (current_read_pos_ < buffer_.size()) {
+  const char* current = data;
+  const char* const end = data + length;
+  while (current < end) {
     bool first_chunk = false;
     if (!current_frame_header_.get()) {
+      // Frame headers are assembled in |buffer_|, which never holds more
+      // than a maximal header. Bytes copied past the end of the header are
+      // payload; they are given back to |current| once the header is parsed.
+      size_t header_bytes = std::min<size_t>(
+          end - current, kMaximumFrameHeaderSize - buffer_.size());
+      buffer_.insert(buffer_.end(), current, current + header_bytes);
+      current += header_bytes;
+
       DecodeFrameHeader();
       if (failed_)
         return false;
       // If frame header is incomplete, then carry over the remaining
       // data to the next round of Decode().
-      if (!current_frame_header_.get())
+      if (!current_frame_header_.get()) {
+        DCHECK(current == end);
         break;
+      }
+      current -= buffer_.size() - current_read_pos_;
+      buffer_.clear();
+      current_read_pos_ = 0;
       first_chunk = true;
     }
 
+    // Payload is copied straight from |data| into the chunk.
     scoped_ptr<WebSocketFrameChunk> frame_chunk =
-        DecodeFramePayload(first_chunk);
+        DecodeFramePayload(first_chunk, &current, end);
     DCHECK(frame_chunk.get());
     frame_chunks->push_back(frame_chunk.release());
 
     if (current_frame_header_.get()) {
-      DCHECK(current_read_pos_ == buffer_.size());
+      DCHECK(current == end);
       break;
     }
   }
 
-  // Drain unnecessary data. TODO(yutak): Remove copy. (but how?)
-  buffer_.erase(buffer_.begin(), buffer_.begin() + current_read_pos_);
-  current_read_pos_ = 0;
-
-  // Sanity check: the size of carried-over data should not exceed
-  // the maximum possible length of a frame header.
-  static const size_t kMaximumFrameHeaderSize =
-      WebSocketFrameHeader::kBaseHeaderSize +
-      WebSocketFrameHeader::kMaximumExtendedLengthSize +
-      WebSocketFrameHeader::kMaskingKeyLength;
   DCHECK_LT(buffer_.size(), kMaximumFrameHeaderSize);
-
   return true;
 }
 
@@ -170,11 +178,10 @@ void WebSocketFrameParser::DecodeFrameHeader() {
 }
 
 scoped_ptr<WebSocketFrameChunk> WebSocketFrameParser::DecodeFramePayload(
-    bool first_chunk) {
-  static const int kMaskingKeyLength = WebSocketFrameHeader::kMaskingKeyLength;
-
-  const char* current = &buffer_.front() + current_read_pos_;
-  const char* end = &buffer_.front() + buffer_.size();
+    bool first_chunk,
+    const char** data,
+    const char* end) {
+  const char* current = *data;
   uint64 next_size = std::min<uint64>(
       end - current,
       current_frame_header_->payload_length - frame_offset_);
@@ -185,18 +192,13 @@ scoped_ptr<WebSocketFrameChunk> WebSocketFrameParser::DecodeFramePayload(
   }
   frame_chunk->final_chunk = false;
   frame_chunk->data.assign(current, current + next_size);
-  if (current_frame_header_->masked) {
+  if (current_frame_header_->masked && next_size) {
     // Unmask the payload.
-    // TODO(yutak): This could be faster by doing unmasking for each
-    // machine word (instead of each byte).
-    size_t key_offset = frame_offset_ % kMaskingKeyLength;
-    for (uint64 i = 0; i < next_size; ++i) {
-      frame_chunk->data[i] ^= masking_key_[key_offset];
-      key_offset = (key_offset + 1) % kMaskingKeyLength;
-    }
+    MaskWebSocketFramePayload(masking_key_, frame_offset_,
+                              &frame_chunk->data.front(), next_size);
   }
 
-  current_read_pos_ += next_size;
+  *data += next_size;
   frame_offset_ += next_size;
 
   DCHECK_LE(frame_offset_, current_frame_header_->payload_length);
@@ -45,7 +45,7 @@ class NET_EXPORT_PRIVATE WebSocketFrameParser {
   bool failed() const { return failed_; }
 
  private:
-  // Tries to decode a frame header from |current_read_pos_|.
+  // Tries to decode a frame header from |current_read_pos_| in |buffer_|.
   // If successful, this function updates |current_read_pos_|,
   // |current_frame_header_|, and |masking_key_| (if available).
   // This function may set |failed_| to true if it observes a corrupt frame.
@@ -53,15 +53,19 @@ class NET_EXPORT_PRIVATE WebSocketFrameParser {
   // header, this function returns without doing anything.
   void DecodeFrameHeader();
 
-  // Decodes frame payload and creates a WebSocketFrameChunk object.
-  // This function updates |current_read_pos_| and |frame_offset_| after
-  // parsing. This function returns a frame object even if no payload data is
-  // available at this moment, so the receiver could make use of frame header
-  // information. If the end of frame is reached, this function clears
-  // |current_frame_header_|, |frame_offset_| and |masking_key_|.
-  scoped_ptr<WebSocketFrameChunk> DecodeFramePayload(bool first_chunk);
-
-  // Internal buffer to store the data to parse.
+  // Decodes frame payload from [|*data|, |end|) and creates a
+  // WebSocketFrameChunk object. This function advances |*data| and updates
+  // |frame_offset_| after parsing. This function returns a frame object even
+  // if no payload data is available at this moment, so the receiver could
+  // make use of frame header information. If the end of frame is reached,
+  // this function clears |current_frame_header_|, |frame_offset_| and
+  // |masking_key_|.
+  scoped_ptr<WebSocketFrameChunk> DecodeFramePayload(bool first_chunk,
+                                                     const char** data,
+                                                     const char* end);
+
+  // Internal buffer to assemble a frame header that was split across calls
+  // to Decode(). Payload data is never stored here.
   std::vector<char> buffer_;
 
   // Position in |buffer_| where the next round of parsing starts.
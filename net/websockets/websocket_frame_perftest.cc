@@ -0,0 +1,112 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_vector.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/websockets/websocket_frame.h"
+#include "net/websockets/websocket_frame_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// The socket read size used when feeding frames into the parser.
+const size_t kReadSize = 32 * 1024;
+
+// Total amount of payload parsed for each frame size.
+const uint64 kTotalPayloadBytes = 256 * 1024 * 1024;
+
+// Builds a masked binary frame with a payload of |payload_length| bytes.
+std::vector<char> MakeMaskedFrame(uint64 payload_length) {
+  std::vector<char> frame;
+  frame.push_back('\x82');
+  if (payload_length <= 125) {
+    frame.push_back(static_cast<char>(0x80 | payload_length));
+  } else if (payload_length <= kuint16max) {
+    frame.push_back('\xFE');
+    frame.push_back(static_cast<char>(payload_length >> 8));
+    frame.push_back(static_cast<char>(payload_length & 0xFF));
+  } else {
+    frame.push_back('\xFF');
+    for (int shift = 56; shift >= 0; shift -= 8)
+      frame.push_back(static_cast<char>((payload_length >> shift) & 0xFF));
+  }
+  const char kMaskingKey[] = "\xDE\xAD\xBE\xEF";
+  frame.insert(frame.end(), kMaskingKey, kMaskingKey + 4);
+  frame.resize(frame.size() + payload_length, 'x');
+  return frame;
+}
+
+// Parses |kTotalPayloadBytes| of frames with |payload_length|-byte payloads,
+// read in |kReadSize| pieces, and logs the throughput.
+void RunParserTest(const char* name, uint64 payload_length) {
+  std::vector<char> frame = MakeMaskedFrame(payload_length);
+
+  // Lay out as many frames back to back as fit in a few reads, so that small
+  // frames are parsed several per read, as they would be off the wire.
+  std::vector<char> stream;
+  while (stream.size() < 4 * kReadSize)
+    stream.insert(stream.end(), frame.begin(), frame.end());
+  const uint64 frames_per_stream = stream.size() / frame.size();
+  const uint64 iterations =
+      std::max<uint64>(1, kTotalPayloadBytes /
+                              (frames_per_stream * payload_length));
+
+  WebSocketFrameParser parser;
+  PerfTimer timer;
+  uint64 parsed_bytes = 0;
+  for (uint64 i = 0; i < iterations; ++i) {
+    for (size_t offset = 0; offset < stream.size(); offset += kReadSize) {
+      ScopedVector<WebSocketFrameChunk> chunks;
+      size_t length = std::min(kReadSize, stream.size() - offset);
+      ASSERT_TRUE(parser.Decode(&stream[offset], length, &chunks));
+      for (size_t j = 0; j < chunks.size(); ++j)
+        parsed_bytes += chunks[j]->data.size();
+    }
+  }
+  double seconds = timer.Elapsed().InSecondsF();
+  EXPECT_EQ(iterations * frames_per_stream * payload_length, parsed_bytes);
+
+  LogPerfResult(base::StringPrintf("WebSocketFrameParser_%s", name).c_str(),
+                parsed_bytes / seconds / (1024 * 1024), "MB/s");
+}
+
+}  // namespace
+
+TEST(WebSocketFramePerfTest, ParseSmallFrames) {
+  RunParserTest("125B", 125);
+}
+
+TEST(WebSocketFramePerfTest, ParseMediumFrames) {
+  RunParserTest("64KB", 64 * 1024);
+}
+
+TEST(WebSocketFramePerfTest, ParseLargeFrames) {
+  RunParserTest("16MB", 16 * 1024 * 1024);
+}
+
+TEST(WebSocketFramePerfTest, MaskPayload) {
+  std::vector<char> payload(1024 * 1024, 'x');
+  const char kMaskingKey[] = "\xDE\xAD\xBE\xEF";
+  const int kIterations = 1024;
+
+  PerfTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    MaskWebSocketFramePayload(kMaskingKey, i, &payload.front(),
+                              payload.size());
+  }
+  double seconds = timer.Elapsed().InSecondsF();
+  LogPerfResult("WebSocketFrame_MaskPayload",
+                kIterations * payload.size() / seconds / (1024 * 1024),
+                "MB/s");
+}
+
+}  // namespace net
@@ -0,0 +1,90 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/websockets/websocket_frame.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const char kMaskingKey[] = "\xDE\xAD\xBE\xEF";
+
+// Reference implementation: masks one byte at a time.
+void MaskByteByByte(uint64 frame_offset, char* data, size_t data_size) {
+  for (size_t i = 0; i < data_size; ++i)
+    data[i] ^= kMaskingKey[(frame_offset + i) % 4];
+}
+
+}  // namespace
+
+TEST(WebSocketFrameTest, MaskPayload) {
+  static const struct {
+    uint64 frame_offset;
+    const char* input;
+    const char* output;
+  } kTests[] = {
+    { 0, "", "" },
+    { 0, "Hello, world!",
+      "\x96\xC8\xD2\x83\xB1\x81\x9E\x98\xB1\xDF\xD2\x8B\xFF" },
+    { 1, "ello, world!",
+      "\xC8\xD2\x83\xB1\x81\x9E\x98\xB1\xDF\xD2\x8B\xFF" },
+    { 5, "\x81\x9E\x98\xB1", ", wo" },
+  };
+
+  for (size_t i = 0; i < arraysize(kTests); ++i) {
+    SCOPED_TRACE(base::StringPrintf("Test[%d]", static_cast<int>(i)));
+    std::vector<char> data(kTests[i].input,
+                           kTests[i].input + strlen(kTests[i].input));
+    if (!data.empty()) {
+      MaskWebSocketFramePayload(kMaskingKey, kTests[i].frame_offset,
+                                &data.front(), data.size());
+    }
+    EXPECT_EQ(kTests[i].output, std::string(data.begin(), data.end()));
+  }
+}
+
+// Checks the word-at-a-time implementation against the byte-at-a-time one
+// for every combination of alignment, frame offset and short length.
+TEST(WebSocketFrameTest, MaskPayloadAlignments) {
+  static const size_t kMaxLength = 100;
+  static const size_t kMaxAlignment = 32;
+
+  char buffer[kMaxLength + kMaxAlignment];
+  for (size_t i = 0; i < sizeof(buffer); ++i)
+    buffer[i] = static_cast<char>(i * 7);
+
+  for (size_t alignment = 0; alignment < kMaxAlignment; ++alignment) {
+    for (uint64 frame_offset = 0; frame_offset < 4; ++frame_offset) {
+      for (size_t length = 0; length <= kMaxLength; ++length) {
+        std::vector<char> expected(buffer + alignment,
+                                   buffer + alignment + length);
+        std::vector<char> actual(buffer, buffer + sizeof(buffer));
+        if (length)
+          MaskByteByByte(frame_offset, &expected.front(), length);
+        MaskWebSocketFramePayload(kMaskingKey, frame_offset,
+                                  &actual.front() + alignment, length);
+        ASSERT_TRUE(std::equal(expected.begin(), expected.end(),
+                               actual.begin() + alignment))
+            << "alignment=" << alignment << " frame_offset=" << frame_offset
+            << " length=" << length;
+        // Bytes outside the range must be untouched.
+        ASSERT_TRUE(std::equal(buffer, buffer + alignment, actual.begin()));
+        ASSERT_TRUE(std::equal(buffer + alignment + length,
+                               buffer + sizeof(buffer),
+                               actual.begin() + alignment + length));
+      }
+    }
+  }
+}
+
+}  // namespace net
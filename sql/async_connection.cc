@@ -0,0 +1,200 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sql/async_connection.h"
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/message_loop_proxy.h"
+#include "base/sequenced_task_runner.h"
+
+namespace sql {
+
+// static
+const int AsyncConnection::kMaxWritesPerTransaction = 1000;
+
+AsyncConnection::Operation::Operation()
+    : type(READ),
+      sequence_number(0) {
+}
+
+AsyncConnection::Operation::~Operation() {
+}
+
+AsyncConnection::AsyncConnection(base::SequencedTaskRunner* task_runner,
+                                 base::TimeDelta commit_delay)
+    : task_runner_(task_runner),
+      commit_delay_(commit_delay),
+      next_sequence_number_(0),
+      in_batch_(false),
+      batch_number_(0) {
+}
+
+AsyncConnection::~AsyncConnection() {
+  // The last reference may go away on any thread, but nothing else can be
+  // using the connection by then.  The connection would roll back a batch
+  // that is still open.
+  if (in_batch_ && connection_.transaction_nesting())
+    connection_.CommitTransaction();
+}
+
+void AsyncConnection::Read(const base::Closure& task,
+                           const base::Closure& reply) {
+  PostOperation(Operation::READ, task, reply);
+}
+
+void AsyncConnection::Write(const base::Closure& task,
+                            const base::Closure& reply) {
+  PostOperation(Operation::WRITE, task, reply);
+}
+
+void AsyncConnection::Execute(const base::Closure& task,
+                              const base::Closure& reply) {
+  PostOperation(Operation::EXECUTE, task, reply);
+}
+
+void AsyncConnection::Flush(const base::Closure& reply) {
+  PostOperation(Operation::EXECUTE, base::Closure(), reply);
+}
+
+void AsyncConnection::Close() {
+  PostOperation(Operation::EXECUTE,
+                base::Bind(&AsyncConnection::CloseConnection, this),
+                base::Closure());
+}
+
+void AsyncConnection::PostOperation(Operation::Type type,
+                                    const base::Closure& task,
+                                    const base::Closure& reply) {
+  Operation operation;
+  operation.type = type;
+  operation.task = task;
+  operation.reply = reply;
+  if (!reply.is_null()) {
+    operation.reply_loop = base::MessageLoopProxy::current();
+    DCHECK(operation.reply_loop) << "Replies need a message loop";
+  }
+
+  {
+    base::AutoLock lock(lock_);
+    operation.sequence_number = next_sequence_number_++;
+    if (type == Operation::READ) {
+      reads_.push_back(operation);
+    } else {
+      writes_.push_back(operation);
+      if (type == Operation::EXECUTE)
+        barriers_.push_back(operation.sequence_number);
+    }
+  }
+
+  // Each posted task runs one operation, though not necessarily this one.
+  task_runner_->PostTask(FROM_HERE,
+                         base::Bind(&AsyncConnection::RunNextOperation, this));
+}
+
+void AsyncConnection::RunNextOperation() {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+
+  Operation operation;
+  bool idle = false;
+  {
+    base::AutoLock lock(lock_);
+    if (!reads_.empty() &&
+        (barriers_.empty() ||
+         reads_.front().sequence_number < barriers_.front())) {
+      operation = reads_.front();
+      reads_.pop_front();
+    } else {
+      DCHECK(!writes_.empty());
+      operation = writes_.front();
+      writes_.pop_front();
+      if (operation.type == Operation::EXECUTE) {
+        DCHECK_EQ(barriers_.front(), operation.sequence_number);
+        barriers_.pop_front();
+      }
+    }
+    idle = reads_.empty() && writes_.empty();
+  }
+
+  switch (operation.type) {
+    case Operation::READ:
+      operation.task.Run();
+      PostReply(operation);
+      break;
+
+    case Operation::WRITE: {
+      if (!in_batch_ && connection_.is_open()) {
+        in_batch_ = connection_.BeginTransaction();
+        if (in_batch_ && commit_delay_ > base::TimeDelta()) {
+          task_runner_->PostDelayedTask(
+              FROM_HERE,
+              base::Bind(&AsyncConnection::CommitBatchAfterDelay, this,
+                         batch_number_),
+              commit_delay_);
+        }
+      }
+      // Each write gets a savepoint, so that one rolling back its own
+      // transaction undoes only its own work, not the rest of the batch.
+      const bool in_savepoint = in_batch_ && connection_.BeginSavepoint();
+      operation.task.Run();
+      if (in_savepoint)
+        connection_.EndSavepoint();
+      if (in_batch_) {
+        operation.task.Reset();
+        batch_writes_.push_back(operation);
+        if (batch_writes_.size() >=
+            static_cast<size_t>(kMaxWritesPerTransaction)) {
+          CommitBatch();
+        }
+      } else {
+        PostReply(operation);
+      }
+      break;
+    }
+
+    case Operation::EXECUTE:
+      CommitBatch();
+      if (!operation.task.is_null())
+        operation.task.Run();
+      PostReply(operation);
+      break;
+  }
+
+  if (idle && commit_delay_ == base::TimeDelta())
+    CommitBatch();
+}
+
+void AsyncConnection::CommitBatch() {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+  if (!in_batch_)
+    return;
+
+  // The connection may have been closed, by error handling for instance.
+  if (connection_.transaction_nesting())
+    connection_.CommitTransaction();
+  in_batch_ = false;
+  ++batch_number_;
+
+  for (size_t i = 0; i < batch_writes_.size(); ++i)
+    PostReply(batch_writes_[i]);
+  batch_writes_.clear();
+}
+
+void AsyncConnection::CommitBatchAfterDelay(int batch_number) {
+  if (batch_number == batch_number_)
+    CommitBatch();
+}
+
+void AsyncConnection::CloseConnection() {
+  connection_.Close();
+}
+
+// static
+void AsyncConnection::PostReply(const Operation& operation) {
+  if (!operation.reply.is_null())
+    operation.reply_loop->PostTask(FROM_HERE, operation.reply);
+}
+
+}  // namespace sql
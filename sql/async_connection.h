@@ -0,0 +1,159 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef SQL_ASYNC_CONNECTION_H_
+#define SQL_ASYNC_CONNECTION_H_
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "sql/connection.h"
+#include "sql/sql_export.h"
+
+namespace base {
+class MessageLoopProxy;
+class SequencedTaskRunner;
+}
+
+namespace sql {
+
+// Runs the database work of a Connection on a task runner, so that clients
+// don't each have to hop threads and batch transactions themselves.
+//
+// Writes are batched: the first write opens a transaction, and the ones that
+// follow join it until it is committed, either as soon as there is no more
+// work queued, or a fixed delay after the batch started.  Committing once per
+// batch rather than once per write saves most of the syncing.  Reads go ahead
+// of queued writes, and see the writes that have already run, committed or
+// not.
+//
+// Tasks get at the database through connection(), or through pointers to it
+// they were given earlier.  Each write runs under its own savepoint, so a
+// write that rolls back its own transaction only undoes its own changes, and
+// the rest of its batch is still committed.
+//
+// Example:
+//   scoped_refptr<sql::AsyncConnection> db(new sql::AsyncConnection(
+//       db_task_runner, base::TimeDelta()));
+//   db->Execute(base::Bind(&MyTable::Init, table, path), base::Closure());
+//   db->Write(base::Bind(&MyTable::AddRow, table, row), base::Closure());
+//   db->Read(base::Bind(&MyTable::GetRows, table, rows),
+//            base::Bind(&MyService::OnGotRows, weak_this, base::Owned(rows)));
+//   ...
+//   db->Close();
+class SQL_EXPORT AsyncConnection
+    : public base::RefCountedThreadSafe<AsyncConnection> {
+ public:
+  // The most writes batched in one transaction.
+  static const int kMaxWritesPerTransaction;
+
+  // Runs the database work on |task_runner|.  With a zero |commit_delay|, a
+  // batch is committed as soon as there is nothing more queued, otherwise
+  // |commit_delay| after its first write.
+  AsyncConnection(base::SequencedTaskRunner* task_runner,
+                  base::TimeDelta commit_delay);
+
+  // The connection being wrapped.  It may be configured before the first
+  // task is posted, and must otherwise only be used from tasks.
+  Connection* connection() { return &connection_; }
+
+  base::SequencedTaskRunner* task_runner() const { return task_runner_; }
+
+  // Each of these runs |task| on the task runner, after the work posted
+  // before it except as noted, and then posts |reply|, unless it is null, to
+  // the thread it was called from.
+
+  // Runs |task| ahead of any queued writes.
+  void Read(const base::Closure& task, const base::Closure& reply);
+
+  // Runs |task| in the current batch.  |reply| is posted once the batch is
+  // committed.
+  void Write(const base::Closure& task, const base::Closure& reply);
+
+  // Commits the current batch, then runs |task| outside of any transaction.
+  // Reads don't go ahead of this, so it can open the database, change the
+  // schema, and such.
+  void Execute(const base::Closure& task, const base::Closure& reply);
+
+  // Commits the current batch and posts |reply|.
+  void Flush(const base::Closure& reply);
+
+  // Commits the current batch and closes the connection.
+  void Close();
+
+ private:
+  friend class base::RefCountedThreadSafe<AsyncConnection>;
+
+  struct Operation {
+    enum Type {
+      READ,
+      WRITE,
+      EXECUTE,
+    };
+
+    Operation();
+    ~Operation();
+
+    Type type;
+    int64 sequence_number;
+    base::Closure task;
+    base::Closure reply;
+    scoped_refptr<base::MessageLoopProxy> reply_loop;
+  };
+
+  ~AsyncConnection();
+
+  // Queues an operation and posts a task to run the next one.
+  void PostOperation(Operation::Type type,
+                     const base::Closure& task,
+                     const base::Closure& reply);
+
+  // Runs one queued operation, reads first.  On the task runner.
+  void RunNextOperation();
+
+  // Commits the current batch, if any, and posts the replies of its writes.
+  void CommitBatch();
+
+  // Commits batch |batch_number| if it is still the current one.
+  void CommitBatchAfterDelay(int batch_number);
+
+  void CloseConnection();
+
+  static void PostReply(const Operation& operation);
+
+  const scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  const base::TimeDelta commit_delay_;
+
+  Connection connection_;
+
+  // Guards the queues, which are filled on any thread.
+  base::Lock lock_;
+  std::deque<Operation> reads_;
+  // Writes and executes, in order.
+  std::deque<Operation> writes_;
+  // The sequence numbers of the executes in |writes_|, which reads don't go
+  // ahead of.
+  std::deque<int64> barriers_;
+  int64 next_sequence_number_;
+
+  // The rest is only used on the task runner.
+
+  // Whether a batch's transaction is open, the number of it, and the writes
+  // in it whose replies wait for the commit.
+  bool in_batch_;
+  int batch_number_;
+  std::vector<Operation> batch_writes_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncConnection);
+};
+
+}  // namespace sql
+
+#endif  // SQL_ASYNC_CONNECTION_H_
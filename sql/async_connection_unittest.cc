@@ -0,0 +1,225 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/message_loop.h"
+#include "base/scoped_temp_dir.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "sql/async_connection.h"
+#include "sql/statement.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Helpers run as tasks on the database thread.
+
+void OpenAndCreateTable(sql::Connection* db, const FilePath& path) {
+  ASSERT_TRUE(db->Open(path));
+  ASSERT_TRUE(db->Execute("CREATE TABLE foo (a)"));
+}
+
+void InsertRow(sql::Connection* db, int value) {
+  sql::Statement s(db->GetCachedStatement(SQL_FROM_HERE,
+                                          "INSERT INTO foo (a) VALUES (?)"));
+  s.BindInt(0, value);
+  EXPECT_TRUE(s.Run());
+}
+
+// Inserts |value| in a transaction of its own, which is rolled back unless
+// |commit|, as table classes do.
+void InsertRowInTransaction(sql::Connection* db, int value, bool commit) {
+  ASSERT_TRUE(db->BeginTransaction());
+  InsertRow(db, value);
+  if (commit)
+    EXPECT_TRUE(db->CommitTransaction());
+  else
+    db->RollbackTransaction();
+}
+
+void SumRows(sql::Connection* db, int* sum) {
+  sql::Statement s(db->GetUniqueStatement("SELECT SUM(a) FROM foo"));
+  ASSERT_TRUE(s.Step());
+  *sum = s.ColumnInt(0);
+}
+
+void CountRows(sql::Connection* db, int* count) {
+  sql::Statement s(db->GetUniqueStatement("SELECT COUNT(*) FROM foo"));
+  ASSERT_TRUE(s.Step());
+  *count = s.ColumnInt(0);
+}
+
+void GetTransactionNesting(sql::Connection* db, int* nesting) {
+  *nesting = db->transaction_nesting();
+}
+
+void Append(std::string* log, const std::string& entry) {
+  *log += entry;
+}
+
+void Wait(base::WaitableEvent* event) {
+  event->Wait();
+}
+
+}  // namespace
+
+class SQLAsyncConnectionTest : public testing::Test {
+ public:
+  SQLAsyncConnectionTest() : db_thread_("SQLAsyncConnectionTest") {}
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    ASSERT_TRUE(db_thread_.Start());
+  }
+
+  virtual void TearDown() OVERRIDE {
+    if (db_) {
+      db_->Close();
+      db_ = NULL;
+    }
+    db_thread_.Stop();
+  }
+
+  void CreateConnection(base::TimeDelta commit_delay) {
+    db_ = new sql::AsyncConnection(db_thread_.message_loop_proxy(),
+                                   commit_delay);
+    db_->Execute(base::Bind(&OpenAndCreateTable, db_->connection(),
+                            temp_dir_.path().AppendASCII("test.db")),
+                 base::Closure());
+  }
+
+  // Waits for everything posted so far, and for the replies.
+  void Flush() {
+    db_->Flush(MessageLoop::QuitClosure());
+    MessageLoop::current()->Run();
+  }
+
+  int CountRowsNow() {
+    int count = -1;
+    db_->Read(base::Bind(&CountRows, db_->connection(), &count),
+              MessageLoop::QuitClosure());
+    MessageLoop::current()->Run();
+    return count;
+  }
+
+ protected:
+  MessageLoop loop_;
+  ScopedTempDir temp_dir_;
+  base::Thread db_thread_;
+  scoped_refptr<sql::AsyncConnection> db_;
+};
+
+TEST_F(SQLAsyncConnectionTest, WritesAreBatched) {
+  CreateConnection(base::TimeDelta());
+
+  // Hold the database thread so that the writes queue up.
+  base::WaitableEvent event(false, false);
+  db_->Execute(base::Bind(&Wait, &event), base::Closure());
+  std::string replies;
+  int nesting[3] = { -1, -1, -1 };
+  for (int i = 0; i < 3; ++i) {
+    db_->Write(base::Bind(&InsertRow, db_->connection(), i),
+               base::Bind(&Append, &replies, "w"));
+    db_->Write(base::Bind(&GetTransactionNesting, db_->connection(),
+                          &nesting[i]),
+               base::Closure());
+  }
+  event.Signal();
+  Flush();
+
+  // All the writes ran in one transaction, committed once they were done.
+  EXPECT_EQ(1, nesting[0]);
+  EXPECT_EQ(1, nesting[2]);
+  EXPECT_EQ("www", replies);
+  EXPECT_EQ(3, CountRowsNow());
+
+  int nesting_after = -1;
+  db_->Read(base::Bind(&GetTransactionNesting, db_->connection(),
+                       &nesting_after),
+            base::Closure());
+  Flush();
+  EXPECT_EQ(0, nesting_after);
+}
+
+TEST_F(SQLAsyncConnectionTest, RollbackIsolatedToWrite) {
+  CreateConnection(base::TimeDelta());
+
+  base::WaitableEvent event(false, false);
+  db_->Execute(base::Bind(&Wait, &event), base::Closure());
+  std::string replies;
+  db_->Write(base::Bind(&InsertRowInTransaction, db_->connection(), 1, true),
+             base::Bind(&Append, &replies, "w"));
+  db_->Write(base::Bind(&InsertRowInTransaction, db_->connection(), 2, false),
+             base::Bind(&Append, &replies, "w"));
+  // Later writes can still open their own transactions.
+  db_->Write(base::Bind(&InsertRowInTransaction, db_->connection(), 4, true),
+             base::Bind(&Append, &replies, "w"));
+  event.Signal();
+  Flush();
+
+  // Only the write that rolled back lost its row.
+  EXPECT_EQ("www", replies);
+  EXPECT_EQ(2, CountRowsNow());
+  int sum = -1;
+  db_->Read(base::Bind(&SumRows, db_->connection(), &sum), base::Closure());
+  Flush();
+  EXPECT_EQ(5, sum);
+}
+
+TEST_F(SQLAsyncConnectionTest, ReadsGoAheadOfWrites) {
+  CreateConnection(base::TimeDelta());
+
+  base::WaitableEvent event(false, false);
+  db_->Execute(base::Bind(&Wait, &event), base::Closure());
+  std::string log;
+  db_->Write(base::Bind(&Append, &log, "w1"), base::Closure());
+  db_->Read(base::Bind(&Append, &log, "r1"), base::Closure());
+  db_->Execute(base::Bind(&Append, &log, "e"), base::Closure());
+  db_->Write(base::Bind(&Append, &log, "w2"), base::Closure());
+  db_->Read(base::Bind(&Append, &log, "r2"), base::Closure());
+  event.Signal();
+  Flush();
+
+  // Reads pass writes, but not executes.
+  EXPECT_EQ("r1w1er2w2", log);
+}
+
+TEST_F(SQLAsyncConnectionTest, CommitDelay) {
+  CreateConnection(base::TimeDelta::FromMilliseconds(10));
+
+  db_->Write(base::Bind(&InsertRow, db_->connection(), 1),
+             base::Bind(&MessageLoop::Quit,
+                        base::Unretained(MessageLoop::current())));
+  // A write sees the batch's transaction, which the earlier write opened.
+  int nesting = -1;
+  db_->Write(base::Bind(&GetTransactionNesting, db_->connection(), &nesting),
+             base::Closure());
+
+  // The reply waits for the delayed commit.
+  MessageLoop::current()->Run();
+  EXPECT_EQ(1, nesting);
+  EXPECT_EQ(1, CountRowsNow());
+
+  nesting = -1;
+  db_->Read(base::Bind(&GetTransactionNesting, db_->connection(), &nesting),
+            base::Closure());
+  Flush();
+  EXPECT_EQ(0, nesting);
+}
+
+TEST_F(SQLAsyncConnectionTest, CloseCommits) {
+  CreateConnection(base::TimeDelta::FromHours(1));
+  db_->Write(base::Bind(&InsertRow, db_->connection(), 1), base::Closure());
+  db_->Close();
+  db_ = NULL;
+  db_thread_.Stop();
+
+  sql::Connection db;
+  ASSERT_TRUE(db.Open(temp_dir_.path().AppendASCII("test.db")));
+  int count = 0;
+  CountRows(&db, &count);
+  EXPECT_EQ(1, count);
+}
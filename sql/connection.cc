@@ -6,8 +6,11 @@
 
 #include <string.h>
 
+#include <algorithm>
+
 #include "base/file_path.h"
 #include "base/logging.h"
+#include "base/metrics/histogram.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "base/utf_string_conversions.h"
@@ -40,6 +43,37 @@ class ScopedBusyTimeout {
   sqlite3* db_;
 };
 
+// Orders statement stats by decreasing total time.
+bool CompareStatementTime(const sql::StatementStats& a,
+                          const sql::StatementStats& b) {
+  return a.time > b.time;
+}
+
+#if !defined(NDEBUG)
+// Returns true if the query plan of |sql| reads through a whole table.  Plan
+// rows look like "SCAN TABLE foo (~100000 rows)" for those, and like "SEARCH
+// TABLE foo USING INDEX ..." or "SCAN TABLE foo USING INDEX ..." otherwise.
+bool HasFullTableScan(sqlite3* db, const char* sql) {
+  const std::string explain = std::string("EXPLAIN QUERY PLAN ") + sql;
+  sqlite3_stmt* stmt = NULL;
+  if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, NULL) != SQLITE_OK)
+    return false;
+
+  bool full_scan = false;
+  while (!full_scan && sqlite3_step(stmt) == SQLITE_ROW) {
+    // The description is the last column.
+    const char* detail = reinterpret_cast<const char*>(
+        sqlite3_column_text(stmt, sqlite3_column_count(stmt) - 1));
+    if (detail && StartsWithASCII(detail, "SCAN TABLE ", true) &&
+        !strstr(detail, " USING ")) {
+      full_scan = true;
+    }
+  }
+  sqlite3_finalize(stmt);
+  return full_scan;
+}
+#endif
+
 }  // namespace
 
 namespace sql {
@@ -50,6 +84,26 @@ bool StatementID::operator<(const StatementID& other) const {
   return strcmp(str_, other.str_) < 0;
 }
 
+std::string StatementID::ToString() const {
+  if (number_ < 0)
+    return str_;
+  return base::StringPrintf("%s:%d", str_, number_);
+}
+
+StatementStats::StatementStats()
+    : executions(0),
+      steps(0),
+      rows(0),
+      slow_executions(0),
+      full_scan(false) {
+}
+
+StatementStats::~StatementStats() {
+}
+
+// static
+const int Connection::kSlowStatementTimeMs = 100;
+
 ErrorDelegate::ErrorDelegate() {
 }
 
@@ -58,13 +112,15 @@ ErrorDelegate::~ErrorDelegate() {
 
 Connection::StatementRef::StatementRef()
     : connection_(NULL),
-      stmt_(NULL) {
+      stmt_(NULL),
+      stats_(NULL) {
 }
 
 Connection::StatementRef::StatementRef(Connection* connection,
                                        sqlite3_stmt* stmt)
     : connection_(connection),
-      stmt_(stmt) {
+      stmt_(stmt),
+      stats_(NULL) {
   connection_->StatementRefCreated(this);
 }
 
@@ -80,6 +136,7 @@ void Connection::StatementRef::Close() {
     stmt_ = NULL;
   }
   connection_ = NULL;  // The connection may be getting deleted.
+  stats_ = NULL;
 }
 
 Connection::Connection()
@@ -87,8 +144,14 @@ Connection::Connection()
       page_size_(0),
       cache_size_(0),
       exclusive_locking_(false),
+      journal_mode_(JOURNAL_MODE_PERSIST),
+      synchronous_(SYNCHRONOUS_FULL),
+      wal_autocheckpoint_(0),
+      wal_mode_(false),
       transaction_nesting_(0),
-      needs_rollback_(false) {
+      needs_rollback_(false),
+      in_savepoint_(false),
+      profiling_(false) {
 }
 
 Connection::~Connection() {
@@ -124,11 +187,22 @@ void Connection::Close() {
   // error-handling code is hit in production.
   ClearCache();
 
+  if (profiling_ && VLOG_IS_ON(1)) {
+    std::vector<StatementStats> stats;
+    GetStatementStats(&stats);
+    for (size_t i = 0; i < stats.size(); ++i) {
+      VLOG(1) << profiling_histogram_tag_ << ": " << stats[i].executions
+              << " executions, " << stats[i].rows << " rows, "
+              << stats[i].time.InMillisecondsF() << " ms: " << stats[i].sql;
+    }
+  }
+
   if (db_) {
     // TODO(shess): Histogram for failure.
     sqlite3_close(db_);
     db_ = NULL;
   }
+  wal_mode_ = false;
 }
 
 void Connection::Preload() {
@@ -291,6 +365,42 @@ bool Connection::CommitTransaction() {
   return commit.Run();
 }
 
+bool Connection::BeginSavepoint() {
+  DCHECK_GT(transaction_nesting_, 0);
+  DCHECK(!needs_rollback_);
+  DCHECK(!in_savepoint_);
+
+  Statement savepoint(GetCachedStatement(SQL_FROM_HERE,
+                                         "SAVEPOINT sql_savepoint"));
+  if (!savepoint.Run())
+    return false;
+  in_savepoint_ = true;
+  return true;
+}
+
+bool Connection::EndSavepoint() {
+  if (!in_savepoint_) {
+    DLOG(FATAL) << "Ending a nonexistent savepoint";
+    return false;
+  }
+  in_savepoint_ = false;
+
+  // A nested transaction rolled back since the savepoint.  Only the work
+  // since the savepoint is undone, so the outer transaction may still commit.
+  bool rolled_back = needs_rollback_;
+  if (rolled_back) {
+    Statement rollback(GetCachedStatement(SQL_FROM_HERE,
+                                          "ROLLBACK TO sql_savepoint"));
+    rollback.Run();
+    needs_rollback_ = false;
+  }
+
+  Statement release(GetCachedStatement(SQL_FROM_HERE,
+                                       "RELEASE sql_savepoint"));
+  release.Run();
+  return !rolled_back;
+}
+
 int Connection::ExecuteAndReturnErrorCode(const char* sql) {
   if (!db_)
     return false;
@@ -337,6 +447,8 @@ scoped_refptr<Connection::StatementRef> Connection::GetCachedStatement(
   scoped_refptr<StatementRef> statement = GetUniqueStatement(sql);
   if (statement->is_valid())
     statement_cache_[id] = statement;  // Only cache valid statements.
+  if (statement->stats() && statement->stats()->source.empty())
+    statement->stats()->source = id.ToString();
   return statement;
 }
 
@@ -351,7 +463,10 @@ scoped_refptr<Connection::StatementRef> Connection::GetUniqueStatement(
     DLOG(FATAL) << "SQL compile error " << GetErrorMessage();
     return new StatementRef(this, NULL);
   }
-  return new StatementRef(this, stmt);
+  scoped_refptr<StatementRef> statement(new StatementRef(this, stmt));
+  if (profiling_)
+    statement->set_stats(GetStatsForStatement(stmt));
+  return statement;
 }
 
 bool Connection::IsSQLValid(const char* sql) {
@@ -477,20 +592,42 @@ bool Connection::OpenInternal(const std::string& file_name) {
       DLOG(FATAL) << "Could not set locking mode: " << GetErrorMessage();
   }
 
-  // http://www.sqlite.org/pragma.html#pragma_journal_mode
-  // DELETE (default) - delete -journal file to commit.
-  // TRUNCATE - truncate -journal file to commit.
-  // PERSIST - zero out header of -journal file to commit.
-  // journal_size_limit provides size to trim to in PERSIST.
-  // TODO(shess): Figure out if PERSIST and journal_size_limit really
-  // matter.  In theory, it keeps pages pre-allocated, so if
-  // transactions usually fit, it should be faster.
-  ignore_result(Execute("PRAGMA journal_mode = PERSIST"));
-  ignore_result(Execute("PRAGMA journal_size_limit = 16384"));
-
   const base::TimeDelta kBusyTimeout =
     base::TimeDelta::FromSeconds(kBusyTimeoutSeconds);
 
+  // Switching to WAL needs a lock on the database, and the pragma returns the
+  // mode in effect afterwards.  With exclusive locking, which was set above,
+  // sqlite keeps the WAL index on the heap instead of in a -shm file.
+  if (journal_mode_ == JOURNAL_MODE_WAL) {
+    ScopedBusyTimeout busy_timeout(db_);
+    busy_timeout.SetTimeout(kBusyTimeout);
+    Statement journal_mode(GetUniqueStatement("PRAGMA journal_mode = WAL"));
+    wal_mode_ = journal_mode.Step() && journal_mode.ColumnString(0) == "wal";
+  }
+
+  if (!wal_mode_) {
+    // http://www.sqlite.org/pragma.html#pragma_journal_mode
+    // DELETE (default) - delete -journal file to commit.
+    // TRUNCATE - truncate -journal file to commit.
+    // PERSIST - zero out header of -journal file to commit.
+    // journal_size_limit provides size to trim to in PERSIST.
+    // TODO(shess): Figure out if PERSIST and journal_size_limit really
+    // matter.  In theory, it keeps pages pre-allocated, so if
+    // transactions usually fit, it should be faster.
+    ignore_result(Execute("PRAGMA journal_mode = PERSIST"));
+    ignore_result(Execute("PRAGMA journal_size_limit = 16384"));
+  } else if (wal_autocheckpoint_ != 0) {
+    // A negative size turns automatic checkpoints off.
+    sqlite3_wal_autocheckpoint(db_, std::max(wal_autocheckpoint_, 0));
+  }
+
+  if (synchronous_ != SYNCHRONOUS_FULL) {
+    const std::string sql = StringPrintf("PRAGMA synchronous=%d",
+                                         static_cast<int>(synchronous_));
+    if (!Execute(sql.c_str()))
+      DLOG(FATAL) << "Could not set synchronous: " << GetErrorMessage();
+  }
+
   if (page_size_ != 0) {
     // Enforce SQLite restrictions on |page_size_|.
     DCHECK(!(page_size_ & (page_size_ - 1)))
@@ -517,6 +654,23 @@ bool Connection::OpenInternal(const std::string& file_name) {
   return true;
 }
 
+bool Connection::CheckpointWAL(CheckpointMode mode) {
+  if (!db_) {
+    DLOG(FATAL) << "Cannot checkpoint null db";
+    return false;
+  }
+  if (!wal_mode_)
+    return true;
+
+  int sqlite_mode = SQLITE_CHECKPOINT_PASSIVE;
+  if (mode == CHECKPOINT_FULL)
+    sqlite_mode = SQLITE_CHECKPOINT_FULL;
+  else if (mode == CHECKPOINT_RESTART)
+    sqlite_mode = SQLITE_CHECKPOINT_RESTART;
+  return sqlite3_wal_checkpoint_v2(db_, NULL, sqlite_mode, NULL, NULL) ==
+      SQLITE_OK;
+}
+
 void Connection::DoRollback() {
   Statement rollback(GetCachedStatement(SQL_FROM_HERE, "ROLLBACK"));
   rollback.Run();
@@ -547,6 +701,58 @@ void Connection::ClearCache() {
     (*i)->Close();
 }
 
+void Connection::EnableStatementProfiling(const std::string& histogram_tag) {
+  profiling_ = true;
+  profiling_histogram_tag_ = histogram_tag;
+}
+
+void Connection::GetStatementStats(std::vector<StatementStats>* stats) const {
+  stats->clear();
+  for (StatementStatsMap::const_iterator it = statement_stats_.begin();
+       it != statement_stats_.end(); ++it) {
+    stats->push_back(it->second);
+  }
+  std::sort(stats->begin(), stats->end(), &CompareStatementTime);
+}
+
+StatementStats* Connection::GetStatsForStatement(sqlite3_stmt* stmt) {
+  const char* sql = sqlite3_sql(stmt);
+  StatementStatsMap::iterator it = statement_stats_.find(sql);
+  if (it != statement_stats_.end())
+    return &it->second;
+
+  StatementStats* stats = &statement_stats_[sql];
+  stats->sql = sql;
+#if !defined(NDEBUG)
+  stats->full_scan = HasFullTableScan(db_, sql);
+  DLOG_IF(WARNING, stats->full_scan) << "Full table scan: " << sql;
+#endif
+  return stats;
+}
+
+void Connection::RecordStatementExecution(StatementStats* stats,
+                                          base::TimeDelta time) {
+  ++stats->executions;
+  stats->time += time;
+  stats->max_time = std::max(stats->max_time, time);
+  if (time.InMilliseconds() >= kSlowStatementTimeMs) {
+    ++stats->slow_executions;
+    DVLOG(1) << "Slow statement (" << time.InMilliseconds() << " ms): "
+             << stats->sql;
+  }
+
+  if (!profiling_histogram_tag_.empty()) {
+    // Histogram names can't be built into the UMA macros, which cache the
+    // histogram in a static.
+    base::Histogram* histogram = base::Histogram::FactoryTimeGet(
+        "Sqlite." + profiling_histogram_tag_ + ".StatementTime",
+        base::TimeDelta::FromMicroseconds(10),
+        base::TimeDelta::FromSeconds(10), 50,
+        base::Histogram::kUmaTargetedHistogramFlag);
+    histogram->AddTime(time);
+  }
+}
+
 int Connection::OnSqliteError(int err, sql::Statement *stmt) {
   if (error_delegate_.get())
     return error_delegate_->OnError(err, this, stmt);
@@ -9,6 +9,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
@@ -63,6 +64,9 @@ class StatementID {
   // We need this to insert into our map.
   bool operator<(const StatementID& other) const;
 
+  // Returns "file:line" or the user-defined name, for diagnostics.
+  std::string ToString() const;
+
  private:
   int number_;
   const char* str_;
@@ -72,6 +76,39 @@ class StatementID {
 
 class Connection;
 
+// What a connection with statement profiling enabled has recorded about one
+// statement, identified by its SQL.  See Connection::EnableStatementProfiling.
+struct SQL_EXPORT StatementStats {
+  StatementStats();
+  ~StatementStats();
+
+  std::string sql;
+
+  // The StatementID the statement was cached under, if it was.
+  std::string source;
+
+  // The number of times the statement was run, that is stepped at least once
+  // and then reset.
+  int executions;
+
+  // The number of calls to sqlite3_step() and how many of them returned a
+  // row.
+  int64 steps;
+  int64 rows;
+
+  // The time spent in sqlite3_step(), in total and for the slowest
+  // execution.
+  base::TimeDelta time;
+  base::TimeDelta max_time;
+
+  // The number of executions slower than Connection::kSlowStatementTimeMs.
+  int slow_executions;
+
+  // Whether the query plan reads a whole table rather than searching an
+  // index.  Only checked in debug builds.
+  bool full_scan;
+};
+
 // ErrorDelegate defines the interface to implement error handling and recovery
 // for sqlite operations. This allows the rest of the classes to return true or
 // false while the actual error code and causing statement are delivered using
@@ -139,6 +176,48 @@ class SQL_EXPORT Connection {
   // This must be called before Open() to have an effect.
   void set_exclusive_locking() { exclusive_locking_ = true; }
 
+  // How commits are made durable, see
+  // http://www.sqlite.org/pragma.html#pragma_journal_mode
+  enum JournalMode {
+    // Changed pages are first copied to a rollback journal, whose header is
+    // zeroed to commit.  This is the default.
+    JOURNAL_MODE_PERSIST,
+    // Changes are appended to a write-ahead log, which is copied back into
+    // the database by checkpoints.  Commits write and sync only the log, and
+    // readers don't block the writer.  See http://www.sqlite.org/wal.html.
+    // In-memory databases keep using their in-memory journal.
+    JOURNAL_MODE_WAL,
+  };
+
+  // Sets the journal mode.  This must be called before Open() to have an
+  // effect.  A database switched back to JOURNAL_MODE_PERSIST leaves write-
+  // ahead logging when it is next opened.
+  void set_journal_mode(JournalMode mode) { journal_mode_ = mode; }
+
+  // How often sqlite waits for data to reach the disk, see
+  // http://www.sqlite.org/pragma.html#pragma_synchronous
+  enum Synchronous {
+    // Never sync.  A power loss or OS crash may corrupt the database.
+    SYNCHRONOUS_OFF,
+    // Sync at the critical moments only.  With JOURNAL_MODE_WAL this means at
+    // checkpoints, so a power loss may roll back the last commits but can't
+    // corrupt the database.
+    SYNCHRONOUS_NORMAL,
+    // Sync on every commit.  This is the default.
+    SYNCHRONOUS_FULL,
+  };
+
+  // Sets the synchronous level.  This must be called before Open() to have
+  // an effect.
+  void set_synchronous(Synchronous synchronous) { synchronous_ = synchronous; }
+
+  // Sets the size, in pages, the write-ahead log grows to before a commit
+  // checkpoints it.  Zero means sqlite's default of 1000 pages, and a
+  // negative value disables automatic checkpoints, leaving them to
+  // CheckpointWAL() and Close().  This must be called before Open() to have
+  // an effect, and only matters with JOURNAL_MODE_WAL.
+  void set_wal_autocheckpoint(int pages) { wal_autocheckpoint_ = pages; }
+
   // Sets the object that will handle errors. Recomended that it should be set
   // before calling Open(). If not set, the default is to ignore errors on
   // release and assert on debug builds.
@@ -160,6 +239,11 @@ class SQL_EXPORT Connection {
   // Returns trie if the database has been successfully opened.
   bool is_open() const { return !!db_; }
 
+  // Returns true if the open database uses a write-ahead log.  This may be
+  // false after asking for JOURNAL_MODE_WAL, for instance for in-memory
+  // databases.
+  bool is_wal_mode() const { return wal_mode_; }
+
   // Closes the database. This is automatically performed on destruction for
   // you, but this allows you to close the database early. You must not call
   // any other functions after closing it. It is permissable to call Close on
@@ -201,6 +285,24 @@ class SQL_EXPORT Connection {
   bool Raze();
   bool RazeWithTimout(base::TimeDelta timeout);
 
+  // How much of the write-ahead log CheckpointWAL() copies back, see
+  // http://www.sqlite.org/c3ref/wal_checkpoint_v2.html
+  enum CheckpointMode {
+    // As much as can be copied without waiting for readers or the writer.
+    CHECKPOINT_PASSIVE,
+    // All of it, waiting for the writer and for readers of older data.
+    CHECKPOINT_FULL,
+    // All of it, and also waits for readers of the log so that the next
+    // commit starts writing it from the beginning again.
+    CHECKPOINT_RESTART,
+  };
+
+  // Copies committed pages from the write-ahead log into the database.  Use
+  // this at idle times when automatic checkpoints were disabled, or to bound
+  // the log's size.  Returns true on success, and trivially when the database
+  // does not use a write-ahead log.
+  bool CheckpointWAL(CheckpointMode mode);
+
   // Transactions --------------------------------------------------------------
 
   // Transaction management. We maintain a virtual transaction stack to emulate
@@ -220,6 +322,19 @@ class SQL_EXPORT Connection {
   // no open transactions.
   int transaction_nesting() const { return transaction_nesting_; }
 
+  // Savepoints let a long-running transaction contain the failure of a
+  // nested one.  After BeginSavepoint(), a nested transaction that is rolled
+  // back only marks the work done since the savepoint as failed, rather than
+  // the whole transaction.  EndSavepoint() then undoes just that work, and
+  // the outer transaction can go on and commit.  Savepoints don't nest, and
+  // must be begun and ended within a transaction, outside of any nested one.
+  //
+  // BeginSavepoint() returns false if the savepoint could not be made, in
+  // which case EndSavepoint() must not be called.  EndSavepoint() returns
+  // false if the work done since the savepoint was rolled back.
+  bool BeginSavepoint();
+  bool EndSavepoint();
+
   // Statements ----------------------------------------------------------------
 
   // Executes the given SQL string, returning true on success. This is
@@ -298,6 +413,26 @@ class SQL_EXPORT Connection {
   // is closed.
   int GetLastChangeCount() const;
 
+  // Profiling -----------------------------------------------------------------
+
+  // Executions that take longer than this are logged and counted as slow.
+  static const int kSlowStatementTimeMs;
+
+  // Starts recording how often and how long each statement runs, see
+  // StatementStats.  Only statements prepared afterwards are profiled, so
+  // call this before Open().  The time of each execution is also recorded in
+  // the "Sqlite.<histogram_tag>.StatementTime" histogram.
+  //
+  // In debug builds, the query plan of each statement is checked when it is
+  // first prepared, and full table scans are logged.
+  void EnableStatementProfiling(const std::string& histogram_tag);
+
+  bool is_profiling() const { return profiling_; }
+
+  // Fills |stats| with what has been recorded, slowest statements in total
+  // first.  The stats persist across Close().
+  void GetStatementStats(std::vector<StatementStats>* stats) const;
+
   // Errors --------------------------------------------------------------------
 
   // Returns the error code associated with the last sqlite operation.
@@ -352,6 +487,11 @@ class SQL_EXPORT Connection {
     // this will return NULL.
     sqlite3_stmt* stmt() const { return stmt_; }
 
+    // Where executions of the statement are recorded, owned by the
+    // connection.  NULL unless the connection is profiling.
+    StatementStats* stats() const { return stats_; }
+    void set_stats(StatementStats* stats) { stats_ = stats; }
+
     // Destroys the compiled statement and marks it NULL. The statement will
     // no longer be active.
     void Close();
@@ -363,6 +503,7 @@ class SQL_EXPORT Connection {
 
     Connection* connection_;
     sqlite3_stmt* stmt_;
+    StatementStats* stats_;
 
     DISALLOW_COPY_AND_ASSIGN(StatementRef);
   };
@@ -388,6 +529,14 @@ class SQL_EXPORT Connection {
   bool ExecuteWithTimeout(const char* sql, base::TimeDelta ms_timeout)
       WARN_UNUSED_RESULT;
 
+  // Returns the stats for |stmt|, creating them the first time its SQL is
+  // seen.  Only called when profiling.
+  StatementStats* GetStatsForStatement(sqlite3_stmt* stmt);
+
+  // Called by Statement objects when they are reset after having been
+  // stepped, with the time spent stepping.
+  void RecordStatementExecution(StatementStats* stats, base::TimeDelta time);
+
   // The actual sqlite database. Will be NULL before Init has been called or if
   // Init resulted in an error.
   sqlite3* db_;
@@ -397,6 +546,12 @@ class SQL_EXPORT Connection {
   int page_size_;
   int cache_size_;
   bool exclusive_locking_;
+  JournalMode journal_mode_;
+  Synchronous synchronous_;
+  int wal_autocheckpoint_;
+
+  // Whether the open database is using a write-ahead log.
+  bool wal_mode_;
 
   // All cached statements. Keeping a reference to these statements means that
   // they'll remain active.
@@ -418,6 +573,16 @@ class SQL_EXPORT Connection {
   // a rollback instead of a commit.
   bool needs_rollback_;
 
+  // True between BeginSavepoint() and EndSavepoint().
+  bool in_savepoint_;
+
+  // Statement profiling state, see EnableStatementProfiling().  The stats
+  // are keyed by SQL, and StatementRefs point into the map.
+  bool profiling_;
+  std::string profiling_histogram_tag_;
+  typedef std::map<std::string, StatementStats> StatementStatsMap;
+  StatementStatsMap statement_stats_;
+
   // This object handles errors resulting from all forms of executing sqlite
   // commands or statements. It can be null which means default handling.
   scoped_refptr<ErrorDelegate> error_delegate_;
@@ -0,0 +1,276 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/compiler_specific.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+#include "sql/async_connection.h"
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/sqlite/sqlite3.h"
+
+namespace {
+
+// The number of single row transactions each commit latency test makes.
+const int kCommits = 200;
+
+// How long the reader and writer run for in the concurrency tests.
+const int kConcurrencyTestSeconds = 2;
+
+const char kCreateSql[] =
+    "CREATE TABLE visits (id INTEGER PRIMARY KEY, url LONGVARCHAR, time INT)";
+const char kInsertSql[] = "INSERT INTO visits (url, time) VALUES (?, ?)";
+const char kSelectSql[] = "SELECT COUNT(*), MAX(time) FROM visits";
+
+// Counts the statements that failed because the database was locked, which
+// would otherwise assert.  A connection and its delegate are only used on one
+// thread.
+class BusyCountingErrorDelegate : public sql::ErrorDelegate {
+ public:
+  BusyCountingErrorDelegate() : busy_count_(0) {}
+
+  virtual int OnError(int error, sql::Connection* connection,
+                      sql::Statement* stmt) OVERRIDE {
+    int basic_error = error & 0xff;
+    EXPECT_TRUE(basic_error == SQLITE_BUSY || basic_error == SQLITE_LOCKED)
+        << connection->GetErrorMessage();
+    ++busy_count_;
+    return error;
+  }
+
+  int busy_count() const { return busy_count_; }
+
+ private:
+  virtual ~BusyCountingErrorDelegate() {}
+
+  int busy_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(BusyCountingErrorDelegate);
+};
+
+// The journal settings a test runs with.
+struct JournalConfig {
+  const char* name;
+  sql::Connection::JournalMode journal_mode;
+  sql::Connection::Synchronous synchronous;
+};
+
+const JournalConfig kJournalConfigs[] = {
+  { "Persist_SyncFull", sql::Connection::JOURNAL_MODE_PERSIST,
+    sql::Connection::SYNCHRONOUS_FULL },
+  { "WAL_SyncFull", sql::Connection::JOURNAL_MODE_WAL,
+    sql::Connection::SYNCHRONOUS_FULL },
+  { "WAL_SyncNormal", sql::Connection::JOURNAL_MODE_WAL,
+    sql::Connection::SYNCHRONOUS_NORMAL },
+};
+
+bool OpenConnection(const JournalConfig& config, const FilePath& path,
+                    sql::Connection* db) {
+  db->set_journal_mode(config.journal_mode);
+  db->set_synchronous(config.synchronous);
+  return db->Open(path);
+}
+
+bool InsertRow(sql::Connection* db, int64 time) {
+  sql::Statement s(db->GetCachedStatement(SQL_FROM_HERE, kInsertSql));
+  s.BindString(0, "http://www.google.com/");
+  s.BindInt64(1, time);
+  return s.Run();
+}
+
+void OpenAndCreateTable(const JournalConfig& config, const FilePath& path,
+                        sql::Connection* db) {
+  ASSERT_TRUE(OpenConnection(config, path, db));
+  ASSERT_TRUE(db->Execute(kCreateSql));
+}
+
+void InsertRowTask(sql::Connection* db, int64 time) {
+  EXPECT_TRUE(InsertRow(db, time));
+}
+
+// Reads the table over and over on its own connection until |end_time|.
+class Reader : public base::DelegateSimpleThread::Delegate {
+ public:
+  Reader(const JournalConfig& config, const FilePath& path,
+         const base::TimeTicks& end_time)
+      : config_(config),
+        path_(path),
+        end_time_(end_time),
+        error_delegate_(new BusyCountingErrorDelegate),
+        reads_(0) {
+  }
+
+  virtual void Run() OVERRIDE {
+    sql::Connection db;
+    db.set_error_delegate(error_delegate_);
+    ASSERT_TRUE(OpenConnection(config_, path_, &db));
+    while (base::TimeTicks::Now() < end_time_) {
+      sql::Statement s(db.GetCachedStatement(SQL_FROM_HERE, kSelectSql));
+      if (s.Step())
+        ++reads_;
+    }
+  }
+
+  int reads() const { return reads_; }
+  int busy_count() const { return error_delegate_->busy_count(); }
+
+ private:
+  const JournalConfig& config_;
+  const FilePath path_;
+  const base::TimeTicks end_time_;
+  scoped_refptr<BusyCountingErrorDelegate> error_delegate_;
+  int reads_;
+
+  DISALLOW_COPY_AND_ASSIGN(Reader);
+};
+
+class SQLConnectionPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  FilePath db_path(const JournalConfig& config) {
+    return temp_dir_.path().AppendASCII(
+        base::StringPrintf("%s.db", config.name));
+  }
+
+ private:
+  ScopedTempDir temp_dir_;
+};
+
+}  // namespace
+
+// Times small transactions, as the history and cookie databases commit.
+TEST_F(SQLConnectionPerfTest, CommitLatency) {
+  for (size_t i = 0; i < arraysize(kJournalConfigs); ++i) {
+    const JournalConfig& config = kJournalConfigs[i];
+    sql::Connection db;
+    ASSERT_TRUE(OpenConnection(config, db_path(config), &db));
+    ASSERT_TRUE(db.Execute(kCreateSql));
+
+    PerfTimer timer;
+    for (int j = 0; j < kCommits; ++j) {
+      ASSERT_TRUE(db.BeginTransaction());
+      ASSERT_TRUE(InsertRow(&db, j));
+      ASSERT_TRUE(db.CommitTransaction());
+    }
+    LogPerfResult(
+        base::StringPrintf("SQLConnection_CommitLatency_%s",
+                           config.name).c_str(),
+        timer.Elapsed().InMillisecondsF() / kCommits, "ms");
+  }
+}
+
+// Commits on one connection while another reads on a second thread, and
+// counts how much work each gets done.
+TEST_F(SQLConnectionPerfTest, ReaderWriterConcurrency) {
+  for (size_t i = 0; i < arraysize(kJournalConfigs); ++i) {
+    const JournalConfig& config = kJournalConfigs[i];
+    scoped_refptr<BusyCountingErrorDelegate> error_delegate(
+        new BusyCountingErrorDelegate);
+    sql::Connection db;
+    db.set_error_delegate(error_delegate);
+    ASSERT_TRUE(OpenConnection(config, db_path(config), &db));
+    ASSERT_TRUE(db.Execute(kCreateSql));
+    ASSERT_TRUE(InsertRow(&db, 0));
+
+    base::TimeTicks end_time = base::TimeTicks::Now() +
+        base::TimeDelta::FromSeconds(kConcurrencyTestSeconds);
+    Reader reader(config, db_path(config), end_time);
+    base::DelegateSimpleThread reader_thread(&reader, "SQLReader");
+    reader_thread.Start();
+
+    int commits = 0;
+    for (int64 time = 1; base::TimeTicks::Now() < end_time; ++time) {
+      if (!db.BeginTransaction()) {
+        ADD_FAILURE();
+        break;
+      }
+      if (!InsertRow(&db, time)) {
+        db.RollbackTransaction();
+        continue;
+      }
+      if (db.CommitTransaction()) {
+        ++commits;
+      } else {
+        // A COMMIT that was refused leaves the transaction open.
+        db.ExecuteAndReturnErrorCode("ROLLBACK");
+      }
+    }
+    reader_thread.Join();
+
+    const std::string prefix =
+        base::StringPrintf("SQLConnection_Concurrency_%s_", config.name);
+    LogPerfResult((prefix + "Commits").c_str(),
+                  static_cast<double>(commits) / kConcurrencyTestSeconds,
+                  "commits/s");
+    LogPerfResult((prefix + "Reads").c_str(),
+                  static_cast<double>(reader.reads()) /
+                      kConcurrencyTestSeconds,
+                  "reads/s");
+    LogPerfResult((prefix + "Busy").c_str(),
+                  error_delegate->busy_count() + reader.busy_count(),
+                  "errors");
+  }
+}
+
+// Writes single rows as a client posting them to a database thread would,
+// first committing each one, then batched by an AsyncConnection.
+TEST_F(SQLConnectionPerfTest, AsyncWriteThroughput) {
+  MessageLoop loop;
+  for (size_t i = 0; i < arraysize(kJournalConfigs); ++i) {
+    const JournalConfig& config = kJournalConfigs[i];
+    base::Thread db_thread("SQLConnectionPerfTest");
+    ASSERT_TRUE(db_thread.Start());
+
+    // The connection is only used on |db_thread|, and with a commit when
+    // idle the batches are as large as the writes queued up.
+    scoped_refptr<sql::AsyncConnection> db(new sql::AsyncConnection(
+        db_thread.message_loop_proxy(), base::TimeDelta()));
+    db->Execute(base::Bind(&OpenAndCreateTable, config, db_path(config),
+                           db->connection()),
+                base::Closure());
+    db->Flush(MessageLoop::QuitClosure());
+    MessageLoop::current()->Run();
+
+    PerfTimer individual_timer;
+    for (int j = 0; j < kCommits; ++j) {
+      db->Execute(base::Bind(&InsertRowTask, db->connection(), j),
+                  base::Closure());
+    }
+    db->Flush(MessageLoop::QuitClosure());
+    MessageLoop::current()->Run();
+    double individual_ms = individual_timer.Elapsed().InMillisecondsF();
+
+    PerfTimer batched_timer;
+    for (int j = 0; j < kCommits; ++j) {
+      db->Write(base::Bind(&InsertRowTask, db->connection(), j),
+                base::Closure());
+    }
+    db->Flush(MessageLoop::QuitClosure());
+    MessageLoop::current()->Run();
+    double batched_ms = batched_timer.Elapsed().InMillisecondsF();
+
+    db->Close();
+    db = NULL;
+    db_thread.Stop();
+
+    const std::string prefix =
+        base::StringPrintf("SQLConnection_AsyncWrite_%s_", config.name);
+    LogPerfResult((prefix + "Individual").c_str(),
+                  kCommits / (individual_ms / 1000), "writes/s");
+    LogPerfResult((prefix + "Batched").c_str(),
+                  kCommits / (batched_ms / 1000), "writes/s");
+  }
+}
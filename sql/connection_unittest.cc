@@ -134,6 +134,33 @@ TEST_F(SQLConnectionTest, Rollback) {
   EXPECT_TRUE(db().BeginTransaction());
 }
 
+TEST_F(SQLConnectionTest, Savepoint) {
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a)"));
+  ASSERT_TRUE(db().BeginTransaction());
+  ASSERT_TRUE(db().Execute("INSERT INTO foo (a) VALUES (1)"));
+
+  // A nested transaction rolled back within a savepoint undoes only the work
+  // since the savepoint.
+  ASSERT_TRUE(db().BeginSavepoint());
+  ASSERT_TRUE(db().BeginTransaction());
+  ASSERT_TRUE(db().Execute("INSERT INTO foo (a) VALUES (2)"));
+  db().RollbackTransaction();
+  EXPECT_FALSE(db().BeginTransaction());
+  EXPECT_FALSE(db().EndSavepoint());
+
+  ASSERT_TRUE(db().BeginSavepoint());
+  ASSERT_TRUE(db().BeginTransaction());
+  ASSERT_TRUE(db().Execute("INSERT INTO foo (a) VALUES (4)"));
+  EXPECT_TRUE(db().CommitTransaction());
+  EXPECT_TRUE(db().EndSavepoint());
+
+  EXPECT_EQ(1, db().transaction_nesting());
+  EXPECT_TRUE(db().CommitTransaction());
+  sql::Statement s(db().GetUniqueStatement("SELECT SUM(a) FROM foo"));
+  ASSERT_TRUE(s.Step());
+  EXPECT_EQ(5, s.ColumnInt(0));
+}
+
 // Test that sql::Connection::Raze() results in a database without the
 // tables from the original database.
 TEST_F(SQLConnectionTest, Raze) {
@@ -261,3 +288,136 @@ TEST_F(SQLConnectionTest, RazeLocked) {
 // TODO(shess): Spin up a background thread to hold other_db, to more
 // closely match real life.  That would also allow testing
 // RazeWithTimeout().
+
+TEST_F(SQLConnectionTest, WALMode) {
+  EXPECT_FALSE(db().is_wal_mode());
+  db().Close();
+
+  db().set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+  db().set_synchronous(sql::Connection::SYNCHRONOUS_NORMAL);
+  db().set_wal_autocheckpoint(-1);
+  ASSERT_TRUE(db().Open(db_path()));
+  EXPECT_TRUE(db().is_wal_mode());
+  {
+    sql::Statement s(db().GetUniqueStatement("PRAGMA journal_mode"));
+    ASSERT_TRUE(s.Step());
+    EXPECT_EQ("wal", s.ColumnString(0));
+  }
+  {
+    sql::Statement s(db().GetUniqueStatement("PRAGMA synchronous"));
+    ASSERT_TRUE(s.Step());
+    EXPECT_EQ(1, s.ColumnInt(0));
+  }
+
+  // With automatic checkpoints off, commits stay in the log until asked.
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  ASSERT_TRUE(db().Execute("INSERT INTO foo VALUES (1, 'data')"));
+  FilePath wal_path(db_path().value() + FILE_PATH_LITERAL("-wal"));
+  int64 wal_size = 0;
+  ASSERT_TRUE(file_util::GetFileSize(wal_path, &wal_size));
+  EXPECT_LT(0, wal_size);
+  EXPECT_TRUE(db().CheckpointWAL(sql::Connection::CHECKPOINT_PASSIVE));
+  EXPECT_TRUE(db().CheckpointWAL(sql::Connection::CHECKPOINT_RESTART));
+
+  // The data survives reopening without write-ahead logging.
+  db().Close();
+  EXPECT_FALSE(db().is_wal_mode());
+  db().set_journal_mode(sql::Connection::JOURNAL_MODE_PERSIST);
+  ASSERT_TRUE(db().Open(db_path()));
+  EXPECT_FALSE(db().is_wal_mode());
+  sql::Statement s(db().GetUniqueStatement("SELECT b FROM foo WHERE a = 1"));
+  ASSERT_TRUE(s.Step());
+  EXPECT_EQ("data", s.ColumnString(0));
+}
+
+TEST_F(SQLConnectionTest, WALModeInMemory) {
+  sql::Connection memory_db;
+  memory_db.set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+  ASSERT_TRUE(memory_db.OpenInMemory());
+
+  // In-memory databases can't use a write-ahead log.
+  EXPECT_FALSE(memory_db.is_wal_mode());
+  EXPECT_TRUE(memory_db.CheckpointWAL(sql::Connection::CHECKPOINT_FULL));
+  ASSERT_TRUE(memory_db.Execute("CREATE TABLE foo (a, b)"));
+}
+
+TEST_F(SQLConnectionTest, WALModeReaderDoesNotBlockWriter) {
+  db().Close();
+  db().set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+  ASSERT_TRUE(db().Open(db_path()));
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  ASSERT_TRUE(db().Execute("INSERT INTO foo VALUES (1, 'data')"));
+
+  sql::Connection other_db;
+  other_db.set_journal_mode(sql::Connection::JOURNAL_MODE_WAL);
+  ASSERT_TRUE(other_db.Open(db_path()));
+  ASSERT_TRUE(other_db.is_wal_mode());
+
+  // An unfinished read keeps seeing the data as of when it started, while
+  // the other connection commits.
+  sql::Statement s(other_db.GetUniqueStatement("SELECT a FROM foo"));
+  ASSERT_TRUE(s.Step());
+  ASSERT_TRUE(db().Execute("INSERT INTO foo VALUES (2, 'more')"));
+  EXPECT_FALSE(s.Step());
+  s.Reset(true);
+
+  sql::Statement count(
+      other_db.GetUniqueStatement("SELECT COUNT(*) FROM foo"));
+  ASSERT_TRUE(count.Step());
+  EXPECT_EQ(2, count.ColumnInt(0));
+}
+
+TEST_F(SQLConnectionTest, StatementProfiling) {
+  db().Close();
+  db().EnableStatementProfiling("Test");
+  ASSERT_TRUE(db().Open(db_path()));
+  EXPECT_TRUE(db().is_profiling());
+
+  ASSERT_TRUE(db().Execute("CREATE TABLE foo (a, b)"));
+  ASSERT_TRUE(db().Execute("CREATE INDEX foo_a ON foo (a)"));
+  const char kInsertSql[] = "INSERT INTO foo (a, b) VALUES (?, ?)";
+  for (int i = 0; i < 3; ++i) {
+    sql::Statement s(db().GetCachedStatement(SQL_FROM_HERE, kInsertSql));
+    s.BindInt(0, i);
+    s.BindInt(1, i);
+    ASSERT_TRUE(s.Run());
+  }
+  const char kSelectSql[] = "SELECT a FROM foo WHERE b >= 1";
+  {
+    sql::Statement s(db().GetUniqueStatement(kSelectSql));
+    while (s.Step()) {}
+  }
+  {
+    sql::Statement s(db().GetUniqueStatement("SELECT b FROM foo WHERE a = 1"));
+    ASSERT_TRUE(s.Step());
+  }
+
+  // Statements run through Execute() are not recorded.
+  std::vector<sql::StatementStats> stats;
+  db().GetStatementStats(&stats);
+  ASSERT_EQ(3u, stats.size());
+  for (size_t i = 0; i < stats.size(); ++i) {
+    if (i > 0)
+      EXPECT_GE(stats[i - 1].time, stats[i].time);
+    if (stats[i].sql == kInsertSql) {
+      EXPECT_EQ(3, stats[i].executions);
+      EXPECT_EQ(3, stats[i].steps);
+      EXPECT_EQ(0, stats[i].rows);
+      EXPECT_NE(std::string::npos,
+                stats[i].source.find("connection_unittest.cc:"));
+      EXPECT_FALSE(stats[i].full_scan);
+    } else if (stats[i].sql == kSelectSql) {
+      EXPECT_EQ(1, stats[i].executions);
+      EXPECT_EQ(3, stats[i].steps);
+      EXPECT_EQ(2, stats[i].rows);
+      EXPECT_TRUE(stats[i].source.empty());
+#if !defined(NDEBUG)
+      EXPECT_TRUE(stats[i].full_scan);
+#endif
+    } else {
+      EXPECT_EQ(1, stats[i].executions);
+      EXPECT_EQ(1, stats[i].rows);
+      EXPECT_FALSE(stats[i].full_scan);
+    }
+  }
+}
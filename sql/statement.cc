@@ -16,12 +16,14 @@ namespace sql {
 // only have to check the ref's validity bit.
 Statement::Statement()
     : ref_(new Connection::StatementRef),
-      succeeded_(false) {
+      succeeded_(false),
+      stepped_(false) {
 }
 
 Statement::Statement(scoped_refptr<Connection::StatementRef> ref)
     : ref_(ref),
-      succeeded_(false) {
+      succeeded_(false),
+      stepped_(false) {
 }
 
 Statement::~Statement() {
@@ -51,14 +53,14 @@ bool Statement::Run() {
   if (!CheckValid())
     return false;
 
-  return CheckError(sqlite3_step(ref_->stmt())) == SQLITE_DONE;
+  return CheckError(StepInternal()) == SQLITE_DONE;
 }
 
 bool Statement::Step() {
   if (!CheckValid())
     return false;
 
-  return CheckError(sqlite3_step(ref_->stmt())) == SQLITE_ROW;
+  return CheckError(StepInternal()) == SQLITE_ROW;
 }
 
 void Statement::Reset(bool clear_bound_vars) {
@@ -69,9 +71,16 @@ void Statement::Reset(bool clear_bound_vars) {
     if (clear_bound_vars)
       sqlite3_clear_bindings(ref_->stmt());
     sqlite3_reset(ref_->stmt());
+
+    if (stepped_ && ref_->stats()) {
+      ref_->connection()->RecordStatementExecution(ref_->stats(),
+                                                   execution_time_);
+    }
   }
 
   succeeded_ = false;
+  stepped_ = false;
+  execution_time_ = base::TimeDelta();
 }
 
 bool Statement::Succeeded() const {
@@ -300,6 +309,21 @@ bool Statement::CheckOk(int err) const {
   return err == SQLITE_OK;
 }
 
+int Statement::StepInternal() {
+  StatementStats* stats = ref_->stats();
+  if (!stats)
+    return sqlite3_step(ref_->stmt());
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  int result = sqlite3_step(ref_->stmt());
+  execution_time_ += base::TimeTicks::Now() - start;
+  stepped_ = true;
+  ++stats->steps;
+  if (result == SQLITE_ROW)
+    ++stats->rows;
+  return result;
+}
+
 int Statement::CheckError(int err) {
   // Please don't add DCHECKs here, OnSqliteError() already has them.
   succeeded_ = (err == SQLITE_OK || err == SQLITE_ROW || err == SQLITE_DONE);
@@ -12,6 +12,7 @@
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
 #include "base/string16.h"
+#include "base/time.h"
 #include "sql/connection.h"
 #include "sql/sql_export.h"
 
@@ -160,6 +161,9 @@ class SQL_EXPORT Statement {
   // succeeded flag.
   bool CheckOk(int err) const;
 
+  // Calls sqlite3_step(), timing it when the connection is profiling.
+  int StepInternal();
+
   // Should be called by all mutating methods to check that the statement is
   // valid. Returns true if the statement is valid. DCHECKS and returns false
   // if it is not.
@@ -182,6 +186,11 @@ class SQL_EXPORT Statement {
   // See Succeeded() for what this holds.
   bool succeeded_;
 
+  // When profiling, whether the statement has been stepped since it was last
+  // reset, and the time spent stepping it.
+  bool stepped_;
+  base::TimeDelta execution_time_;
+
   DISALLOW_COPY_AND_ASSIGN(Statement);
 };
 